@@ -0,0 +1,117 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+/// \addtogroup clanCore_Crypto clanCore Crypto
+/// \{
+
+class DataBuffer;
+class AES_CTR_Impl;
+
+/// \brief AES encryption and decryption class (running in Counter mode)
+///
+/// Counter mode turns AES into a stream cipher, so encryption and decryption are the same operation,
+/// no padding is needed and the data can have any length. The key size selects AES-128, AES-192 or AES-256.
+///
+/// Never use the same counter block twice with the same key.
+class AES_CTR
+{
+/// \name Construction
+/// \{
+
+public:
+	/// \brief Constructs a AES generator (running in Counter mode)
+	AES_CTR();
+
+/// \}
+/// \name Attributes
+/// \{
+
+public:
+	/// \brief Get encrypted or decrypted data
+	///
+	/// This is the databuffer used internally to store the output data.
+	/// You may call "set_size()" to clear the buffer, inbetween calls to "add()"
+	/// You may call "set_capacity()" to optimise storage requirements before the add() call
+	DataBuffer get_data() const;
+
+/// \}
+/// \name Operations
+/// \{
+
+public:
+	static const int iv_size = 16;
+
+	/// \brief Resets the encryption
+	void reset();
+
+	/// \brief Sets the initial counter block
+	///
+	/// The whole block is incremented as a 128 bit big endian number for each block of data\n
+	/// This must be called before the initial add()
+	void set_iv(const unsigned char iv[iv_size]);
+
+	/// \brief Sets the cipher key
+	///
+	/// This must be called before the initial add()
+	///
+	/// \param key = The key
+	/// \param key_size = 16 (AES-128), 24 (AES-192) or 32 (AES-256)
+	void set_key(const unsigned char *key, int key_size);
+
+	/// \brief Adds data to be encrypted or decrypted
+	void add(const void *data, int size);
+
+	/// \brief Add data to be encrypted or decrypted
+	///
+	/// \param data = Data Buffer
+	void add(const DataBuffer &data);
+
+	/// \brief Finalize the encryption
+	///
+	/// This removes the key from memory. set_iv() and set_key() must be called again before the next add()
+	void calculate();
+
+/// \}
+/// \name Implementation
+/// \{
+
+private:
+	std::shared_ptr<AES_CTR_Impl> impl;
+/// \}
+};
+
+}
+
+/// \}
@@ -77,6 +77,20 @@ public:
 	/// \param public_exponent_value = public exponent value
 	static void create_keypair(Random &random, Secret &out_private_exponent, DataBuffer &out_public_exponent, DataBuffer &out_modulus, int key_size_in_bits = 1024, int public_exponent_value = 65537);
 
+	/// \brief Create a keypair, also returning the two primes of the modulus
+	///
+	/// Keep the primes with the private exponent, they allow the faster CRT based decrypt() and sign()
+	///
+	/// \param random = Random number generator
+	/// \param out_private_exponent = Private exponent (to decrypt with)
+	/// \param out_public_exponent = Public exponent (to encrypt with)
+	/// \param out_modulus = Modulus
+	/// \param out_prime1 = First prime factor of the modulus
+	/// \param out_prime2 = Second prime factor of the modulus
+	/// \param key_size_in_bits = key size in bits
+	/// \param public_exponent_value = public exponent value
+	static void create_keypair(Random &random, Secret &out_private_exponent, DataBuffer &out_public_exponent, DataBuffer &out_modulus, Secret &out_prime1, Secret &out_prime2, int key_size_in_bits = 1024, int public_exponent_value = 65537);
+
 	/// \brief Encrypt
 	///
 	/// \param block_type = 0 (private key), 1 (private key) or 2 (public key)
@@ -123,6 +137,34 @@ public:
 	/// \param in_data_size = size in bytes of in_data (length equals in_modulus_size)
 	/// \return Decrypted data
 	static Secret decrypt(const Secret &in_private_exponent, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
+
+	/// \brief Decrypt using the Chinese Remainder Theorem
+	///
+	/// Gives the same result as decrypt() without the primes, but does the exponentiation
+	/// modulo each prime at half the size, which is about three times faster.
+	///
+	/// Warning: An exception may be thrown when decrypting if in_data is not valid.
+	/// Be careful handling this, to prevent "timing attacks"
+	///
+	/// \param in_private_exponent = Private exponent
+	/// \param in_prime1 = First prime factor of the modulus
+	/// \param in_prime2 = Second prime factor of the modulus
+	/// \param in_modulus = Modulus
+	/// \param in_data = Data to decrypt (length equals in_modulus.get_size())
+	/// \return Decrypted data
+	static Secret decrypt(const Secret &in_private_exponent, const Secret &in_prime1, const Secret &in_prime2, const DataBuffer &in_modulus, const DataBuffer &in_data);
+
+	/// \brief Sign using the private key (PKCS#1 v1.5 block type 1) and the Chinese Remainder Theorem
+	///
+	/// The signature is verified with decrypt(), passing the public exponent as the private exponent.
+	///
+	/// \param in_private_exponent = Private exponent
+	/// \param in_prime1 = First prime factor of the modulus
+	/// \param in_prime2 = Second prime factor of the modulus
+	/// \param in_modulus = Modulus
+	/// \param in_data = Data to sign (maximum length is in_modulus.get_size() - 11)
+	/// \return Signature
+	static DataBuffer sign(const Secret &in_private_exponent, const Secret &in_prime1, const Secret &in_prime2, const DataBuffer &in_modulus, const Secret &in_data);
 /// \}
 };
 
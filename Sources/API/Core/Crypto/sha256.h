@@ -92,6 +92,30 @@ public:
 	/// \brief Finalize hash calculation.
 	void calculate();
 
+	/// \brief Calculates the hashes of several independent messages
+	///
+	/// On CPUs with AVX2 but without the SHA instructions the messages are hashed in parallel lanes
+	///
+	/// \param count = Number of messages
+	/// \param data = Pointer to each message
+	/// \param sizes = Size of each message
+	/// \param out_hashes = Where to write the hashes (count * hash_size bytes)
+	static void hash_multiple(int count, const void * const *data, const int *sizes, unsigned char *out_hashes);
+
+	/// \brief Returns true if the CPU and OS support hashing messages in parallel AVX2 lanes
+	static bool is_avx2_supported();
+
+	/// \brief Calculates the hashes of several independent messages in parallel AVX2 lanes
+	///
+	/// Unlike hash_multiple, the AVX2 lanes are also used on CPUs with the SHA instructions.
+	/// Throws an exception if is_avx2_supported() returns false.
+	///
+	/// \param count = Number of messages
+	/// \param data = Pointer to each message
+	/// \param sizes = Size of each message
+	/// \param out_hashes = Where to write the hashes (count * hash_size bytes)
+	static void hash_multiple_avx2(int count, const void * const *data, const int *sizes, unsigned char *out_hashes);
+
 /// \}
 /// \name Implementation
 /// \{
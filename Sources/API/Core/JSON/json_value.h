@@ -30,12 +30,18 @@
 
 #include <map>
 #include <vector>
+#include <algorithm>
+#include <iterator>
+#include <memory>
 
 namespace clan
 {
 /// \addtogroup clanCore_JSON clanCore JSON
 /// \{
 
+class IODevice;
+class JsonMembers;
+
 /// \brief Exception class thrown for JSON exceptions.
 class JsonException : public Exception
 {
@@ -82,14 +88,24 @@ public:
 
 	/// \brief Create a value from UTF-8 JSON string
 	static JsonValue from_json(const std::string &json);
+	static JsonValue from_json(const char *json, size_t length);
+
+	/// \brief Create a value from UTF-8 JSON data, unescaping strings in place
+	///
+	/// String values point into the buffer instead of being copied. The buffer
+	/// must stay valid for as long as the returned value, or copies of it, are used.
+	static JsonValue from_json_insitu(char *json, size_t length);
 
 	/// \brief Constructs a value
-	JsonValue() : type(type_null), value_number(), value_boolean() { }
-	JsonValue(Type type) : type(type), value_number(), value_boolean() { }
-	JsonValue(const std::string &value) : type(type_string), value_string(value), value_number(), value_boolean() { }
-	JsonValue(int value) : type(type_number), value_number((double)value), value_boolean() { }
-	JsonValue(double value) : type(type_number), value_number(value), value_boolean() { }
-	explicit JsonValue(bool value) : type(type_boolean), value_number(), value_boolean(value) { }
+	JsonValue() : value_type(type_null), string_insitu(false), string_length(0) { value_number = 0.0; }
+	JsonValue(Type type);
+	JsonValue(const std::string &value) : value_type(type_string), string_insitu(false), string_length(0) { set_string(value.data(), value.length()); }
+	JsonValue(int value) : value_type(type_number), string_insitu(false), string_length(0) { value_number = (double)value; }
+	JsonValue(double value) : value_type(type_number), string_insitu(false), string_length(0) { value_number = value; }
+	explicit JsonValue(bool value) : value_type(type_boolean), string_insitu(false), string_length(0) { value_boolean = value; }
+	JsonValue(const JsonValue &other);
+	JsonValue(JsonValue &&other) throw();
+	~JsonValue() { clear(); }
 /// \}
 
 /// \name Attributes
@@ -102,72 +118,67 @@ public:
 	operator int() const { return to_int(); }
 
 	/// \brief Indexers for object members or array items
-	JsonValue &operator[](const char *key) { return members[key]; }
-	JsonValue &operator[](const std::string &key) { return members[key]; }
-	const JsonValue &operator[](int index) const { return items[index]; }
-	JsonValue &operator[](int index) { return items[index]; }
+	///
+	/// A null value becomes an object or an array when indexed.
+	JsonValue &operator[](const char *key);
+	JsonValue &operator[](const std::string &key);
+	const JsonValue &operator[](int index) const { return get_items()[index]; }
+	JsonValue &operator[](int index) { return get_items()[index]; }
 
 	/// \brief Get value type
-	Type get_type() const { return type; }
+	Type get_type() const { return (Type)value_type; }
 
 	/// \brief Get size of value
-	size_t get_size() const
-	{
-		switch (type)
-		{
-		case type_object: return members.size();
-		case type_array: return items.size();
-		case type_string: return value_string.size();
-		default: return 0;
-		}
-	}
+	size_t get_size() const;
 
 	/// \brief Get object members
-	std::map<std::string, JsonValue> &get_members() { return members; }
-	const std::map<std::string, JsonValue> &get_members() const { return members; }
+	JsonMembers &get_members();
+	const JsonMembers &get_members() const;
 
 	/// \brief Get array items
-	std::vector<JsonValue> &get_items() { return items; }
-	const std::vector<JsonValue> &get_items() const { return items; }
+	std::vector<JsonValue> &get_items();
+	const std::vector<JsonValue> &get_items() const;
 
 	/// \brief Return true if value is null
-	bool is_null() const { return type == type_null; }
+	bool is_null() const { return value_type == type_null; }
 
 	/// \brief Return true if value is an object
-	bool is_object() const { return type == type_object; }
+	bool is_object() const { return value_type == type_object; }
 
 	/// \brief Return true if value is an array
-	bool is_array() const { return type == type_array; }
+	bool is_array() const { return value_type == type_array; }
 
 	/// \brief Return true if value is a string
-	bool is_string() const { return type == type_string; }
+	bool is_string() const { return value_type == type_string; }
 
 	/// \brief Return true if value is a number
-	bool is_number() const { return type == type_number; }
+	bool is_number() const { return value_type == type_number; }
 
 	/// \brief Return true if value is a boolean
-	bool is_boolean() const { return type == type_boolean; }
+	bool is_boolean() const { return value_type == type_boolean; }
 
 	/// \brief Convert value object to a string
-	std::string to_string() const { if (type != type_string) throw JsonException("JSON Value is not a string"); return value_string; }
+	std::string to_string() const { if (value_type != type_string) throw JsonException("JSON Value is not a string"); return string_length ? std::string(value_string, string_length) : std::string(); }
 
 	/// \brief Convert value object to an int
-	int to_int() const { if (type != type_number) throw JsonException("JSON Value is not a number"); return (int)value_number; }
+	int to_int() const { if (value_type != type_number) throw JsonException("JSON Value is not a number"); return (int)value_number; }
 
 	/// \brief Convert value object to a float
-	float to_float() const { if (type != type_number) throw JsonException("JSON Value is not a number"); return (float)value_number; }
+	float to_float() const { if (value_type != type_number) throw JsonException("JSON Value is not a number"); return (float)value_number; }
 
 	/// \brief Convert value object to a double
-	double to_double() const { if (type != type_number) throw JsonException("JSON Value is not a number"); return value_number; }
+	double to_double() const { if (value_type != type_number) throw JsonException("JSON Value is not a number"); return value_number; }
 
 	/// \brief Convert value object to a boolean
-	bool to_boolean() const { if (type != type_boolean) throw JsonException("JSON Value is not a boolean"); return value_boolean; }
+	bool to_boolean() const { if (value_type != type_boolean) throw JsonException("JSON Value is not a boolean"); return value_boolean; }
 /// \}
 
 /// \name Operations
 /// \{
 public:
 	/// \brief Assign a new value
+	JsonValue &operator =(const JsonValue &other);
+	JsonValue &operator =(JsonValue &&other) throw();
 	JsonValue &operator =(const char *value) { *this = JsonValue(std::string(value)); return *this; }
 	JsonValue &operator =(const std::string &value) { *this = JsonValue(value); return *this; }
 	JsonValue &operator =(int value) { *this = JsonValue(value); return *this; }
@@ -176,62 +187,253 @@ public:
 
 	/// \brief Convert value object to a std::map with the template specified value type
 	template<typename Type>
-	std::map<std::string, Type> to_map() const
-	{
-		if (type != type_object)
-			throw JsonException("JSON Value is not an object");
-
-		std::map<std::string, Type> object;
-		std::map<std::string, JsonValue>::const_iterator it;
-		for (it = members.begin(); it != members.end(); ++it)
-			object[it->first] = it->second;
-		return object;
-	}
+	std::map<std::string, Type> to_map() const;
 
 	/// \brief Convert value array to a std::vector with the template specified value type
 	template<typename Type>
-	std::vector<Type> to_vector() const
-	{
-		if (type != type_array)
-			throw JsonException("JSON Value is not an array");
-
-		std::vector<Type> list;
-		list.reserve(items.size());
-		for (size_t i = 0; i < items.size(); i++)
-			list.push_back(items[i]);
-		return list;
-	}
+	std::vector<Type> to_vector() const;
 
 	/// \brief Create an UTF-8 JSON string for the value
 	std::string to_json() const;
 	void to_json(std::string &result) const;
+
+	/// \brief Write the value as UTF-8 JSON to a device, in blocks
+	void to_json(IODevice &device) const;
 /// \}
 
 /// \name Implementation
 /// \{
 private:
-	void write(std::string &json) const;
-	void write_array(std::string &json) const;
-	void write_object(std::string &json) const;
-	static void write_string(const std::string &str, std::string &json);
-	void write_number(std::string &json) const;
-
-	static JsonValue read(const std::string &json, size_t &pos);
-	static JsonValue read_object(const std::string &json, size_t &pos);
-	static JsonValue read_array(const std::string &json, size_t &pos);
-	static std::string read_string(const std::string &json, size_t &pos);
-	static JsonValue read_number(const std::string &json, size_t &pos);
-	static JsonValue read_boolean(const std::string &json, size_t &pos);
-	static void read_whitespace(const std::string &json, size_t &pos);
-
-	Type type;
-	std::map<std::string, JsonValue> members;
-	std::vector<JsonValue> items;
-	std::string value_string;
-	double value_number;
-	bool value_boolean;
+	void clear();
+	void copy_from(const JsonValue &other);
+	void set_string(const char *data, size_t length);
+
+	// Strings, arrays and objects are stored out of line, keeping values at 16 bytes
+	unsigned char value_type;
+	bool string_insitu;
+	unsigned int string_length;
+	union
+	{
+		double value_number;
+		bool value_boolean;
+		char *value_string;
+		std::vector<JsonValue> *value_items;
+		JsonMembers *value_members;
+	};
+
+	friend class JsonReader;
+	friend class JsonWriter;
 /// \}
 };
 
+/// \brief Object members of a JsonValue, sorted by name
+///
+/// Has the interface of a std::map. The members are stored in blocks and looked up through a sorted
+/// array of pointers, so references to members stay valid until the member is erased, like they do
+/// for a std::map.
+class JsonMembers
+{
+public:
+	typedef std::pair<std::string, JsonValue> value_type;
+
+	/// \brief Iterator visiting the members in name order
+	template<typename Member, typename IndexIterator>
+	class basic_iterator
+	{
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef JsonMembers::value_type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef Member *pointer;
+		typedef Member &reference;
+
+		basic_iterator() { }
+		basic_iterator(IndexIterator it) : it(it) { }
+		template<typename OtherMember, typename OtherIndexIterator>
+		basic_iterator(const basic_iterator<OtherMember, OtherIndexIterator> &other) : it(other.it) { }
+
+		Member &operator*() const { return **it; }
+		Member *operator->() const { return *it; }
+
+		basic_iterator &operator++() { ++it; return *this; }
+		basic_iterator operator++(int) { basic_iterator result = *this; ++it; return result; }
+		basic_iterator &operator--() { --it; return *this; }
+		basic_iterator operator--(int) { basic_iterator result = *this; --it; return result; }
+
+		bool operator==(const basic_iterator &other) const { return it == other.it; }
+		bool operator!=(const basic_iterator &other) const { return it != other.it; }
+
+		IndexIterator it;
+	};
+
+	typedef basic_iterator<value_type, std::vector<value_type *>::iterator> iterator;
+	typedef basic_iterator<const value_type, std::vector<value_type *>::const_iterator> const_iterator;
+
+	JsonMembers() { }
+
+	JsonMembers(const JsonMembers &other)
+	{
+		if (other.index.empty())
+			return;
+		value_type *nodes = allocate_block(other.index.size());
+		index.reserve(other.index.size());
+		for (size_t i = 0; i < other.index.size(); i++)
+		{
+			nodes[i] = *other.index[i];
+			index.push_back(nodes + i);
+		}
+	}
+
+	JsonMembers &operator=(const JsonMembers &other)
+	{
+		if (this != &other)
+		{
+			JsonMembers copy(other);
+			index.swap(copy.index);
+			blocks.swap(copy.blocks);
+			free_nodes.swap(copy.free_nodes);
+		}
+		return *this;
+	}
+
+	iterator begin() { return index.begin(); }
+	iterator end() { return index.end(); }
+	const_iterator begin() const { return index.begin(); }
+	const_iterator end() const { return index.end(); }
+
+	size_t size() const { return index.size(); }
+	bool empty() const { return index.empty(); }
+
+	void clear()
+	{
+		index.clear();
+		blocks.clear();
+		free_nodes.clear();
+	}
+
+	iterator find(const std::string &key)
+	{
+		std::vector<value_type *>::iterator it = lower_bound(key);
+		return (it != index.end() && (*it)->first == key) ? it : index.end();
+	}
+
+	const_iterator find(const std::string &key) const
+	{
+		std::vector<value_type *>::const_iterator it = const_cast<JsonMembers *>(this)->lower_bound(key);
+		return (it != index.end() && (*it)->first == key) ? it : index.end();
+	}
+
+	size_t count(const std::string &key) const { return find(key) != end() ? 1 : 0; }
+
+	JsonValue &operator[](const std::string &key)
+	{
+		std::vector<value_type *>::iterator it = lower_bound(key);
+		if (it == index.end() || (*it)->first != key)
+		{
+			value_type *node = allocate_node();
+			node->first = key;
+			it = index.insert(it, node);
+		}
+		return (*it)->second;
+	}
+
+	iterator erase(iterator it)
+	{
+		value_type *node = *it.it;
+		std::string().swap(node->first);
+		node->second = JsonValue();
+		free_nodes.push_back(node);
+		return index.erase(it.it);
+	}
+
+	size_t erase(const std::string &key)
+	{
+		iterator it = find(key);
+		if (it == end())
+			return 0;
+		erase(it);
+		return 1;
+	}
+
+private:
+	std::vector<value_type *>::iterator lower_bound(const std::string &key)
+	{
+		return std::lower_bound(index.begin(), index.end(), key, [](const value_type *member, const std::string &key) { return member->first < key; });
+	}
+
+	value_type *allocate_block(size_t count)
+	{
+		value_type *nodes = new value_type[count];
+		blocks.push_back(std::unique_ptr<value_type[]>(nodes));
+		return nodes;
+	}
+
+	value_type *allocate_node()
+	{
+		if (free_nodes.empty())
+		{
+			// Blocks grow with the object, so adding members one at a time does not allocate for every member
+			size_t count = std::max(index.size() / 2, (size_t)4);
+			value_type *nodes = allocate_block(count);
+			for (size_t i = count; i > 0; i--)
+				free_nodes.push_back(nodes + i - 1);
+		}
+		value_type *node = free_nodes.back();
+		free_nodes.pop_back();
+		return node;
+	}
+
+	/// \brief Members sorted by name
+	std::vector<value_type *> index;
+
+	/// \brief Storage of the members. Nodes never move, keeping references to them valid
+	std::vector<std::unique_ptr<value_type[]> > blocks;
+
+	/// \brief Nodes of erased members, reused by operator[]
+	std::vector<value_type *> free_nodes;
+
+	friend class JsonReader;
+};
+
+inline JsonValue &JsonValue::operator[](const char *key) { return get_members()[key]; }
+inline JsonValue &JsonValue::operator[](const std::string &key) { return get_members()[key]; }
+
+inline size_t JsonValue::get_size() const
+{
+	switch (value_type)
+	{
+	case type_object: return value_members->size();
+	case type_array: return value_items->size();
+	case type_string: return string_length;
+	default: return 0;
+	}
+}
+
+template<typename Type>
+std::map<std::string, Type> JsonValue::to_map() const
+{
+	if (value_type != type_object)
+		throw JsonException("JSON Value is not an object");
+
+	std::map<std::string, Type> object;
+	JsonMembers::const_iterator it;
+	for (it = value_members->begin(); it != value_members->end(); ++it)
+		object[it->first] = it->second;
+	return object;
+}
+
+template<typename Type>
+std::vector<Type> JsonValue::to_vector() const
+{
+	if (value_type != type_array)
+		throw JsonException("JSON Value is not an array");
+
+	std::vector<Type> list;
+	list.reserve(value_items->size());
+	for (size_t i = 0; i < value_items->size(); i++)
+		list.push_back((*value_items)[i]);
+	return list;
+}
+
 /// \}
 }
@@ -147,11 +147,11 @@ public:
 
 	/// \brief  Compute c = (a ** b) mod m.
 	///
-	/// Uses a standard square-and-multiply
-	/// method with modular reductions at each step. (This is basically the
-	/// same code as expt(), except for the addition of the reductions)
+	/// For odd moduli this uses sliding window exponentiation with Montgomery
+	/// multiplication (on 64-bit limbs where the compiler has a 128-bit integer type).
 	///
-	/// The modular reductions are done using Barrett's algorithm (see reduce() for details)
+	/// Even moduli use a standard square-and-multiply method with modular reductions
+	/// at each step, done using Barrett's algorithm (see reduce() for details)
 	void exptmod(const BigInt *b, const BigInt *m, BigInt *c) const;
 
 	/// \brief  Compute c = a (mod m).  Result will always be 0 <= c < m.
@@ -32,6 +32,7 @@
 #include <memory>
 #include <functional>
 #include <vector>
+#include <type_traits>
 
 namespace clan
 {
@@ -63,76 +64,243 @@ namespace clan
 		virtual ~SlotImpl() { }
 	};
 
-	template<typename SlotImplType>
-	class SignalImpl
+	/// \brief Callback record owned by a signal.
+	///
+	/// The callable is stored inline in the record, so connecting costs one allocation and emitting never touches a std::function.
+	template<typename FuncType>
+	class SlotCallbackT;
+
+	template<typename R, typename... Args>
+	class SlotCallbackT<R(Args...)>
 	{
 	public:
-		std::vector<std::weak_ptr<SlotImplType>> slots;
+		SlotCallbackT() : index(0) { }
+		SlotCallbackT(const SlotCallbackT &) = delete;
+		SlotCallbackT &operator=(const SlotCallbackT &) = delete;
+		virtual ~SlotCallbackT() { }
+
+		virtual R invoke(Args... args) = 0;
+
+		/// \brief Position in SignalImpl::slots, used for O(1) disconnect
+		size_t index;
+	};
+
+	template<typename FuncType, typename CallableType>
+	class SlotCallbackFunctorT;
+
+	template<typename CallableType, typename R, typename... Args>
+	class SlotCallbackFunctorT<R(Args...), CallableType> : public SlotCallbackT<R(Args...)>
+	{
+	public:
+		SlotCallbackFunctorT(const CallableType &callable) : callable(callable) { }
+		R invoke(Args... args) override { return callable(args...); }
+
+		CallableType callable;
 	};
 
+	template<typename FuncType, typename InstanceType, typename MemberFuncType>
+	class SlotCallbackMemberT;
+
+	template<typename InstanceType, typename MemberFuncType, typename R, typename... Args>
+	class SlotCallbackMemberT<R(Args...), InstanceType, MemberFuncType> : public SlotCallbackT<R(Args...)>
+	{
+	public:
+		SlotCallbackMemberT(InstanceType instance, MemberFuncType func) : instance(instance), func(func) { }
+		R invoke(Args... args) override { return (instance->*func)(args...); }
+
+		InstanceType instance;
+		MemberFuncType func;
+	};
+
+	/// \brief Slot list shared between a signal and its slots.
+	///
+	/// While an emit is in progress the list is only appended to. Disconnecting clears the
+	/// entry instead of erasing it, and the callback record is kept alive until the outermost
+	/// emit returns. Cleared entries are compacted away once they make up half the list.
 	template<typename FuncType>
-	class SlotImplT : public SlotImpl
+	class SignalImpl
 	{
 	public:
-		SlotImplT(const std::weak_ptr<SignalImpl<SlotImplT>> &signal, const std::function<FuncType> &callback) : signal(signal), callback(callback)
+		SignalImpl() : emit_depth(0), num_disconnected(0) { }
+		SignalImpl(const SignalImpl &) = delete;
+		SignalImpl &operator=(const SignalImpl &) = delete;
+
+		~SignalImpl()
 		{
+			for (auto slot : slots)
+				delete slot;
+			for (auto slot : disconnected_slots)
+				delete slot;
 		}
 
-		~SlotImplT()
+		void connect(SlotCallbackT<FuncType> *slot)
 		{
-			std::shared_ptr<SignalImpl<SlotImplT>> sig = signal.lock();
-			if (sig)
+			slot->index = slots.size();
+			slots.push_back(slot);
+		}
+
+		void disconnect(SlotCallbackT<FuncType> *slot)
+		{
+			slots[slot->index] = nullptr;
+			num_disconnected++;
+
+			if (emit_depth > 0)
+			{
+				disconnected_slots.push_back(slot);
+			}
+			else
+			{
+				delete slot;
+				compact();
+			}
+		}
+
+		void end_emit()
+		{
+			if (--emit_depth == 0)
+			{
+				for (auto slot : disconnected_slots)
+					delete slot;
+				disconnected_slots.clear();
+				compact();
+			}
+		}
+
+		std::vector<SlotCallbackT<FuncType> *> slots;
+		std::vector<SlotCallbackT<FuncType> *> disconnected_slots;
+		int emit_depth;
+		size_t num_disconnected;
+
+		/// \brief Keeps the list alive when the Signal is destroyed by one of its own slots
+		std::shared_ptr<SignalImpl> self;
+
+	private:
+		void compact()
+		{
+			if (num_disconnected * 2 < slots.size())
+				return;
+
+			size_t count = 0;
+			for (auto slot : slots)
 			{
-				for (auto it = sig->slots.begin(); it != sig->slots.end(); ++it)
+				if (slot)
 				{
-					if (it->lock().get() == this)
-					{
-						sig->slots.erase(it);
-						break;
-					}
+					slot->index = count;
+					slots[count++] = slot;
 				}
 			}
+			slots.resize(count);
+			num_disconnected = 0;
 		}
+	};
 
-		std::weak_ptr<SignalImpl<SlotImplT>> signal;
-		std::function<FuncType> callback;
+	template<typename FuncType>
+	class SlotImplT : public SlotImpl
+	{
+	public:
+		SlotImplT(const std::weak_ptr<SignalImpl<FuncType>> &signal, SlotCallbackT<FuncType> *callback) : signal(signal), callback(callback)
+		{
+		}
+
+		~SlotImplT()
+		{
+			std::shared_ptr<SignalImpl<FuncType>> sig = signal.lock();
+			if (sig)
+				sig->disconnect(callback);
+		}
+
+		std::weak_ptr<SignalImpl<FuncType>> signal;
+		SlotCallbackT<FuncType> *callback;
 	};
 
 	template<typename FuncType>
 	class Signal
 	{
 	public:
-		Signal() : impl(std::make_shared<SignalImpl<SlotImplT<FuncType>>>()) { }
+		Signal() : impl(std::make_shared<SignalImpl<FuncType>>()) { }
+
+		~Signal()
+		{
+			if (impl && impl->emit_depth > 0)
+				impl->self = std::move(impl);
+		}
 
 		template<typename... Args>
 		void operator()(Args... args)
 		{
-			std::vector<std::weak_ptr<SlotImplT<FuncType>>> slots = impl->slots;
-			for (std::weak_ptr<SlotImplT<FuncType>> &weak_slot : slots)
+			// Slots may disconnect themselves, connect new slots or even destroy this signal while being called.
+			// Only the slots connected when the emit started are called, and none of them after being disconnected.
+			SignalImpl<FuncType> *signal_impl = impl.get();
+			size_t count = signal_impl->slots.size();
+			signal_impl->emit_depth++;
+			try
 			{
-				std::shared_ptr<SlotImplT<FuncType>> slot = weak_slot.lock();
-				if (slot)
+				for (size_t i = 0; i < count; i++)
 				{
-					slot->callback(args...);
+					SlotCallbackT<FuncType> *slot = signal_impl->slots[i];
+					if (slot)
+						slot->invoke(args...);
 				}
 			}
+			catch (...)
+			{
+				finish_emit(signal_impl);
+				throw;
+			}
+			finish_emit(signal_impl);
 		}
 
 		Slot connect(const std::function<FuncType> &func)
 		{
-			auto slot_impl = std::make_shared<SlotImplT<FuncType>>(impl, func);
-			impl->slots.push_back(slot_impl);
-			return Slot(slot_impl);
+			return connect_callback(new SlotCallbackFunctorT<FuncType, std::function<FuncType>>(func));
+		}
+
+		template<typename CallableType>
+		Slot connect(const CallableType &func)
+		{
+			return connect_callback(new SlotCallbackFunctorT<FuncType, typename std::decay<CallableType>::type>(func));
 		}
 
 		template<typename InstanceType, typename MemberFuncType>
 		Slot connect(InstanceType instance, MemberFuncType func)
 		{
-			return connect(bind_member(instance, func));
+			return connect_callback(new SlotCallbackMemberT<FuncType, InstanceType, MemberFuncType>(instance, func));
 		}
 
 	private:
-		std::shared_ptr<SignalImpl<SlotImplT<FuncType>>> impl;
+		Slot connect_callback(SlotCallbackT<FuncType> *callback)
+		{
+			try
+			{
+				impl->connect(callback);
+			}
+			catch (...)
+			{
+				delete callback;
+				throw;
+			}
+
+			try
+			{
+				return Slot(std::make_shared<SlotImplT<FuncType>>(impl, callback));
+			}
+			catch (...)
+			{
+				impl->disconnect(callback);
+				throw;
+			}
+		}
+
+		static void finish_emit(SignalImpl<FuncType> *signal_impl)
+		{
+			signal_impl->end_emit();
+			if (signal_impl->emit_depth == 0 && signal_impl->self)
+			{
+				std::shared_ptr<SignalImpl<FuncType>> self = std::move(signal_impl->self);
+			}
+		}
+
+		std::shared_ptr<SignalImpl<FuncType>> impl;
 	};
 
 	class SlotContainer
@@ -49,6 +49,12 @@ public:
 	DataBuffer(unsigned int size);
 	DataBuffer(const void *data, unsigned int size);
 	DataBuffer(const DataBuffer &data, unsigned int pos, unsigned int size);
+
+	/// \brief Constructs a data buffer referring to memory it does not own, without copying it.
+	///
+	/// \param owner = Object keeping the memory valid. It is released when the last buffer referring to the memory is destroyed.
+	/// <p>The data is copied if the buffer grows beyond its initial size. Read-only memory must not be written to.</p>
+	DataBuffer(const std::shared_ptr<void> &owner, const void *data, unsigned int size);
 	~DataBuffer();
 /// \}
 
@@ -0,0 +1,117 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+/// \addtogroup clanCore_System clanCore System
+/// \{
+
+class Event;
+class EventWaitSet_Impl;
+
+/// \brief Set of events that is registered with the OS once and waited on repeatedly.
+///
+/// Event::wait hands every OS handle to the kernel on each call. An EventWaitSet keeps its
+/// handles registered between waits (epoll on Linux), so waiting only costs time proportional
+/// to the number of events that are flagged, and there is no limit on descriptor numbers.
+///
+/// Events keep the index they were added at until an event in front of them is removed.
+/// When several events are flagged, wait() returns the one with the lowest index, like Event::wait.
+class EventWaitSet
+{
+/// \name Construction
+/// \{
+
+public:
+	/// \brief Constructs an empty wait set.
+	EventWaitSet();
+
+	~EventWaitSet();
+
+
+/// \}
+/// \name Attributes
+/// \{
+
+public:
+	/// \brief Returns the number of events in the set.
+	int get_size() const;
+
+	/// \brief Returns the event at the specified index.
+	Event get_event(int index) const;
+
+
+/// \}
+/// \name Operations
+/// \{
+
+public:
+	/// \brief Adds an event to the end of the set.
+	///
+	/// \return The index of the event
+	int add(const Event &event);
+
+	/// \brief Replaces the event at the specified index.
+	void replace(int index, const Event &event);
+
+	/// \brief Removes the event at the specified index.
+	///
+	/// The events after it move one index down.
+	void remove(int index);
+
+	/// \brief Removes all events from the set.
+	void clear();
+
+	/// \brief Wait for an event in the set to become flagged.
+	///
+	/// \param timeout = Timeout (ms). -1 = Wait forever
+	/// \return The index of the flagged event, or -1 on timeout
+	int wait(int timeout = -1);
+
+
+/// \}
+/// \name Implementation
+/// \{
+
+private:
+	EventWaitSet(const EventWaitSet &);
+	EventWaitSet &operator=(const EventWaitSet &);
+
+	std::unique_ptr<EventWaitSet_Impl> impl;
+/// \}
+};
+
+
+/// \}
+
+}
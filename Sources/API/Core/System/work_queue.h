@@ -51,14 +51,21 @@ public:
 };
 
 class WorkQueue_Impl;
+class WorkGroup;
 
 /// \brief Thread pool for worker threads
+///
+/// Each worker thread owns a local queue of work. Work queued from outside the pool
+/// is placed in a shared lock-free submission queue, while work queued by a worker
+/// thread goes into that worker's local queue. Idle workers steal work from the
+/// other workers before going to sleep.
 class WorkQueue
 {
 public:
 	/// \brief Constructs a work queue
 	/// \param serial_queue If true, executes items in the order they are queued, one at a time
-	WorkQueue(bool serial_queue = false);
+	/// \param num_threads Number of worker threads to use. 0 = one less than the number of cores. Ignored for serial queues
+	WorkQueue(bool serial_queue = false, int num_threads = 0);
 	~WorkQueue();
 
 	/// \brief Queue some work to be executed on a worker thread
@@ -75,9 +82,57 @@ public:
 	/// \brief Returns the number of items currently queued
 	int get_items_queued() const;
 
+	/// \brief Returns the number of worker threads used by the queue
+	int get_num_threads() const;
+
+	/// \brief Calls a function for sub ranges of [begin, end) on the worker threads
+	///
+	/// Blocks until all sub ranges have been processed. The calling thread helps
+	/// processing queued work while it waits. On a serial queue only the worker
+	/// thread of the queue helps, running the queued work in order.
+	///
+	/// \param begin = First index in the range
+	/// \param end = One past the last index in the range
+	/// \param func = Function called with the begin and end index of each sub range
+	/// \param grain_size = Maximum number of indices per sub range. 0 = choose automatically
+	void parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain_size = 0);
+
 private:
 
 	std::shared_ptr<WorkQueue_Impl> impl;
+
+	friend class WorkGroup;
+};
+
+class WorkGroup_Impl;
+
+/// \brief Group of functions executed on a WorkQueue that can be waited on as a whole
+///
+/// run() and wait() must be called from the thread owning the group.
+class WorkGroup
+{
+public:
+	/// \brief Constructs a work group executing on the specified work queue
+	WorkGroup(WorkQueue &queue);
+
+	/// \brief Waits for all functions in the group to finish
+	~WorkGroup();
+
+	/// \brief Returns the number of functions in the group not finished yet
+	int get_pending() const;
+
+	/// \brief Queue a function to be executed on a worker thread as part of the group
+	void run(const std::function<void()> &func);
+
+	/// \brief Waits for all functions in the group to finish
+	///
+	/// The calling thread helps processing queued work while it waits. On a serial queue
+	/// only the worker thread of the queue helps, running the queued work in order.
+	/// If a function threw an exception, the first exception thrown is rethrown here.
+	void wait();
+
+private:
+	std::shared_ptr<WorkGroup_Impl> impl;
 };
 
 }
@@ -30,6 +30,7 @@
 #pragma once
 
 #include "logger.h"
+#include "../System/cl_platform.h"
 
 namespace clan
 {
@@ -39,6 +40,8 @@ namespace clan
 class File;
 
 /// \brief File logger.
+///
+/// In asynchronous logging mode the lines of a batch are written to the file with a single write.
 class FileLogger : public Logger
 {
 /// \name Construction
@@ -61,15 +64,35 @@ public:
 /// \{
 
 public:
+	/// \brief Start a new file when the current one would grow larger than max_size.
+	///
+	/// The full file is renamed to filename.1, the previous filename.1 to filename.2 and so on.
+	///
+	/// \param max_size = Maximum file size (bytes). 0 = no limit
+	/// \param max_backup_files = Number of old files to keep. 0 = the full file is deleted
+	void set_rotation(byte64 max_size, int max_backup_files = 1);
+
 	/// \brief Log text to file.
 	void log(const std::string &type, const std::string &text);
 
+	/// \brief Write the buffered lines to the file.
+	void flush();
+
 /// \}
 /// \name Implementation
 /// \{
 
 private:
+	void rotate();
+
+	std::string filename;
 	File *file;
+	std::string pending_text;
+	byte64 file_size;
+	byte64 max_file_size;
+	int max_backup_files;
+
+	static const int max_pending_size = 64 * 1024;
 /// \}
 };
 
@@ -32,6 +32,7 @@
 #include "string_format.h"
 #include "string_help.h"
 #include "../System/mutex.h"
+#include <cstring>
 
 namespace clan
 {
@@ -75,47 +76,146 @@ public:
 	/// \brief Log text.
 	virtual void log(const std::string &type, const std::string &text) = 0;
 
+	/// \brief Write any text the logger has buffered.
+	///
+	/// Called after each batch of lines in asynchronous mode.
+	virtual void flush() { }
+
+	/// \brief Move logging to a background thread.
+	///
+	/// log_event stores the line, unformatted, in a ring buffer owned by the calling thread.
+	/// A flusher thread formats the queued lines and passes them to the loggers in batches,
+	/// either every flush_interval milliseconds or when a buffer is half full. Lines from one
+	/// thread keep their order. Threads not started by clan::Thread or SetupCore log synchronously.
+	///
+	/// \param buffer_size = Ring buffer size per thread (bytes). A thread finding its buffer full waits for the flusher.
+	/// \param flush_interval = Time between flushes (ms)
+	static void enable_async(int buffer_size = 64 * 1024, int flush_interval = 50);
+
+	/// \brief Flush the queued lines and return to logging on the calling thread.
+	///
+	/// A thread logging while this runs waits for its queued lines, so its lines keep their order.
+	/// If a logger threw an exception on the flusher thread, the first one is rethrown here.
+	static void disable_async();
+
+	/// \brief Returns true if asynchronous mode is enabled.
+	static bool is_async();
+
+	/// \brief Block until every line logged before the call has been passed to the loggers.
+	///
+	/// If a logger threw an exception on the flusher thread, the first one is rethrown here.
+	static void flush_async();
+
 /// \}
 /// \name Implementation
 /// \{
 
 protected:
+	/// \brief Formats a log line.
+	///
+	/// The time stamp is the time log_event was called, also when the line is written later by the flusher thread.
 	static StringFormat get_log_string(const std::string &type, const std::string &text);
 
 /// \}
 };
 
+/// \brief Arguments of a log_event call, stored in binary form until the line is formatted.
+///
+/// The add() overloads mirror StringFormat::set_arg, so a formatted line is identical to what string_format would produce.
+class LogEventArgs
+{
+public:
+	LogEventArgs() : size(0) { }
+
+	void add(const std::string &text);
+	void add(int value);
+	void add(unsigned int value);
+	void add(long unsigned int value);
+	void add(long long value);
+	void add(unsigned long long value);
+	void add(float value);
+	void add(double value);
+
+	const char *get_data() const { return heap_data.empty() ? inline_data : heap_data.data(); }
+	int get_size() const { return size; }
+
+	/// \brief Sets the arguments stored in data on a StringFormat, starting at index 1.
+	static void apply(StringFormat &format, const char *data, int size);
+
+private:
+	char *append(int length);
+
+	enum Type
+	{
+		type_string,
+		type_int,
+		type_uint,
+		type_ulong,
+		type_longlong,
+		type_ulonglong,
+		type_float,
+		type_double
+	};
+
+	template<typename T>
+	void add_value(Type type, T value)
+	{
+		char *dest = append(1 + sizeof(T));
+		dest[0] = (char)type;
+		memcpy(dest + 1, &value, sizeof(T));
+	}
+
+	template<typename T>
+	static T read_value(const char *data, int &pos)
+	{
+		T value;
+		memcpy(&value, data + pos, sizeof(T));
+		pos += sizeof(T);
+		return value;
+	}
+
+	static const int inline_size = 128;
+	char inline_data[inline_size];
+	std::string heap_data;
+	int size;
+};
+
 /// \brief Log text to logger.
 ///
 void log_event(const std::string &type, const std::string &text);
 
+/// \brief Log a formatted line to logger.
+///
+/// In asynchronous mode the formatting is done by the flusher thread.
+void log_event(const std::string &type, const std::string &format, const LogEventArgs &args);
+
 template <class Arg1>
 void log_event(const std::string &type, const std::string &format, Arg1 arg1)
-{ StringFormat f(format); f.set_arg(1, arg1); log_event(type, f.get_result()); }
+{ LogEventArgs args; args.add(arg1); log_event(type, format, args); }
 
 template <class Arg1, class Arg2>
 void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2)
-{ StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); log_event(type, f.get_result()); }
+{ LogEventArgs args; args.add(arg1); args.add(arg2); log_event(type, format, args); }
 
 template <class Arg1, class Arg2, class Arg3>
 void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3)
-{ StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); log_event(type, f.get_result()); }
+{ LogEventArgs args; args.add(arg1); args.add(arg2); args.add(arg3); log_event(type, format, args); }
 
 template <class Arg1, class Arg2, class Arg3, class Arg4>
 void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4)
-{ StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); f.set_arg(4, arg4); log_event(type, f.get_result()); }
+{ LogEventArgs args; args.add(arg1); args.add(arg2); args.add(arg3); args.add(arg4); log_event(type, format, args); }
 
 template <class Arg1, class Arg2, class Arg3, class Arg4, class Arg5>
 void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5)
-{ StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); f.set_arg(4, arg4); f.set_arg(5, arg5); log_event(type, f.get_result()); }
+{ LogEventArgs args; args.add(arg1); args.add(arg2); args.add(arg3); args.add(arg4); args.add(arg5); log_event(type, format, args); }
 
 template <class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6>
 void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6)
-{ StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); f.set_arg(4, arg4); f.set_arg(5, arg5); f.set_arg(6, arg6); log_event(type, f.get_result()); }
+{ LogEventArgs args; args.add(arg1); args.add(arg2); args.add(arg3); args.add(arg4); args.add(arg5); args.add(arg6); log_event(type, format, args); }
 
 template <class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6, class Arg7>
 void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7)
-{ StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); f.set_arg(4, arg4); f.set_arg(5, arg5); f.set_arg(6, arg6); f.set_arg(7, arg7); log_event(type, f.get_result()); }
+{ LogEventArgs args; args.add(arg1); args.add(arg2); args.add(arg3); args.add(arg4); args.add(arg5); args.add(arg6); args.add(arg7); log_event(type, format, args); }
 
 }
 
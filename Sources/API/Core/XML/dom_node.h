@@ -424,6 +424,8 @@ protected:
 	friend class DomDocument;
 
 	friend class DomNamedNodeMap;
+
+	friend class XPathExpression_Impl;
 /// \}
 };
 
@@ -0,0 +1,120 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "xml_token.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace clan
+{
+/// \addtogroup clanCore_XML clanCore XML
+/// \{
+
+/// \brief Reference to a string owned by a XMLTokenizer.
+///
+/// The referenced characters are not null terminated.
+class XMLStringView
+{
+/// \name Construction
+/// \{
+
+public:
+	XMLStringView() : data(0), length(0) { }
+	XMLStringView(const char *data, std::string::size_type length) : data(data), length(length) { }
+
+/// \}
+/// \name Attributes
+/// \{
+
+public:
+	/// \brief First character of the string.
+	const char *data;
+
+	/// \brief Length of the string in bytes.
+	std::string::size_type length;
+
+	/// \brief Returns true if the string is empty.
+	bool empty() const { return length == 0; }
+
+	/// \brief Returns a copy of the string.
+	std::string to_string() const { return std::string(data, length); }
+
+	/// \brief Returns true if the string equals the null terminated string passed.
+	bool operator==(const char *str) const { return std::string::traits_type::length(str) == length && std::string::traits_type::compare(data, str, length) == 0; }
+	bool operator!=(const char *str) const { return !operator==(str); }
+
+	/// \brief Returns true if the string equals the string passed.
+	bool operator==(const std::string &str) const { return str.length() == length && str.compare(0, length, data, length) == 0; }
+	bool operator!=(const std::string &str) const { return !operator==(str); }
+/// \}
+};
+
+/// \brief XML token referencing the internal buffer of a XMLTokenizer.
+///
+/// The strings in the token are only valid until the next call to XMLTokenizer::next.
+class XMLTokenView
+{
+/// \name Construction
+/// \{
+
+public:
+	XMLTokenView() : type(XMLToken::NULL_TOKEN), variant(XMLToken::SINGLE)
+	{
+	}
+
+/// \}
+/// \name Attributes
+/// \{
+
+public:
+	// Attribute name/value pair.
+	typedef std::pair<XMLStringView, XMLStringView> Attribute;
+
+	/// \brief The token type.
+	XMLToken::TokenType type;
+
+	/// \brief The token variant.
+	XMLToken::TokenVariant variant;
+
+	/// \brief The name of the token.
+	XMLStringView name;
+
+	/// \brief The value of the token.
+	XMLStringView value;
+
+	/// \brief All the attributes attached to the token.
+	std::vector<Attribute> attributes;
+/// \}
+};
+
+}
+
+/// \}
@@ -38,6 +38,7 @@ namespace clan
 
 class IODevice;
 class XMLToken;
+class XMLTokenView;
 class XMLTokenizer_Impl;
 
 /// \brief The XML Tokenizer breaks a XML file into XML tokens.
@@ -59,6 +60,15 @@ public:
 	/// \param input = IODevice
 	XMLTokenizer(IODevice &input);
 
+	/// \brief Constructs a streaming XMLTokenizer
+	///
+	/// Instead of loading the entire input into memory, the input is read in
+	/// blocks of buffer_size bytes as tokens are requested.
+	///
+	/// \param input = IODevice
+	/// \param buffer_size = Size of each block read from the device
+	XMLTokenizer(IODevice &input, int buffer_size);
+
 	virtual ~XMLTokenizer();
 
 /// \}
@@ -85,6 +95,13 @@ public:
 	/// \param out_token = XMLToken
 	void next(XMLToken *out_token);
 
+	/// \brief Returns the next token without copying its strings
+	///
+	/// The strings in the token reference the tokenizer and are only valid until the next call to next().
+	///
+	/// \param out_token = XMLTokenView
+	void next(XMLTokenView *out_token);
+
 /// \}
 /// \name Implementation
 /// \{
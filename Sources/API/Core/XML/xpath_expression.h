@@ -0,0 +1,105 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include "xpath_object.h"
+
+namespace clan
+{
+/// \addtogroup clanCore_XML clanCore XML
+/// \{
+
+class DomNode;
+class XPathExpression_Impl;
+
+/// \brief Compiled XPath expression.
+///
+/// The expression is tokenized once when constructed. Location paths made of child, attribute,
+/// self, parent and descendant steps without predicates are evaluated directly on the document
+/// tree. Other expressions are interpreted like XPathEvaluator does, but from the cached tokens.
+class XPathExpression
+{
+/// \name Construction
+/// \{
+
+public:
+	/// \brief Constructs a null instance
+	XPathExpression();
+
+	/// \brief Compiles an expression
+	///
+	/// Throws an XPathException if the expression contains invalid tokens or location steps.
+	///
+	/// \param expression = XPath expression
+	XPathExpression(const std::string &expression);
+
+/// \}
+/// \name Attributes
+/// \{
+
+public:
+	/// \brief Returns true if this object is invalid.
+	bool is_null() const { return !impl; }
+
+	/// \brief Returns the expression source
+	std::string get_expression() const;
+
+	/// \brief Returns true if results are memoized
+	bool is_memoized() const;
+
+/// \}
+/// \name Operations
+/// \{
+
+public:
+	/// \brief Evaluate
+	///
+	/// \param context_node = Dom Node
+	///
+	/// \return XPath Object
+	XPathObject evaluate(const DomNode &context_node) const;
+
+	/// \brief Remember the results for each document and context node
+	///
+	/// The results of a document are discarded when the document is modified.
+	void set_memoized(bool enable);
+
+/// \}
+/// \name Implementation
+/// \{
+
+private:
+	std::shared_ptr<XPathExpression_Impl> impl;
+/// \}
+};
+
+}
+
+/// \}
@@ -32,6 +32,7 @@
 
 #include <memory>
 #include "zip_file_entry.h"
+#include "../System/databuffer.h"
 #include <vector>
 
 namespace clan
@@ -40,6 +41,7 @@ namespace clan
 /// \{
 
 class IODevice;
+class WorkQueue;
 class ZipArchive_Impl;
 
 /// \brief Zip archive.
@@ -62,7 +64,11 @@ public:
 	/// \brief Constructs a ZipArchive
 	///
 	/// \param filename = String Ref
-	ZipArchive(const std::string &filename);
+	/// \param memory_map = Reads the archive through a copy-on-write memory mapping of the file.
+	/// <p>Stored files of a memory mapped archive are returned without copying them, deflated files are
+	/// inflated straight from the mapping, and files can be opened and read from several threads at once.
+	/// Memory mapped archives are limited to 0x7fffffff bytes. An exception is thrown for larger files.</p>
+	ZipArchive(const std::string &filename, bool memory_map = false);
 
 	/// \brief Constructs a ZipArchive
 	///
@@ -79,8 +85,18 @@ public:
 	/// \brief List of file entries in archive.
 	std::vector<ZipFileEntry> get_file_list();
 
+	/// \brief List of files and subdirectories in a directory of the archive.
 	std::vector<ZipFileEntry> get_file_list(const std::string &path);
 
+	/// \brief Returns true if filenames are compared case sensitively (the default).
+	bool is_case_sensitive() const;
+
+	/// \brief Returns true if the archive is read through a memory mapping of its file.
+	bool is_memory_mapped() const;
+
+	/// \brief Returns the deflate compression level used when saving added files.
+	int get_compression_level() const;
+
 /// \}
 /// \name Operations
 /// \{
@@ -89,6 +105,12 @@ public:
 	/// \brief Opens a file in the archive.
 	IODevice open_file(const std::string &filename);
 
+	/// \brief Returns the contents of a file in the archive.
+	///
+	/// <p>For stored files of a memory mapped archive the buffer refers to the mapping. Writing to it changes
+	/// the contents seen by other buffers of the same file, but never the zip file itself.</p>
+	DataBuffer get_file_data(const std::string &filename);
+
 	/// \brief Get full path to source:
 	std::string get_pathname(const std::string &filename);
 
@@ -97,8 +119,17 @@ public:
 
 	/// \brief Adds a file to zip archive.
 	/** <p>File is not added to zip file until it save() is called.</p>
-	    \param filename Filename of file.*/
-	void add_file(const std::string &input_filename, const std::string &filename_in_archive);
+	    \param filename Filename of file.
+	    \param compress Deflates the file when saving. The file is stored instead if deflating does not make it smaller.*/
+	void add_file(const std::string &input_filename, const std::string &filename_in_archive, bool compress = true);
+
+	/// \brief Sets if open_file and get_file_list compare filenames case sensitively.
+	void set_case_sensitive(bool enable);
+
+	/// \brief Sets the deflate compression level used when saving added files.
+	///
+	/// \param level Compression level in range 0-9. 0 = store every file, 1 = best speed, 6 = default, 9 = best compression.
+	void set_compression_level(int level);
 
 	/// \brief Saves zip archive.
 	///
@@ -124,6 +155,16 @@ public:
 	/// \param iodev = The file to save to
 	void save(IODevice iodev);
 
+	/// \brief Save, compressing the added files on a work queue
+	///
+	/// <p>Files are compressed in parallel and written to the output in archive order as they
+	/// complete, so only a window of files ahead of the output is kept in memory. Files from a
+	/// loaded archive are copied without being recompressed. The other save functions use a
+	/// temporary work queue.</p>
+	/// \param iodev = The file to save to
+	/// \param work_queue = The work queue compressing the files
+	void save(IODevice iodev, WorkQueue &work_queue);
+
 	/// \brief Loads the zip archive from a input device (done automatically at construction).
 	void load(IODevice &input);
 
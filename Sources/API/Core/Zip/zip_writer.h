@@ -42,6 +42,8 @@ class IODevice;
 class ZipWriter_Impl;
 
 /// \brief Zip file writer.
+///
+/// Zip64 file entries are not written, so zip files are limited to 2 GB. An exception is thrown before the output grows larger.
 class ZipWriter
 {
 /// \name Construction
@@ -69,6 +71,16 @@ public:
 	/// \brief Ends the file entry.
 	void end_file();
 
+	/// \brief Writes a complete file entry whose data is already stored or deflated.
+	///
+	/// The local file header is written once with the final sizes, so the output is never seeked.
+	/// \param data = File data, a raw deflate stream if deflated is true
+	/// \param size = Size of data
+	/// \param uncompressed_size = Size of the file once inflated
+	/// \param crc32 = CRC-32 of the uncompressed file
+	/// \param deflated = true if data is deflated, false if it is stored
+	void write_file(const std::string &filename, const void *data, byte64 size, byte64 uncompressed_size, ubyte32 crc32, bool deflated);
+
 	/// \brief Writes the table of contents part of the zip file.
 	void write_toc();
 
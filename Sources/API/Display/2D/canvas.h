@@ -280,6 +280,18 @@ public:
 	/// \param color = Colorf
 	void fill_rect(const Rectf &rect, const Colorf &color);
 
+	/// \brief Draw many textured rectangles in one call
+	///
+	/// \param dest_rects = Destination rectangles
+	/// \param texture_rects = Source rectangles in the texture, in texels
+	/// \param num_rects = Number of rectangles
+	/// \param texture = Texture
+	/// \param color = Color of all rectangles
+	void fill_rects(const Rectf *dest_rects, const Rectf *texture_rects, int num_rects, const Texture2D &texture, const Colorf &color = Colorf::white);
+
+	/// \brief Draw many textured rectangles in one call, with a color per rectangle
+	void fill_rects(const Rectf *dest_rects, const Rectf *texture_rects, int num_rects, const Texture2D &texture, const Colorf *colors);
+
 	/// \brief Gradient fill
 	///
 	/// \param gc = Graphic Context
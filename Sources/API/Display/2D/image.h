@@ -30,6 +30,7 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include "../../Core/Math/origin.h"
 #include "../../Core/Resources/resource.h"
 #include "color.h"
@@ -112,6 +113,9 @@ public:
 
 	/// \brief Loads a Sprite from a XML resource definition
 	static Image load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc);
+
+	/// \brief Loads an Image from a XML resource definition, creating the texture of its image file with a callback
+	static Image load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(GraphicContext &gc, const std::string &filename, const FileSystem &fs)> &load_texture);
 /// \}
 
 /// \name Attributes
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include "../../Core/Math/origin.h"
 #include "../../Core/Signals/signal.h"
 #include "../../Core/IOData/file_system.h"
@@ -50,6 +51,7 @@ class Canvas;
 class ResourceManager;
 class Font_Impl;
 class Subtexture;
+class Texture2D;
 
 /// \brief Sprite class.
 class Sprite
@@ -109,6 +111,9 @@ public:
 
 	/// \brief Loads a Sprite from a XML resource definition
 	static Sprite load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc);
+
+	/// \brief Loads a Sprite from a XML resource definition, creating the textures of its image files with a callback
+	static Sprite load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(GraphicContext &gc, const std::string &filename, const FileSystem &fs)> &load_texture);
 /// \}
 
 /// \name Attributes
@@ -31,6 +31,7 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include "../../Core/IOData/file_system.h"
 #include "../../Core/Resources/resource.h"
 #include "graphic_context.h"
@@ -136,6 +137,9 @@ public:
 
 	/// \brief Loads a Texture from a XML resource definition
 	static Texture load(GraphicContext &gc, const std::string &id, const XMLResourceDocument &doc);
+
+	/// \brief Loads a Texture from a XML resource definition, creating it from its image file with a callback
+	static Texture load(GraphicContext &gc, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(GraphicContext &gc, const std::string &filename, const FileSystem &fs)> &load_texture);
 /// \}
 
 /// \name Operators
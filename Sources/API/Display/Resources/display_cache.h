@@ -30,7 +30,10 @@
 #pragma once
 
 #include "../../Core/Resources/resource.h"
+#include "../../Core/System/cl_platform.h"
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace clan
 {
@@ -46,6 +49,90 @@ class Texture;
 class Font;
 class FontDescription;
 class CollisionOutline;
+class DisplayCachePreload_Impl;
+
+/// \brief Handle to a set of resources being preloaded by a DisplayCache
+///
+/// The handle is updated by DisplayCache::process_preloads and must only be used on the thread rendering with the cache.
+class DisplayCachePreload
+{
+public:
+	/// \brief Constructs a null instance
+	DisplayCachePreload();
+
+	/// \brief Constructs a handle to a preload
+	DisplayCachePreload(const std::shared_ptr<DisplayCachePreload_Impl> &impl);
+
+	/// \brief Returns true if this object is invalid
+	bool is_null() const { return !impl; }
+
+	/// \brief Returns true when every resource has been loaded or failed to load
+	bool is_done() const;
+
+	/// \brief Returns the number of resources preloaded
+	int get_resource_count() const;
+
+	/// \brief Returns the number of resources loaded or failed so far
+	int get_loaded_count() const;
+
+	/// \brief Returns the fraction of the resources loaded or failed, in the range 0 to 1
+	float get_progress() const;
+
+	/// \brief Returns an error message for each resource that failed to load
+	std::vector<std::string> get_errors() const;
+
+private:
+	std::shared_ptr<DisplayCachePreload_Impl> impl;
+};
+
+/// \brief Preload and load timing counters of a DisplayCache
+///
+/// Times are in microseconds.
+class DisplayCacheStatistics
+{
+public:
+	DisplayCacheStatistics()
+	: resources_preloaded(0), images_decoded(0), total_decode_time(0), max_decode_time(0),
+	  upload_calls(0), bytes_uploaded(0), total_upload_time(0), max_upload_time(0),
+	  sync_loads(0), total_sync_load_time(0), max_sync_load_time(0)
+	{
+	}
+
+	/// \brief Number of resources completed by preloads.
+	int resources_preloaded;
+
+	/// \brief Number of image files decoded on worker threads.
+	int images_decoded;
+
+	/// \brief Time spent decoding image files on worker threads.
+	ubyte64 total_decode_time;
+
+	/// \brief Longest time spent decoding a single image file.
+	ubyte64 max_decode_time;
+
+	/// \brief Number of process_preloads calls that uploaded images or completed resources.
+	int upload_calls;
+
+	/// \brief Number of bytes of decoded images uploaded.
+	ubyte64 bytes_uploaded;
+
+	/// \brief Time spent in process_preloads uploading images and completing resources.
+	ubyte64 total_upload_time;
+
+	/// \brief Longest time spent in a single process_preloads call.
+	///
+	/// This is the preloading cost of the worst frame.
+	ubyte64 max_upload_time;
+
+	/// \brief Number of resources a get function had to load itself because they were not preloaded.
+	int sync_loads;
+
+	/// \brief Time spent loading resources in get functions.
+	ubyte64 total_sync_load_time;
+
+	/// \brief Longest time spent loading a single resource in a get function.
+	ubyte64 max_sync_load_time;
+};
 
 class DisplayCache
 {
@@ -57,6 +144,32 @@ public:
 	virtual Resource<Font> get_font(Canvas &canvas, const FontDescription &desc) = 0;
 	virtual Resource<CollisionOutline> get_collision(const std::string &id) = 0;
 
+	/// \brief Starts loading sprites, images, textures and sprite fonts ahead of their get function
+	///
+	/// Image files are decoded on worker threads. The textures are uploaded and the resources
+	/// completed by process_preloads. The default implementation preloads nothing.
+	virtual DisplayCachePreload preload(Canvas &canvas, const std::vector<std::string> &ids);
+
+	/// \brief Starts loading the sprites, images, textures and sprite fonts of a resource section
+	virtual DisplayCachePreload preload_section(Canvas &canvas, const std::string &section);
+
+	/// \brief Uploads decoded images within the upload budget and completes the preloaded resources ready
+	///
+	/// Call this once per frame on the thread rendering with the cache.
+	virtual void process_preloads() { }
+
+	/// \brief Waits for a preload to finish, uploading its images regardless of the upload budget
+	virtual void finish_preload(DisplayCachePreload &preload) { }
+
+	/// \brief Sets the maximum number of bytes uploaded by each process_preloads call. 0 = no limit
+	virtual void set_preload_upload_budget(int bytes) { }
+
+	/// \brief Returns the preload and load timing counters
+	virtual DisplayCacheStatistics get_statistics() const;
+
+	/// \brief Resets the preload and load timing counters
+	virtual void reset_statistics() { }
+
 	static DisplayCache &get(const ResourceManager &resources);
 	static void set(ResourceManager &resources, const std::shared_ptr<DisplayCache> &cache);
 };
@@ -44,6 +44,8 @@ namespace clan
 
 class NetGameConnectionSite;
 class NetGameConnection_Impl;
+class NetGameConnectionReactor;
+class NetGameServer;
 
 /// \brief NetGameConnection
 class NetGameConnection
@@ -86,11 +88,15 @@ public:
 	SocketName get_remote_name() const;
 
 private:
+	NetGameConnection(NetGameConnectionSite *site, const TCPConnection &connection, NetGameConnectionReactor *reactor);
+
 	/// \brief Disallow copy constructors
 	NetGameConnection(NetGameConnection &other);
 	NetGameConnection &operator =(const NetGameConnection &other);
 
 	NetGameConnection_Impl *impl;
+
+	friend class NetGameServer;
 };
 
 }
@@ -61,6 +61,16 @@ public:
 	/// \param port = String
 	void start(const std::string &address, const std::string &port);
 
+	/// \brief Set the number of I/O threads serving client connections
+	///
+	/// With the default of 0 every connection gets its own thread. A positive count
+	/// serves all connections on a fixed pool of epoll based I/O threads instead, which
+	/// scales to many thousands of clients. Only supported on Linux; ignored elsewhere.
+	/// Takes effect on the next call to start().
+	///
+	/// \param count = Number of I/O threads
+	void set_io_thread_count(int count);
+
 	/// \brief Process events
 	void process_events();
 
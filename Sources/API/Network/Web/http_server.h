@@ -62,6 +62,25 @@ public:
 /// \{
 
 public:
+	/// \brief Serve connections on a fixed pool of event loop threads
+	///
+	/// By default every connection gets its own thread and is closed after one request.
+	/// With I/O threads connections are served by epoll event loops supporting HTTP/1.1
+	/// keep-alive and request pipelining. Request handlers are then called on the I/O
+	/// threads and should not block. Only supported on Linux; ignored elsewhere.
+	/// Must be called before bind().
+	///
+	/// \param count = Number of I/O threads
+	void set_io_thread_count(int count);
+
+	/// \brief Set the largest request body the I/O threads accept
+	///
+	/// With I/O threads the request body is read into memory before the handler is called.
+	/// Larger requests are answered with 413 Payload Too Large. Defaults to 8 MB.
+	/// Must be called before bind().
+	///
+	/// \param size = Maximum body size (bytes)
+	void set_max_request_body_size(unsigned int size);
 
 	/// \brief Bind
 	///
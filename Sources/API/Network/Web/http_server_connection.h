@@ -110,6 +110,13 @@ public:
 	/// \param data = Data Buffer
 	void write_response_data(const DataBuffer &data);
 
+	/// \brief Write response data from a file
+	///
+	/// When the server uses I/O threads the file is sent with sendfile() after the handler returns.
+	///
+	/// \param filename = Name of the file to send
+	void write_response_file(const std::string &filename);
+
 /// \}
 /// \name Implementation
 /// \{
@@ -67,11 +67,24 @@ public:
 
 	virtual ~SoundProvider_Wave();
 
+/// \}
+/// \name Attributes
+/// \{
+
+public:
+	/// \brief Returns the number of samples sessions decode ahead of the mixer, or 0 if they decode when the mixer needs data.
+	int get_decode_ahead() const;
+
 /// \}
 /// \name Operations
 /// \{
 
 public:
+	/// \brief Sets the number of samples sessions decode ahead of the mixer on a background thread.
+	///
+	/// Applies to sessions started afterwards. Streamed providers decode ahead by default, 0 disables it.
+	void set_decode_ahead(int samples);
+
 	/// \brief Called by SoundBuffer when a new session starts.
 	/** \return The soundbuffer session to be attached to the newly started session.*/
 	virtual SoundProvider_Session *begin_session();
@@ -41,6 +41,17 @@ class SoundFilter;
 class SoundBuffer;
 class SoundBuffer_Session_Impl;
 class SoundOutput;
+class SoundMixerCommand;
+
+/// \brief Resampling used when a session plays at another frequency than its sound output
+enum SoundResampleQuality
+{
+	/// \brief Linear interpolation between neighbouring samples
+	resample_linear,
+
+	/// \brief Windowed sinc interpolation, which avoids the aliasing of linear interpolation
+	resample_sinc
+};
 
 /// \brief SoundBuffer_Session provides control over a playing soundeffect.
 ///
@@ -109,6 +120,9 @@ public:
 	/// \brief Returns true if the session is playing
 	bool is_playing();
 
+	/// \brief Returns the resampling quality of the session
+	SoundResampleQuality get_resample_quality() const;
+
 /// \}
 /// \name Operations
 /// \{
@@ -142,6 +156,11 @@ public:
 	/// \param new_freq New frequency of session.
 	void set_frequency(int new_freq);
 
+	/// \brief Sets how the session is resampled to the mixing frequency of the sound output
+	///
+	/// Defaults to resample_linear.
+	void set_resample_quality(SoundResampleQuality quality);
+
 	/// \brief Sets the volume of the session in a relative measure (0->1)
 	///
 	/// A value of 0 will effectively mute the sound (although it will
@@ -186,6 +205,10 @@ public:
 
 private:
 	SoundBuffer_Session(SoundBuffer &soundbuffer, bool looping, SoundOutput &output);
+
+	/// \brief Passes a change to the mixer thread. Takes ownership of the command.
+	void queue_mixer_command(SoundMixerCommand *command);
+
 	std::shared_ptr<SoundBuffer_Session_Impl> impl;
 
 	friend class SoundBuffer;
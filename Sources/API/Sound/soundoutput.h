@@ -29,7 +29,9 @@
 
 #pragma once
 
+#include "../Core/System/cl_platform.h"
 #include <memory>
+#include <string>
 
 namespace clan
 {
@@ -41,6 +43,51 @@ class SoundBuffer;
 class SoundOutput_Description;
 class SoundOutput_Impl;
 
+/// \brief Mixer thread timing counters of a sound output.
+///
+/// The decode counters are shared by all sound outputs, as one decode thread decodes ahead for the whole process.
+class SoundOutputStatistics
+{
+public:
+	SoundOutputStatistics()
+	: fragment_size(0), fragments_mixed(0), late_fragments(0), total_mix_time(0), max_mix_time(0),
+	  decode_chunks(0), total_decode_time(0), max_decode_time(0), decode_underruns(0), min_decode_headroom(0)
+	{
+	}
+
+	/// \brief Number of samples per channel in each fragment.
+	int fragment_size;
+
+	/// \brief Number of fragments mixed.
+	int fragments_mixed;
+
+	/// \brief Number of fragments that took longer to mix than to play.
+	int late_fragments;
+
+	/// \brief Time spent mixing all the fragments, in microseconds.
+	ubyte64 total_mix_time;
+
+	/// \brief Longest time spent mixing a single fragment, in microseconds.
+	ubyte64 max_mix_time;
+
+	/// \brief Number of chunks decoded ahead of the mixer by streamed sound providers.
+	int decode_chunks;
+
+	/// \brief Time spent decoding ahead, in microseconds.
+	ubyte64 total_decode_time;
+
+	/// \brief Longest time spent decoding a single chunk, in microseconds.
+	ubyte64 max_decode_time;
+
+	/// \brief Number of times the mixer had to decode a streamed session itself because nothing was decoded ahead.
+	int decode_underruns;
+
+	/// \brief Least amount of audio decoded ahead when the mixer read from a streamed session, in microseconds.
+	///
+	/// A value close to the fragment duration means decoding barely kept up with the mixer.
+	ubyte64 min_decode_headroom;
+};
+
 /// \brief SoundOutput interface in ClanLib.
 ///
 ///   <p>SoundOutput is the interface to a sound output device. It is used to
@@ -93,6 +140,9 @@ public:
 	/// \brief Returns the main panning position of the sound output.
 	float get_global_pan() const;
 
+	/// \brief Returns the timing counters of the mixer thread.
+	SoundOutputStatistics get_statistics() const;
+
 /// \}
 /// \name Operations
 /// \{
@@ -115,6 +165,11 @@ public:
 	/// \brief Remove the sound filter from the session.
 	void remove_filter(SoundFilter &filter);
 
+	/// \brief Sets all timing counters of the mixer thread to zero.
+	///
+	/// The decode counters are reset for all sound outputs.
+	void reset_statistics();
+
 /// \}
 /// \name Implementation
 /// \{
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 namespace clan
 {
@@ -38,6 +39,19 @@ namespace clan
 
 class SoundOutput_Description_Impl;
 
+/// \brief Sound output device types
+enum SoundOutputDevice
+{
+	/// \brief The sound device of the platform
+	sound_output_device_default,
+
+	/// \brief Mixes without playing the result, for headless benchmarking
+	sound_output_device_null,
+
+	/// \brief Writes the mix to a 16 bit stereo wave file, see set_filename
+	sound_output_device_wave_file
+};
+
 /// \brief Sound output description class.
 class SoundOutput_Description
 {
@@ -61,6 +75,18 @@ public:
 	/// \brief Returns the mixing latency in milliseconds.
 	int get_mixing_latency() const;
 
+	/// \brief Returns the type of device to output to.
+	SoundOutputDevice get_device() const;
+
+	/// \brief Returns the number of threads sound sessions are mixed on.
+	int get_mixing_threads() const;
+
+	/// \brief Returns the file written by the wave file device.
+	const std::string &get_filename() const;
+
+	/// \brief Returns true if the null and wave file devices mix at the speed the sound would play.
+	bool is_real_time() const;
+
 /// \}
 /// \name Operations
 /// \{
@@ -72,6 +98,24 @@ public:
 	/// \brief Sets the mixing latency in milliseconds.
 	void set_mixing_latency(int latency);
 
+	/// \brief Sets the type of device to output to. Defaults to sound_output_device_default.
+	void set_device(SoundOutputDevice device);
+
+	/// \brief Sets the number of threads sound sessions are mixed on.
+	///
+	/// When many sessions are playing, they are mixed in groups on a pool of worker threads.
+	/// Sessions sharing a sound filter are always mixed in the same group, so a filter is never run on two threads at once.
+	/// 1 = mix everything on the mixer thread. 0 = based on the number of cores (default).
+	void set_mixing_threads(int num_threads);
+
+	/// \brief Sets the file written by the wave file device.
+	void set_filename(const std::string &filename);
+
+	/// \brief Sets if the null and wave file devices mix at the speed the sound would play.
+	///
+	/// By default they mix as fast as possible.
+	void set_real_time(bool enable);
+
 /// \}
 /// \name Implementation
 /// \{
@@ -71,6 +71,7 @@
 #include "Core/System/disposable_object.h"
 #include "Core/System/event.h"
 #include "Core/System/event_provider.h"
+#include "Core/System/event_wait_set.h"
 #include "Core/System/exception.h"
 #include "Core/System/mutex.h"
 #include "Core/System/runnable.h"
@@ -120,7 +121,9 @@
 #include "Core/XML/xml_tokenizer.h"
 #include "Core/XML/xml_writer.h"
 #include "Core/XML/xml_token.h"
+#include "Core/XML/xml_token_view.h"
 #include "Core/XML/xpath_evaluator.h"
+#include "Core/XML/xpath_expression.h"
 #include "Core/XML/xpath_object.h"
 #include "Core/IOData/file.h"
 #include "Core/IOData/file_help.h"
@@ -190,6 +193,7 @@
 #include "Core/Crypto/aes192_decrypt.h"
 #include "Core/Crypto/aes256_encrypt.h"
 #include "Core/Crypto/aes256_decrypt.h"
+#include "Core/Crypto/aes_ctr.h"
 #include "Core/Crypto/rsa.h"
 #include "Core/Crypto/tls_client.h"
 #include "Core/Math/size.h"
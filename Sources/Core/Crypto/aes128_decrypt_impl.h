@@ -101,9 +101,11 @@ public:
 /// \{
 
 private:
-	void process_chunk();
+	void process_blocks(const unsigned char *data, int num_blocks);
+	void process_chunk(const unsigned char *input);
 
 	ubyte32 key_expanded[aes128_nb_mult_nr_plus1];
+	unsigned char round_keys[aes128_nb_mult_nr_plus1 * 4];	// key_expanded in the byte order used by AES-NI
 
 	unsigned char chunk[aes128_block_size_bytes];
 	ubyte32 initialisation_vector_1;
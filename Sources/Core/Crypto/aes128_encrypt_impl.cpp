@@ -89,6 +89,8 @@ void AES128_Encrypt_Impl::set_key(const unsigned char key[16])
 {
 	cipher_key_set = true;
 	extract_encrypt_key128(key, key_expanded);
+	if (use_aes_ni)
+		get_round_keys(key_expanded, aes128_num_rounds_nr, round_keys);
 }
 
 void AES128_Encrypt_Impl::add(const void *_data, int size)
@@ -106,6 +108,18 @@ void AES128_Encrypt_Impl::add(const void *_data, int size)
 	int pos = 0;
 	while (pos < size)
 	{
+		if (chunk_filled == 0)
+		{
+			// Encrypt the whole blocks directly from the input
+			int num_blocks = (size - pos) / aes128_block_size_bytes;
+			if (num_blocks > 0)
+			{
+				process_blocks(data + pos, num_blocks);
+				pos += num_blocks * aes128_block_size_bytes;
+				continue;
+			}
+		}
+
 		int data_left = size - pos;
 		int buffer_space = aes128_block_size_bytes - chunk_filled;
 		int data_used = min(buffer_space, data_left);
@@ -114,7 +128,7 @@ void AES128_Encrypt_Impl::add(const void *_data, int size)
 		pos += data_used;
 		if (chunk_filled == aes128_block_size_bytes)
 		{
-			process_chunk();
+			process_blocks(chunk, 1);
 			chunk_filled = 0;
 		}
 	}
@@ -133,7 +147,7 @@ void AES128_Encrypt_Impl::calculate()
 			// PKCS#7
 			unsigned char pad_size = aes128_block_size_bytes - chunk_filled;
 			memset(chunk + chunk_filled, pad_size, pad_size);
-			process_chunk();
+			process_blocks(chunk, 1);
 			chunk_filled = 0;
 		}
 		else
@@ -156,28 +170,53 @@ void AES128_Encrypt_Impl::calculate()
 	initialisation_vector_set = false;	// Force to reset after each call
 	cipher_key_set = false;				// Force to reset after each call (to avoid keeping the cipher key in memory)
 	memset(key_expanded, 0, sizeof(key_expanded));	// Remove the key from memory
+	memset(round_keys, 0, sizeof(round_keys));
 }
 
 /////////////////////////////////////////////////////////////////////////////
 // AES128_Encrypt_Impl Implementation:
 
-void AES128_Encrypt_Impl::process_chunk()
+void AES128_Encrypt_Impl::process_blocks(const unsigned char *data, int num_blocks)
+{
+	if (use_aes_ni)
+	{
+		unsigned char iv[16];
+		put_word(initialisation_vector_1, iv);
+		put_word(initialisation_vector_2, iv + 4);
+		put_word(initialisation_vector_3, iv + 8);
+		put_word(initialisation_vector_4, iv + 12);
+
+		aes_ni_encrypt_cbc(round_keys, aes128_num_rounds_nr, iv, data, append_data(databuffer, num_blocks * aes128_block_size_bytes), num_blocks);
+
+		initialisation_vector_1 = get_word(iv);
+		initialisation_vector_2 = get_word(iv + 4);
+		initialisation_vector_3 = get_word(iv + 8);
+		initialisation_vector_4 = get_word(iv + 12);
+	}
+	else
+	{
+		for (int block = 0; block < num_blocks; block++)
+			process_chunk(data + block * aes128_block_size_bytes);
+	}
+}
+
+void AES128_Encrypt_Impl::process_chunk(const unsigned char *input)
 {
 
 	const ubyte32 *key_expanded_ptr = key_expanded;
 
 	/* Electronic Codebook Mode
-	ubyte32 s0 = get_word(chunk) ^ key_expanded_ptr[0];
-	ubyte32 s1 = get_word(chunk + 4) ^ key_expanded_ptr[1];
-	ubyte32 s2 = get_word(chunk + 8) ^ key_expanded_ptr[2];
-	ubyte32 s3 = get_word(chunk + 12) ^ key_expanded_ptr[3];
+	ubyte32 s0 = get_word(input) ^ key_expanded_ptr[0];
+	ubyte32 s1 = get_word(input + 4) ^ key_expanded_ptr[1];
+	ubyte32 s2 = get_word(input + 8) ^ key_expanded_ptr[2];
+	ubyte32 s3 = get_word(input + 12) ^ key_expanded_ptr[3];
 	*/
 
 	// Cipher Block Chaining Mode
-	ubyte32 s0 = initialisation_vector_1 ^ get_word(chunk) ^ key_expanded_ptr[0];
-	ubyte32 s1 = initialisation_vector_2 ^ get_word(chunk + 4) ^ key_expanded_ptr[1];
-	ubyte32 s2 = initialisation_vector_3 ^ get_word(chunk + 8) ^ key_expanded_ptr[2];
-	ubyte32 s3 = initialisation_vector_4 ^ get_word(chunk + 12) ^ key_expanded_ptr[3];
+	ubyte32 s0 = initialisation_vector_1 ^ get_word(input) ^ key_expanded_ptr[0];
+	ubyte32 s1 = initialisation_vector_2 ^ get_word(input + 4) ^ key_expanded_ptr[1];
+	ubyte32 s2 = initialisation_vector_3 ^ get_word(input + 8) ^ key_expanded_ptr[2];
+	ubyte32 s3 = initialisation_vector_4 ^ get_word(input + 12) ^ key_expanded_ptr[3];
 
 	ubyte32 t0;
 	ubyte32 t1;
@@ -87,6 +87,8 @@ void AES192_Decrypt_Impl::set_key(const unsigned char key[24])
 	cipher_key_set = true;
 	extract_encrypt_key192(key, key_expanded);
 	extract_decrypt_key(key_expanded, aes192_num_rounds_nr);
+	if (use_aes_ni)
+		get_round_keys(key_expanded, aes192_num_rounds_nr, round_keys);
 }
 
 void AES192_Decrypt_Impl::add(const void *_data, int size)
@@ -104,6 +106,20 @@ void AES192_Decrypt_Impl::add(const void *_data, int size)
 	int pos = 0;
 	while (pos < size)
 	{
+		if (chunk_filled == 0)
+		{
+			// Decrypt the whole blocks directly from the input. If padding is enabled, keep the last block for calculate()
+			int num_blocks = (size - pos) / aes192_block_size_bytes;
+			if (padding_enabled && (num_blocks * aes192_block_size_bytes == size - pos))
+				num_blocks--;
+			if (num_blocks > 0)
+			{
+				process_blocks(data + pos, num_blocks);
+				pos += num_blocks * aes192_block_size_bytes;
+				continue;
+			}
+		}
+
 		int data_left = size - pos;
 		int buffer_space = aes192_block_size_bytes - chunk_filled;
 		int data_used = min(buffer_space, data_left);
@@ -114,7 +130,7 @@ void AES192_Decrypt_Impl::add(const void *_data, int size)
 		{
 			if ((!padding_enabled) || (pos < size) )	// Do not process chunk on the last block if padding is enabled, as calculate() must process it
 			{
-				process_chunk();
+				process_blocks(chunk, 1);
 				chunk_filled = 0;
 			}
 		}
@@ -133,7 +149,7 @@ bool AES192_Decrypt_Impl::calculate()
 	{
 		if (chunk_filled == aes192_block_size_bytes)
 		{
-			process_chunk();
+			process_blocks(chunk, 1);
 			chunk_filled = 0;
 			int current_size = databuffer.get_size();
 			if (current_size > 0)
@@ -185,6 +201,7 @@ bool AES192_Decrypt_Impl::calculate()
 	initialisation_vector_set = false;	// Force to reset after each call
 	cipher_key_set = false;				// Force to reset after each call (to avoid keeping the cipher key in memory)
 	memset(key_expanded, 0, sizeof(key_expanded));
+	memset(round_keys, 0, sizeof(round_keys));
 
 	return true;
 
@@ -193,14 +210,38 @@ bool AES192_Decrypt_Impl::calculate()
 /////////////////////////////////////////////////////////////////////////////
 // AES192_Decrypt_Impl Implementation:
 
-void AES192_Decrypt_Impl::process_chunk()
+void AES192_Decrypt_Impl::process_blocks(const unsigned char *data, int num_blocks)
+{
+	if (use_aes_ni)
+	{
+		unsigned char iv[16];
+		put_word(initialisation_vector_1, iv);
+		put_word(initialisation_vector_2, iv + 4);
+		put_word(initialisation_vector_3, iv + 8);
+		put_word(initialisation_vector_4, iv + 12);
+
+		aes_ni_decrypt_cbc(round_keys, aes192_num_rounds_nr, iv, data, append_data(databuffer, num_blocks * aes192_block_size_bytes), num_blocks);
+
+		initialisation_vector_1 = get_word(iv);
+		initialisation_vector_2 = get_word(iv + 4);
+		initialisation_vector_3 = get_word(iv + 8);
+		initialisation_vector_4 = get_word(iv + 12);
+	}
+	else
+	{
+		for (int block = 0; block < num_blocks; block++)
+			process_chunk(data + block * aes192_block_size_bytes);
+	}
+}
+
+void AES192_Decrypt_Impl::process_chunk(const unsigned char *input)
 {
 	const ubyte32 *key_expanded_ptr = key_expanded;
 
-	ubyte32 chunk1 = get_word(chunk);
-	ubyte32 chunk2 = get_word(chunk + 4);
-	ubyte32 chunk3 = get_word(chunk + 8);
-	ubyte32 chunk4 = get_word(chunk + 12);
+	ubyte32 chunk1 = get_word(input);
+	ubyte32 chunk2 = get_word(input + 4);
+	ubyte32 chunk3 = get_word(input + 8);
+	ubyte32 chunk4 = get_word(input + 12);
 
 	ubyte32 s0 = chunk1 ^ key_expanded_ptr[0];
 	ubyte32 s1 = chunk2 ^ key_expanded_ptr[1];
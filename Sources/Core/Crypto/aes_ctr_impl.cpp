@@ -0,0 +1,183 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "aes_ctr_impl.h"
+
+#include "../../API/Core/Math/cl_math.h"
+
+#ifndef WIN32
+#include <cstring>
+#endif
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// AES_CTR_Impl Construction:
+
+AES_CTR_Impl::AES_CTR_Impl() : num_rounds(0), initialisation_vector_set(false), cipher_key_set(false)
+{
+	reset();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AES_CTR_Impl Attributes:
+
+DataBuffer AES_CTR_Impl::get_data() const
+{
+	return databuffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AES_CTR_Impl Operations:
+
+void AES_CTR_Impl::reset()
+{
+	calculated = false;
+	memset(key_stream, 0, sizeof(key_stream));
+	key_stream_used = aes128_block_size_bytes;
+	databuffer.set_size(0);
+}
+
+void AES_CTR_Impl::set_iv(const unsigned char iv[16])
+{
+	memcpy(counter, iv, aes128_block_size_bytes);
+	key_stream_used = aes128_block_size_bytes;
+	initialisation_vector_set = true;
+}
+
+void AES_CTR_Impl::set_key(const unsigned char *key, int key_size)
+{
+	switch (key_size)
+	{
+		case aes128_key_length_bytes:
+			extract_encrypt_key128(key, key_expanded);
+			num_rounds = aes128_num_rounds_nr;
+			break;
+		case aes192_key_length_bytes:
+			extract_encrypt_key192(key, key_expanded);
+			num_rounds = aes192_num_rounds_nr;
+			break;
+		case aes256_key_length_bytes:
+			extract_encrypt_key256(key, key_expanded);
+			num_rounds = aes256_num_rounds_nr;
+			break;
+		default:
+			throw Exception("AES key size must be 16, 24 or 32 bytes");
+	}
+
+	cipher_key_set = true;
+	if (use_aes_ni)
+		get_round_keys(key_expanded, num_rounds, round_keys);
+}
+
+void AES_CTR_Impl::add(const void *_data, int size)
+{
+	if (calculated)
+		reset();
+
+	if (!initialisation_vector_set)
+		throw Exception("AES-CTR initialisation vector has not been set");
+
+	if (!cipher_key_set)
+		throw Exception("AES-CTR cipher key has not been set");
+
+	const unsigned char *data = (const unsigned char *) _data;
+	int pos = 0;
+
+	// Use what is left of the key stream from a previous partial block
+	if (key_stream_used < aes128_block_size_bytes && size > 0)
+	{
+		int data_used = min(aes128_block_size_bytes - key_stream_used, size);
+		unsigned char *dest_ptr = append_data(databuffer, data_used);
+		for (int cnt = 0; cnt < data_used; cnt++)
+			dest_ptr[cnt] = data[cnt] ^ key_stream[key_stream_used + cnt];
+		key_stream_used += data_used;
+		pos += data_used;
+	}
+
+	int num_blocks = (size - pos) / aes128_block_size_bytes;
+	if (num_blocks > 0)
+	{
+		process_blocks(data + pos, num_blocks);
+		pos += num_blocks * aes128_block_size_bytes;
+	}
+
+	// Start a new partial block
+	if (pos < size)
+	{
+		encrypt_block(key_expanded, num_rounds, counter, key_stream);
+		increment_counter(counter);
+
+		int data_used = size - pos;
+		unsigned char *dest_ptr = append_data(databuffer, data_used);
+		for (int cnt = 0; cnt < data_used; cnt++)
+			dest_ptr[cnt] = data[pos + cnt] ^ key_stream[cnt];
+		key_stream_used = data_used;
+	}
+}
+
+void AES_CTR_Impl::calculate()
+{
+	if (calculated)
+		reset();
+
+	calculated = true;
+	initialisation_vector_set = false;	// Force to reset after each call
+	cipher_key_set = false;				// Force to reset after each call (to avoid keeping the cipher key in memory)
+	memset(key_expanded, 0, sizeof(key_expanded));	// Remove the key from memory
+	memset(round_keys, 0, sizeof(round_keys));
+	memset(key_stream, 0, sizeof(key_stream));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AES_CTR_Impl Implementation:
+
+void AES_CTR_Impl::process_blocks(const unsigned char *data, int num_blocks)
+{
+	unsigned char *dest_ptr = append_data(databuffer, num_blocks * aes128_block_size_bytes);
+	if (use_aes_ni)
+	{
+		aes_ni_crypt_ctr(round_keys, num_rounds, counter, data, dest_ptr, num_blocks);
+	}
+	else
+	{
+		for (int block = 0; block < num_blocks; block++)
+		{
+			encrypt_block(key_expanded, num_rounds, counter, key_stream);
+			increment_counter(counter);
+			for (int cnt = 0; cnt < aes128_block_size_bytes; cnt++)
+				dest_ptr[cnt] = data[cnt] ^ key_stream[cnt];
+			data += aes128_block_size_bytes;
+			dest_ptr += aes128_block_size_bytes;
+		}
+	}
+}
+
+}
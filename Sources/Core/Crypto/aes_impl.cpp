@@ -31,12 +31,22 @@
 #include "API/Core/System/cl_platform.h"
 #include "API/Core/System/databuffer.h"
 #include "API/Core/Math/cl_math.h"
+#include "API/Core/System/system.h"
 #include "aes_impl.h"
 
 #ifndef WIN32
 #include <cstring>
 #endif
 
+#ifdef CL_AES_NI
+#include <wmmintrin.h>
+#ifdef __GNUC__
+#define cl_aes_ni_target __attribute__((target("sse2,aes")))
+#else
+#define cl_aes_ni_target
+#endif
+#endif
+
 namespace clan
 {
 
@@ -56,6 +66,7 @@ AES_Impl::AES_Impl()
 // AES_Impl Attributes:
 
 bool AES_Impl::is_tables_created = false;
+bool AES_Impl::use_aes_ni = false;
 
 ubyte32 AES_Impl::table_e0[256];
 ubyte32 AES_Impl::table_e1[256];
@@ -190,6 +201,214 @@ void AES_Impl::store_block(ubyte32 s0, ubyte32 s1, ubyte32 s2, ubyte32 s3, DataB
 	put_word(s3, dest_ptr+12);
 }
 
+unsigned char *AES_Impl::append_data(DataBuffer &databuffer, int size)
+{
+	unsigned int current_size = databuffer.get_size();
+	if (current_size + size > databuffer.get_capacity())
+		databuffer.set_capacity(max(current_size + size, current_size + 1024));	// Increase in blocks of at least 1K
+	databuffer.set_size(current_size + size);
+	return (unsigned char *) databuffer.get_data() + current_size;
+}
+
+void AES_Impl::encrypt_block(const ubyte32 *key_expanded, int num_rounds, const unsigned char input[16], unsigned char output[16]) const
+{
+	ubyte32 s0 = get_word(input) ^ key_expanded[0];
+	ubyte32 s1 = get_word(input + 4) ^ key_expanded[1];
+	ubyte32 s2 = get_word(input + 8) ^ key_expanded[2];
+	ubyte32 s3 = get_word(input + 12) ^ key_expanded[3];
+
+	for (int round = 1; round < num_rounds; round++)
+	{
+		key_expanded += 4;
+		ubyte32 t0 = table_e0[s0 >> 24] ^ table_e1[(s1 >> 16) & 0xff] ^ table_e2[(s2 >>  8) & 0xff] ^ table_e3[s3 & 0xff] ^ key_expanded[0];
+		ubyte32 t1 = table_e0[s1 >> 24] ^ table_e1[(s2 >> 16) & 0xff] ^ table_e2[(s3 >>  8) & 0xff] ^ table_e3[s0 & 0xff] ^ key_expanded[1];
+		ubyte32 t2 = table_e0[s2 >> 24] ^ table_e1[(s3 >> 16) & 0xff] ^ table_e2[(s0 >>  8) & 0xff] ^ table_e3[s1 & 0xff] ^ key_expanded[2];
+		ubyte32 t3 = table_e0[s3 >> 24] ^ table_e1[(s0 >> 16) & 0xff] ^ table_e2[(s1 >>  8) & 0xff] ^ table_e3[s2 & 0xff] ^ key_expanded[3];
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	key_expanded += 4;
+
+	// Apply last round
+	put_word((sbox_substitution_values[(s0 >> 24) ] & 0xff000000) ^ (sbox_substitution_values[(s1 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s2 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s3 ) & 0xff] & 0x000000ff) ^ key_expanded[0], output);
+	put_word((sbox_substitution_values[(s1 >> 24) ] & 0xff000000) ^ (sbox_substitution_values[(s2 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s3 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s0 ) & 0xff] & 0x000000ff) ^ key_expanded[1], output + 4);
+	put_word((sbox_substitution_values[(s2 >> 24) ] & 0xff000000) ^ (sbox_substitution_values[(s3 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s0 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s1 ) & 0xff] & 0x000000ff) ^ key_expanded[2], output + 8);
+	put_word((sbox_substitution_values[(s3 >> 24) ] & 0xff000000) ^ (sbox_substitution_values[(s0 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s1 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s2 ) & 0xff] & 0x000000ff) ^ key_expanded[3], output + 12);
+}
+
+void AES_Impl::get_round_keys(const ubyte32 *key_expanded, int num_rounds, unsigned char *round_keys) const
+{
+	for (int cnt = 0; cnt < (num_rounds + 1) * 4; cnt++)
+		put_word(key_expanded[cnt], round_keys + cnt * 4);
+}
+
+void AES_Impl::increment_counter(unsigned char counter[16])
+{
+	for (int cnt = 15; cnt >= 0; cnt--)
+	{
+		if (++counter[cnt])
+			break;
+	}
+}
+
+#ifdef CL_AES_NI
+
+static inline byte64 aes_ni_byte_swap(ubyte64 value)
+{
+#ifdef _MSC_VER
+	return (byte64) _byteswap_uint64(value);
+#else
+	return (byte64) __builtin_bswap64(value);
+#endif
+}
+
+cl_aes_ni_target void AES_Impl::aes_ni_encrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks)
+{
+	__m128i keys[aes256_num_rounds_nr + 1];
+	for (int cnt = 0; cnt <= num_rounds; cnt++)
+		keys[cnt] = _mm_loadu_si128((const __m128i *) (round_keys + cnt * 16));
+
+	// Each block depends on the previous cipher block, so encryption cannot be interleaved
+	__m128i state = _mm_loadu_si128((const __m128i *) iv);
+	for (int block = 0; block < num_blocks; block++)
+	{
+		state = _mm_xor_si128(state, _mm_loadu_si128((const __m128i *) (input + block * 16)));
+		state = _mm_xor_si128(state, keys[0]);
+		for (int round = 1; round < num_rounds; round++)
+			state = _mm_aesenc_si128(state, keys[round]);
+		state = _mm_aesenclast_si128(state, keys[num_rounds]);
+		_mm_storeu_si128((__m128i *) (output + block * 16), state);
+	}
+	_mm_storeu_si128((__m128i *) iv, state);
+}
+
+cl_aes_ni_target void AES_Impl::aes_ni_decrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks)
+{
+	__m128i keys[aes256_num_rounds_nr + 1];
+	for (int cnt = 0; cnt <= num_rounds; cnt++)
+		keys[cnt] = _mm_loadu_si128((const __m128i *) (round_keys + cnt * 16));
+
+	__m128i previous = _mm_loadu_si128((const __m128i *) iv);
+	int block = 0;
+
+	// Decrypt four independent blocks at a time to hide the latency of aesdec
+	for (; block + 4 <= num_blocks; block += 4)
+	{
+		__m128i cipher0 = _mm_loadu_si128((const __m128i *) (input + block * 16));
+		__m128i cipher1 = _mm_loadu_si128((const __m128i *) (input + block * 16 + 16));
+		__m128i cipher2 = _mm_loadu_si128((const __m128i *) (input + block * 16 + 32));
+		__m128i cipher3 = _mm_loadu_si128((const __m128i *) (input + block * 16 + 48));
+
+		__m128i state0 = _mm_xor_si128(cipher0, keys[0]);
+		__m128i state1 = _mm_xor_si128(cipher1, keys[0]);
+		__m128i state2 = _mm_xor_si128(cipher2, keys[0]);
+		__m128i state3 = _mm_xor_si128(cipher3, keys[0]);
+		for (int round = 1; round < num_rounds; round++)
+		{
+			state0 = _mm_aesdec_si128(state0, keys[round]);
+			state1 = _mm_aesdec_si128(state1, keys[round]);
+			state2 = _mm_aesdec_si128(state2, keys[round]);
+			state3 = _mm_aesdec_si128(state3, keys[round]);
+		}
+		state0 = _mm_aesdeclast_si128(state0, keys[num_rounds]);
+		state1 = _mm_aesdeclast_si128(state1, keys[num_rounds]);
+		state2 = _mm_aesdeclast_si128(state2, keys[num_rounds]);
+		state3 = _mm_aesdeclast_si128(state3, keys[num_rounds]);
+
+		_mm_storeu_si128((__m128i *) (output + block * 16), _mm_xor_si128(state0, previous));
+		_mm_storeu_si128((__m128i *) (output + block * 16 + 16), _mm_xor_si128(state1, cipher0));
+		_mm_storeu_si128((__m128i *) (output + block * 16 + 32), _mm_xor_si128(state2, cipher1));
+		_mm_storeu_si128((__m128i *) (output + block * 16 + 48), _mm_xor_si128(state3, cipher2));
+		previous = cipher3;
+	}
+
+	for (; block < num_blocks; block++)
+	{
+		__m128i cipher = _mm_loadu_si128((const __m128i *) (input + block * 16));
+		__m128i state = _mm_xor_si128(cipher, keys[0]);
+		for (int round = 1; round < num_rounds; round++)
+			state = _mm_aesdec_si128(state, keys[round]);
+		state = _mm_aesdeclast_si128(state, keys[num_rounds]);
+		_mm_storeu_si128((__m128i *) (output + block * 16), _mm_xor_si128(state, previous));
+		previous = cipher;
+	}
+
+	_mm_storeu_si128((__m128i *) iv, previous);
+}
+
+cl_aes_ni_target void AES_Impl::aes_ni_crypt_ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], const unsigned char *input, unsigned char *output, int num_blocks)
+{
+	__m128i keys[aes256_num_rounds_nr + 1];
+	for (int cnt = 0; cnt <= num_rounds; cnt++)
+		keys[cnt] = _mm_loadu_si128((const __m128i *) (round_keys + cnt * 16));
+
+	// Keep the big endian counter as two native 64 bit halves
+	ubyte64 counter_high = 0;
+	ubyte64 counter_low = 0;
+	for (int cnt = 0; cnt < 8; cnt++)
+	{
+		counter_high = (counter_high << 8) | counter[cnt];
+		counter_low = (counter_low << 8) | counter[cnt + 8];
+	}
+
+	int block = 0;
+	while (block < num_blocks)
+	{
+		// Encrypt up to four counter blocks at a time, they are independent of each other
+		int group_size = min(num_blocks - block, 4);
+		__m128i state[4];
+		for (int cnt = 0; cnt < 4; cnt++)
+		{
+			state[cnt] = _mm_xor_si128(_mm_set_epi64x(aes_ni_byte_swap(counter_low), aes_ni_byte_swap(counter_high)), keys[0]);
+			if (cnt < group_size && ++counter_low == 0)
+				counter_high++;
+		}
+		for (int round = 1; round < num_rounds; round++)
+		{
+			state[0] = _mm_aesenc_si128(state[0], keys[round]);
+			state[1] = _mm_aesenc_si128(state[1], keys[round]);
+			state[2] = _mm_aesenc_si128(state[2], keys[round]);
+			state[3] = _mm_aesenc_si128(state[3], keys[round]);
+		}
+		for (int cnt = 0; cnt < group_size; cnt++, block++)
+		{
+			__m128i key_stream = _mm_aesenclast_si128(state[cnt], keys[num_rounds]);
+			__m128i data = _mm_loadu_si128((const __m128i *) (input + block * 16));
+			_mm_storeu_si128((__m128i *) (output + block * 16), _mm_xor_si128(data, key_stream));
+		}
+	}
+
+	for (int cnt = 7; cnt >= 0; cnt--)
+	{
+		counter[cnt] = (unsigned char) counter_high;
+		counter[cnt + 8] = (unsigned char) counter_low;
+		counter_high >>= 8;
+		counter_low >>= 8;
+	}
+}
+
+#else
+
+void AES_Impl::aes_ni_encrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks)
+{
+	throw Exception("AES-NI is not available");
+}
+
+void AES_Impl::aes_ni_decrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks)
+{
+	throw Exception("AES-NI is not available");
+}
+
+void AES_Impl::aes_ni_crypt_ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], const unsigned char *input, unsigned char *output, int num_blocks)
+{
+	throw Exception("AES-NI is not available");
+}
+
+#endif
+
 void AES_Impl::extract_decrypt_key(ubyte32 *key_expanded, int num_rounds)
 {
 	// Invert the order of the round keys
@@ -233,6 +452,10 @@ void AES_Impl::extract_decrypt_key(ubyte32 *key_expanded, int num_rounds)
 
 void AES_Impl::create_tables()
 {
+#ifdef CL_AES_NI
+	use_aes_ni = System::detect_cpu_extension(System::sse2) && System::detect_cpu_extension(System::aes);
+#endif
+
 	int power[256];
     int logarithm[256];
 
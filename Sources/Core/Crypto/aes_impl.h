@@ -29,6 +29,11 @@
 
 #pragma once
 
+// AES-NI is used when compiling for x86 (and the CPU supports it at runtime)
+#if !defined(CL_DISABLE_SSE2) && (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
+#define CL_AES_NI
+#endif
+
 namespace clan
 {
 
@@ -79,6 +84,9 @@ public:
 	static ubyte32 table_d1[256];
 	static ubyte32 table_d2[256];
 	static ubyte32 table_d3[256];
+
+	/// \brief True when the CPU supports the AES-NI instructions (detected by create_tables())
+	static bool use_aes_ni;
 /// \}
 /// \name Operations
 /// \{
@@ -90,6 +98,29 @@ public:
 	void extract_decrypt_key(ubyte32 *key_expanded, int num_rounds);
 	void store_block(ubyte32 s0, ubyte32 s1, ubyte32 s2, ubyte32 s3, DataBuffer &databuffer);
 
+	/// \brief Grow the databuffer by size bytes and return a pointer to the new data
+	static unsigned char *append_data(DataBuffer &databuffer, int size);
+
+	/// \brief Encrypt a single block using the tables (for any key size)
+	void encrypt_block(const ubyte32 *key_expanded, int num_rounds, const unsigned char input[16], unsigned char output[16]) const;
+
+	/// \brief Convert the expanded key to the byte order used by the AES-NI functions
+	void get_round_keys(const ubyte32 *key_expanded, int num_rounds, unsigned char *round_keys) const;
+
+	/// \brief Encrypt blocks in Cipher Block Chaining mode using AES-NI. iv is updated to the last cipher block
+	static void aes_ni_encrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks);
+
+	/// \brief Decrypt blocks in Cipher Block Chaining mode using AES-NI, four blocks at a time. iv is updated to the last cipher block
+	///
+	/// round_keys must be created from an expanded key passed through extract_decrypt_key()
+	static void aes_ni_decrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks);
+
+	/// \brief Encrypt or decrypt blocks in Counter mode using AES-NI, four blocks at a time. counter is updated to the next counter block
+	static void aes_ni_crypt_ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], const unsigned char *input, unsigned char *output, int num_blocks);
+
+	/// \brief Increment a counter block (the full 128 bits, big endian)
+	static void increment_counter(unsigned char counter[16]);
+
 	inline ubyte32 get_word(const unsigned char *data) const
 	{
 		return ( (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | (data[3]) );
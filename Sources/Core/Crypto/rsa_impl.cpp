@@ -223,6 +223,43 @@ void RSA_Impl::rsadp(BigInt *cipher, const BigInt *d, const BigInt *modulus, Big
 	cipher->exptmod(d, modulus, msg);
 }
 
+void RSA_Impl::rsadp_crt(BigInt *cipher, const BigInt *d, const BigInt *p, const BigInt *q, const BigInt *modulus, BigInt *msg)
+{
+	// Insure that ciphertext representative is in range of modulus
+	if((cipher->cmp_z() < 0) || (cipher->cmp(modulus) >= 0))
+	{
+		throw Exception("ciphertext is out of range of modulus");
+	}
+
+	BigInt psub1(*p), qsub1(*q), dp, dq, qinv;
+
+	// Make sure the primes belong to this modulus, a mismatch would give garbage (and can leak the key)
+	BigInt n = psub1 * (*q);
+	if (n.cmp(modulus) != 0)
+		throw Exception("primes do not match the modulus");
+
+	// 1.  Compute dp = d mod (p-1), dq = d mod (q-1) and qinv = q**-1 mod p
+	psub1 -= 1;
+	qsub1 -= 1;
+	d->mod(&psub1, &dp);
+	d->mod(&qsub1, &dq);
+	if (!q->invmod(p, &qinv))
+		throw Exception("primes are not coprime");
+
+	// 2.  Compute m1 = c**dp mod p and m2 = c**dq mod q
+	BigInt m1, m2, h;
+	cipher->exptmod(&dp, p, &m1);
+	cipher->exptmod(&dq, q, &m2);
+
+	// 3.  Compute h = qinv * (m1 - m2) mod p
+	h = m1 - m2;
+	h = h * qinv;
+	h.mod(p, &h);
+
+	// 4.  Compute m = m2 + h * q
+	*msg = m2 + h * (*q);
+}
+
 void RSA_Impl::pkcs1v15_encode(int block_type, Random &random, const char *msg, int mlen, char *emsg, int emlen)
 {
 	if(mlen > emlen - 11)
@@ -357,6 +394,71 @@ Secret RSA_Impl::decrypt(const Secret &in_private_exponent, const void *in_modul
 	return pkcs1v15_decrypt((const char *) in_data, in_data_size, &exponent, &modulus);
 }
 
+Secret RSA_Impl::decrypt_crt(const Secret &in_private_exponent, const Secret &in_prime1, const Secret &in_prime2, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size)
+{
+	BigInt exponent;
+	exponent.read_unsigned_octets((const unsigned char *) in_private_exponent.get_data(), in_private_exponent.get_size());
+
+	BigInt p, q;
+	p.read_unsigned_octets((const unsigned char *) in_prime1.get_data(), in_prime1.get_size());
+	q.read_unsigned_octets((const unsigned char *) in_prime2.get_data(), in_prime2.get_size());
+
+	BigInt modulus;
+	modulus.read_unsigned_octets((const unsigned char *) in_modulus, in_modulus_size);
+
+	int k = modulus.unsigned_octet_size();		// size of modulus, in bytes
+	if((int) in_data_size != k)
+		throw Exception("Invalid message length");
+
+	BigInt mrep;
+	mrep.read_unsigned_octets((const unsigned char *) in_data, in_data_size);
+
+	rsadp_crt(&mrep, &exponent, &p, &q, &modulus, &mrep);
+
+	Secret key_buffer(k);
+	mrep.to_unsigned_octets(key_buffer.get_data(), k);
+	return pkcs1v15_decode( (char *) key_buffer.get_data(), k);
+}
+
+DataBuffer RSA_Impl::sign_crt(const Secret &in_private_exponent, const Secret &in_prime1, const Secret &in_prime2, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size)
+{
+	BigInt exponent;
+	exponent.read_unsigned_octets((const unsigned char *) in_private_exponent.get_data(), in_private_exponent.get_size());
+
+	BigInt p, q;
+	p.read_unsigned_octets((const unsigned char *) in_prime1.get_data(), in_prime1.get_size());
+	q.read_unsigned_octets((const unsigned char *) in_prime2.get_data(), in_prime2.get_size());
+
+	BigInt modulus;
+	modulus.read_unsigned_octets((const unsigned char *) in_modulus, in_modulus_size);
+
+	int k = modulus.unsigned_octet_size();	// length of modulus, in bytes
+
+	Secret key(k);
+
+	// Encode according to PKCS #1 v1.5, block type 1 (the padding does not use the random number generator)
+	Random random;
+	pkcs1v15_encode(1, random, (const char *) in_data, in_data_size, (char *) key.get_data(), k);
+
+	BigInt mrep;
+	mrep.read_unsigned_octets(key.get_data(), key.get_size());
+
+	rsadp_crt(&mrep, &exponent, &p, &q, &modulus, &mrep);
+
+	DataBuffer buffer(k);
+	mrep.to_unsigned_octets((unsigned char *) buffer.get_data(), buffer.get_size());
+	return buffer;
+}
+
+void RSA_Impl::get_primes(Secret &out_prime1, Secret &out_prime2) const
+{
+	out_prime1 = Secret(rsa_private_key.prime1.unsigned_octet_size());
+	rsa_private_key.prime1.to_unsigned_octets(out_prime1.get_data(), out_prime1.get_size());
+
+	out_prime2 = Secret(rsa_private_key.prime2.unsigned_octet_size());
+	rsa_private_key.prime2.to_unsigned_octets(out_prime2.get_data(), out_prime2.get_size());
+}
+
 void RSA_Impl::create_keypair(Random &random, Secret &out_private_exponent, DataBuffer &out_public_exponent, DataBuffer &out_modulus, int key_size_in_bits, int public_exponent_value)
 {
 	create(random, key_size_in_bits, public_exponent_value);
@@ -84,6 +84,11 @@ public:
 
 	static DataBuffer encrypt(int block_type, Random &random, const void *in_public_exponent, unsigned int in_public_exponent_size, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
 	static Secret decrypt(const Secret &in_private_exponent, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
+	static Secret decrypt_crt(const Secret &in_private_exponent, const Secret &in_prime1, const Secret &in_prime2, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
+	static DataBuffer sign_crt(const Secret &in_private_exponent, const Secret &in_prime1, const Secret &in_prime2, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
+
+	/// \brief Get the primes of the key created by create()
+	void get_primes(Secret &out_prime1, Secret &out_prime2) const;
 
 /// \}
 /// \name Operations
@@ -114,6 +119,11 @@ private:
 	static void rsaep(BigInt *msg, const BigInt *e, const BigInt *modulus, BigInt *cipher);
 	static void rsadp(BigInt *cipher, const BigInt *d, const BigInt *modulus, BigInt *msg);
 
+	// RSA decryption primitive using the Chinese Remainder Theorem
+	// d         - decryption exponent
+	// p, q      - prime factors of the modulus
+	static void rsadp_crt(BigInt *cipher, const BigInt *d, const BigInt *p, const BigInt *q, const BigInt *modulus, BigInt *msg);
+
 	// PKCS#1 v.1.5 message padding and encoding
 	// msg       - input message
 	// mlen      - length of input message, in bytes
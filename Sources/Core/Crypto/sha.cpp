@@ -31,10 +31,55 @@
 #include "sha.h"
 
 #include "../../API/Core/Math/cl_math.h"
+#include "../../API/Core/System/system.h"
+
+#ifdef CL_SHA_NI
+#include <immintrin.h>
+#ifdef __GNUC__
+#define cl_sha_ni_target __attribute__((target("sse4.1,ssse3,sha")))
+#define cl_sha_avx2_target __attribute__((target("avx2")))
+#else
+#define cl_sha_ni_target
+#define cl_sha_avx2_target
+#endif
+#endif
 
 namespace clan
 {
 
+bool SHA::is_extensions_detected = false;
+bool SHA::use_sha_ni = false;
+bool SHA::use_avx2 = false;
+
+// Constants defined in FIPS 180-3, section 4.2.2
+const ubyte32 SHA::sha256_constant_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+	0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+	0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+	0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+	0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+	0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+	0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+	0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+	0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+void SHA::detect_extensions()
+{
+	if (is_extensions_detected)
+		return;
+
+#ifdef CL_SHA_NI
+	use_sha_ni = System::detect_cpu_extension(System::ssse3) && System::detect_cpu_extension(System::sse4_1) && System::detect_cpu_extension(System::sha);
+	use_avx2 = System::detect_cpu_extension(System::avx) && System::detect_cpu_extension(System::avx2);
+#endif
+	is_extensions_detected = true;
+}
+
 void SHA::to_hex_le(char *buffer, ubyte32 value, bool uppercase) const
 {
 	ubyte32 values[4];
@@ -96,4 +141,250 @@ void SHA::to_hex64_be(char *buffer, ubyte64 value, bool uppercase) const
 	}
 }
 
+#ifdef CL_SHA_NI
+
+cl_sha_ni_target void SHA::sha_ni_process_sha1(ubyte32 state[5], const unsigned char *data, int num_blocks)
+{
+	const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607ll, 0x08090a0b0c0d0e0fll);
+
+	// The instructions expect a in the highest word
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0x1b);
+	__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+// Computes the next four message words from the previous sixteen (w0 is replaced)
+#define cl_sha1_ni_schedule(w0, w1, w2, w3) \
+	w0 = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w0, w1), w2), w3)
+
+// Performs four rounds, the round function selector has to be an immediate
+#define cl_sha1_ni_rounds(w, func) \
+	e = _mm_sha1nexte_epu32(abcd_previous, w); \
+	abcd_previous = abcd; \
+	abcd = _mm_sha1rnds4_epu32(abcd, e, func)
+
+	for (int block = 0; block < num_blocks; block++, data += 64)
+	{
+		__m128i abcd_save = abcd;
+		__m128i e_save = e0;
+
+		__m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data), byte_swap);
+		__m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), byte_swap);
+		__m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), byte_swap);
+		__m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), byte_swap);
+
+		// Rounds 0 to 19
+		__m128i e = _mm_add_epi32(e0, w0);
+		__m128i abcd_previous = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+		cl_sha1_ni_rounds(w1, 0);
+		cl_sha1_ni_rounds(w2, 0);
+		cl_sha1_ni_rounds(w3, 0);
+		cl_sha1_ni_schedule(w0, w1, w2, w3); cl_sha1_ni_rounds(w0, 0);
+
+		// Rounds 20 to 39
+		cl_sha1_ni_schedule(w1, w2, w3, w0); cl_sha1_ni_rounds(w1, 1);
+		cl_sha1_ni_schedule(w2, w3, w0, w1); cl_sha1_ni_rounds(w2, 1);
+		cl_sha1_ni_schedule(w3, w0, w1, w2); cl_sha1_ni_rounds(w3, 1);
+		cl_sha1_ni_schedule(w0, w1, w2, w3); cl_sha1_ni_rounds(w0, 1);
+		cl_sha1_ni_schedule(w1, w2, w3, w0); cl_sha1_ni_rounds(w1, 1);
+
+		// Rounds 40 to 59
+		cl_sha1_ni_schedule(w2, w3, w0, w1); cl_sha1_ni_rounds(w2, 2);
+		cl_sha1_ni_schedule(w3, w0, w1, w2); cl_sha1_ni_rounds(w3, 2);
+		cl_sha1_ni_schedule(w0, w1, w2, w3); cl_sha1_ni_rounds(w0, 2);
+		cl_sha1_ni_schedule(w1, w2, w3, w0); cl_sha1_ni_rounds(w1, 2);
+		cl_sha1_ni_schedule(w2, w3, w0, w1); cl_sha1_ni_rounds(w2, 2);
+
+		// Rounds 60 to 79
+		cl_sha1_ni_schedule(w3, w0, w1, w2); cl_sha1_ni_rounds(w3, 3);
+		cl_sha1_ni_schedule(w0, w1, w2, w3); cl_sha1_ni_rounds(w0, 3);
+		cl_sha1_ni_schedule(w1, w2, w3, w0); cl_sha1_ni_rounds(w1, 3);
+		cl_sha1_ni_schedule(w2, w3, w0, w1); cl_sha1_ni_rounds(w2, 3);
+		cl_sha1_ni_schedule(w3, w0, w1, w2); cl_sha1_ni_rounds(w3, 3);
+
+		e0 = _mm_sha1nexte_epu32(abcd_previous, e_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+
+#undef cl_sha1_ni_schedule
+#undef cl_sha1_ni_rounds
+
+	_mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1b));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+
+cl_sha_ni_target void SHA::sha_ni_process_sha256(ubyte32 state[8], const unsigned char *data, int num_blocks)
+{
+	const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+
+	// The instructions operate on the state as ABEF and CDGH
+	__m128i temp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0xb1);
+	__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) (state + 4)), 0x1b);
+	__m128i state0 = _mm_alignr_epi8(temp, state1, 8);
+	state1 = _mm_blend_epi16(state1, temp, 0xf0);
+
+// Computes the next four message words from the previous sixteen (w0 is replaced)
+#define cl_sha256_ni_schedule(w0, w1, w2, w3) \
+	w0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4)), w3)
+
+// Performs four rounds using the message words of the given group
+#define cl_sha256_ni_rounds(w, group) \
+	message = _mm_add_epi32(w, _mm_loadu_si128((const __m128i *) (sha256_constant_k + (group) * 4))); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, message); \
+	state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(message, 0x0e))
+
+	for (int block = 0; block < num_blocks; block++, data += 64)
+	{
+		__m128i abef_save = state0;
+		__m128i cdgh_save = state1;
+		__m128i message;
+
+		__m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data), byte_swap);
+		__m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), byte_swap);
+		__m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), byte_swap);
+		__m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), byte_swap);
+
+		cl_sha256_ni_rounds(w0, 0);
+		cl_sha256_ni_rounds(w1, 1);
+		cl_sha256_ni_rounds(w2, 2);
+		cl_sha256_ni_rounds(w3, 3);
+
+		for (int group = 4; group < 16; group += 4)
+		{
+			cl_sha256_ni_schedule(w0, w1, w2, w3); cl_sha256_ni_rounds(w0, group);
+			cl_sha256_ni_schedule(w1, w2, w3, w0); cl_sha256_ni_rounds(w1, group + 1);
+			cl_sha256_ni_schedule(w2, w3, w0, w1); cl_sha256_ni_rounds(w2, group + 2);
+			cl_sha256_ni_schedule(w3, w0, w1, w2); cl_sha256_ni_rounds(w3, group + 3);
+		}
+
+		state0 = _mm_add_epi32(state0, abef_save);
+		state1 = _mm_add_epi32(state1, cdgh_save);
+	}
+
+#undef cl_sha256_ni_schedule
+#undef cl_sha256_ni_rounds
+
+	temp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	_mm_storeu_si128((__m128i *) state, _mm_blend_epi16(temp, state1, 0xf0));
+	_mm_storeu_si128((__m128i *) (state + 4), _mm_alignr_epi8(state1, temp, 8));
+}
+
+static inline cl_sha_avx2_target __m256i sha_avx2_rightrotate(__m256i value, int shift)
+{
+	return _mm256_or_si256(_mm256_srli_epi32(value, shift), _mm256_slli_epi32(value, 32 - shift));
+}
+
+cl_sha_avx2_target void SHA::avx2_process_sha256_x8(ubyte32 state[64], const unsigned char * const data[8], int num_blocks)
+{
+	const __m256i byte_swap = _mm256_set_epi8(
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+	__m256i h[8];
+	for (int cnt = 0; cnt < 8; cnt++)
+		h[cnt] = _mm256_loadu_si256((const __m256i *) (state + cnt * 8));
+
+	for (int block = 0; block < num_blocks; block++)
+	{
+		// Load the message words and transpose them so that each register holds one word for all eight lanes
+		__m256i w[16];
+		for (int half = 0; half < 2; half++)
+		{
+			__m256i r[8];
+			for (int lane = 0; lane < 8; lane++)
+				r[lane] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) (data[lane] + block * 64 + half * 32)), byte_swap);
+
+			__m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+			__m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+			__m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+			__m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+			__m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+			__m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+			__m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+			__m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+			__m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+			__m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+			__m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+			__m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+			__m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+			__m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+			__m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+			__m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+			__m256i *out = w + half * 8;
+			out[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+			out[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+			out[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+			out[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+			out[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+			out[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+			out[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+			out[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+		}
+
+		__m256i a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+
+		for (int i = 0; i < 64; i++)
+		{
+			if (i >= 16)
+			{
+				__m256i w2 = w[(i - 2) & 15];
+				__m256i w15 = w[(i - 15) & 15];
+				__m256i s1 = _mm256_xor_si256(_mm256_xor_si256(sha_avx2_rightrotate(w2, 17), sha_avx2_rightrotate(w2, 19)), _mm256_srli_epi32(w2, 10));
+				__m256i s0 = _mm256_xor_si256(_mm256_xor_si256(sha_avx2_rightrotate(w15, 7), sha_avx2_rightrotate(w15, 18)), _mm256_srli_epi32(w15, 3));
+				w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(s1, w[(i - 7) & 15]), _mm256_add_epi32(s0, w[i & 15]));
+			}
+
+			__m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(sha_avx2_rightrotate(e, 6), sha_avx2_rightrotate(e, 11)), sha_avx2_rightrotate(e, 25));
+			__m256i ch = _mm256_xor_si256(_mm256_and_si256(e, _mm256_xor_si256(f, g)), g);
+			__m256i t1 = _mm256_add_epi32(_mm256_add_epi32(hh, sigma1), _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32(sha256_constant_k[i]), w[i & 15])));
+
+			__m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(sha_avx2_rightrotate(a, 2), sha_avx2_rightrotate(a, 13)), sha_avx2_rightrotate(a, 22));
+			__m256i maj = _mm256_or_si256(_mm256_and_si256(a, _mm256_or_si256(b, c)), _mm256_and_si256(b, c));
+			__m256i t2 = _mm256_add_epi32(sigma0, maj);
+
+			hh = g;
+			g = f;
+			f = e;
+			e = _mm256_add_epi32(d, t1);
+			d = c;
+			c = b;
+			b = a;
+			a = _mm256_add_epi32(t1, t2);
+		}
+
+		h[0] = _mm256_add_epi32(h[0], a);
+		h[1] = _mm256_add_epi32(h[1], b);
+		h[2] = _mm256_add_epi32(h[2], c);
+		h[3] = _mm256_add_epi32(h[3], d);
+		h[4] = _mm256_add_epi32(h[4], e);
+		h[5] = _mm256_add_epi32(h[5], f);
+		h[6] = _mm256_add_epi32(h[6], g);
+		h[7] = _mm256_add_epi32(h[7], hh);
+	}
+
+	for (int cnt = 0; cnt < 8; cnt++)
+		_mm256_storeu_si256((__m256i *) (state + cnt * 8), h[cnt]);
+}
+
+#else
+
+void SHA::sha_ni_process_sha1(ubyte32 state[5], const unsigned char *data, int num_blocks)
+{
+	throw Exception("SHA-NI is not available");
+}
+
+void SHA::sha_ni_process_sha256(ubyte32 state[8], const unsigned char *data, int num_blocks)
+{
+	throw Exception("SHA-NI is not available");
+}
+
+void SHA::avx2_process_sha256_x8(ubyte32 state[64], const unsigned char * const data[8], int num_blocks)
+{
+	throw Exception("AVX2 is not available");
+}
+
+#endif
+
 }
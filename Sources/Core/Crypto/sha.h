@@ -31,6 +31,11 @@
 
 #include "API/Core/System/cl_platform.h"
 
+// SHA-NI and AVX2 kernels are used when compiling for x86 (and the CPU supports them at runtime)
+#if !defined(CL_DISABLE_SSE2) && (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
+#define CL_SHA_NI
+#endif
+
 namespace clan
 {
 
@@ -116,6 +121,26 @@ public:
 	void to_hex_le(char *buffer, ubyte32 value, bool uppercase) const;
 	void to_hex64_be(char *buffer, ubyte64 value, bool uppercase) const;
 
+	/// \brief Detect the instruction set extensions used by the hash kernels (only performed once)
+	static void detect_extensions();
+
+	/// \brief Process whole 64 byte blocks using the SHA-NI instructions (state is h0 to h4)
+	static void sha_ni_process_sha1(ubyte32 state[5], const unsigned char *data, int num_blocks);
+
+	/// \brief Process whole 64 byte blocks using the SHA-NI instructions (state is h0 to h7)
+	static void sha_ni_process_sha256(ubyte32 state[8], const unsigned char *data, int num_blocks);
+
+	/// \brief Process whole 64 byte blocks of eight independent SHA-256 messages using AVX2
+	///
+	/// The state is stored word major, state[word * 8 + lane]. Each lane reads num_blocks consecutive blocks from data[lane]
+	static void avx2_process_sha256_x8(ubyte32 state[64], const unsigned char * const data[8], int num_blocks);
+
+	/// \brief The SHA-224 and SHA-256 round constants
+	static const ubyte32 sha256_constant_k[64];
+
+	static bool is_extensions_detected;
+	static bool use_sha_ni;
+	static bool use_avx2;
 };
 
 }
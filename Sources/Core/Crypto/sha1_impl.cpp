@@ -44,6 +44,7 @@ namespace clan
 
 SHA1_Impl::SHA1_Impl()
 {
+	detect_extensions();
 	reset();
 }
 
@@ -118,20 +119,31 @@ void SHA1_Impl::add(const void *_data, int size)
 
 	const unsigned char *data = (const unsigned char *) _data;
 	int pos = 0;
-	while (pos < size)
+
+	// Complete a partially filled chunk first
+	if (chunk_filled > 0)
 	{
-		int data_left = size - pos;
-		int buffer_space = block_size - chunk_filled;
-		int data_used = min(buffer_space, data_left);
-		memcpy(chunk + chunk_filled, data + pos, data_used);
+		int data_used = min(block_size - chunk_filled, size);
+		memcpy(chunk + chunk_filled, data, data_used);
 		chunk_filled += data_used;
 		pos += data_used;
 		if (chunk_filled == block_size)
 		{
-			process_chunk();
+			process_blocks(chunk, 1);
 			chunk_filled = 0;
 		}
 	}
+
+	// Whole blocks are hashed directly from the input
+	int num_blocks = (size - pos) / block_size;
+	if (num_blocks > 0)
+	{
+		process_blocks(data + pos, num_blocks);
+		pos += num_blocks * block_size;
+	}
+
+	memcpy(chunk + chunk_filled, data + pos, size - pos);
+	chunk_filled += size - pos;
 	length_message += size * (ubyte64) 8;
 }
 
@@ -221,17 +233,36 @@ void SHA1_Impl::calculate()
 /////////////////////////////////////////////////////////////////////////////
 // SHA1_Impl Implementation:
 
-void SHA1_Impl::process_chunk()
+void SHA1_Impl::process_blocks(const unsigned char *data, int num_blocks)
+{
+	if (use_sha_ni)
+	{
+		ubyte32 state[5] = { h0, h1, h2, h3, h4 };
+		sha_ni_process_sha1(state, data, num_blocks);
+		h0 = state[0];
+		h1 = state[1];
+		h2 = state[2];
+		h3 = state[3];
+		h4 = state[4];
+	}
+	else
+	{
+		for (int cnt = 0; cnt < num_blocks; cnt++)
+			process_chunk(data + cnt * block_size);
+	}
+}
+
+void SHA1_Impl::process_chunk(const unsigned char *input)
 {
 	int i;
 	unsigned int w[80];
 
 	for (i = 0; i < 16; i++)
 	{
-		unsigned int b1 = chunk[i*4];
-		unsigned int b2 = chunk[i*4+1];
-		unsigned int b3 = chunk[i*4+2];
-		unsigned int b4 = chunk[i*4+3];
+		unsigned int b1 = input[i*4];
+		unsigned int b2 = input[i*4+1];
+		unsigned int b3 = input[i*4+2];
+		unsigned int b4 = input[i*4+3];
 		w[i] = (b1 << 24) + (b2 << 16) + (b3 << 8) + b4;
 	}
 	
@@ -71,7 +71,8 @@ public:
 /// \{
 
 private:
-	void process_chunk();
+	void process_blocks(const unsigned char *data, int num_blocks);
+	void process_chunk(const unsigned char *input);
 
 	inline unsigned int leftrotate_uint32(unsigned int value, int shift) const
 	{
@@ -79,6 +79,23 @@ void SHA256::calculate()
 	impl->calculate();
 }
 
+void SHA256::hash_multiple(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+{
+	SHA256_Impl::hash_multiple(count, data, sizes, out_hashes);
+}
+
+bool SHA256::is_avx2_supported()
+{
+	return SHA256_Impl::is_avx2_supported();
+}
+
+void SHA256::hash_multiple_avx2(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+{
+	if (!SHA256_Impl::is_avx2_supported())
+		throw Exception("SHA256: AVX2 is not supported on this computer");
+	SHA256_Impl::hash_multiple_avx2(count, data, sizes, out_hashes);
+}
+
 void SHA256::set_hmac(const void *key_data, int key_size)
 {
 	impl->set_hmac(key_data, key_size);
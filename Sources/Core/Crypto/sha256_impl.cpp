@@ -46,6 +46,7 @@ namespace clan
 
 SHA256_Impl::SHA256_Impl(cl_sha_type new_sha_type) : sha_type(new_sha_type)
 {
+	detect_extensions();
 	reset();
 }
 
@@ -169,20 +170,31 @@ void SHA256_Impl::add(const void *_data, int size)
 
 	const unsigned char *data = (const unsigned char *) _data;
 	int pos = 0;
-	while (pos < size)
+
+	// Complete a partially filled chunk first
+	if (chunk_filled > 0)
 	{
-		int data_left = size - pos;
-		int buffer_space = block_size - chunk_filled;
-		int data_used = min(buffer_space, data_left);
-		memcpy(chunk + chunk_filled, data + pos, data_used);
+		int data_used = min(block_size - chunk_filled, size);
+		memcpy(chunk + chunk_filled, data, data_used);
 		chunk_filled += data_used;
 		pos += data_used;
 		if (chunk_filled == block_size)
 		{
-			process_chunk();
+			process_blocks(chunk, 1);
 			chunk_filled = 0;
 		}
 	}
+
+	// Whole blocks are hashed directly from the input
+	int num_blocks = (size - pos) / block_size;
+	if (num_blocks > 0)
+	{
+		process_blocks(data + pos, num_blocks);
+		pos += num_blocks * block_size;
+	}
+
+	memcpy(chunk + chunk_filled, data + pos, size - pos);
+	chunk_filled += size - pos;
 	length_message += size * (ubyte64) 8;
 }
 
@@ -298,37 +310,175 @@ void SHA256_Impl::calculate()
 	}
 }
 
+void SHA256_Impl::hash_multiple(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+{
+	detect_extensions();
+
+	// The SHA-NI path is faster per message than eight AVX2 lanes, and a single message would leave most lanes idle
+	if (use_avx2 && !use_sha_ni && count > 1)
+	{
+		hash_multiple_avx2(count, data, sizes, out_hashes);
+		return;
+	}
+
+	SHA256_Impl sha256(cl_sha_256);
+	for (int cnt = 0; cnt < count; cnt++)
+	{
+		sha256.reset();
+		sha256.add(data[cnt], sizes[cnt]);
+		sha256.calculate();
+		sha256.get_hash(out_hashes + cnt * SHA256::hash_size);
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // SHA256_Impl Implementation:
 
-void SHA256_Impl::process_chunk()
+void SHA256_Impl::hash_multiple_avx2(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+{
+	static const ubyte32 initial_state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	const int num_lanes = 8;
+
+	// Each lane hashes the whole blocks directly from its message, followed by the padded tail
+	ubyte32 state[8 * num_lanes];
+	const unsigned char *lane_data[num_lanes];
+	int lane_message[num_lanes];
+	int lane_blocks_left[num_lanes];
+	int lane_tail_blocks[num_lanes];
+	unsigned char lane_tail[num_lanes][block_size * 2];
+
+	int next_message = 0;
+	for (int lane = 0; lane < num_lanes; lane++)
+		lane_message[lane] = -1;
+
+	while (true)
+	{
+		// Assign the remaining messages to idle lanes
+		for (int lane = 0; lane < num_lanes; lane++)
+		{
+			if (lane_message[lane] >= 0 || next_message == count)
+				continue;
+
+			int message = next_message++;
+			int size = sizes[message];
+			int full_blocks = size / block_size;
+			int tail_size = size - full_blocks * block_size;
+
+			unsigned char *tail = lane_tail[lane];
+			memset(tail, 0, block_size * 2);
+			memcpy(tail, (const unsigned char *) data[message] + full_blocks * block_size, tail_size);
+			tail[tail_size] = 128;
+			lane_tail_blocks[lane] = (tail_size + 9 <= block_size) ? 1 : 2;
+
+			ubyte64 length_message = size * (ubyte64) 8;
+			unsigned char *length_ptr = tail + lane_tail_blocks[lane] * block_size - 8;
+			for (int cnt = 0; cnt < 8; cnt++)
+				length_ptr[cnt] = (unsigned char) (length_message >> (56 - cnt * 8));
+
+			for (int word = 0; word < 8; word++)
+				state[word * num_lanes + lane] = initial_state[word];
+
+			lane_message[lane] = message;
+			if (full_blocks > 0)
+			{
+				lane_data[lane] = (const unsigned char *) data[message];
+				lane_blocks_left[lane] = full_blocks;
+			}
+			else
+			{
+				lane_data[lane] = tail;
+				lane_blocks_left[lane] = lane_tail_blocks[lane];
+				lane_tail_blocks[lane] = 0;
+			}
+		}
+
+		// Process as many blocks as every active lane has left in its current data segment
+		int active_lane = -1;
+		int num_blocks = 0;
+		for (int lane = 0; lane < num_lanes; lane++)
+		{
+			if (lane_message[lane] >= 0 && (active_lane < 0 || lane_blocks_left[lane] < num_blocks))
+			{
+				num_blocks = lane_blocks_left[lane];
+				active_lane = lane;
+			}
+		}
+		if (active_lane < 0)
+			break;
+
+		// Idle lanes hash a copy of an active lane and their result is ignored
+		const unsigned char *block_data[num_lanes];
+		for (int lane = 0; lane < num_lanes; lane++)
+			block_data[lane] = (lane_message[lane] >= 0) ? lane_data[lane] : lane_data[active_lane];
+
+		avx2_process_sha256_x8(state, block_data, num_blocks);
+
+		for (int lane = 0; lane < num_lanes; lane++)
+		{
+			if (lane_message[lane] < 0)
+				continue;
+
+			lane_data[lane] += num_blocks * block_size;
+			lane_blocks_left[lane] -= num_blocks;
+			if (lane_blocks_left[lane] > 0)
+				continue;
+
+			if (lane_tail_blocks[lane] > 0)
+			{
+				lane_data[lane] = lane_tail[lane];
+				lane_blocks_left[lane] = lane_tail_blocks[lane];
+				lane_tail_blocks[lane] = 0;
+			}
+			else
+			{
+				unsigned char *out_hash = out_hashes + lane_message[lane] * SHA256::hash_size;
+				for (int word = 0; word < 8; word++)
+				{
+					ubyte32 value = state[word * num_lanes + lane];
+					out_hash[word * 4 + 0] = (unsigned char) (value >> 24);
+					out_hash[word * 4 + 1] = (unsigned char) (value >> 16);
+					out_hash[word * 4 + 2] = (unsigned char) (value >> 8);
+					out_hash[word * 4 + 3] = (unsigned char) value;
+				}
+				lane_message[lane] = -1;
+			}
+		}
+	}
+}
+
+void SHA256_Impl::process_blocks(const unsigned char *data, int num_blocks)
 {
-	// Constants defined in FIPS 180-3, section 4.2.2
-	static const ubyte32 constant_K[64] = {
-		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
-		0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
-		0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
-		0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-		0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
-		0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
-		0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
-		0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
-		0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
-		0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
-		0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-		0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-	};
+	if (use_sha_ni)
+	{
+		ubyte32 state[8] = { h0, h1, h2, h3, h4, h5, h6, h7 };
+		sha_ni_process_sha256(state, data, num_blocks);
+		h0 = state[0];
+		h1 = state[1];
+		h2 = state[2];
+		h3 = state[3];
+		h4 = state[4];
+		h5 = state[5];
+		h6 = state[6];
+		h7 = state[7];
+	}
+	else
+	{
+		for (int cnt = 0; cnt < num_blocks; cnt++)
+			process_chunk(data + cnt * block_size);
+	}
+}
 
+void SHA256_Impl::process_chunk(const unsigned char *input)
+{
 	int i;
 	unsigned int w[64];
 
 	for (i = 0; i < 16; i++)
 	{
-		unsigned int b1 = chunk[i*4];
-		unsigned int b2 = chunk[i*4+1];
-		unsigned int b3 = chunk[i*4+2];
-		unsigned int b4 = chunk[i*4+3];
+		unsigned int b1 = input[i*4];
+		unsigned int b2 = input[i*4+1];
+		unsigned int b3 = input[i*4+2];
+		unsigned int b4 = input[i*4+3];
 		w[i] = (b1 << 24) + (b2 << 16) + (b3 << 8) + b4;
 	}
 	
@@ -350,7 +500,7 @@ void SHA256_Impl::process_chunk()
 	{
 		ubyte32 t1, t2;
 
-		t1 = h + sigma_rr6_rr11_rr25(e) + sha_ch(e,f,g) + constant_K[i] + w[i];
+		t1 = h + sigma_rr6_rr11_rr25(e) + sha_ch(e,f,g) + sha256_constant_k[i] + w[i];
 		t2 = sigma_rr2_rr13_rr22(a) + sha_maj(a,b,c);
 		h = g;
 		g = f;
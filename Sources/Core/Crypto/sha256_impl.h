@@ -65,6 +65,10 @@ public:
 
 	void calculate();
 
+	static void hash_multiple(int count, const void * const *data, const int *sizes, unsigned char *out_hashes);
+	static bool is_avx2_supported() { detect_extensions(); return use_avx2; }
+	static void hash_multiple_avx2(int count, const void * const *data, const int *sizes, unsigned char *out_hashes);
+
 
 /// \}
 /// \name Implementation
@@ -101,7 +105,8 @@ private:
 		return  (((x) & ((y) | (z))) | ((y) & (z)));
 	}
 
-	void process_chunk();
+	void process_blocks(const unsigned char *data, int num_blocks);
+	void process_chunk(const unsigned char *input);
 
 	ubyte32 h0, h1, h2, h3, h4, h5, h6, h7;
 
@@ -256,20 +256,31 @@ void SHA512_Impl::add(const void *_data, int size)
 
 	const unsigned char *data = (const unsigned char *) _data;
 	int pos = 0;
-	while (pos < size)
+
+	// Complete a partially filled chunk first
+	if (chunk_filled > 0)
 	{
-		int data_left = size - pos;
-		int buffer_space = block_size - chunk_filled;
-		int data_used = min(buffer_space, data_left);
-		memcpy(chunk + chunk_filled, data + pos, data_used);
+		int data_used = min(block_size - chunk_filled, size);
+		memcpy(chunk + chunk_filled, data, data_used);
 		chunk_filled += data_used;
 		pos += data_used;
 		if (chunk_filled == block_size)
 		{
-			process_chunk();
+			process_blocks(chunk, 1);
 			chunk_filled = 0;
 		}
 	}
+
+	// Whole blocks are hashed directly from the input
+	int num_blocks = (size - pos) / block_size;
+	if (num_blocks > 0)
+	{
+		process_blocks(data + pos, num_blocks);
+		pos += num_blocks * block_size;
+	}
+
+	memcpy(chunk + chunk_filled, data + pos, size - pos);
+	chunk_filled += size - pos;
 	length_message = length_message + (size * (ubyte64) 8);
 }
 
@@ -421,7 +432,13 @@ void SHA512_Impl::calculate()
 /////////////////////////////////////////////////////////////////////////////
 // SHA512_Impl Implementation:
 
-void SHA512_Impl::process_chunk()
+void SHA512_Impl::process_blocks(const unsigned char *data, int num_blocks)
+{
+	for (int cnt = 0; cnt < num_blocks; cnt++)
+		process_chunk(data + cnt * block_size);
+}
+
+void SHA512_Impl::process_chunk(const unsigned char *input)
 {
 	// Constants defined in FIPS 180-3, section 4.2.3
 	static const ubyte64 constant_K[80] = {
@@ -460,14 +477,14 @@ void SHA512_Impl::process_chunk()
 
 	for (i = 0; i < 16; i++)
 	{
-		ubyte64 b1 = chunk[i*8];
-		ubyte64 b2 = chunk[i*8+1];
-		ubyte64 b3 = chunk[i*8+2];
-		ubyte64 b4 = chunk[i*8+3];
-		ubyte64 b5 = chunk[i*8+4];
-		ubyte64 b6 = chunk[i*8+5];
-		ubyte64 b7 = chunk[i*8+6];
-		ubyte64 b8 = chunk[i*8+7];
+		ubyte64 b1 = input[i*8];
+		ubyte64 b2 = input[i*8+1];
+		ubyte64 b3 = input[i*8+2];
+		ubyte64 b4 = input[i*8+3];
+		ubyte64 b5 = input[i*8+4];
+		ubyte64 b6 = input[i*8+5];
+		ubyte64 b7 = input[i*8+6];
+		ubyte64 b8 = input[i*8+7];
 		w[i] = (b1 << 56) + (b2 << 48) + (b3 << 40) + (b4 << 32) + (b5 << 24) + (b6 << 16) + (b7 << 8) + b8;
 	}
 	
@@ -102,7 +102,8 @@ private:
 		return  (((x) & ((y) | (z))) | ((y) & (z)));
 	}
 
-	void process_chunk();
+	void process_blocks(const unsigned char *data, int num_blocks);
+	void process_chunk(const unsigned char *input);
 
 	ubyte64 h0, h1, h2, h3, h4, h5, h6, h7;
 
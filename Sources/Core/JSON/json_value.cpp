@@ -28,361 +28,959 @@
 
 #include "Core/precomp.h"
 #include "API/Core/JSON/json_value.h"
+#include "API/Core/IOData/iodevice.h"
+#include <cstring>
+#include <cstdlib>
+#include <deque>
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace clan
 {
 
-std::string JsonValue::to_json() const
-{
-	std::string result;
-	to_json(result);
-	return result;
-}
-
-void JsonValue::to_json(std::string &result) const
-{
-	result.clear();
-	write(result);
-}
+/////////////////////////////////////////////////////////////////////////////
+// JsonReader:
 
-void JsonValue::write(std::string &json) const
+class JsonReader
 {
-	switch (type)
+public:
+	JsonReader(const char *data, size_t length, bool insitu)
+	: pos(data), end(data + length), insitu(insitu), depth(0)
 	{
-	case type_null:
-		json += "null";
-		break;
-	case type_object:
-		write_object(json);
-		break;
-	case type_array:
-		write_array(json);
-		break;
-	case type_string:
-		write_string(value_string, json);
-		break;
-	case type_number:
-		write_number(json);
-		break;
-	case type_boolean:
-		json += value_boolean ? "true" : "false";
-		break;
 	}
-}
 
-void JsonValue::write_array(std::string &json) const
-{
-	json += "[";
-	for (size_t i = 0; i < items.size(); i++)
+	void read(JsonValue &value)
 	{
-		if (i > 0)
-			json += ",";
-		items[i].write(json);
-	}
-	json += "]";
-}
+		skip_whitespace();
+		if (pos == end)
+			throw JsonException("Unexpected end of JSON data");
 
-void JsonValue::write_object(std::string &json) const
-{
-	json += "{";
-	std::map<std::string, JsonValue>::const_iterator it;
-	for (it = members.begin(); it != members.end(); ++it)
-	{
-		if (it != members.begin())
-			json += ",";
-		write_string(it->first, json);
-		json += ":";
-		it->second.write(json);
+		switch (*pos)
+		{
+		case '{':
+			read_object(value);
+			break;
+		case '[':
+			read_array(value);
+			break;
+		case '"':
+			read_string(value);
+			break;
+		case '-':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+			read_number(value);
+			break;
+		case 't':
+			read_literal("true", 4);
+			value = JsonValue(true);
+			break;
+		case 'f':
+			read_literal("false", 5);
+			value = JsonValue(false);
+			break;
+		case 'n':
+			read_literal("null", 4);
+			value = JsonValue();
+			break;
+		default:
+			throw JsonException("Unexpected character in JSON data");
+		}
 	}
-	json += "}";
-}
-
-void JsonValue::write_string(const std::string &str, std::string &json)
-{
-	json += "\"";
-	json += str; // To do: escape this
-	json += "\"";
-}
 
-void JsonValue::write_number(std::string &json) const
-{
-	char buf[64];
-	buf[0] = 0;
-	if (static_cast<double>(static_cast<int>(value_number)) == value_number)
-	{
-#ifdef WIN32
-		_snprintf(buf, 63, "%d", (int)value_number);
-#else
-		snprintf(buf, 63, "%d", (int)value_number);
-#endif
-	}
-	else
+private:
+	void read_object(JsonValue &value)
 	{
-#ifdef WIN32
-		_snprintf(buf, 63, "%f", value_number);
-#else
-		snprintf(buf, 63, "%f", value_number);
-#endif
-	}
-	buf[63] = 0;
-	json += buf;
-}
+		value = JsonValue(JsonValue::type_object);
 
-JsonValue JsonValue::from_json(const std::string &json)
-{
-	size_t pos = 0;
-	return read(json, pos);
-}
+		pos++;
+		skip_whitespace();
+		if (pos != end && *pos == '}')
+		{
+			pos++;
+			return;
+		}
 
-JsonValue JsonValue::read(const std::string &json, size_t &pos)
-{
-	read_whitespace(json, pos);
+		// Members are collected in a scratch vector reused at this depth, so the final vector is allocated once
+		if (depth >= member_scratch.size())
+			member_scratch.resize(depth + 1);
+		std::vector<JsonMembers::value_type> &members = member_scratch[depth++];
 
-	if (pos == json.length())
-		throw JsonException("Unexpected end of JSON data");
+		bool sorted = true;
+		while (true)
+		{
+			skip_whitespace();
+			if (pos == end)
+				throw JsonException("Unexpected end of JSON data");
+			else if (*pos != '"')
+				throw JsonException("Unexpected character in JSON data");
 
-	switch (json[pos])
-	{
-	case '{':
-		return read_object(json, pos);
-	case '[':
-		return read_array(json, pos);
-	case '"':
-		return read_string(json, pos);
-	case '-':
-	case '0':
-	case '1':
-	case '2':
-	case '3':
-	case '4':
-	case '5':
-	case '6':
-	case '7':
-	case '8':
-	case '9':
-		return read_number(json, pos);
-	case 'f':
-	case 't':
-		return read_boolean(json, pos);
-	default:
-		throw JsonException("Unexpected character in JSON data");
-	}
-}
+			members.push_back(JsonMembers::value_type());
+			read_key(members.back().first);
+			if (members.size() > 1 && !(members[members.size() - 2].first < members.back().first))
+				sorted = false;
 
-JsonValue JsonValue::read_object(const std::string &json, size_t &pos)
-{
-	JsonValue result(type_object);
+			skip_whitespace();
+			if (pos == end)
+				throw JsonException("Unexpected end of JSON data");
+			else if (*pos != ':')
+				throw JsonException("Unexpected character in JSON data");
+			pos++;
 
-	pos++;
+			read(members.back().second);
 
-	read_whitespace(json, pos);
+			skip_whitespace();
+			if (pos == end)
+				throw JsonException("Unexpected end of JSON data");
+			else if (*pos == '}')
+				break;
+			else if (*pos != ',')
+				throw JsonException("Unexpected character in JSON data");
+			pos++;
+		}
+		pos++;
+		depth--;
 
-	if (pos == json.length())
-		throw JsonException("Unexpected end of JSON data");
+		// All members of the object are moved into a single block
+		JsonMembers &result = *value.value_members;
+		JsonMembers::value_type *nodes = result.allocate_block(members.size());
+		result.index.reserve(members.size());
+		if (sorted)
+		{
+			for (size_t i = 0; i < members.size(); i++)
+			{
+				nodes[i] = std::move(members[i]);
+				result.index.push_back(nodes + i);
+			}
+		}
+		else
+		{
+			sort_members(members);
+			for (size_t i = 0; i < member_order.size(); i++)
+			{
+				// A name occurring more than once keeps its last value
+				size_t index = member_order[i];
+				if (i + 1 < member_order.size() && members[index].first == members[member_order[i + 1]].first)
+					continue;
+				JsonMembers::value_type *node = nodes + result.index.size();
+				*node = std::move(members[index]);
+				result.index.push_back(node);
+			}
+		}
+		members.clear();
+	}
 
-	while (pos != json.length() && json[pos] != '}')
+	// Sorts member_order into a stable by-name order of members, without moving the members themselves
+	void sort_members(const std::vector<JsonMembers::value_type> &members)
 	{
-		std::string key = read_string(json, pos);
+		member_order.resize(members.size());
+		for (size_t i = 0; i < members.size(); i++)
+			member_order[i] = i;
 
-		read_whitespace(json, pos);
+		auto less = [&](size_t a, size_t b) { return members[a].first < members[b].first; };
+		if (members.size() <= 16)
+		{
+			for (size_t i = 1; i < member_order.size(); i++)
+			{
+				size_t index = member_order[i];
+				size_t j = i;
+				for (; j > 0 && less(index, member_order[j - 1]); j--)
+					member_order[j] = member_order[j - 1];
+				member_order[j] = index;
+			}
+		}
+		else
+		{
+			std::stable_sort(member_order.begin(), member_order.end(), less);
+		}
+	}
+
+	void read_array(JsonValue &value)
+	{
+		value = JsonValue(JsonValue::type_array);
 
-		if (pos == json.length())
-			throw JsonException("Unexpected end of JSON data");
-		else if (json[pos] != ':')
-			throw JsonException("Unexpected character in JSON data");
 		pos++;
+		skip_whitespace();
+		if (pos != end && *pos == ']')
+		{
+			pos++;
+			return;
+		}
 
-		read_whitespace(json, pos);
+		if (depth >= item_scratch.size())
+			item_scratch.resize(depth + 1);
+		std::vector<JsonValue> &items = item_scratch[depth++];
 
-		result.members[key] = read(json, pos);
+		while (true)
+		{
+			items.push_back(JsonValue());
+			read(items.back());
+
+			skip_whitespace();
+			if (pos == end)
+				throw JsonException("Unexpected end of JSON data");
+			else if (*pos == ']')
+				break;
+			else if (*pos != ',')
+				throw JsonException("Unexpected character in JSON data");
+			pos++;
+		}
+		pos++;
+		depth--;
 
-		read_whitespace(json, pos);
+		std::vector<JsonValue> &result = *value.value_items;
+		result.reserve(items.size());
+		for (size_t i = 0; i < items.size(); i++)
+			result.push_back(std::move(items[i]));
+		items.clear();
+	}
 
-		if (pos == json.length())
-		{
+	void read_string(JsonValue &value)
+	{
+		const char *start = pos + 1;
+		pos = find_quote_or_escape(start);
+		if (pos == end)
 			throw JsonException("Unexpected end of JSON data");
-		}
-		else if (json[pos] == '}')
+
+		value.clear();
+		value.value_type = JsonValue::type_string;
+		if (*pos == '"')
 		{
+			if (insitu)
+				set_insitu_string(value, start, pos - start);
+			else
+				value.set_string(start, pos - start);
 			pos++;
-			break;
 		}
-		else if (json[pos] == ',')
+		else if (insitu)
 		{
-			pos++;
-			read_whitespace(json, pos);
+			// Escape sequences never expand, so the string can be unescaped where it is
+			char *output = const_cast<char *>(pos);
+			unescape(output);
+			set_insitu_string(value, start, output - start);
 		}
 		else
 		{
-			throw JsonException("Unexpected character in JSON data");
+			unescape_buffer.assign(start, pos - start);
+			unescape(unescape_buffer);
+			value.set_string(unescape_buffer.data(), unescape_buffer.length());
 		}
 	}
 
-	return result;
-}
+	void read_key(std::string &key)
+	{
+		const char *start = pos + 1;
+		pos = find_quote_or_escape(start);
+		if (pos == end)
+			throw JsonException("Unexpected end of JSON data");
 
-JsonValue JsonValue::read_array(const std::string &json, size_t &pos)
-{
-	JsonValue result(type_array);
+		if (*pos == '"')
+		{
+			key.assign(start, pos - start);
+			pos++;
+		}
+		else
+		{
+			key.assign(start, pos - start);
+			unescape(key);
+		}
+	}
+
+	static void set_insitu_string(JsonValue &value, const char *data, size_t length)
+	{
+		if (length > 0xffffffff)
+			throw JsonException("JSON string too long");
+		value.string_insitu = true;
+		value.value_string = const_cast<char *>(data);
+		value.string_length = (unsigned int)length;
+	}
 
-	pos++;
+	// Unescapes from pos, which is at a backslash, until the closing quote. Output can be a std::string or a char pointer
+	template<typename Output>
+	void unescape(Output &output)
+	{
+		while (true)
+		{
+			if (pos == end)
+				throw JsonException("Unexpected end of JSON data");
 
-	read_whitespace(json, pos);
+			if (*pos == '"')
+			{
+				pos++;
+				return;
+			}
+			else if (*pos == '\\')
+			{
+				pos++;
+				if (pos == end)
+					throw JsonException("Unexpected end of JSON data");
 
-	if (pos == json.length())
-		throw JsonException("Unexpected end of JSON data");
+				switch (*pos)
+				{
+				case '"': append(output, '"'); break;
+				case '\\': append(output, '\\'); break;
+				case '/': append(output, '/'); break;
+				case 'b': append(output, '\b'); break;
+				case 'f': append(output, '\f'); break;
+				case 'n': append(output, '\n'); break;
+				case 'r': append(output, '\r'); break;
+				case 't': append(output, '\t'); break;
+				case 'u': read_unicode_escape(output); break;
+				default: throw JsonException("Unexpected character in JSON data");
+				}
+				pos++;
+			}
+			else
+			{
+				const char *next = find_quote_or_escape(pos);
+				append(output, pos, next - pos);
+				pos = next;
+			}
+		}
+	}
 
-	while (json[pos] != ']')
+	template<typename Output>
+	void read_unicode_escape(Output &output)
 	{
-		read_whitespace(json, pos);
-		result.items.push_back(read(json, pos));
-		read_whitespace(json, pos);
+		// pos is at the 'u' and is left at the last hex digit
+		unsigned int code = read_hex4();
+		if (code >= 0xd800 && code < 0xdc00 && end - pos > 6 && pos[1] == '\\' && pos[2] == 'u')
+		{
+			pos += 2;
+			unsigned int low = read_hex4();
+			if (low < 0xdc00 || low >= 0xe000)
+				throw JsonException("Invalid unicode surrogate pair in JSON data");
+			code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+		}
 
-		if (pos == json.length())
+		if (code < 0x80)
+		{
+			append(output, (char)code);
+		}
+		else if (code < 0x800)
+		{
+			append(output, (char)(0xc0 | (code >> 6)));
+			append(output, (char)(0x80 | (code & 0x3f)));
+		}
+		else if (code < 0x10000)
 		{
+			append(output, (char)(0xe0 | (code >> 12)));
+			append(output, (char)(0x80 | ((code >> 6) & 0x3f)));
+			append(output, (char)(0x80 | (code & 0x3f)));
+		}
+		else
+		{
+			append(output, (char)(0xf0 | (code >> 18)));
+			append(output, (char)(0x80 | ((code >> 12) & 0x3f)));
+			append(output, (char)(0x80 | ((code >> 6) & 0x3f)));
+			append(output, (char)(0x80 | (code & 0x3f)));
+		}
+	}
+
+	unsigned int read_hex4()
+	{
+		if (end - pos < 5)
 			throw JsonException("Unexpected end of JSON data");
+
+		unsigned int code = 0;
+		for (int i = 1; i <= 4; i++)
+		{
+			char c = pos[i];
+			code <<= 4;
+			if (c >= '0' && c <= '9')
+				code += c - '0';
+			else if (c >= 'a' && c <= 'f')
+				code += c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F')
+				code += c - 'A' + 10;
+			else
+				throw JsonException("Unexpected character in JSON data");
 		}
-		else if (json[pos] == ']')
+		pos += 4;
+		return code;
+	}
+
+	static void append(std::string &output, char c) { output.push_back(c); }
+	static void append(std::string &output, const char *data, size_t length) { output.append(data, length); }
+	static void append(char *&output, char c) { *(output++) = c; }
+	static void append(char *&output, const char *data, size_t length) { memmove(output, data, length); output += length; }
+
+	void read_number(JsonValue &value)
+	{
+		const char *start = pos;
+		bool negative = false;
+		if (*pos == '-')
 		{
-			break;
+			negative = true;
+			pos++;
 		}
-		else if (json[pos] == ',')
+
+		// Up to 15 digits are exact in a double, and so is the division by an exact power of ten
+		ubyte64 mantissa = 0;
+		const char *digits_start = pos;
+		while (pos != end && *pos >= '0' && *pos <= '9')
 		{
+			mantissa = mantissa * 10 + (*pos - '0');
 			pos++;
-			read_whitespace(json, pos);
+		}
+		size_t num_digits = pos - digits_start;
+		if (num_digits == 0)
+			throw JsonException("Unexpected character in JSON data");
+
+		size_t fraction_digits = 0;
+		if (pos != end && *pos == '.')
+		{
+			pos++;
+			const char *fraction_start = pos;
+			while (pos != end && *pos >= '0' && *pos <= '9')
+			{
+				mantissa = mantissa * 10 + (*pos - '0');
+				pos++;
+			}
+			fraction_digits = pos - fraction_start;
+			num_digits += fraction_digits;
+		}
+
+		bool has_exponent = false;
+		if (pos != end && (*pos == 'e' || *pos == 'E'))
+		{
+			has_exponent = true;
+			pos++;
+			if (pos != end && (*pos == '+' || *pos == '-'))
+				pos++;
+			while (pos != end && *pos >= '0' && *pos <= '9')
+				pos++;
+		}
+
+		double number;
+		if (!has_exponent && num_digits <= 15)
+		{
+			static const double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+			number = (double)mantissa;
+			if (fraction_digits > 0)
+				number /= powers_of_ten[fraction_digits];
+			if (negative)
+				number = -number;
 		}
 		else
 		{
+			// strtod needs a terminated string
+			char buffer[64];
+			size_t length = pos - start;
+			if (length < sizeof(buffer))
+			{
+				memcpy(buffer, start, length);
+				buffer[length] = 0;
+				number = strtod(buffer, 0);
+			}
+			else
+			{
+				number = strtod(std::string(start, length).c_str(), 0);
+			}
+		}
+
+		value.clear();
+		value.value_type = JsonValue::type_number;
+		value.value_number = number;
+	}
+
+	void read_literal(const char *literal, size_t length)
+	{
+		if ((size_t)(end - pos) < length || memcmp(pos, literal, length) != 0)
 			throw JsonException("Unexpected character in JSON data");
+		pos += length;
+	}
+
+	void skip_whitespace()
+	{
+		// Most tokens are not preceded by whitespace, or by a single space
+		if (pos != end && !is_whitespace(*pos))
+			return;
+
+#ifndef CL_DISABLE_SSE2
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i newline = _mm_set1_epi8('\n');
+		const __m128i carriage_return = _mm_set1_epi8('\r');
+		const __m128i tab = _mm_set1_epi8('\t');
+		while (end - pos >= 16)
+		{
+			__m128i data = _mm_loadu_si128((const __m128i *)pos);
+			__m128i whitespace = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(data, space), _mm_cmpeq_epi8(data, newline)),
+				_mm_or_si128(_mm_cmpeq_epi8(data, carriage_return), _mm_cmpeq_epi8(data, tab)));
+			unsigned int mask = ~_mm_movemask_epi8(whitespace) & 0xffff;
+			if (mask)
+			{
+				pos += bit_scan_forward(mask);
+				if (*pos != '\f')
+					return;
+				pos++;
+			}
+			else
+			{
+				pos += 16;
+			}
 		}
+#endif
+
+		while (pos != end && is_whitespace(*pos))
+			pos++;
 	}
-	pos++;
 
-	return result;
-}
+	static bool is_whitespace(char c)
+	{
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f';
+	}
+
+	const char *find_quote_or_escape(const char *p) const
+	{
+#ifndef CL_DISABLE_SSE2
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		while (end - p >= 16)
+		{
+			__m128i data = _mm_loadu_si128((const __m128i *)p);
+			unsigned int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(data, quote), _mm_cmpeq_epi8(data, backslash)));
+			if (mask)
+				return p + bit_scan_forward(mask);
+			p += 16;
+		}
+#endif
+		while (p != end && *p != '"' && *p != '\\')
+			p++;
+		return p;
+	}
+
+	static unsigned int bit_scan_forward(unsigned int mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	const char *pos;
+	const char *end;
+	bool insitu;
+	std::string unescape_buffer;
+
+	size_t depth;
+	// Deques, as growing them must not move the scratch vectors of outer levels
+	std::deque<std::vector<JsonMembers::value_type> > member_scratch;
+	std::deque<std::vector<JsonValue> > item_scratch;
+	std::vector<size_t> member_order;
+};
 
-std::string JsonValue::read_string(const std::string &json, size_t &pos)
+/////////////////////////////////////////////////////////////////////////////
+// JsonWriter:
+
+class JsonWriter
 {
-	pos++;
-	if (pos == json.length())
-		throw JsonException("Unexpected end of JSON data");
+public:
+	JsonWriter(std::string &json, IODevice *device) : json(json), device(device) { }
 
-	std::string result;
-	while (true)
+	void write(const JsonValue &value)
 	{
-		if (pos == json.length())
+		switch (value.get_type())
 		{
-			throw JsonException("Unexpected end of JSON data");
+		case JsonValue::type_null:
+			json.append("null", 4);
+			break;
+		case JsonValue::type_object:
+			write_object(value.get_members());
+			break;
+		case JsonValue::type_array:
+			write_array(value.get_items());
+			break;
+		case JsonValue::type_string:
+			write_string(value.value_string, value.string_length);
+			break;
+		case JsonValue::type_number:
+			write_number(value.to_double());
+			break;
+		case JsonValue::type_boolean:
+			if (value.to_boolean())
+				json.append("true", 4);
+			else
+				json.append("false", 5);
+			break;
 		}
-		else if (json[pos] == '"')
+
+		if (device && json.size() >= flush_size)
+			flush();
+	}
+
+	void flush()
+	{
+		if (!json.empty())
 		{
-			break;
+			device->write(json.data(), json.size());
+			json.clear();
 		}
-		else if (json[pos] == '\\')
+	}
+
+private:
+	void write_object(const JsonMembers &members)
+	{
+		json.push_back('{');
+		for (JsonMembers::const_iterator it = members.begin(); it != members.end(); ++it)
 		{
-			pos++;
-			if (pos == json.length())
-				throw JsonException("Unexpected end of JSON data");
-			switch (json[pos])
-			{
-			case '"':
-				result.push_back('"');
-				break;
-			case '\\':
-				result.push_back('\\');
-				break;
-			case '/':
-				result.push_back('/');
-				break;
-			case 'b':
-				result.push_back('\b');
-				break;
-			case 'f':
-				result.push_back('\f');
-				break;
-			case 'n':
-				result.push_back('\n');
-				break;
-			case 'r':
-				result.push_back('\r');
-				break;
-			case 't':
-				result.push_back('\t');
+			if (it != members.begin())
+				json.push_back(',');
+			write_string(it->first.data(), it->first.length());
+			json.push_back(':');
+			write(it->second);
+		}
+		json.push_back('}');
+	}
+
+	void write_array(const std::vector<JsonValue> &items)
+	{
+		json.push_back('[');
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			if (i > 0)
+				json.push_back(',');
+			write(items[i]);
+		}
+		json.push_back(']');
+	}
+
+	void write_string(const char *data, size_t length)
+	{
+		static const char hex[] = "0123456789abcdef";
+
+		json.push_back('"');
+		const char *end = data + length;
+		while (data != end)
+		{
+			const char *next = find_escape(data, end);
+			json.append(data, next - data);
+			if (next == end)
 				break;
-			case 'u':
-				if (pos + 5 > json.length())
-					throw JsonException("Unexpected end of JSON data");
-				// To do: parse unicode
-				throw JsonException("Unicode escapes not supported yet in JSON data");
-				pos += 3;
+
+			unsigned char c = *next;
+			switch (c)
+			{
+			case '"': json.append("\\\"", 2); break;
+			case '\\': json.append("\\\\", 2); break;
+			case '\b': json.append("\\b", 2); break;
+			case '\f': json.append("\\f", 2); break;
+			case '\n': json.append("\\n", 2); break;
+			case '\r': json.append("\\r", 2); break;
+			case '\t': json.append("\\t", 2); break;
+			default:
+				{
+					char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+					json.append(escape, 6);
+				}
 				break;
 			}
-			pos++;
+			data = next + 1;
+		}
+		json.push_back('"');
+	}
+
+	static const char *find_escape(const char *p, const char *end)
+	{
+#ifndef CL_DISABLE_SSE2
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i control = _mm_set1_epi8(0x1f);
+		while (end - p >= 16)
+		{
+			__m128i data = _mm_loadu_si128((const __m128i *)p);
+			__m128i is_control = _mm_cmpeq_epi8(_mm_max_epu8(data, control), control);
+			__m128i matches = _mm_or_si128(is_control, _mm_or_si128(_mm_cmpeq_epi8(data, quote), _mm_cmpeq_epi8(data, backslash)));
+			unsigned int mask = _mm_movemask_epi8(matches);
+			if (mask)
+			{
+#ifdef _MSC_VER
+				unsigned long index;
+				_BitScanForward(&index, mask);
+				return p + index;
+#else
+				return p + __builtin_ctz(mask);
+#endif
+			}
+			p += 16;
+		}
+#endif
+		while (p != end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20)
+			p++;
+		return p;
+	}
+
+	void write_number(double value)
+	{
+		char buffer[64];
+		if (value >= -2147483648.0 && value <= 2147483647.0 && static_cast<double>(static_cast<int>(value)) == value)
+		{
+			// Integer fast path, formatted like "%d"
+			int integer = static_cast<int>(value);
+			unsigned int magnitude = integer < 0 ? 0u - (unsigned int)integer : (unsigned int)integer;
+			char *p = buffer + sizeof(buffer);
+			do
+			{
+				*(--p) = '0' + magnitude % 10;
+				magnitude /= 10;
+			} while (magnitude);
+			if (integer < 0)
+				*(--p) = '-';
+			json.append(p, buffer + sizeof(buffer) - p);
 		}
 		else
 		{
-			result.push_back(json[pos]);
-			pos++;
+#ifdef WIN32
+			int length = _snprintf(buffer, 63, "%f", value);
+#else
+			int length = snprintf(buffer, 63, "%f", value);
+#endif
+			buffer[63] = 0;
+			json.append(buffer, (length >= 0 && length < 63) ? length : strlen(buffer));
 		}
 	}
 
-	pos++;
+	static const size_t flush_size = 64 * 1024;
+
+	std::string &json;
+	IODevice *device;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// JsonValue Construction:
+
+JsonValue::JsonValue(Type type)
+: value_type(type), string_insitu(false), string_length(0)
+{
+	switch (type)
+	{
+	case type_object:
+		value_members = new JsonMembers();
+		break;
+	case type_array:
+		value_items = new std::vector<JsonValue>();
+		break;
+	case type_string:
+		value_string = 0;
+		break;
+	case type_boolean:
+		value_boolean = false;
+		break;
+	default:
+		value_number = 0.0;
+		break;
+	}
+}
+
+JsonValue::JsonValue(const JsonValue &other)
+: value_type(type_null), string_insitu(false), string_length(0)
+{
+	copy_from(other);
+}
+
+JsonValue::JsonValue(JsonValue &&other) throw()
+: value_type(other.value_type), string_insitu(other.string_insitu), string_length(other.string_length)
+{
+	value_number = 0.0;
+	memcpy(&value_number, &other.value_number, sizeof(value_number) > sizeof(value_members) ? sizeof(value_number) : sizeof(value_members));
+	other.value_type = type_null;
+	other.string_insitu = false;
+	other.string_length = 0;
+}
+
+JsonValue JsonValue::from_json(const std::string &json)
+{
+	return from_json(json.data(), json.length());
+}
 
+JsonValue JsonValue::from_json(const char *json, size_t length)
+{
+	JsonValue result;
+	JsonReader reader(json, length, false);
+	reader.read(result);
 	return result;
 }
 
-JsonValue JsonValue::read_number(const std::string &json, size_t &pos)
+JsonValue JsonValue::from_json_insitu(char *json, size_t length)
 {
-	int start_pos = pos;
-	if (json[pos] == '-')
-		pos++;
-	while (pos < json.length() && json[pos] >= '0' && json[pos] <= '9')
-		pos++;
-	if (pos != json.length() && json[pos] == '.')
-		pos++;
-	while (pos < json.length() && json[pos] >= '0' && json[pos] <= '9')
-		pos++;
-	if (pos != json.length() && (json[pos] == 'e' || json[pos] == 'E'))
+	JsonValue result;
+	JsonReader reader(json, length, true);
+	reader.read(result);
+	return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// JsonValue Attributes:
+
+JsonMembers &JsonValue::get_members()
+{
+	if (value_type == type_null)
+		*this = JsonValue(type_object);
+	else if (value_type != type_object)
+		throw JsonException("JSON Value is not an object");
+	return *value_members;
+}
+
+const JsonMembers &JsonValue::get_members() const
+{
+	static const JsonMembers empty_members;
+	if (value_type == type_null)
+		return empty_members;
+	else if (value_type != type_object)
+		throw JsonException("JSON Value is not an object");
+	return *value_members;
+}
+
+std::vector<JsonValue> &JsonValue::get_items()
+{
+	if (value_type == type_null)
+		*this = JsonValue(type_array);
+	else if (value_type != type_array)
+		throw JsonException("JSON Value is not an array");
+	return *value_items;
+}
+
+const std::vector<JsonValue> &JsonValue::get_items() const
+{
+	static const std::vector<JsonValue> empty_items;
+	if (value_type == type_null)
+		return empty_items;
+	else if (value_type != type_array)
+		throw JsonException("JSON Value is not an array");
+	return *value_items;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// JsonValue Operations:
+
+JsonValue &JsonValue::operator =(const JsonValue &other)
+{
+	if (this != &other)
 	{
-		pos++;
-		if (pos != json.length() && (json[pos] == '+' || json[pos] == '-'))
-			pos++;
-		while (pos < json.length() && json[pos] >= '0' && json[pos] <= '9')
-			pos++;
+		JsonValue copy(other);
+		*this = std::move(copy);
 	}
-	int end_pos = pos;
+	return *this;
+}
 
-	std::string number_string = json.substr(start_pos, end_pos - start_pos);
-	if (number_string.empty())
-		throw JsonException("Unexpected character in JSON data");
+JsonValue &JsonValue::operator =(JsonValue &&other) throw()
+{
+	if (this != &other)
+	{
+		clear();
+		value_type = other.value_type;
+		string_insitu = other.string_insitu;
+		string_length = other.string_length;
+		memcpy(&value_number, &other.value_number, sizeof(value_number) > sizeof(value_members) ? sizeof(value_number) : sizeof(value_members));
+		other.value_type = type_null;
+		other.string_insitu = false;
+		other.string_length = 0;
+	}
+	return *this;
+}
 
-	double result = 0.0;
-	sscanf(number_string.c_str(), "%lf", &result);
+std::string JsonValue::to_json() const
+{
+	std::string result;
+	to_json(result);
 	return result;
 }
 
-JsonValue JsonValue::read_boolean(const std::string &json, size_t &pos)
+void JsonValue::to_json(std::string &result) const
+{
+	result.clear();
+	JsonWriter writer(result, 0);
+	writer.write(*this);
+}
+
+void JsonValue::to_json(IODevice &device) const
+{
+	std::string buffer;
+	JsonWriter writer(buffer, &device);
+	writer.write(*this);
+	writer.flush();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// JsonValue Implementation:
+
+void JsonValue::clear()
 {
-	if (json[pos] == 't')
+	switch (value_type)
 	{
-		if (pos + 4 > json.length() || memcmp(&json[pos], "true", 4) != 0)
-			throw JsonException("Unexpected character in JSON data");
-		pos += 4;
-		return JsonValue::boolean(true);
+	case type_object:
+		delete value_members;
+		break;
+	case type_array:
+		delete value_items;
+		break;
+	case type_string:
+		if (!string_insitu)
+			delete[] value_string;
+		break;
+	default:
+		break;
 	}
-	else
+	value_type = type_null;
+	string_insitu = false;
+	string_length = 0;
+	value_number = 0.0;
+}
+
+void JsonValue::copy_from(const JsonValue &other)
+{
+	switch (other.value_type)
 	{
-		if (pos + 5 > json.length() || memcmp(&json[pos], "false", 5) != 0)
-			throw JsonException("Unexpected character in JSON data");
-		pos += 5;
-		return JsonValue::boolean(false);
+	case type_object:
+		value_members = new JsonMembers(*other.value_members);
+		break;
+	case type_array:
+		value_items = new std::vector<JsonValue>(*other.value_items);
+		break;
+	case type_string:
+		if (other.string_insitu)
+			value_string = other.value_string;
+		else
+			set_string(other.value_string, other.string_length);
+		break;
+	case type_boolean:
+		value_boolean = other.value_boolean;
+		break;
+	default:
+		value_number = other.value_number;
+		break;
 	}
+	value_type = other.value_type;
+	string_insitu = other.string_insitu;
+	string_length = other.string_length;
 }
 
-void JsonValue::read_whitespace(const std::string &json, size_t &pos)
+void JsonValue::set_string(const char *data, size_t length)
 {
-	while (pos != json.length() && (json[pos] == ' ' || json[pos] == '\r' ||json[pos] == '\n' || json[pos] == '\t' || json[pos] == '\f'))
-		pos++;
+	if (length > 0xffffffff)
+		throw JsonException("JSON string too long");
+
+	value_string = 0;
+	if (length > 0)
+	{
+		value_string = new char[length];
+		memcpy(value_string, data, length);
+	}
+	string_insitu = false;
+	string_length = (unsigned int)length;
 }
 
 }
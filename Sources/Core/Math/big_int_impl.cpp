@@ -1601,6 +1601,228 @@ void BigInt_Impl::internal_sqr()
 	tmp_impl.internal_exch(this);
 }
 
+// Montgomery arithmetic used by exptmod() for odd moduli.
+static const int mont_limb_bits = 8 * sizeof(BigInt_MontLimb);
+static const int mont_digits_per_limb = sizeof(BigInt_MontLimb) / sizeof(ubyte32);
+
+// Compute -n0^-1 mod 2^mont_limb_bits (n0 must be odd)
+static BigInt_MontLimb mont_inverse_limb(BigInt_MontLimb n0)
+{
+	// Newton iteration, every step doubles the number of correct low bits (n0*n0 == 1 mod 8)
+	BigInt_MontLimb inv = n0;
+	for (int bits = 3; bits < mont_limb_bits; bits *= 2)
+		inv *= 2 - n0 * inv;
+	return 0 - inv;
+}
+
+// r = a * b * R^-1 mod n, using coarsely integrated operand scanning.
+// t is scratch space of (size + 2) limbs. r may alias a or b.
+static void mont_mul(BigInt_MontLimb *r, const BigInt_MontLimb *a, const BigInt_MontLimb *b, const BigInt_MontLimb *n, BigInt_MontLimb n0inv, int size, BigInt_MontLimb *t)
+{
+	memset(t, 0, (size + 2) * sizeof(BigInt_MontLimb));
+
+	for (int i = 0; i < size; i++)
+	{
+		BigInt_MontDoubleLimb w;
+		BigInt_MontLimb carry = 0;
+		BigInt_MontLimb bi = b[i];
+
+		for (int j = 0; j < size; j++)
+		{
+			w = (BigInt_MontDoubleLimb) a[j] * bi + t[j] + carry;
+			t[j] = (BigInt_MontLimb) w;
+			carry = (BigInt_MontLimb) (w >> mont_limb_bits);
+		}
+		w = (BigInt_MontDoubleLimb) t[size] + carry;
+		t[size] = (BigInt_MontLimb) w;
+		t[size + 1] = (BigInt_MontLimb) (w >> mont_limb_bits);
+
+		// Add a multiple of n that clears the lowest limb, then shift down one limb
+		BigInt_MontLimb q = t[0] * n0inv;
+		w = (BigInt_MontDoubleLimb) q * n[0] + t[0];
+		carry = (BigInt_MontLimb) (w >> mont_limb_bits);
+		for (int j = 1; j < size; j++)
+		{
+			w = (BigInt_MontDoubleLimb) q * n[j] + t[j] + carry;
+			t[j - 1] = (BigInt_MontLimb) w;
+			carry = (BigInt_MontLimb) (w >> mont_limb_bits);
+		}
+		w = (BigInt_MontDoubleLimb) t[size] + carry;
+		t[size - 1] = (BigInt_MontLimb) w;
+		t[size] = t[size + 1] + (BigInt_MontLimb) (w >> mont_limb_bits);
+	}
+
+	// The result is below 2n, subtract n once if needed
+	bool subtract = t[size] != 0;
+	if (!subtract)
+	{
+		subtract = true;
+		for (int j = size - 1; j >= 0; j--)
+		{
+			if (t[j] != n[j])
+			{
+				subtract = t[j] > n[j];
+				break;
+			}
+		}
+	}
+
+	if (subtract)
+	{
+		BigInt_MontLimb borrow = 0;
+		for (int j = 0; j < size; j++)
+		{
+			BigInt_MontLimb d = t[j] - n[j];
+			BigInt_MontLimb borrow_out = (t[j] < n[j]) || (d < borrow);
+			r[j] = d - borrow;
+			borrow = borrow_out;
+		}
+	}
+	else
+	{
+		memcpy(r, t, size * sizeof(BigInt_MontLimb));
+	}
+}
+
+void BigInt_Impl::internal_to_mont_limbs(BigInt_MontLimb *dest, int size) const
+{
+	for (int i = 0; i < size; i++)
+	{
+		BigInt_MontLimb limb = 0;
+		for (int j = mont_digits_per_limb - 1; j >= 0; j--)
+		{
+			unsigned int ix = i * mont_digits_per_limb + j;
+			ubyte32 d = ix < digits_used ? digits[ix] : 0;
+			limb = (mont_digits_per_limb > 1) ? ((BigInt_MontDoubleLimb) limb << num_bits_in_digit) | d : d;
+		}
+		dest[i] = limb;
+	}
+}
+
+void BigInt_Impl::internal_from_mont_limbs(const BigInt_MontLimb *src, int size)
+{
+	zero();
+	internal_pad(size * mont_digits_per_limb);
+	for (int i = 0; i < size; i++)
+	{
+		BigInt_MontLimb limb = src[i];
+		for (int j = 0; j < mont_digits_per_limb; j++)
+		{
+			digits[i * mont_digits_per_limb + j] = (ubyte32) limb;
+			limb = (BigInt_MontLimb) ((BigInt_MontDoubleLimb) limb >> num_bits_in_digit);
+		}
+	}
+	internal_clamp();
+}
+
+void BigInt_Impl::internal_exptmod_montgomery(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c) const
+{
+	const int size = (m->digits_used + mont_digits_per_limb - 1) / mont_digits_per_limb;
+	const int exponent_bits = b->significant_bits();
+
+	// Choose the sliding window width from the exponent length
+	int window_bits = 1;
+	if (exponent_bits > 671)
+		window_bits = 6;
+	else if (exponent_bits > 239)
+		window_bits = 5;
+	else if (exponent_bits > 79)
+		window_bits = 4;
+	else if (exponent_bits > 23)
+		window_bits = 3;
+	const int table_size = 1 << (window_bits - 1);
+
+	// Layout: n, t (size+2), x, result, table (odd powers x^1, x^3, x^5, ...)
+	std::vector<BigInt_MontLimb> buffer(size * (4 + table_size) + 2);
+	BigInt_MontLimb *n = &buffer[0];
+	BigInt_MontLimb *t = n + size;
+	BigInt_MontLimb *x = t + size + 2;
+	BigInt_MontLimb *result = x + size;
+	BigInt_MontLimb *table = result + size;
+
+	m->internal_to_mont_limbs(n, size);
+	BigInt_MontLimb n0inv = mont_inverse_limb(n[0]);
+
+	// rr = R^2 mod m, with R = 2^(size * mont_limb_bits)
+	BigInt_Impl rr;
+	rr.set((ubyte32) 1);
+	rr.internal_lshd(2 * size * mont_digits_per_limb);
+	rr.mod(m, &rr);
+
+	BigInt_Impl base(*this);
+	base.mod(m, &base);
+
+	// Convert base and 1 into Montgomery form
+	base.internal_to_mont_limbs(x, size);
+	rr.internal_to_mont_limbs(t, size);
+	memcpy(result, t, size * sizeof(BigInt_MontLimb));
+	mont_mul(table, x, result, n, n0inv, size, t);
+
+	memset(x, 0, size * sizeof(BigInt_MontLimb));
+	x[0] = 1;
+	rr.internal_to_mont_limbs(result, size);
+	mont_mul(result, x, result, n, n0inv, size, t);
+
+	if (table_size > 1)
+	{
+		// x = base^2, table[i] = base^(2i+1)
+		mont_mul(x, table, table, n, n0inv, size, t);
+		for (int i = 1; i < table_size; i++)
+			mont_mul(table + i * size, table + (i - 1) * size, x, n, n0inv, size, t);
+	}
+
+	// Scan the exponent from the most significant bit
+	const ubyte32 *db = b->digits;
+	bool started = false;
+	int i = exponent_bits - 1;
+	while (i >= 0)
+	{
+		if (!((db[i / num_bits_in_digit] >> (i % num_bits_in_digit)) & 1))
+		{
+			if (started)
+				mont_mul(result, result, result, n, n0inv, size, t);
+			i--;
+			continue;
+		}
+
+		// Find the longest window ending in a set bit
+		int low = i - window_bits + 1;
+		if (low < 0)
+			low = 0;
+		while (!((db[low / num_bits_in_digit] >> (low % num_bits_in_digit)) & 1))
+			low++;
+
+		int value = 0;
+		for (int bit = i; bit >= low; bit--)
+		{
+			value = (value << 1) | ((db[bit / num_bits_in_digit] >> (bit % num_bits_in_digit)) & 1);
+			if (started)
+				mont_mul(result, result, result, n, n0inv, size, t);
+		}
+
+		if (started)
+		{
+			mont_mul(result, result, table + (value >> 1) * size, n, n0inv, size, t);
+		}
+		else
+		{
+			memcpy(result, table + (value >> 1) * size, size * sizeof(BigInt_MontLimb));
+			started = true;
+		}
+		i = low - 1;
+	}
+
+	// Convert back from Montgomery form
+	memset(x, 0, size * sizeof(BigInt_MontLimb));
+	x[0] = 1;
+	mont_mul(result, result, x, n, n0inv, size, t);
+
+	c->internal_from_mont_limbs(result, size);
+
+	// The intermediate values may be derived from secret exponents
+	memset(&buffer[0], 0, buffer.size() * sizeof(BigInt_MontLimb));
+}
+
 void BigInt_Impl::exptmod(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c) const
 {
 	BigInt_Impl s, mu;
@@ -1613,6 +1835,13 @@ void BigInt_Impl::exptmod(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Imp
 	if (b->cmp_z() < 0 || m->cmp_z() <= 0)
 		throw Exception("Divide by zero");
 
+	// Odd moduli (all RSA moduli and primes) use Montgomery multiplication
+	if (m->isodd() && m->cmp_d(1) > 0)
+	{
+		internal_exptmod_montgomery(b, m, c);
+		return;
+	}
+
 	BigInt_Impl x(*this);
 
 	x.mod(m, &x);
@@ -53,6 +53,16 @@ namespace clan
 {
 class BigInt_Impl;
 
+// Limb used by the Montgomery exponentiation. The 32-bit digits are packed into the widest
+// limb the compiler can multiply into a double width product (64-bit limbs with a 128-bit product where available)
+#if defined(__SIZEOF_INT128__)
+typedef ubyte64 BigInt_MontLimb;
+typedef unsigned __int128 BigInt_MontDoubleLimb;
+#else
+typedef ubyte32 BigInt_MontLimb;
+typedef ubyte64 BigInt_MontDoubleLimb;
+#endif
+
 class BigInt_Impl
 {
 
@@ -169,6 +179,11 @@ private:
 	void internal_reduce(const BigInt_Impl *m, BigInt_Impl *mu);
 	void internal_sqr();
 
+	// Sliding window exponentiation using Montgomery multiplication (m must be odd)
+	void internal_exptmod_montgomery(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c) const;
+	void internal_to_mont_limbs(BigInt_MontLimb *dest, int size) const;
+	void internal_from_mont_limbs(const BigInt_MontLimb *src, int size);
+
 	bool digits_negative;	// True if the value is negative
 	unsigned int digits_alloc;		// How many digits allocated
 	unsigned int digits_used;		// How many digits used
@@ -0,0 +1,162 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+
+#ifdef __linux__
+
+#include "API/Core/System/exception.h"
+#include "event_provider_eventfd.h"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// EventProvider_Eventfd Construction:
+
+EventProvider_Eventfd::EventProvider_Eventfd(bool manual_reset, bool initial_state)
+: manual_reset(manual_reset), state(false), handle(-1)
+{
+	handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (handle == -1)
+	{
+		switch (errno)
+		{
+		case EMFILE:
+		case ENFILE:
+			throw Exception("Could not create event descriptor! Too many descriptors are in use.");
+		case ENOMEM:
+			throw Exception("Could not create event descriptor! Insufficient memory.");
+		default:
+			throw Exception("Could not create event descriptor!");
+		}
+	}
+
+	if (initial_state)
+		set();
+}
+
+EventProvider_Eventfd::~EventProvider_Eventfd()
+{
+	close(handle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// EventProvider_Eventfd Attributes:
+
+EventProvider::EventType EventProvider_Eventfd::get_event_type(int index)
+{
+	return type_fd_read;
+}
+
+int EventProvider_Eventfd::get_event_handle(int index)
+{
+	return handle;
+}
+
+int EventProvider_Eventfd::get_num_event_handles()
+{
+	return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// EventProvider_Eventfd Operations:
+
+bool EventProvider_Eventfd::check_after_wait(int index)
+{
+	if (!manual_reset)
+	{
+		// For automatic reset, only the first thread to wake up gets the event:
+		MutexSection mutex_lock(&mutex);
+		if (state == true)
+		{
+			consume();
+			state = false;
+			return true;
+		}
+
+		// Someone beat us to it, go back and wait.
+		return false;
+	}
+	else
+	{
+		return true;
+	}
+}
+
+bool EventProvider_Eventfd::set()
+{
+	MutexSection mutex_lock(&mutex);
+	if (state == false)
+	{
+		state = true;
+		uint64_t value = 1;
+		ssize_t result;
+		do
+		{
+			result = write(handle, &value, sizeof(uint64_t));
+		} while (result == -1 && errno == EINTR);
+		if (result != sizeof(uint64_t))
+			throw Exception("EventProvider_Eventfd::set failed");
+	}
+	return true;
+}
+
+bool EventProvider_Eventfd::reset()
+{
+	MutexSection mutex_lock(&mutex);
+	if (state == true)
+	{
+		consume();
+		state = false;
+	}
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// EventProvider_Eventfd Implementation:
+
+void EventProvider_Eventfd::consume()
+{
+	uint64_t value = 0;
+	ssize_t result;
+	do
+	{
+		result = read(handle, &value, sizeof(uint64_t));
+	} while (result == -1 && errno == EINTR);
+	if (result == -1 && errno != EAGAIN)
+		throw Exception("EventProvider_Eventfd::reset failed");
+}
+
+}
+
+#endif
@@ -45,13 +45,31 @@ public:
 
 	~DataBuffer_Impl()
 	{
-		delete[] data;
+		if (!owner)
+			delete[] data;
+	}
+
+	/// \brief Replaces data with a copy owned by the buffer
+	void reallocate(unsigned int new_allocated_size)
+	{
+		char *old_data = data;
+		data = new char[new_allocated_size];
+		memcpy(data, old_data, size);
+		if (owner)
+			owner.reset();
+		else
+			delete[] old_data;
+		memset(data+size, 0, new_allocated_size-size);
+		allocated_size = new_allocated_size;
 	}
 
 public:
 	char *data;
 	unsigned int size;
 	unsigned int allocated_size;
+
+	/// \brief Keeps data alive when it refers to memory not owned by the buffer
+	std::shared_ptr<void> owner;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -75,6 +93,15 @@ DataBuffer::DataBuffer(const void *new_data, unsigned int new_size)
 	memcpy(impl->data, new_data, new_size);
 }
 
+DataBuffer::DataBuffer(const std::shared_ptr<void> &owner, const void *data, unsigned int size)
+: impl(std::make_shared<DataBuffer_Impl>())
+{
+	impl->owner = owner;
+	impl->data = const_cast<char *>(static_cast<const char *>(data));
+	impl->size = size;
+	impl->allocated_size = size;
+}
+
 DataBuffer::DataBuffer(const DataBuffer &new_data, unsigned int pos, unsigned int size)
 : impl(std::make_shared<DataBuffer_Impl>())
 {
@@ -142,13 +169,8 @@ void DataBuffer::set_size(unsigned int new_size)
 {
 	if (new_size > impl->allocated_size)
 	{
-		char *old_data = impl->data;
-		impl->data = new char[new_size];
-		memcpy(impl->data, old_data, impl->size);
-		delete[] old_data;
-		memset(impl->data+impl->size, 0, new_size-impl->size);
+		impl->reallocate(new_size);
 		impl->size = new_size;
-		impl->allocated_size = new_size;
 	}
 	else
 	{
@@ -160,12 +182,7 @@ void DataBuffer::set_capacity(unsigned int new_capacity)
 {
 	if (new_capacity > impl->allocated_size)
 	{
-		char *old_data = impl->data;
-		impl->data = new char[new_capacity];
-		memcpy(impl->data, old_data, impl->size);
-		delete[] old_data;
-		memset(impl->data+impl->size, 0, new_capacity-impl->size);
-		impl->allocated_size = new_capacity;
+		impl->reallocate(new_capacity);
 	}
 }
 
@@ -55,6 +55,9 @@ bool System::detect_cpu_extension(CPU_ExtensionX86 ext)
 
 #define __cpuid(out, infoType)\
 	asm("cpuid": "=a" ((out)[0]), "=b" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType));
+
+#define __cpuidex(out, infoType, subInfoType)\
+	asm("cpuid": "=a" ((out)[0]), "=b" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType), "c" (subInfoType));
 #else
 
 #define __cpuid(out, infoType) \
@@ -64,10 +67,39 @@ bool System::detect_cpu_extension(CPU_ExtensionX86 ext)
 			"popl %%ebx" \
 		: "=a" ((out)[0]), "=r" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType));
 
+#define __cpuidex(out, infoType, subInfoType) \
+	asm volatile(	"pushl %%ebx \n" \
+			"cpuid \n" \
+			"movl %%ebx, %1 \n" \
+			"popl %%ebx" \
+		: "=a" ((out)[0]), "=r" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType), "c" (subInfoType));
+
 #endif
 
+#define _xgetbv(xcr) \
+	__xgetbv_gcc(xcr)
+
+static inline unsigned long long __xgetbv_gcc(unsigned int xcr)
+{
+	unsigned int eax, edx;
+	asm volatile("xgetbv" : "=a" (eax), "=d" (edx) : "c" (xcr));
+	return ((unsigned long long)edx << 32) | eax;
+}
+
 #endif
 
+// AVX instructions can only be used if the OS saves the YMM registers on context switches
+static bool detect_avx_os_support()
+{
+	unsigned int cpuinfo[4] = {0};
+	__cpuid((int*)cpuinfo, 0x1);
+	if ((cpuinfo[2] & (1 << 27)) == 0) // OSXSAVE
+		return false;
+
+	// XCR0 bits 1 and 2: the OS saves the XMM and YMM state
+	return (_xgetbv(0) & 6) == 6;
+}
+
 bool System::detect_cpu_extension(CPU_ExtensionPPC ext)
 {
 	throw ("Congratulations, you've just been selected to code this feature!");
@@ -161,7 +193,7 @@ bool System::detect_cpu_extension(CPU_ExtensionX86 ext)
 	else if(ext == avx)
 	{
 		__cpuid((int*)cpuinfo, 0x1);
-		return ((cpuinfo[2] & (1 << 28)) != 0);
+		return ((cpuinfo[2] & (1 << 28)) != 0) && detect_avx_os_support();
 	}
 	else if(ext == aes)
 	{
@@ -182,6 +214,24 @@ bool System::detect_cpu_extension(CPU_ExtensionX86 ext)
 		__cpuid((int*)cpuinfo, 0x80000001);
 		return ((cpuinfo[2] & (1 << 16)) != 0);
 	}
+	else if(ext == avx2)
+	{
+		__cpuid((int*)cpuinfo, 0);
+		if(cpuinfo[0] < 7)
+			return false;
+
+		__cpuidex((int*)cpuinfo, 7, 0);
+		return ((cpuinfo[1] & (1 << 5)) != 0) && detect_avx_os_support();
+	}
+	else if(ext == sha)
+	{
+		__cpuid((int*)cpuinfo, 0);
+		if(cpuinfo[0] < 7)
+			return false;
+
+		__cpuidex((int*)cpuinfo, 7, 0);
+		return ((cpuinfo[1] & (1 << 29)) != 0);
+	}
 	return false;
 }
 
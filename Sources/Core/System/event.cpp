@@ -34,13 +34,16 @@
 #ifdef WIN32
 #include "Win32/event_provider_win32.h"
 #else
+#include "API/Core/System/system.h"
+#ifdef __linux__
+#include "Unix/event_provider_eventfd.h"
+#else
 #include "Unix/event_provider_socketpair.h"
+#endif
+#include <poll.h>
 #include <errno.h>
 #include <stdlib.h>
-#endif
-
-#ifndef WIN32
-#include <sys/time.h>
+#include <string.h>
 #endif
 
 namespace clan
@@ -54,6 +57,11 @@ Event::Event(bool manual_reset, bool initial_state)
 : impl(std::make_shared<Event_Impl>(new EventProvider_Win32(manual_reset, initial_state)))
 {
 }
+#elif defined(__linux__)
+Event::Event(bool manual_reset, bool initial_state)
+: impl(std::make_shared<Event_Impl>(new EventProvider_Eventfd(manual_reset, initial_state)))
+{
+}
 #else
 Event::Event(bool manual_reset, bool initial_state)
 : impl(std::make_shared<Event_Impl>(new EventProvider_Socketpair(manual_reset, initial_state)))
@@ -174,81 +182,56 @@ int Event::wait(int count, Event const * const * events, int timeout)
 			return index_events;
 	}
 
-	// Placing the timeval struct here allows linux systems to more
-	// correctly resume a select if it was awaken by a complex event.
-	// On non-linux unixes (those that do not update timeval), the
-	// timeout precision will be more inaccurate for manual reset
-	// events with multiple listeners.
-	//   -- mbn 4 nov 2004
-	timeval tv;
-	if (timeout == -1)
-	{
-		// Just set the timeval to zero.  Not really needed since we don't pass the field to select in this case.
-		tv.tv_sec = 0;
-		tv.tv_usec = 0;
-	}
-	else
+	// poll() has no FD_SETSIZE limit on the descriptor numbers, unlike select().
+	// Use an EventWaitSet when waiting on the same events repeatedly.
+	std::vector<pollfd> handles;
+	std::vector<std::pair<int, int> > handle_owners; // event index, handle index
+	for (index_events = 0; index_events < count; index_events++)
 	{
-		tv.tv_sec = timeout / 1000;
-		tv.tv_usec = (timeout % 1000) * 1000;
+		EventProvider *provider = events[index_events]->impl->provider;
+		int num_handles = provider->get_num_event_handles();
+		for (int i=0; i<num_handles; i++)
+		{
+			pollfd handle;
+			handle.fd = provider->get_event_handle(i);
+			handle.revents = 0;
+			switch (provider->get_event_type(i))
+			{
+			case EventProvider::type_fd_read:
+				handle.events = POLLIN;
+				break;
+			case EventProvider::type_fd_write:
+				handle.events = POLLOUT;
+				break;
+			case EventProvider::type_fd_exception:
+			default:
+				handle.events = POLLPRI;
+				break;
+			}
+			handles.push_back(handle);
+			handle_owners.push_back(std::pair<int, int>(index_events, i));
+		}
 	}
 
+	ubyte64 time_start = (timeout > 0) ? System::get_time() : 0;
 	while (true)
 	{
-		bool reads = false;
-		bool writes = false;
-		bool exceptions = false;
-		int highest_fd = -1;
-		fd_set rfds, wfds, efds;
-		FD_ZERO(&rfds);
-		FD_ZERO(&wfds);
-		FD_ZERO(&efds);
-
-		for (index_events = 0; index_events < count; index_events++)
+		int time_to_wait = -1;
+		if (timeout == 0)
 		{
-			EventProvider *provider = events[index_events]->impl->provider;
-			if (provider == 0)
-				throw Exception("Event's EventProvider is a null pointer!");
-			int num_handles = provider->get_num_event_handles();
-			for (int i=0; i<num_handles; i++)
-			{
-				int handle = provider->get_event_handle(i);
-				switch (provider->get_event_type(i))
-				{
-				case EventProvider::type_fd_read:
-					FD_SET(handle, &rfds);
-					if (handle > highest_fd)
-						highest_fd = handle;
-					reads = true;
-					break;
-				case EventProvider::type_fd_write:
-					FD_SET(handle, &wfds);
-					if (handle > highest_fd)
-						highest_fd = handle;
-					writes = true;
-					break;
-				case EventProvider::type_fd_exception:
-					FD_SET(handle, &efds);
-					if (handle > highest_fd)
-						highest_fd = handle;
-					exceptions = true;
-					break;
-				}
-			}
+			time_to_wait = 0;
 		}
-
-		int result;
-		do
+		else if (timeout > 0)
 		{
-			result = select(highest_fd+1,
-					reads ? &rfds : 0,
-					writes ? &wfds : 0,
-					exceptions ? &efds : 0,
-					(timeout == -1) ? 0 : &tv);
-		} while (result == -1 && errno == EINTR); // The syscall was interrupted.  Try again.
-		
-		if (result == -1) // Error occoured
+			ubyte64 time_elapsed = System::get_time() - time_start;
+			time_to_wait = (time_elapsed < (ubyte64)timeout) ? timeout - (int)time_elapsed : 0;
+		}
+
+		int result = poll(handles.empty() ? 0 : &handles[0], handles.size(), time_to_wait);
+		if (result == -1)
 		{
+			if (errno == EINTR) // The syscall was interrupted.  Try again.
+				continue;
 			throw Exception(std::string("Event wait failed! Unix Error: ") + strerror(errno));
 		}
 		else if (result == 0) // Timed out
@@ -257,39 +240,28 @@ int Event::wait(int count, Event const * const * events, int timeout)
 		}
 		else // Got a message
 		{
-			// find the flagged sockets
-			for (index_events = 0; index_events < count; index_events++)
+			// find the flagged handles, they are in event order
+			for (size_t i = 0; i < handles.size(); i++)
 			{
-				EventProvider *provider = events[index_events]->impl->provider;
-				if (provider == 0)
-					throw Exception("Event's EventProvider is a null pointer!");
-				int num_handles = provider->get_num_event_handles();
-				for (int i=0; i<num_handles; i++)
+				bool flagged = false;
+				switch (handles[i].events)
 				{
-					int handle = provider->get_event_handle(i);
-					bool flagged = false;
-					switch (provider->get_event_type(i))
-					{
-					case EventProvider::type_fd_read:
-						if (FD_ISSET(handle, &rfds))
-							flagged = true;
-						break;
-					case EventProvider::type_fd_write:
-						if (FD_ISSET(handle, &wfds))
-							flagged = true;
-						break;
-					case EventProvider::type_fd_exception:
-						if (FD_ISSET(handle, &efds))
-							flagged = true;
-						break;
-					}
+				case POLLIN:
+					flagged = (handles[i].revents & (POLLIN | POLLERR | POLLHUP)) != 0;
+					break;
+				case POLLOUT:
+					flagged = (handles[i].revents & (POLLOUT | POLLERR | POLLHUP)) != 0;
+					break;
+				default:
+					flagged = (handles[i].revents & POLLPRI) != 0;
+					break;
+				}
 
-					if (flagged)
-					{
-						flagged = provider->check_after_wait(i);
-						if (flagged)
-							return index_events;
-					}
+				if (flagged)
+				{
+					EventProvider *provider = events[handle_owners[i].first]->impl->provider;
+					if (provider->check_after_wait(handle_owners[i].second))
+						return handle_owners[i].first;
 				}
 			}
 		}
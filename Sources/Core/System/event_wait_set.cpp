@@ -0,0 +1,541 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/event_wait_set.h"
+#include "API/Core/System/event.h"
+#include "API/Core/System/event_provider.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/System/system.h"
+#include <algorithm>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#elif !defined(WIN32)
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace clan
+{
+
+class EventWaitSet_Slot
+{
+public:
+	EventWaitSet_Slot(const Event &event, int index) : event(event), index(index) { }
+
+	Event event;
+	int index;
+};
+
+#ifndef WIN32
+class EventWaitSet_Listener
+{
+public:
+	EventWaitSet_Listener(EventWaitSet_Slot *slot, int handle_index, EventProvider::EventType type)
+	: slot(slot), handle_index(handle_index), type(type) { }
+
+	bool operator<(const EventWaitSet_Listener &other) const
+	{
+		return slot->index < other.slot->index || (slot->index == other.slot->index && handle_index < other.handle_index);
+	}
+
+	EventWaitSet_Slot *slot;
+	int handle_index;
+	EventProvider::EventType type;
+};
+#endif
+
+#ifdef __linux__
+class EventWaitSet_Descriptor
+{
+public:
+	EventWaitSet_Descriptor() : mask(0) { }
+
+	uint32_t mask;
+	std::vector<EventWaitSet_Listener> listeners;
+};
+#endif
+
+class EventWaitSet_Impl
+{
+public:
+	EventWaitSet_Impl();
+	~EventWaitSet_Impl();
+
+	void register_slot(EventWaitSet_Slot *slot);
+	void unregister_slot(EventWaitSet_Slot *slot);
+	int wait(int timeout);
+
+	std::vector<std::unique_ptr<EventWaitSet_Slot> > slots;
+
+private:
+	int check_before_wait();
+	int get_time_to_wait(int timeout, ubyte64 time_start);
+
+#ifdef __linux__
+	void remove_listener(EventWaitSet_Slot *slot, int handle_index, int handle);
+	int update_descriptor(int handle, bool force_modify);
+	static uint32_t get_mask(EventProvider::EventType type);
+	static bool is_flagged(EventProvider::EventType type, uint32_t events);
+
+	int epoll_handle;
+	std::unordered_map<int, EventWaitSet_Descriptor> descriptors;
+	std::vector<epoll_event> ready_events;
+	std::vector<EventWaitSet_Listener> candidates;
+
+	static const int max_events_per_wait = 64;
+#elif !defined(WIN32)
+	void build_poll_handles();
+
+	bool poll_handles_dirty;
+	std::vector<pollfd> poll_handles;
+	std::vector<EventWaitSet_Listener> poll_listeners;
+#endif
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// EventWaitSet Construction:
+
+EventWaitSet::EventWaitSet()
+: impl(new EventWaitSet_Impl())
+{
+}
+
+EventWaitSet::~EventWaitSet()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// EventWaitSet Attributes:
+
+int EventWaitSet::get_size() const
+{
+	return (int)impl->slots.size();
+}
+
+Event EventWaitSet::get_event(int index) const
+{
+	if (index < 0 || index >= (int)impl->slots.size())
+		throw Exception("EventWaitSet index out of range");
+	return impl->slots[index]->event;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// EventWaitSet Operations:
+
+int EventWaitSet::add(const Event &event)
+{
+	int index = (int)impl->slots.size();
+	std::unique_ptr<EventWaitSet_Slot> slot(new EventWaitSet_Slot(event, index));
+	impl->register_slot(slot.get());
+	impl->slots.push_back(std::move(slot));
+	return index;
+}
+
+void EventWaitSet::replace(int index, const Event &event)
+{
+	if (index < 0 || index >= (int)impl->slots.size())
+		throw Exception("EventWaitSet index out of range");
+
+	EventWaitSet_Slot *slot = impl->slots[index].get();
+	if (slot->event.get_event_provider() == event.get_event_provider())
+		return;
+
+	impl->unregister_slot(slot);
+	slot->event = event;
+	impl->register_slot(slot);
+}
+
+void EventWaitSet::remove(int index)
+{
+	if (index < 0 || index >= (int)impl->slots.size())
+		throw Exception("EventWaitSet index out of range");
+
+	impl->unregister_slot(impl->slots[index].get());
+	impl->slots.erase(impl->slots.begin() + index);
+	for (size_t i = index; i < impl->slots.size(); i++)
+		impl->slots[i]->index = (int)i;
+}
+
+void EventWaitSet::clear()
+{
+	for (size_t i = 0; i < impl->slots.size(); i++)
+		impl->unregister_slot(impl->slots[i].get());
+	impl->slots.clear();
+}
+
+int EventWaitSet::wait(int timeout)
+{
+	return impl->wait(timeout);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// EventWaitSet_Impl Implementation:
+
+int EventWaitSet_Impl::check_before_wait()
+{
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		EventProvider *provider = slots[i]->event.get_event_provider();
+		if (provider->check_before_wait())
+			return (int)i;
+	}
+	return -1;
+}
+
+int EventWaitSet_Impl::get_time_to_wait(int timeout, ubyte64 time_start)
+{
+	if (timeout <= 0)
+		return timeout < 0 ? -1 : 0;
+
+	// time_start is only read for positive timeouts
+	ubyte64 time_elapsed = System::get_time() - time_start;
+	return (time_elapsed < (ubyte64)timeout) ? timeout - (int)time_elapsed : 0;
+}
+
+#ifdef WIN32
+
+EventWaitSet_Impl::EventWaitSet_Impl()
+{
+}
+
+EventWaitSet_Impl::~EventWaitSet_Impl()
+{
+}
+
+void EventWaitSet_Impl::register_slot(EventWaitSet_Slot *slot)
+{
+	if (slot->event.get_event_provider() == 0)
+		throw Exception("Event's EventProvider is a null pointer!");
+}
+
+void EventWaitSet_Impl::unregister_slot(EventWaitSet_Slot *slot)
+{
+}
+
+int EventWaitSet_Impl::wait(int timeout)
+{
+	// WaitForMultipleObjects takes the handles on every call, so there is nothing to keep registered
+	std::vector<Event *> events;
+	events.reserve(slots.size());
+	for (size_t i = 0; i < slots.size(); i++)
+		events.push_back(&slots[i]->event);
+	return Event::wait(events, timeout);
+}
+
+#elif defined(__linux__)
+
+EventWaitSet_Impl::EventWaitSet_Impl()
+: epoll_handle(-1), ready_events(max_events_per_wait)
+{
+	epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_handle == -1)
+		throw Exception(std::string("Unable to create epoll instance: ") + strerror(errno));
+}
+
+EventWaitSet_Impl::~EventWaitSet_Impl()
+{
+	close(epoll_handle);
+}
+
+void EventWaitSet_Impl::register_slot(EventWaitSet_Slot *slot)
+{
+	EventProvider *provider = slot->event.get_event_provider();
+	if (provider == 0)
+		throw Exception("Event's EventProvider is a null pointer!");
+
+	int num_handles = provider->get_num_event_handles();
+	for (int i = 0; i < num_handles; i++)
+	{
+		int handle = provider->get_event_handle(i);
+		descriptors[handle].listeners.push_back(EventWaitSet_Listener(slot, i, provider->get_event_type(i)));
+
+		// Always tell the kernel: the descriptor may have been closed and reused since it was last registered
+		int error = update_descriptor(handle, true);
+		if (error != 0)
+		{
+			for (int j = i; j >= 0; j--)
+				remove_listener(slot, j, provider->get_event_handle(j));
+			throw Exception(std::string("Unable to add event to epoll set: ") + strerror(error));
+		}
+	}
+}
+
+void EventWaitSet_Impl::unregister_slot(EventWaitSet_Slot *slot)
+{
+	EventProvider *provider = slot->event.get_event_provider();
+	int num_handles = provider->get_num_event_handles();
+	for (int i = 0; i < num_handles; i++)
+		remove_listener(slot, i, provider->get_event_handle(i));
+}
+
+void EventWaitSet_Impl::remove_listener(EventWaitSet_Slot *slot, int handle_index, int handle)
+{
+	auto it = descriptors.find(handle);
+	if (it == descriptors.end())
+		return;
+
+	std::vector<EventWaitSet_Listener> &listeners = it->second.listeners;
+	for (size_t i = 0; i < listeners.size(); i++)
+	{
+		if (listeners[i].slot == slot && listeners[i].handle_index == handle_index)
+		{
+			listeners.erase(listeners.begin() + i);
+			break;
+		}
+	}
+
+	// Failures are ignored: a closed descriptor has already left the epoll set
+	update_descriptor(handle, false);
+}
+
+int EventWaitSet_Impl::update_descriptor(int handle, bool force_modify)
+{
+	auto it = descriptors.find(handle);
+	EventWaitSet_Descriptor &descriptor = it->second;
+
+	if (descriptor.listeners.empty())
+	{
+		if (descriptor.mask != 0)
+			epoll_ctl(epoll_handle, EPOLL_CTL_DEL, handle, 0);
+		descriptors.erase(it);
+		return 0;
+	}
+
+	uint32_t mask = 0;
+	for (size_t i = 0; i < descriptor.listeners.size(); i++)
+		mask |= get_mask(descriptor.listeners[i].type);
+
+	if (mask == descriptor.mask && !force_modify)
+		return 0;
+
+	epoll_event event;
+	memset(&event, 0, sizeof(epoll_event));
+	event.events = mask;
+	event.data.fd = handle;
+
+	int result;
+	if (descriptor.mask == 0)
+	{
+		result = epoll_ctl(epoll_handle, EPOLL_CTL_ADD, handle, &event);
+		if (result == -1 && errno == EEXIST)
+			result = epoll_ctl(epoll_handle, EPOLL_CTL_MOD, handle, &event);
+	}
+	else
+	{
+		result = epoll_ctl(epoll_handle, EPOLL_CTL_MOD, handle, &event);
+		if (result == -1 && errno == ENOENT)
+			result = epoll_ctl(epoll_handle, EPOLL_CTL_ADD, handle, &event);
+	}
+
+	if (result == -1)
+		return errno;
+
+	descriptor.mask = mask;
+	return 0;
+}
+
+uint32_t EventWaitSet_Impl::get_mask(EventProvider::EventType type)
+{
+	switch (type)
+	{
+	case EventProvider::type_fd_read:
+		return EPOLLIN;
+	case EventProvider::type_fd_write:
+		return EPOLLOUT;
+	case EventProvider::type_fd_exception:
+	default:
+		return EPOLLPRI;
+	}
+}
+
+bool EventWaitSet_Impl::is_flagged(EventProvider::EventType type, uint32_t events)
+{
+	// select() reports errors and hang ups as readable and writable, so do the same here
+	switch (type)
+	{
+	case EventProvider::type_fd_read:
+		return (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+	case EventProvider::type_fd_write:
+		return (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0;
+	case EventProvider::type_fd_exception:
+	default:
+		return (events & EPOLLPRI) != 0;
+	}
+}
+
+int EventWaitSet_Impl::wait(int timeout)
+{
+	int flagged_index = check_before_wait();
+	if (flagged_index != -1)
+		return flagged_index;
+
+	ubyte64 time_start = (timeout > 0) ? System::get_time() : 0;
+	while (true)
+	{
+		int time_to_wait = get_time_to_wait(timeout, time_start);
+		int count = epoll_wait(epoll_handle, &ready_events[0], max_events_per_wait, time_to_wait);
+		if (count == -1)
+		{
+			if (errno == EINTR) // The syscall was interrupted.  Try again.
+				continue;
+			throw Exception(std::string("Event wait failed! Unix Error: ") + strerror(errno));
+		}
+		else if (count == 0)
+		{
+			return -1;
+		}
+
+		candidates.clear();
+		for (int i = 0; i < count; i++)
+		{
+			auto it = descriptors.find(ready_events[i].data.fd);
+			if (it == descriptors.end())
+				continue;
+			const std::vector<EventWaitSet_Listener> &listeners = it->second.listeners;
+			for (size_t j = 0; j < listeners.size(); j++)
+			{
+				if (is_flagged(listeners[j].type, ready_events[i].events))
+					candidates.push_back(listeners[j]);
+			}
+		}
+
+		// Lowest index wins, same as Event::wait
+		std::sort(candidates.begin(), candidates.end());
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			EventProvider *provider = candidates[i].slot->event.get_event_provider();
+			if (provider->check_after_wait(candidates[i].handle_index))
+				return candidates[i].slot->index;
+		}
+	}
+}
+
+#else
+
+EventWaitSet_Impl::EventWaitSet_Impl()
+: poll_handles_dirty(false)
+{
+}
+
+EventWaitSet_Impl::~EventWaitSet_Impl()
+{
+}
+
+void EventWaitSet_Impl::register_slot(EventWaitSet_Slot *slot)
+{
+	if (slot->event.get_event_provider() == 0)
+		throw Exception("Event's EventProvider is a null pointer!");
+	poll_handles_dirty = true;
+}
+
+void EventWaitSet_Impl::unregister_slot(EventWaitSet_Slot *slot)
+{
+	poll_handles_dirty = true;
+}
+
+void EventWaitSet_Impl::build_poll_handles()
+{
+	poll_handles.clear();
+	poll_listeners.clear();
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		EventProvider *provider = slots[i]->event.get_event_provider();
+		int num_handles = provider->get_num_event_handles();
+		for (int j = 0; j < num_handles; j++)
+		{
+			EventProvider::EventType type = provider->get_event_type(j);
+
+			pollfd handle;
+			handle.fd = provider->get_event_handle(j);
+			handle.events = (type == EventProvider::type_fd_read) ? POLLIN : (type == EventProvider::type_fd_write) ? POLLOUT : POLLPRI;
+			handle.revents = 0;
+			poll_handles.push_back(handle);
+			poll_listeners.push_back(EventWaitSet_Listener(slots[i].get(), j, type));
+		}
+	}
+	poll_handles_dirty = false;
+}
+
+int EventWaitSet_Impl::wait(int timeout)
+{
+	int flagged_index = check_before_wait();
+	if (flagged_index != -1)
+		return flagged_index;
+
+	if (poll_handles_dirty)
+		build_poll_handles();
+
+	ubyte64 time_start = (timeout > 0) ? System::get_time() : 0;
+	while (true)
+	{
+		int time_to_wait = get_time_to_wait(timeout, time_start);
+		int count = poll(poll_handles.empty() ? 0 : &poll_handles[0], poll_handles.size(), time_to_wait);
+		if (count == -1)
+		{
+			if (errno == EINTR) // The syscall was interrupted.  Try again.
+				continue;
+			throw Exception(std::string("Event wait failed! Unix Error: ") + strerror(errno));
+		}
+		else if (count == 0)
+		{
+			return -1;
+		}
+
+		// The handles are stored in index order, so the first flagged one has the lowest index
+		for (size_t i = 0; i < poll_handles.size(); i++)
+		{
+			short revents = poll_handles[i].revents;
+			bool flagged;
+			switch (poll_listeners[i].type)
+			{
+			case EventProvider::type_fd_read:
+				flagged = (revents & (POLLIN | POLLERR | POLLHUP)) != 0;
+				break;
+			case EventProvider::type_fd_write:
+				flagged = (revents & (POLLOUT | POLLERR | POLLHUP)) != 0;
+				break;
+			default:
+				flagged = (revents & POLLPRI) != 0;
+				break;
+			}
+
+			if (flagged && poll_listeners[i].slot->event.get_event_provider()->check_after_wait(poll_listeners[i].handle_index))
+				return poll_listeners[i].slot->index;
+		}
+	}
+}
+
+#endif
+
+}
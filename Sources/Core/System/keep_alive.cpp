@@ -30,6 +30,7 @@
 #include "API/Core/System/keep_alive.h"
 #include "API/Core/System/system.h"
 #include "API/Core/System/event.h"
+#include "API/Core/System/event_wait_set.h"
 #include <algorithm>
 
 namespace clan
@@ -42,23 +43,24 @@ public:
     Event wakeup_event;
 };
 
+class KeepAlive_ThreadData
+{
+public:
+	std::vector<KeepAliveObject *> objects;
+
+	/// \brief Wakeup events of the objects, in the same order as objects
+	EventWaitSet wait_set;
+};
+
 void cl_alloc_tls_keep_alive_slot();
-void cl_set_keep_alive_vector(std::vector<KeepAliveObject *> *v);
-std::vector<KeepAliveObject *> *cl_get_keep_alive_vector();
+void cl_set_keep_alive_data(KeepAlive_ThreadData *data);
+KeepAlive_ThreadData *cl_get_keep_alive_data();
 std::function<int /*retval*/(const std::vector<Event> &/*events*/, int /*timeout */)> cl_keepalive_func_event_wait;
 std::function<void *()> cl_keepalive_func_thread_id;
 std::function<void(void *)> cl_keepalive_func_awake_thread;
 
 void KeepAlive::process(int timeout)
 {
-	// Get the objects to wait for
-	std::vector<KeepAliveObject *> objects = get_objects();
-	std::vector<Event> events;
-	for (std::vector<KeepAliveObject *>::size_type i = 0; i < objects.size(); i++)
-	{
-		events.push_back(objects[i]->impl->wakeup_event);
-	}
-		
 	ubyte64 time_start = System::get_time();
 	while (true)
 	{
@@ -72,15 +74,29 @@ void KeepAlive::process(int timeout)
 			time_to_wait = -1;
 		}
 
+		// Objects can be created and destroyed while processing, so fetch them on every iteration
+		KeepAlive_ThreadData *data = cl_get_keep_alive_data();
+
 		// Wait for the events
 		int wakeup_reason;
 		if (cl_keepalive_func_event_wait)
 		{
+			std::vector<Event> events;
+			if (data)
+			{
+				for (std::vector<KeepAliveObject *>::size_type i = 0; i < data->objects.size(); i++)
+					events.push_back(data->objects[i]->impl->wakeup_event);
+			}
 			wakeup_reason = cl_keepalive_func_event_wait(events, time_to_wait);
 		}
+		else if (data)
+		{
+			// The wait set keeps the wakeup events registered between calls
+			wakeup_reason = data->wait_set.wait(time_to_wait);
+		}
 		else
 		{
-			wakeup_reason = Event::wait(events, time_to_wait);
+			wakeup_reason = Event::wait(0, 0, time_to_wait);
 		}
 
 		// Check for Timeout
@@ -92,10 +108,11 @@ void KeepAlive::process(int timeout)
 		timeout = 0;	// Event found, reset the timeout
 
 		// Process the event
-		if ( ((unsigned int) wakeup_reason) < events.size())	// (Note, wakeup_reason is >=0)
+		if (data && ((unsigned int) wakeup_reason) < data->objects.size())	// (Note, wakeup_reason is >=0)
 		{
-            objects[wakeup_reason]->impl->wakeup_event.reset();
-			objects[wakeup_reason]->process();
+			KeepAliveObject *object = data->objects[wakeup_reason];
+			object->impl->wakeup_event.reset();
+			object->process();
 		}
 	}
 }
@@ -117,9 +134,9 @@ std::function<void(void *)> &KeepAlive::func_awake_thread()
 
 std::vector<KeepAliveObject *> KeepAlive::get_objects()
 {
-	std::vector<KeepAliveObject*> *tls_objects = cl_get_keep_alive_vector();
-	if (tls_objects)
-		return *tls_objects;
+	KeepAlive_ThreadData *data = cl_get_keep_alive_data();
+	if (data)
+		return data->objects;
 	else
 		return std::vector<KeepAliveObject *>();
 }
@@ -130,23 +147,26 @@ KeepAliveObject::KeepAliveObject()
     if (KeepAlive::func_thread_id())
         impl->thread_id = KeepAlive::func_thread_id()();
     
-	std::vector<KeepAliveObject*> *tls_objects = cl_get_keep_alive_vector();
-	if (!tls_objects)
+	KeepAlive_ThreadData *data = cl_get_keep_alive_data();
+	if (!data)
 	{
-		tls_objects = new std::vector<KeepAliveObject*>();
-		cl_set_keep_alive_vector(tls_objects);
+		data = new KeepAlive_ThreadData();
+		cl_set_keep_alive_data(data);
 	}
-	tls_objects->push_back(this);
+	data->wait_set.add(impl->wakeup_event);
+	data->objects.push_back(this);
 }
 
 KeepAliveObject::~KeepAliveObject()
 {
-	std::vector<KeepAliveObject*> *tls_objects = cl_get_keep_alive_vector();
-	tls_objects->erase(std::find(tls_objects->begin(), tls_objects->end(), this));
-	if (tls_objects->empty())
+	KeepAlive_ThreadData *data = cl_get_keep_alive_data();
+	std::vector<KeepAliveObject *>::iterator it = std::find(data->objects.begin(), data->objects.end(), this);
+	data->wait_set.remove(it - data->objects.begin());
+	data->objects.erase(it);
+	if (data->objects.empty())
 	{
-		delete tls_objects;
-		cl_set_keep_alive_vector(0);
+		delete data;
+		cl_set_keep_alive_data(0);
 	}
 }
 
@@ -174,16 +194,16 @@ void cl_alloc_tls_keep_alive_slot()
 	}
 }
 
-void cl_set_keep_alive_vector(std::vector<KeepAliveObject *> *v)
+void cl_set_keep_alive_data(KeepAlive_ThreadData *data)
 {
 	cl_alloc_tls_keep_alive_slot();
-	TlsSetValue(cl_tls_keep_alive_index, v);
+	TlsSetValue(cl_tls_keep_alive_index, data);
 }
 
-std::vector<KeepAliveObject *> *cl_get_keep_alive_vector()
+KeepAlive_ThreadData *cl_get_keep_alive_data()
 {
 	cl_alloc_tls_keep_alive_slot();
-	return reinterpret_cast<std::vector<KeepAliveObject*> *>(TlsGetValue(cl_tls_keep_alive_index));
+	return reinterpret_cast<KeepAlive_ThreadData *>(TlsGetValue(cl_tls_keep_alive_index));
 }
 
 #elif defined(__APPLE__)
@@ -202,32 +222,32 @@ void cl_alloc_tls_keep_alive_slot()
 	}
 }
 
-void cl_set_keep_alive_vector(std::vector<KeepAliveObject *> *v)
+void cl_set_keep_alive_data(KeepAlive_ThreadData *data)
 {
 	cl_alloc_tls_keep_alive_slot();
-	pthread_setspecific(cl_tls_keep_alive_index, v);
+	pthread_setspecific(cl_tls_keep_alive_index, data);
 }
 
-std::vector<KeepAliveObject *> *cl_get_keep_alive_vector()
+KeepAlive_ThreadData *cl_get_keep_alive_data()
 {
 	cl_alloc_tls_keep_alive_slot();
-	return reinterpret_cast<std::vector<KeepAliveObject*> *>(pthread_getspecific(cl_tls_keep_alive_index));
+	return reinterpret_cast<KeepAlive_ThreadData *>(pthread_getspecific(cl_tls_keep_alive_index));
 }
 
 #else
 
-__thread std::vector<KeepAliveObject*> *cl_tls_keep_alive = 0;
+__thread KeepAlive_ThreadData *cl_tls_keep_alive = 0;
 
 void cl_alloc_tls_keep_alive_slot()
 {
 }
 
-void cl_set_keep_alive_vector(std::vector<KeepAliveObject *> *v)
+void cl_set_keep_alive_data(KeepAlive_ThreadData *data)
 {
-	cl_tls_keep_alive = v;
+	cl_tls_keep_alive = data;
 }
 
-std::vector<KeepAliveObject *> *cl_get_keep_alive_vector()
+KeepAlive_ThreadData *cl_get_keep_alive_data()
 {
 	return cl_tls_keep_alive;
 }
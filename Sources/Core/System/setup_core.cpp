@@ -32,6 +32,7 @@
 #include "API/Core/System/exception.h"
 #include "API/Core/System/thread_local_storage.h"
 #include "API/Core/System/system.h"
+#include "API/Core/Text/logger.h"
 
 namespace clan
 {
@@ -77,6 +78,9 @@ void SetupCore_Impl::init()
 
 void SetupCore_Impl::deinit()
 {
+	// Write the queued log lines while the loggers still exist
+	Logger::disable_async();
+
 #ifdef WIN32
 	::CoUninitialize();
 #endif
@@ -34,7 +34,11 @@
 #include "API/Core/System/thread.h"
 #include "API/Core/System/system.h"
 #include "API/Core/System/interlocked_variable.h"
+#include "API/Core/System/thread_local_storage.h"
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
 #include "API/Core/Math/cl_math.h"
 
 namespace clan
@@ -63,32 +67,191 @@ private:
 	std::function<void()> func;
 };
 
+class QueuedWork
+{
+public:
+	QueuedWork() : item(0), needs_completion(true) { }
+	QueuedWork(WorkItem *item, bool needs_completion) : item(item), needs_completion(needs_completion) { }
+
+	WorkItem *item;
+
+	/// \brief False if the item is deleted on the worker thread instead of being passed on to work_completed
+	bool needs_completion;
+};
+
+/// \brief Bounded multi-producer multi-consumer queue without locks
+class WorkQueue_SubmitQueue
+{
+public:
+	WorkQueue_SubmitQueue();
+
+	bool try_push(const QueuedWork &work);
+	bool try_pop(QueuedWork &work);
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		QueuedWork work;
+	};
+
+	enum { capacity = 4096, capacity_mask = capacity - 1 };
+
+	std::unique_ptr<Cell[]> cells;
+	std::atomic<size_t> enqueue_pos;
+	char padding[64];
+	std::atomic<size_t> dequeue_pos;
+};
+
+class WorkQueue_Impl;
+
+class WorkQueue_Worker
+{
+public:
+	WorkQueue_Worker(WorkQueue_Impl *queue, int index) : queue(queue), index(index), wakeup_event(false, false), sleeping(false) { }
+
+	WorkQueue_Impl *queue;
+	int index;
+	Thread thread;
+
+	Mutex mutex;
+	std::deque<QueuedWork> local_items;
+
+	Event wakeup_event;
+	std::atomic<bool> sleeping;
+
+	// Only accessed by the worker thread itself
+	std::vector<WorkItem *> finished_batch;
+};
+
 class WorkQueue_Impl : public KeepAliveObject
 {
 public:
-	WorkQueue_Impl(bool serial_queue);
+	WorkQueue_Impl(bool serial_queue, int num_threads);
 	~WorkQueue_Impl();
 
-	void queue(WorkItem *item); // transfers ownership
+	void queue(WorkItem *item, bool needs_completion = true); // transfers ownership
 	void work_completed(WorkItem *item); // transfers ownership
 
 	int get_items_queued() const { return items_queued.get(); }
+	int get_num_threads() const { return (int)workers.size(); }
+	bool is_serial_queue() const { return serial_queue; }
+
+	/// \brief Processes one queued item on the calling thread, if any is available
+	bool help_process_work();
 
 private:
 	void process();
-	void worker_main();
+	void worker_main(WorkQueue_Worker *worker);
+	void start_threads();
+
+	bool find_work(WorkQueue_Worker *worker, QueuedWork &work);
+	bool steal_work(WorkQueue_Worker *worker, QueuedWork &work);
+	void run_work(WorkQueue_Worker *worker, const QueuedWork &work);
+	void flush_finished(WorkQueue_Worker *worker);
+	void wake_one_worker();
 
 	bool serial_queue;
-	std::vector<Thread> threads;
+	std::vector<std::unique_ptr<WorkQueue_Worker> > workers;
+	std::atomic<bool> threads_started;
+	std::atomic<bool> stop_flag;
+	Mutex start_mutex;
+
+	WorkQueue_SubmitQueue submit_queue;
+	Mutex overflow_mutex;
+	std::deque<QueuedWork> overflow_items;
+	std::atomic<int> overflow_count;
+
+	std::atomic<int> unstarted_count;
+	std::atomic<int> sleeping_count;
+	std::atomic<unsigned int> wake_position;
+
 	Mutex mutex;
-	Event stop_event, work_available_event;
-	std::vector<WorkItem *> queued_items;
 	std::vector<WorkItem *> finished_items;
 	InterlockedVariable items_queued;
+
+	static cl_tls_variable WorkQueue_Worker *current_worker;
+
+	static const size_t finished_batch_size = 32;
+};
+
+cl_tls_variable WorkQueue_Worker *WorkQueue_Impl::current_worker = 0;
+
+/// \brief Completion state shared between a WorkGroup and its queued tasks
+///
+/// The tasks only reference this state and never the queue. A task may be deleted on a worker
+/// thread after the group has been waited for, and must not drop the last reference to the
+/// queue there, as the queue destructor joins its worker threads.
+class WorkGroup_State
+{
+public:
+	WorkGroup_State() : done_event(true, true) { }
+
+	void task_finished(std::exception_ptr task_exception);
+
+	InterlockedVariable pending;
+	Event done_event;
+
+	Mutex mutex;
+	std::exception_ptr exception;
+};
+
+class WorkGroup_Impl
+{
+public:
+	WorkGroup_Impl(const std::shared_ptr<WorkQueue_Impl> &queue) : queue(queue), state(std::make_shared<WorkGroup_State>()) { }
+
+	void wait(bool rethrow);
+
+	std::shared_ptr<WorkQueue_Impl> queue;
+	std::shared_ptr<WorkGroup_State> state;
+};
+
+class WorkItemGroupTask : public WorkItem
+{
+public:
+	WorkItemGroupTask(const std::shared_ptr<WorkGroup_State> &group, const std::function<void()> &func) : group(group), func(func) { }
+
+	void process_work()
+	{
+		std::exception_ptr task_exception;
+		try
+		{
+			func();
+		}
+		catch (...)
+		{
+			task_exception = std::current_exception();
+		}
+
+		// Release whatever the function captured before the waiting thread is allowed to continue
+		func = std::function<void()>();
+		group->task_finished(task_exception);
+	}
+
+private:
+	std::shared_ptr<WorkGroup_State> group;
+	std::function<void()> func;
 };
 
-WorkQueue::WorkQueue(bool serial_queue)
-	: impl(std::make_shared<WorkQueue_Impl>(serial_queue))
+/// \brief Function object calling the parallel_for function for one sub range
+class ParallelForChunk
+{
+public:
+	ParallelForChunk(const std::function<void(int, int)> &func, int begin, int end) : func(func), begin(begin), end(end) { }
+
+	void operator()() const { func(begin, end); }
+
+private:
+	const std::function<void(int, int)> &func;
+	int begin;
+	int end;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+WorkQueue::WorkQueue(bool serial_queue, int num_threads)
+	: impl(std::make_shared<WorkQueue_Impl>(serial_queue, num_threads))
 {
 }
 
@@ -116,42 +279,245 @@ int WorkQueue::get_items_queued() const
 	return impl->get_items_queued();
 }
 
+int WorkQueue::get_num_threads() const
+{
+	return impl->get_num_threads();
+}
+
+void WorkQueue::parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain_size)
+{
+	if (end <= begin)
+		return;
+
+	int count = end - begin;
+	if (grain_size <= 0)
+		grain_size = clan::max(count / ((impl->get_num_threads() + 1) * 4), 1);
+
+	// The group waits for all chunks before func goes out of scope
+	WorkGroup group(*this);
+	for (int chunk_begin = begin; chunk_begin < end; chunk_begin += clan::min(grain_size, end - chunk_begin))
+	{
+		int chunk_end = chunk_begin + clan::min(grain_size, end - chunk_begin);
+		group.run(ParallelForChunk(func, chunk_begin, chunk_end));
+	}
+	group.wait();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+WorkGroup::WorkGroup(WorkQueue &queue)
+	: impl(std::make_shared<WorkGroup_Impl>(queue.impl))
+{
+}
+
+WorkGroup::~WorkGroup()
+{
+	impl->wait(false);
+}
+
+int WorkGroup::get_pending() const
+{
+	return impl->state->pending.get();
+}
+
+void WorkGroup::run(const std::function<void()> &func)
+{
+	if (impl->state->pending.increment() == 1)
+		impl->state->done_event.reset();
+	impl->queue->queue(new WorkItemGroupTask(impl->state, func), false);
+}
+
+void WorkGroup::wait()
+{
+	impl->wait(true);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void WorkGroup_State::task_finished(std::exception_ptr task_exception)
+{
+	if (task_exception)
+	{
+		MutexSection mutex_lock(&mutex);
+		if (!exception)
+			exception = task_exception;
+	}
+
+	if (pending.decrement() == 0)
+		done_event.set();
+}
+
+void WorkGroup_Impl::wait(bool rethrow)
+{
+	while (state->pending.get() != 0)
+	{
+		if (!queue->help_process_work())
+		{
+			state->done_event.wait();
+
+			// A late set() from a previous batch may leave the event flagged while tasks are still pending
+			if (state->pending.get() != 0)
+				state->done_event.reset();
+		}
+	}
+
+	if (rethrow)
+	{
+		MutexSection mutex_lock(&state->mutex);
+		std::exception_ptr task_exception = state->exception;
+		state->exception = std::exception_ptr();
+		mutex_lock.unlock();
+		if (task_exception)
+			std::rethrow_exception(task_exception);
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
-WorkQueue_Impl::WorkQueue_Impl(bool serial_queue)
-	: serial_queue(serial_queue)
+WorkQueue_SubmitQueue::WorkQueue_SubmitQueue()
+	: cells(new Cell[capacity]), enqueue_pos(0), dequeue_pos(0)
+{
+	for (size_t i = 0; i < capacity; i++)
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool WorkQueue_SubmitQueue::try_push(const QueuedWork &work)
 {
+	Cell *cell;
+	size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+	while (true)
+	{
+		cell = &cells[pos & capacity_mask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+		if (difference == 0)
+		{
+			if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->work = work;
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool WorkQueue_SubmitQueue::try_pop(QueuedWork &work)
+{
+	Cell *cell;
+	size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+	while (true)
+	{
+		cell = &cells[pos & capacity_mask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)(pos + 1);
+		if (difference == 0)
+		{
+			if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = dequeue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	work = cell->work;
+	cell->sequence.store(pos + capacity, std::memory_order_release);
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+WorkQueue_Impl::WorkQueue_Impl(bool serial_queue, int num_threads)
+	: serial_queue(serial_queue), threads_started(false), stop_flag(false), overflow_count(0), unstarted_count(0), sleeping_count(0), wake_position(0)
+{
+	if (serial_queue)
+		num_threads = 1;
+	else if (num_threads <= 0)
+		num_threads = clan::max(System::get_num_cores() - 1, 1);
+
+	for (int i = 0; i < num_threads; i++)
+		workers.push_back(std::unique_ptr<WorkQueue_Worker>(new WorkQueue_Worker(this, i)));
 }
 
 WorkQueue_Impl::~WorkQueue_Impl()
 {
-	stop_event.set();
-	for (size_t i = 0; i < threads.size(); i++)
-		threads[i].join();
-	for (size_t i = 0; i < queued_items.size(); i++)
-		delete queued_items[i];
+	stop_flag.store(true);
+	if (threads_started.load())
+	{
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i]->wakeup_event.set();
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i]->thread.join();
+	}
+
+	QueuedWork work;
+	while (submit_queue.try_pop(work))
+		delete work.item;
+	for (size_t i = 0; i < overflow_items.size(); i++)
+		delete overflow_items[i].item;
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		for (size_t j = 0; j < workers[i]->local_items.size(); j++)
+			delete workers[i]->local_items[j].item;
+		for (size_t j = 0; j < workers[i]->finished_batch.size(); j++)
+			delete workers[i]->finished_batch[j];
+	}
 	for (size_t i = 0; i < finished_items.size(); i++)
 		delete finished_items[i];
 }
 
-void WorkQueue_Impl::queue(WorkItem *item) // transfers ownership
+void WorkQueue_Impl::start_threads()
 {
-	if (threads.empty())
+	if (threads_started.load(std::memory_order_acquire))
+		return;
+
+	MutexSection mutex_lock(&start_mutex);
+	if (!threads_started.load(std::memory_order_relaxed))
 	{
-		int num_cores = serial_queue ? 1 : clan::max(System::get_num_cores() - 1, 1);
-		for (int i = 0; i < num_cores; i++)
-		{
-			Thread thread;
-			thread.start(this, &WorkQueue_Impl::worker_main);
-			threads.push_back(thread);
-		}
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i]->thread.start(this, &WorkQueue_Impl::worker_main, workers[i].get());
+		threads_started.store(true, std::memory_order_release);
 	}
+}
+
+void WorkQueue_Impl::queue(WorkItem *item, bool needs_completion) // transfers ownership
+{
+	start_threads();
 
-	MutexSection mutex_lock(&mutex);
-	queued_items.push_back(item);
 	items_queued.increment();
-	mutex_lock.unlock();
-	work_available_event.set();
+	unstarted_count.fetch_add(1);
+	QueuedWork work(item, needs_completion);
+
+	WorkQueue_Worker *worker = current_worker;
+	if (worker && worker->queue == this && !serial_queue)
+	{
+		// Work spawned by one of our own workers stays local until stolen
+		MutexSection mutex_lock(&worker->mutex);
+		worker->local_items.push_back(work);
+	}
+	else if (overflow_count.load() != 0 || !submit_queue.try_push(work))
+	{
+		MutexSection mutex_lock(&overflow_mutex);
+		overflow_items.push_back(work);
+		overflow_count.fetch_add(1);
+	}
+
+	if (sleeping_count.load() != 0)
+		wake_one_worker();
 }
 
 void WorkQueue_Impl::work_completed(WorkItem *item) // transfers ownership
@@ -163,6 +529,24 @@ void WorkQueue_Impl::work_completed(WorkItem *item) // transfers ownership
 	set_wakeup_event();
 }
 
+bool WorkQueue_Impl::help_process_work()
+{
+	WorkQueue_Worker *worker = current_worker;
+	if (worker && worker->queue != this)
+		worker = 0;
+
+	// Serial queues must never run two items at the same time. Their own worker runs
+	// the next item nested in the one waiting, which keeps them one at a time and in order.
+	if (serial_queue && !worker)
+		return false;
+
+	QueuedWork work;
+	if (!find_work(worker, work))
+		return false;
+	run_work(worker, work);
+	return true;
+}
+
 void WorkQueue_Impl::process()
 {
 	MutexSection mutex_lock(&mutex);
@@ -186,28 +570,148 @@ void WorkQueue_Impl::process()
 	}
 }
 
-void WorkQueue_Impl::worker_main()
+void WorkQueue_Impl::worker_main(WorkQueue_Worker *worker)
 {
-	while (true)
+	current_worker = worker;
+	while (!stop_flag.load())
 	{
-		int wakeup_reason = Event::wait(stop_event, work_available_event);
-		if (wakeup_reason != 1)
-			break;
-		MutexSection mutex_lock(&mutex);
-		if (!queued_items.empty())
+		QueuedWork work;
+		if (find_work(worker, work))
 		{
-			WorkItem *item = queued_items.front();
-			queued_items.erase(queued_items.begin());
-			mutex_lock.unlock();
-			item->process_work();
-			mutex_lock.lock();
-			finished_items.push_back(item);
-			mutex_lock.unlock();
-			set_wakeup_event();
+			run_work(worker, work);
+			continue;
 		}
-		else
+
+		flush_finished(worker);
+
+		// Announce that we are going to sleep before checking for work one last time.
+		// queue() increments unstarted_count before it looks at sleeping_count, so either
+		// we see the new work here or queue() sees us sleeping and wakes us up.
+		worker->sleeping.store(true);
+		sleeping_count.fetch_add(1);
+		if (unstarted_count.load() != 0 || stop_flag.load())
+		{
+			if (worker->sleeping.exchange(false))
+				sleeping_count.fetch_sub(1);
+			// else someone already flagged our wakeup event and the next wait returns at once
+			continue;
+		}
+
+		worker->wakeup_event.wait();
+	}
+	current_worker = 0;
+}
+
+bool WorkQueue_Impl::find_work(WorkQueue_Worker *worker, QueuedWork &work)
+{
+	if (worker)
+	{
+		MutexSection mutex_lock(&worker->mutex);
+		if (!worker->local_items.empty())
+		{
+			// Newest first: the data it needs is most likely still in cache
+			work = worker->local_items.back();
+			worker->local_items.pop_back();
+			return true;
+		}
+	}
+
+	if (submit_queue.try_pop(work))
+		return true;
+
+	if (overflow_count.load() != 0)
+	{
+		MutexSection mutex_lock(&overflow_mutex);
+		if (!overflow_items.empty())
+		{
+			work = overflow_items.front();
+			overflow_items.pop_front();
+			overflow_count.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return steal_work(worker, work);
+}
+
+bool WorkQueue_Impl::steal_work(WorkQueue_Worker *worker, QueuedWork &work)
+{
+	int num_workers = (int)workers.size();
+	int start = worker ? worker->index + 1 : 0;
+	for (int i = 0; i < num_workers; i++)
+	{
+		WorkQueue_Worker *victim = workers[(start + i) % num_workers].get();
+		if (victim == worker)
+			continue;
+
+		// Never block on a busy victim, just move on to the next one
+		MutexSection mutex_lock(&victim->mutex, false);
+		if (!mutex_lock.try_lock())
+			continue;
+
+		if (!victim->local_items.empty())
+		{
+			// Oldest first: leaves the victim with the work closest to what it is doing now
+			work = victim->local_items.front();
+			victim->local_items.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkQueue_Impl::run_work(WorkQueue_Worker *worker, const QueuedWork &work)
+{
+	// Wake up another worker if there is more work than us around
+	if (unstarted_count.fetch_sub(1) > 1 && sleeping_count.load() != 0)
+		wake_one_worker();
+
+	work.item->process_work();
+
+	if (!work.needs_completion)
+	{
+		delete work.item;
+		items_queued.decrement();
+	}
+	else if (worker)
+	{
+		worker->finished_batch.push_back(work.item);
+		if (worker->finished_batch.size() >= finished_batch_size)
+			flush_finished(worker);
+	}
+	else
+	{
+		MutexSection mutex_lock(&mutex);
+		finished_items.push_back(work.item);
+		mutex_lock.unlock();
+		set_wakeup_event();
+	}
+}
+
+void WorkQueue_Impl::flush_finished(WorkQueue_Worker *worker)
+{
+	if (worker->finished_batch.empty())
+		return;
+
+	MutexSection mutex_lock(&mutex);
+	finished_items.insert(finished_items.end(), worker->finished_batch.begin(), worker->finished_batch.end());
+	mutex_lock.unlock();
+	worker->finished_batch.clear();
+	set_wakeup_event();
+}
+
+void WorkQueue_Impl::wake_one_worker()
+{
+	int num_workers = (int)workers.size();
+	int start = (int)(wake_position.fetch_add(1) % num_workers);
+	for (int i = 0; i < num_workers; i++)
+	{
+		WorkQueue_Worker *worker = workers[(start + i) % num_workers].get();
+		if (worker->sleeping.load(std::memory_order_relaxed) && worker->sleeping.exchange(false))
 		{
-			work_available_event.reset();
+			sleeping_count.fetch_sub(1);
+			worker->wakeup_event.set();
+			return;
 		}
 	}
 }
@@ -29,6 +29,8 @@
 #include "Core/precomp.h"
 #include "API/Core/Text/file_logger.h"
 #include "API/Core/IOData/file.h"
+#include "API/Core/IOData/file_help.h"
+#include "API/Core/IOData/directory.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/Text/string_format.h"
 
@@ -38,13 +40,18 @@ namespace clan
 /////////////////////////////////////////////////////////////////////////////
 // FileLogger Construction:
 
-FileLogger::FileLogger(const std::string &filename) : file(0)
+FileLogger::FileLogger(const std::string &filename)
+: filename(filename), file(0), file_size(0), max_file_size(0), max_backup_files(0)
 {
 	file = new File(filename, File::open_always, File::access_read_write);
+	file_size = file->get_size();
 }
 
 FileLogger::~FileLogger()
 {
+	// Waits for the asynchronous flusher to finish its current batch
+	disable();
+	flush();
 	delete file;
 }
 
@@ -54,16 +61,85 @@ FileLogger::~FileLogger()
 /////////////////////////////////////////////////////////////////////////////
 // FileLogger Operations:
 
+void FileLogger::set_rotation(byte64 max_size, int new_max_backup_files)
+{
+	MutexSection mutex_lock(&Logger::mutex);
+	max_file_size = max_size;
+	max_backup_files = new_max_backup_files;
+}
+
 void FileLogger::log(const std::string &type, const std::string &text)
 {
 	StringFormat format = get_log_string(type, text);
-	std::string log_line = StringHelp::text_to_local8(format.get_result());
+	pending_text += StringHelp::text_to_local8(format.get_result());
+
+	// The asynchronous flusher calls flush() after each batch
+	if (!Logger::is_async() || pending_text.length() >= (std::string::size_type)max_pending_size)
+		flush();
+}
+
+void FileLogger::flush()
+{
+	MutexSection mutex_lock(&Logger::mutex);
+	if (pending_text.empty())
+		return;
+
+	if (max_file_size > 0 && file_size > 0 && file_size + (byte64)pending_text.length() > max_file_size)
+		rotate();
 
 	file->seek(0, File::seek_end);
-	file->write(log_line.data(), (int) log_line.length());
+	file->write(pending_text.data(), (int) pending_text.length());
+	file_size += pending_text.length();
+	pending_text.clear();
 }
 
 /////////////////////////////////////////////////////////////////////////////
 // FileLogger Implementation:
 
+void FileLogger::rotate()
+{
+	// The current file stays open until its replacement has been created. If a step fails, logging
+	// continues in the current file and the rotation is tried again after another max_file_size bytes.
+	file_size = 0;
+
+	if (max_backup_files > 0)
+	{
+		try
+		{
+			std::string oldest = string_format("%1.%2", filename, max_backup_files);
+			if (FileHelp::file_exists(oldest))
+				FileHelp::delete_file(oldest);
+		}
+		catch (const Exception &)
+		{
+			return;
+		}
+
+		for (int i = max_backup_files - 1; i >= 1; i--)
+		{
+			std::string backup = string_format("%1.%2", filename, i);
+			if (FileHelp::file_exists(backup) && !Directory::rename(backup, string_format("%1.%2", filename, i + 1)))
+				return;
+		}
+
+		// Files are opened with share_delete, so the open file can be renamed on all platforms
+		if (!Directory::rename(filename, filename + ".1"))
+			return;
+	}
+
+	File *new_file = 0;
+	try
+	{
+		new_file = new File(filename, File::create_always, File::access_read_write);
+	}
+	catch (const Exception &)
+	{
+		// The current file is still valid, also after it was renamed to the first backup
+		return;
+	}
+
+	delete file;
+	file = new_file;
+}
+
 }
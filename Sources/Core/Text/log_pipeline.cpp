@@ -0,0 +1,459 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/System/system.h"
+#include "API/Core/Text/logger.h"
+#include "log_pipeline.h"
+
+namespace clan
+{
+
+#ifndef __APPLE__
+// Fast path in front of ThreadLocalStorage, which needs a string lookup
+static cl_tls_variable LogThreadBuffer *cl_log_thread_buffer = 0;
+static cl_tls_variable bool cl_log_thread_without_storage = false;
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// LogThreadBuffer Construction:
+
+LogThreadBuffer::LogThreadBuffer(int buffer_size)
+: capacity(1024), write_pos(0), read_pos(0), writing(false), orphaned(false)
+{
+	// Power of two, so positions can wrap around unsigned int
+	while (capacity < (unsigned int)buffer_size && capacity < (1u << 30))
+		capacity *= 2;
+	data.resize(capacity);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LogThreadBuffer Operations:
+
+unsigned int LogThreadBuffer::get_record_size(const std::string &type, const std::string &text, int args_length)
+{
+	unsigned int size = sizeof(RecordHeader) + type.length() + text.length() + args_length;
+	return (size + 7) & ~7u;
+}
+
+bool LogThreadBuffer::try_write(unsigned int record_size, const std::string &type, const std::string &text, const char *args_data, int args_length, bool formatted, bool &out_half_full)
+{
+	unsigned int write = write_pos.load(std::memory_order_relaxed);
+	unsigned int read = read_pos.load(std::memory_order_acquire);
+	unsigned int offset = write & (capacity - 1);
+	unsigned int contiguous = capacity - offset;
+
+	// Records never wrap around the end of the buffer. The rest of the buffer is skipped with a padding record instead.
+	unsigned int needed = record_size + ((contiguous < record_size) ? contiguous : 0);
+	unsigned int used = write - read;
+	if (capacity - used < needed)
+		return false;
+
+	if (contiguous < record_size)
+	{
+		RecordHeader *padding = reinterpret_cast<RecordHeader *>(&data[offset]);
+		padding->size = contiguous;
+		padding->flags = flag_padding;
+		offset = 0;
+	}
+
+	RecordHeader *header = reinterpret_cast<RecordHeader *>(&data[offset]);
+	header->size = record_size;
+	header->flags = formatted ? flag_formatted : 0;
+	header->time = (byte64)time(0);
+	header->type_length = type.length();
+	header->text_length = text.length();
+	header->args_length = args_length;
+	header->reserved = 0;
+
+	char *dest = reinterpret_cast<char *>(header + 1);
+	memcpy(dest, type.data(), type.length());
+	dest += type.length();
+	memcpy(dest, text.data(), text.length());
+	dest += text.length();
+	if (args_length > 0)
+		memcpy(dest, args_data, args_length);
+
+	write_pos.store(write + needed, std::memory_order_release);
+
+	out_half_full = (used < capacity / 2 && used + needed >= capacity / 2);
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LogThreadBufferHolder Construction:
+
+LogThreadBufferHolder::~LogThreadBufferHolder()
+{
+	// ThreadLocalStorage is destroyed by the thread that owns it, so no more lines can arrive
+	buffer->orphaned.store(true);
+#ifndef __APPLE__
+	if (cl_log_thread_buffer == buffer.get())
+		cl_log_thread_buffer = 0;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LogPipeline Construction:
+
+std::atomic<bool> LogPipeline::enabled(false);
+std::atomic<bool> LogPipeline::stopping(false);
+std::atomic<LogPipeline *> LogPipeline::instance(0);
+Mutex LogPipeline::instance_mutex;
+
+LogPipeline::LogPipeline()
+: buffer_size(64 * 1024), flush_interval(50), passes_started(0), passes_completed(0), stop_flag(false),
+  wakeup_event(false, false), pass_completed_event(true, false), last_time_seconds(0)
+{
+}
+
+LogPipeline *LogPipeline::get_instance()
+{
+	LogPipeline *pipeline = instance.load();
+	if (pipeline == 0)
+	{
+		MutexSection mutex_lock(&instance_mutex);
+		pipeline = instance.load();
+		if (pipeline == 0)
+		{
+			pipeline = new LogPipeline();
+			instance.store(pipeline);
+		}
+	}
+	return pipeline;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LogPipeline Operations:
+
+void LogPipeline::start(int new_buffer_size, int new_flush_interval)
+{
+	MutexSection control_lock(&control_mutex);
+	if (enabled.load())
+		return;
+
+	MutexSection mutex_lock(&mutex);
+	buffer_size = new_buffer_size;
+	flush_interval = new_flush_interval;
+	stop_flag = false;
+	mutex_lock.unlock();
+
+	thread.start(this, &LogPipeline::thread_main);
+	enabled.store(true);
+}
+
+void LogPipeline::stop()
+{
+	MutexSection control_lock(&control_mutex);
+	if (!enabled.load())
+		return;
+
+	// Threads check enabled after raising their writing flag, so once every flag is
+	// seen lowered no thread can write another record
+	stopping.store(true);
+	enabled.store(false);
+	MutexSection mutex_lock(&mutex);
+	std::vector<std::shared_ptr<LogThreadBuffer> > current_buffers = buffers;
+	mutex_lock.unlock();
+	for (size_t i = 0; i < current_buffers.size(); i++)
+	{
+		while (current_buffers[i]->writing.load())
+			System::sleep(1);
+	}
+
+	mutex_lock.lock();
+	stop_flag = true;
+	mutex_lock.unlock();
+	wakeup_event.set();
+	thread.join();
+	stopping.store(false);
+
+	rethrow_exception();
+}
+
+void LogPipeline::flush()
+{
+	MutexSection mutex_lock(&mutex);
+	if (!enabled.load())
+		return;
+	int target_pass = passes_started + 1;
+	mutex_lock.unlock();
+
+	wakeup_event.set();
+	while (true)
+	{
+		mutex_lock.lock();
+		bool done = passes_completed >= target_pass || stop_flag;
+		mutex_lock.unlock();
+		if (done)
+			break;
+		pass_completed_event.wait(flush_interval);
+	}
+
+	rethrow_exception();
+}
+
+bool LogPipeline::write(const std::string &type, const std::string &text, const char *args_data, int args_length, bool formatted)
+{
+	LogThreadBuffer *buffer = get_thread_buffer();
+	if (buffer == 0)
+		return false;
+
+	unsigned int record_size = LogThreadBuffer::get_record_size(type, text, args_length);
+	if (record_size > buffer->capacity / 2)
+	{
+		// Too large to queue, write it synchronously after the lines queued before it
+		flush();
+		wait_for_stop(buffer);
+		return false;
+	}
+
+	buffer->writing.store(true);
+	while (true)
+	{
+		if (!enabled.load())
+		{
+			// The line is written synchronously, after the lines this thread queued before
+			buffer->writing.store(false);
+			wait_for_stop(buffer);
+			return false;
+		}
+
+		bool half_full = false;
+		if (buffer->try_write(record_size, type, text, args_data, args_length, formatted, half_full))
+		{
+			buffer->writing.store(false, std::memory_order_release);
+			if (half_full)
+				wakeup_event.set();
+			return true;
+		}
+
+		// Buffer full: wait for the flusher to make room
+		buffer->writing.store(false);
+		wakeup_event.set();
+		System::sleep(1);
+		buffer->writing.store(true);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LogPipeline Implementation:
+
+LogThreadBuffer *LogPipeline::get_thread_buffer()
+{
+#ifndef __APPLE__
+	if (cl_log_thread_buffer)
+		return cl_log_thread_buffer;
+	if (cl_log_thread_without_storage)
+		return 0;
+#endif
+
+	const char *variable_name = "clan::LogPipeline::thread_buffer";
+	std::shared_ptr<LogThreadBufferHolder> holder;
+	try
+	{
+		holder = std::dynamic_pointer_cast<LogThreadBufferHolder>(ThreadLocalStorage::get_variable(variable_name));
+		if (!holder)
+		{
+			MutexSection mutex_lock(&mutex);
+			holder = std::make_shared<LogThreadBufferHolder>(std::make_shared<LogThreadBuffer>(buffer_size));
+			buffers.push_back(holder->buffer);
+			mutex_lock.unlock();
+
+			ThreadLocalStorage::set_variable(variable_name, holder);
+		}
+	}
+	catch (const Exception &)
+	{
+		// Thread was not started by clan::Thread. Its exit could not be detected, so it logs synchronously.
+#ifndef __APPLE__
+		cl_log_thread_without_storage = true;
+#endif
+		return 0;
+	}
+
+#ifndef __APPLE__
+	cl_log_thread_buffer = holder->buffer.get();
+#endif
+	return holder->buffer.get();
+}
+
+void LogPipeline::wait_for_stop(LogThreadBuffer *buffer)
+{
+	// stop() holds control_mutex from clearing enabled until the flusher thread has passed every queued line on
+	if (buffer->read_pos.load(std::memory_order_acquire) != buffer->write_pos.load(std::memory_order_relaxed))
+	{
+		MutexSection control_lock(&control_mutex);
+	}
+}
+
+void LogPipeline::thread_main()
+{
+	Thread::set_thread_name("Logger");
+
+	while (true)
+	{
+		wakeup_event.wait(flush_interval);
+
+		MutexSection mutex_lock(&mutex);
+		bool stop_requested = stop_flag;
+		passes_started++;
+		pass_completed_event.reset();
+		mutex_lock.unlock();
+
+		process_buffers();
+
+		mutex_lock.lock();
+		passes_completed++;
+		pass_completed_event.set();
+		mutex_lock.unlock();
+
+		if (stop_requested)
+			break;
+	}
+}
+
+void LogPipeline::process_buffers()
+{
+	MutexSection mutex_lock(&mutex);
+	std::vector<std::shared_ptr<LogThreadBuffer> > current_buffers = buffers;
+	mutex_lock.unlock();
+
+	// One lock and one flush per logger for the whole batch
+	MutexSection logger_lock(&Logger::mutex);
+	for (size_t i = 0; i < current_buffers.size(); i++)
+		process_buffer(current_buffers[i].get());
+	for (size_t i = 0; i < Logger::instances.size(); i++)
+	{
+		try
+		{
+			Logger::instances[i]->flush();
+		}
+		catch (...)
+		{
+			set_exception(std::current_exception());
+		}
+	}
+	logger_lock.unlock();
+
+	// Drop the buffers of threads that have exited once they are empty
+	mutex_lock.lock();
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		LogThreadBuffer *buffer = buffers[i].get();
+		if (buffer->orphaned.load() && buffer->read_pos.load() == buffer->write_pos.load())
+		{
+			buffers.erase(buffers.begin() + i);
+			i--;
+		}
+	}
+}
+
+void LogPipeline::process_buffer(LogThreadBuffer *buffer)
+{
+	unsigned int read = buffer->read_pos.load(std::memory_order_relaxed);
+	unsigned int write = buffer->write_pos.load(std::memory_order_acquire);
+	if (read == write)
+		return;
+
+	std::string type, text;
+	while (read != write)
+	{
+		const LogThreadBuffer::RecordHeader *header = reinterpret_cast<const LogThreadBuffer::RecordHeader *>(&buffer->data[read & (buffer->capacity - 1)]);
+		if ((header->flags & LogThreadBuffer::flag_padding) == 0)
+		{
+			const char *src = reinterpret_cast<const char *>(header + 1);
+			type.assign(src, header->type_length);
+			src += header->type_length;
+			text.assign(src, header->text_length);
+			src += header->text_length;
+
+			if (header->time != last_time_seconds || last_time.is_null())
+			{
+				last_time = get_record_time(header->time);
+				last_time_seconds = header->time;
+			}
+
+			// A logger throwing must not stop the rest of the batch from being consumed
+			try
+			{
+				if (header->flags & LogThreadBuffer::flag_formatted)
+				{
+					StringFormat format(text);
+					LogEventArgs::apply(format, src, header->args_length);
+					cl_log_dispatch(&last_time, type, format.get_result());
+				}
+				else
+				{
+					cl_log_dispatch(&last_time, type, text);
+				}
+			}
+			catch (...)
+			{
+				set_exception(std::current_exception());
+			}
+		}
+		read += header->size;
+	}
+
+	buffer->read_pos.store(read, std::memory_order_release);
+}
+
+void LogPipeline::set_exception(const std::exception_ptr &new_exception)
+{
+	// Only the first exception is kept until it has been reported
+	MutexSection mutex_lock(&mutex);
+	if (!exception)
+		exception = new_exception;
+}
+
+void LogPipeline::rethrow_exception()
+{
+	MutexSection mutex_lock(&mutex);
+	std::exception_ptr current_exception = exception;
+	exception = std::exception_ptr();
+	mutex_lock.unlock();
+
+	if (current_exception)
+		std::rethrow_exception(current_exception);
+}
+
+DateTime LogPipeline::get_record_time(byte64 seconds)
+{
+	time_t unix_time = (time_t)seconds;
+	tm tm_utc;
+#ifdef WIN32
+	gmtime_s(&tm_utc, &unix_time);
+#else
+	gmtime_r(&unix_time, &tm_utc);
+#endif
+	return DateTime(tm_utc.tm_year + 1900, tm_utc.tm_mon + 1, tm_utc.tm_mday, tm_utc.tm_hour, tm_utc.tm_min, tm_utc.tm_sec);
+}
+
+}
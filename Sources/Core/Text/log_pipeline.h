@@ -0,0 +1,163 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/event.h"
+#include "API/Core/System/mutex.h"
+#include "API/Core/System/thread.h"
+#include "API/Core/System/thread_local_storage.h"
+#include "API/Core/System/datetime.h"
+#include "API/Core/Text/logger.h"
+#include <atomic>
+#include <ctime>
+#include <exception>
+
+namespace clan
+{
+
+/// \brief Ring buffer of queued log lines written by one thread and read by the flusher thread.
+class LogThreadBuffer
+{
+public:
+	LogThreadBuffer(int capacity);
+
+	/// \brief Header in front of every record. The type, text and argument bytes follow it.
+	struct RecordHeader
+	{
+		unsigned int size;
+		unsigned int flags;
+		byte64 time; // Seconds since 1970
+		unsigned int type_length;
+		unsigned int text_length;
+		unsigned int args_length;
+		unsigned int reserved;
+	};
+
+	enum RecordFlags
+	{
+		flag_padding = 1,
+		flag_formatted = 2
+	};
+
+	static unsigned int get_record_size(const std::string &type, const std::string &text, int args_length);
+
+	/// \brief Returns true if the record was written. Only called by the owning thread.
+	bool try_write(unsigned int record_size, const std::string &type, const std::string &text, const char *args_data, int args_length, bool formatted, bool &out_half_full);
+
+	std::vector<char> data;
+	unsigned int capacity;
+
+	std::atomic<unsigned int> write_pos;
+	std::atomic<unsigned int> read_pos;
+
+	/// \brief Set while the owning thread is writing a record, so disable_async can wait for it
+	std::atomic<bool> writing;
+
+	/// \brief Set when the owning thread has exited
+	std::atomic<bool> orphaned;
+};
+
+/// \brief Holds the buffer of a thread in its ThreadLocalStorage, so thread exit is noticed.
+class LogThreadBufferHolder : public ThreadLocalStorageData
+{
+public:
+	LogThreadBufferHolder(const std::shared_ptr<LogThreadBuffer> &buffer) : buffer(buffer) { }
+	~LogThreadBufferHolder();
+
+	std::shared_ptr<LogThreadBuffer> buffer;
+};
+
+/// \brief Background thread dispatching the lines queued by log_event in asynchronous mode.
+///
+/// Created the first time asynchronous mode is enabled and never destroyed, so threads can
+/// keep pointers to their buffers across disable_async and enable_async.
+class LogPipeline
+{
+public:
+	static LogPipeline *get_instance();
+
+	void start(int buffer_size, int flush_interval);
+	void stop();
+	void flush();
+
+	/// \brief Returns false if the line must be logged synchronously.
+	bool write(const std::string &type, const std::string &text, const char *args_data, int args_length, bool formatted);
+
+	/// \brief Set while asynchronous mode is enabled
+	static std::atomic<bool> enabled;
+
+	/// \brief Set while stop passes the queued lines to the loggers. Threads still call write then, to keep their lines in order.
+	static std::atomic<bool> stopping;
+
+private:
+	LogPipeline();
+
+	static std::atomic<LogPipeline *> instance;
+	static Mutex instance_mutex;
+
+	LogThreadBuffer *get_thread_buffer();
+
+	/// \brief Waits until a running stop has passed the lines queued in buffer to the loggers
+	void wait_for_stop(LogThreadBuffer *buffer);
+
+	void thread_main();
+	void process_buffers();
+	void process_buffer(LogThreadBuffer *buffer);
+
+	/// \brief Stores an exception thrown by a logger on the flusher thread
+	void set_exception(const std::exception_ptr &exception);
+
+	/// \brief Rethrows the stored exception, if any, on the calling thread
+	void rethrow_exception();
+	static DateTime get_record_time(byte64 seconds);
+
+	Mutex mutex;
+	std::vector<std::shared_ptr<LogThreadBuffer> > buffers;
+	int buffer_size;
+	int flush_interval;
+	int passes_started;
+	int passes_completed;
+	bool stop_flag;
+
+	Thread thread;
+	Mutex control_mutex;
+	Event wakeup_event;
+	Event pass_completed_event;
+
+	DateTime last_time;
+	byte64 last_time_seconds;
+
+	/// \brief First exception thrown by a logger since the last flush or stop
+	std::exception_ptr exception;
+};
+
+/// \brief Passes a line to every enabled logger. Logger::mutex must be locked.
+void cl_log_dispatch(const DateTime *time, const std::string &type, const std::string &text);
+
+}
@@ -30,11 +30,19 @@
 #include "API/Core/System/datetime.h"
 #include "API/Core/Text/logger.h"
 #include "API/Core/Text/string_format.h"
+#include "API/Core/System/exception.h"
+#include "log_pipeline.h"
 #include <algorithm>
 
 namespace clan
 {
 
+// Number of enabled loggers, so log_event can return without locking when there are none
+static std::atomic<int> cl_num_loggers(0);
+
+// Time stamp of the line being dispatched. Protected by Logger::mutex.
+static const DateTime *cl_log_time = 0;
+
 /////////////////////////////////////////////////////////////////////////////
 // Logger Construction:
 
@@ -62,7 +70,10 @@ void Logger::enable()
 {
 	MutexSection mutex_lock(&Logger::mutex);
 	if (std::find(instances.begin(), instances.end(), this) == instances.end())
+	{
 		instances.push_back(this);
+		cl_num_loggers++;
+	}
 }
 
 void Logger::disable()
@@ -70,12 +81,37 @@ void Logger::disable()
 	MutexSection mutex_lock(&Logger::mutex);
 	std::vector<Logger*>::iterator il = std::find(instances.begin(), instances.end(), this);
 	if(il != instances.end())
+	{
 		instances.erase(il);
+		cl_num_loggers--;
+	}
+}
+
+void Logger::enable_async(int buffer_size, int flush_interval)
+{
+	LogPipeline::get_instance()->start(buffer_size, flush_interval);
+}
+
+void Logger::disable_async()
+{
+	if (LogPipeline::enabled.load())
+		LogPipeline::get_instance()->stop();
+}
+
+bool Logger::is_async()
+{
+	return LogPipeline::enabled.load();
+}
+
+void Logger::flush_async()
+{
+	if (LogPipeline::enabled.load())
+		LogPipeline::get_instance()->flush();
 }
 
 StringFormat Logger::get_log_string(const std::string &type, const std::string &text)
 {
-	std::string months[] =
+	static const char *months[] =
 	{
 		"Jan",
 		"Feb",
@@ -91,7 +127,7 @@ StringFormat Logger::get_log_string(const std::string &type, const std::string &
 		"Dec"
 	};
 
-	std::string days[] =
+	static const char *days[] =
 	{
 		"Sun",
 		"Mon",
@@ -103,7 +139,7 @@ StringFormat Logger::get_log_string(const std::string &type, const std::string &
 	};
 
 	// Tue Nov 16 11:34:15 CET 2004
-	DateTime cur_time = DateTime::get_current_utc_time();
+	DateTime cur_time = cl_log_time ? *cl_log_time : DateTime::get_current_utc_time();
 
 #ifdef WIN32
 	StringFormat format("%1 %2 %3 %4:%5:%6 %7 UTC [%8] %9\r\n");
@@ -125,14 +161,167 @@ StringFormat Logger::get_log_string(const std::string &type, const std::string &
 
 void log_event(const std::string &type, const std::string &text)
 {
+	if (cl_num_loggers.load() == 0)
+		return;
+
+	if ((Logger::is_async() || LogPipeline::stopping.load()) && LogPipeline::get_instance()->write(type, text, 0, 0, false))
+		return;
+
 	MutexSection mutex_lock(&Logger::mutex);
-	if (Logger::instances.empty())
+	cl_log_dispatch(0, type, text);
+}
+
+void log_event(const std::string &type, const std::string &format, const LogEventArgs &args)
+{
+	if (cl_num_loggers.load() == 0)
+		return;
+
+	if ((Logger::is_async() || LogPipeline::stopping.load()) && LogPipeline::get_instance()->write(type, format, args.get_data(), args.get_size(), true))
 		return;
+
+	StringFormat f(format);
+	LogEventArgs::apply(f, args.get_data(), args.get_size());
+	MutexSection mutex_lock(&Logger::mutex);
+	cl_log_dispatch(0, type, f.get_result());
+}
+
+void cl_log_dispatch(const DateTime *time, const std::string &type, const std::string &text)
+{
+	const DateTime *old_time = cl_log_time;
+	cl_log_time = time;
+
+	// A logger throwing does not keep the line from the other loggers. The first exception is rethrown afterwards.
+	std::exception_ptr exception;
 	for(std::vector<Logger*>::iterator il = Logger::instances.begin(); il != Logger::instances.end(); il++)
-		(*il)->log(type, text);
+	{
+		try
+		{
+			(*il)->log(type, text);
+		}
+		catch (...)
+		{
+			if (!exception)
+				exception = std::current_exception();
+		}
+	}
+
+	cl_log_time = old_time;
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LogEventArgs Operations:
+
+void LogEventArgs::add(const std::string &text)
+{
+	unsigned int length = text.length();
+	char *dest = append(1 + sizeof(unsigned int) + length);
+	dest[0] = (char)type_string;
+	memcpy(dest + 1, &length, sizeof(unsigned int));
+	memcpy(dest + 1 + sizeof(unsigned int), text.data(), length);
+}
+
+void LogEventArgs::add(int value)
+{
+	add_value(type_int, value);
+}
+
+void LogEventArgs::add(unsigned int value)
+{
+	add_value(type_uint, value);
+}
+
+void LogEventArgs::add(long unsigned int value)
+{
+	add_value(type_ulong, value);
+}
+
+void LogEventArgs::add(long long value)
+{
+	add_value(type_longlong, value);
+}
+
+void LogEventArgs::add(unsigned long long value)
+{
+	add_value(type_ulonglong, value);
+}
+
+void LogEventArgs::add(float value)
+{
+	add_value(type_float, value);
+}
+
+void LogEventArgs::add(double value)
+{
+	add_value(type_double, value);
+}
+
+void LogEventArgs::apply(StringFormat &format, const char *data, int size)
+{
+	int index = 1;
+	int pos = 0;
+	while (pos < size)
+	{
+		Type type = (Type)data[pos++];
+		switch (type)
+		{
+		case type_string:
+			{
+				unsigned int length;
+				memcpy(&length, data + pos, sizeof(unsigned int));
+				pos += sizeof(unsigned int);
+				format.set_arg(index, std::string(data + pos, length));
+				pos += length;
+			}
+			break;
+		case type_int:
+			format.set_arg(index, read_value<int>(data, pos));
+			break;
+		case type_uint:
+			format.set_arg(index, read_value<unsigned int>(data, pos));
+			break;
+		case type_ulong:
+			format.set_arg(index, read_value<long unsigned int>(data, pos));
+			break;
+		case type_longlong:
+			format.set_arg(index, read_value<long long>(data, pos));
+			break;
+		case type_ulonglong:
+			format.set_arg(index, read_value<unsigned long long>(data, pos));
+			break;
+		case type_float:
+			format.set_arg(index, read_value<float>(data, pos));
+			break;
+		case type_double:
+			format.set_arg(index, read_value<double>(data, pos));
+			break;
+		default:
+			throw Exception("Invalid log event argument");
+		}
+		index++;
+	}
 }
 
 /////////////////////////////////////////////////////////////////////////////
-// Logger Implementation:
+// LogEventArgs Implementation:
+
+char *LogEventArgs::append(int length)
+{
+	int new_size = size + length;
+	if (heap_data.empty() && new_size <= inline_size)
+	{
+		char *dest = inline_data + size;
+		size = new_size;
+		return dest;
+	}
+
+	if (heap_data.empty())
+		heap_data.assign(inline_data, size);
+	heap_data.resize(new_size);
+	char *dest = &heap_data[size];
+	size = new_size;
+	return dest;
+}
 
 }
@@ -80,7 +80,7 @@ void DomCharacterData::append_data(const DomString &arg)
 	{
 		DomDocument_Impl *doc = static_cast<DomDocument_Impl *>(impl->owner_document.lock().get());
 		DomString value = impl->get_tree_node()->get_node_value();
-		impl->get_tree_node()->node_value += arg;
+		impl->get_tree_node()->set_node_value(doc, value + arg);
 	}
 }
 
@@ -92,7 +92,7 @@ void DomCharacterData::insert_data(unsigned long offset, const DomString &arg)
 		DomString value = impl->get_tree_node()->get_node_value();
 		if (offset > value.length())
 			offset = value.length();
-		impl->get_tree_node()->node_value = value.substr(0, offset) + arg + value.substr(offset);
+		impl->get_tree_node()->set_node_value(doc, value.substr(0, offset) + arg + value.substr(offset));
 	}
 }
 
@@ -116,7 +116,8 @@ void DomCharacterData::delete_data(unsigned long offset, unsigned long count)
 		{
 			value = DomString();
 		}
-		impl->get_tree_node()->node_value = value;
+		DomDocument_Impl *doc = static_cast<DomDocument_Impl *>(impl->owner_document.lock().get());
+		impl->get_tree_node()->set_node_value(doc, value);
 	}
 }
 
@@ -43,7 +43,10 @@
 #include "API/Core/XML/xml_tokenizer.h"
 #include "API/Core/XML/xml_writer.h"
 #include "API/Core/XML/xml_token.h"
+#include "API/Core/XML/xml_token_view.h"
 #include "dom_document_generic.h"
+#include "dom_tree_node.h"
+#include <cstring>
 #include <stack>
 
 namespace clan
@@ -277,58 +280,75 @@ std::vector<DomNode> DomDocument::load(
 {
 	clear_all();
 
-	XMLTokenizer tokenizer(input);
+	XMLTokenizer tokenizer(input, 64*1024);
 	tokenizer.set_eat_whitespace(eat_whitespace);
 
 	if (insert_point.is_element() == false)
 		insert_point = *this;
 
-	std::vector<DomNode> node_stack;
-	node_stack.push_back(insert_point);
+	// The tree is built directly from the tokens, without creating DomNode objects
+	DomDocument_Impl *doc_impl = static_cast<DomDocument_Impl *>(impl.get());
+	unsigned int insert_index = insert_point.impl->node_index;
 
-	std::vector<DomNode> result;
+	// Namespace lookups only need to search the ancestors once something has declared a namespace
+	bool namespace_declarations = false;
+	for (const DomTreeNode *cur = doc_impl->nodes[insert_index]; cur && !namespace_declarations; cur = cur->get_parent(doc_impl))
+	{
+		for (const DomTreeNode *cur_attr = cur->get_first_attribute(doc_impl); cur_attr && !namespace_declarations; cur_attr = cur_attr->get_next_sibling(doc_impl))
+			namespace_declarations = cur_attr->get_node_name().compare(0, 5, "xmlns") == 0;
+	}
+
+	std::vector<unsigned int> node_stack;
+	node_stack.push_back(insert_index);
+
+	std::vector<unsigned int> result_indexes;
 	try
 	{
-		XMLToken cur_token;
+		XMLTokenView cur_token;
 		tokenizer.next(&cur_token);
 		while (cur_token.type != XMLToken::NULL_TOKEN)
 		{
+			unsigned int parent_index = node_stack.back();
+			unsigned int node_index = cl_null_node_index;
 			switch (cur_token.type)
 			{
 			case XMLToken::TEXT_TOKEN:
-				node_stack.back().append_child(create_text_node(cur_token.value));
-				if (node_stack.back() == insert_point)
-					result.push_back(node_stack.back().get_last_child());
+				node_index = doc_impl->append_tree_node(parent_index, TEXT_NODE);
+				doc_impl->nodes[node_index]->set_node_value(doc_impl, cur_token.value.data, cur_token.value.length);
 				break;
 
 			case XMLToken::CDATA_SECTION_TOKEN:
-				node_stack.back().append_child(create_cdata_section(cur_token.value));
-				if (node_stack.back() == insert_point)
-					result.push_back(node_stack.back().get_last_child());
+				node_index = doc_impl->append_tree_node(parent_index, CDATA_SECTION_NODE);
+				doc_impl->nodes[node_index]->set_node_value(doc_impl, cur_token.value.data, cur_token.value.length);
 				break;
 
 			case XMLToken::ELEMENT_TOKEN:
 				if (cur_token.variant != XMLToken::END)
 				{
-					DomString namespace_uri = DomDocument_Impl::find_namespace_uri(cur_token.name, cur_token, node_stack.back());
-					DomElement element = create_element_ns(namespace_uri, cur_token.name);
-					node_stack.back().append_child(element);
-					if (node_stack.back() == insert_point)
-						result.push_back(node_stack.back().get_last_child());
+					const DomString *namespace_uri = doc_impl->find_namespace_uri(cur_token.name, cur_token, parent_index, namespace_declarations);
+					node_index = doc_impl->append_tree_node(parent_index, ELEMENT_NODE);
+					DomTreeNode *tree_node = doc_impl->nodes[node_index];
+					tree_node->node_name = doc_impl->intern_name(cur_token.name.data, cur_token.name.length);
+					tree_node->namespace_uri = namespace_uri;
 
 					int size = (int) cur_token.attributes.size();
 					for (int i=0; i<size; i++)
 					{
-						XMLToken::Attribute &attribute = cur_token.attributes[i];
-						DomString attribute_namespace_uri = DomDocument_Impl::find_namespace_uri(attribute.first, cur_token, node_stack.back());
-						element.set_attribute_ns(
+						const XMLTokenView::Attribute &attribute = cur_token.attributes[i];
+						const DomString *attribute_namespace_uri = doc_impl->find_namespace_uri(attribute.first, cur_token, parent_index, namespace_declarations);
+						doc_impl->set_tree_attribute(
+							node_index,
 							attribute_namespace_uri,
-							attribute.first,
-							attribute.second);
+							doc_impl->intern_name(attribute.first.data, attribute.first.length),
+							attribute.second.data,
+							attribute.second.length);
+
+						if (attribute.first.length >= 5 && memcmp(attribute.first.data, "xmlns", 5) == 0)
+							namespace_declarations = true;
 					}
-				
+
 					if (cur_token.variant == XMLToken::BEGIN)
-						node_stack.push_back(element);
+						node_stack.push_back(node_index);
 				}
 				else
 				{
@@ -347,9 +367,8 @@ std::vector<DomNode> DomDocument::load(
 				break;
 			
 			case XMLToken::COMMENT_TOKEN:
-				node_stack.back().append_child(create_comment(cur_token.value));
-				if (node_stack.back() == insert_point)
-					result.push_back(node_stack.back().get_last_child());
+				node_index = doc_impl->append_tree_node(parent_index, COMMENT_NODE);
+				doc_impl->nodes[node_index]->set_node_value(doc_impl, cur_token.value.data, cur_token.value.length);
 				break;
 
 			case XMLToken::DOCUMENT_TYPE_TOKEN:
@@ -359,23 +378,38 @@ std::vector<DomNode> DomDocument::load(
 				break;
 
 			case XMLToken::PROCESSING_INSTRUCTION_TOKEN:
-				node_stack.back().append_child(create_processing_instruction(cur_token.name, cur_token.value));
-				if (node_stack.back() == insert_point)
-					result.push_back(node_stack.back().get_last_child());
+				node_index = doc_impl->append_tree_node(parent_index, PROCESSING_INSTRUCTION_NODE);
+				doc_impl->nodes[node_index]->node_name = doc_impl->intern_name(cur_token.name.data, cur_token.name.length);
+				doc_impl->nodes[node_index]->set_node_value(doc_impl, cur_token.value.data, cur_token.value.length);
 				break;
 			}		
 
+			if (node_index != cl_null_node_index && parent_index == insert_index)
+				result_indexes.push_back(node_index);
+
 			tokenizer.next(&cur_token);
 		}
 	}
 	catch (const Exception& e)
 	{
-		for (std::vector<DomNode>::size_type i = 0; i < result.size(); i++)
+		for (std::vector<unsigned int>::size_type i = 0; i < result_indexes.size(); i++)
 		{
-			insert_point.remove_child(result[i]);
+			DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
+			dom_node->node_index = result_indexes[i];
+			DomNode node(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
+			insert_point.remove_child(node);
 		}
 		throw;
 	}
+
+	std::vector<DomNode> result;
+	result.reserve(result_indexes.size());
+	for (std::vector<unsigned int>::size_type i = 0; i < result_indexes.size(); i++)
+	{
+		DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
+		dom_node->node_index = result_indexes[i];
+		result.push_back(DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl))));
+	}
 	return result;
 }
 
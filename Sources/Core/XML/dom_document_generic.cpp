@@ -27,19 +27,23 @@
 */
 
 #include "Core/precomp.h"
-#include "API/Core/XML/xml_token.h"
+#include "API/Core/XML/xml_token_view.h"
 #include "API/Core/XML/dom_node.h"
 #include "dom_document_generic.h"
 #include "dom_tree_node.h"
 #include "dom_named_node_map_generic.h"
+#include <cstring>
 
 namespace clan
 {
 
+const DomString DomTreeNode::empty_string;
+
 /////////////////////////////////////////////////////////////////////////////
 // DomDocument_Impl construction:
 
 DomDocument_Impl::DomDocument_Impl()
+: modification_count(0), xpath_memo_modification_count(0)
 {
 	node_index = DomDocument_Impl::allocate_tree_node();
 	nodes[node_index]->node_type = DomNode::DOCUMENT_NODE;
@@ -47,11 +51,7 @@ DomDocument_Impl::DomDocument_Impl()
 
 DomDocument_Impl::~DomDocument_Impl()
 {
-	std::vector<DomNode_Impl *>::size_type pos, size;
-
-	size = nodes.size();
-	for (pos = 0; pos < size; pos++)
-		delete nodes[pos];
+	// Tree nodes and their strings are released together with the allocators
 
 	while (!free_dom_nodes.empty())
 	{
@@ -72,35 +72,207 @@ DomDocument_Impl::~DomDocument_Impl()
 /////////////////////////////////////////////////////////////////////////////
 // DomDocument_Impl operations:
 
-DomString DomDocument_Impl::find_namespace_uri(
-	const DomString &qualified_name,
-	const XMLToken &search_token,
-	const DomNode &search_node)
+const DomString *DomDocument_Impl::find_namespace_uri(
+	const XMLStringView &qualified_name,
+	const XMLTokenView &search_token,
+	unsigned int search_node_index,
+	bool check_ancestors)
 {
-	static DomString xmlns_prefix("xmlns:");
-	DomString name = qualified_name;
-	DomString prefix;
-	DomString::size_type pos = name.find(':');
-	if (pos != DomString::npos)
-		prefix = name.substr(0, pos);
+	static const char xmlns_prefix[] = "xmlns:";
+
+	XMLStringView prefix;
+	const char *colon = static_cast<const char *>(memchr(qualified_name.data, ':', qualified_name.length));
+	if (colon)
+		prefix = XMLStringView(qualified_name.data, colon - qualified_name.data);
 
 	int size = (int) search_token.attributes.size();
 	for (int i=0; i<size; i++)
 	{
+		const XMLStringView &attribute_name = search_token.attributes[i].first;
 		if (prefix.empty())
 		{
-			if (search_token.attributes[i].first == "xmlns")
-				return search_token.attributes[i].second;
+			if (attribute_name == "xmlns")
+				return intern_name(search_token.attributes[i].second.data, search_token.attributes[i].second.length);
 		}
 		else
 		{
-			if (search_token.attributes[i].first.substr(0, 6) == xmlns_prefix &&
-				search_token.attributes[i].first.substr(6) == prefix)
-				return search_token.attributes[i].second;
+			if (attribute_name.length == prefix.length + 6 &&
+				memcmp(attribute_name.data, xmlns_prefix, 6) == 0 &&
+				memcmp(attribute_name.data + 6, prefix.data, prefix.length) == 0)
+				return intern_name(search_token.attributes[i].second.data, search_token.attributes[i].second.length);
+		}
+	}
+
+	// Same rules as DomNode::find_namespace_uri
+	if (prefix == "xml")
+		return intern_name("xml", 3);
+	else if (prefix == "xmlns" || qualified_name == "xmlns")
+		return intern_name("xmlns", 5);
+
+	if (check_ancestors)
+	{
+		const DomTreeNode *cur = search_node_index != cl_null_node_index ? nodes[search_node_index] : 0;
+		while (cur)
+		{
+			const DomTreeNode *cur_attr = cur->get_first_attribute(this);
+			while (cur_attr)
+			{
+				const DomString &node_name = cur_attr->get_node_name();
+				if (prefix.empty())
+				{
+					if (node_name == "xmlns")
+						return intern_name(cur_attr->node_value, cur_attr->node_value_length);
+				}
+				else
+				{
+					if (node_name.length() == prefix.length + 6 &&
+						node_name.compare(0, 6, xmlns_prefix) == 0 &&
+						node_name.compare(6, prefix.length, prefix.data, prefix.length) == 0)
+						return intern_name(cur_attr->node_value, cur_attr->node_value_length);
+				}
+				cur_attr = cur_attr->get_next_sibling(this);
+			}
+			cur = cur->get_parent(this);
 		}
 	}
 
-	return search_node.find_namespace_uri(qualified_name);
+	return 0;
+}
+
+const DomString *DomDocument_Impl::intern_name(const char *data, DomString::size_type length)
+{
+	if (length == 0)
+		return 0;
+
+	if ((name_strings.size() + 1) * 2 > name_table.size())
+		grow_name_table();
+
+	unsigned int mask = name_table.size() - 1;
+	unsigned int slot = hash_name(data, length) & mask;
+	while (name_table[slot] != 0)
+	{
+		const DomString &name = name_strings[name_table[slot] - 1];
+		if (name.length() == length && memcmp(name.data(), data, length) == 0)
+			return &name;
+		slot = (slot + 1) & mask;
+	}
+
+	name_strings.push_back(DomString(data, length));
+	name_table[slot] = name_strings.size();
+	return &name_strings.back();
+}
+
+const DomString *DomDocument_Impl::find_name(const char *data, DomString::size_type length) const
+{
+	if (length == 0 || name_table.empty())
+		return 0;
+
+	unsigned int mask = name_table.size() - 1;
+	unsigned int slot = hash_name(data, length) & mask;
+	while (name_table[slot] != 0)
+	{
+		const DomString &name = name_strings[name_table[slot] - 1];
+		if (name.length() == length && memcmp(name.data(), data, length) == 0)
+			return &name;
+		slot = (slot + 1) & mask;
+	}
+	return 0;
+}
+
+void DomDocument_Impl::grow_name_table()
+{
+	std::vector<unsigned int> new_table(name_table.empty() ? 64 : name_table.size() * 2, 0);
+	unsigned int mask = new_table.size() - 1;
+	for (size_t i = 0; i < name_table.size(); i++)
+	{
+		if (name_table[i] != 0)
+		{
+			const DomString &name = name_strings[name_table[i] - 1];
+			unsigned int slot = hash_name(name.data(), name.length()) & mask;
+			while (new_table[slot] != 0)
+				slot = (slot + 1) & mask;
+			new_table[slot] = name_table[i];
+		}
+	}
+	name_table.swap(new_table);
+}
+
+unsigned int DomDocument_Impl::hash_name(const char *data, DomString::size_type length)
+{
+	// FNV-1a
+	unsigned int hash = 2166136261U;
+	for (DomString::size_type i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char)data[i]) * 16777619U;
+	return hash;
+}
+
+char *DomDocument_Impl::allocate_string(DomString::size_type length)
+{
+	return static_cast<char *>(string_allocator.allocate(length));
+}
+
+unsigned int DomDocument_Impl::append_tree_node(unsigned int parent_index, unsigned short node_type)
+{
+	modification_count++;
+	unsigned int node_index = allocate_tree_node();
+	DomTreeNode *tree_node = nodes[node_index];
+	DomTreeNode *parent = nodes[parent_index];
+	tree_node->node_type = node_type;
+	tree_node->parent = parent_index;
+	if (parent->last_child != cl_null_node_index)
+	{
+		nodes[parent->last_child]->next_sibling = node_index;
+		tree_node->previous_sibling = parent->last_child;
+	}
+	else
+	{
+		parent->first_child = node_index;
+	}
+	parent->last_child = node_index;
+	return node_index;
+}
+
+void DomDocument_Impl::set_tree_attribute(unsigned int element_index, const DomString *namespace_uri, const DomString *qualified_name, const char *value, DomString::size_type length)
+{
+	modification_count++;
+
+	const DomString &new_name = qualified_name ? *qualified_name : DomTreeNode::empty_string;
+	DomString::size_type local_pos = new_name.find(':');
+	local_pos = (local_pos == DomString::npos) ? 0 : local_pos + 1;
+
+	// Replace an attribute with the same namespace and local name
+	unsigned int last_index = cl_null_node_index;
+	unsigned int cur_index = nodes[element_index]->first_attribute;
+	while (cur_index != cl_null_node_index)
+	{
+		DomTreeNode *cur_attribute = nodes[cur_index];
+		if (cur_attribute->namespace_uri == namespace_uri)
+		{
+			const DomString &name = cur_attribute->get_node_name();
+			DomString::size_type name_local_pos = name.find(':');
+			name_local_pos = (name_local_pos == DomString::npos) ? 0 : name_local_pos + 1;
+			if (name.compare(name_local_pos, DomString::npos, new_name, local_pos, DomString::npos) == 0)
+			{
+				cur_attribute->set_node_value(this, value, length);
+				return;
+			}
+		}
+		last_index = cur_index;
+		cur_index = cur_attribute->next_sibling;
+	}
+
+	unsigned int attribute_index = allocate_tree_node();
+	DomTreeNode *attribute = nodes[attribute_index];
+	attribute->node_type = DomNode::ATTRIBUTE_NODE;
+	attribute->node_name = qualified_name;
+	attribute->namespace_uri = namespace_uri;
+	attribute->set_node_value(this, value, length);
+	attribute->parent = element_index;
+	attribute->previous_sibling = last_index;
+	if (last_index == cl_null_node_index)
+		nodes[element_index]->first_attribute = attribute_index;
+	else
+		nodes[last_index]->next_sibling = attribute_index;
 }
 
 unsigned int DomDocument_Impl::allocate_tree_node()
@@ -30,16 +30,30 @@
 
 #include "dom_node_generic.h"
 #include "API/Core/System/block_allocator.h"
+#include "API/Core/XML/xpath_object.h"
 #include <vector>
 #include <stack>
+#include <deque>
+#include <map>
 
 namespace clan
 {
 
 class DomTreeNode;
-class XMLToken;
+class XMLTokenView;
+class XMLStringView;
 class DomNamedNodeMap_Impl;
 
+class DomXPathMemoEntry
+{
+public:
+	DomXPathMemoEntry() : is_node_set(false) { }
+
+	bool is_node_set;
+	std::vector<unsigned int> node_set;
+	XPathObject result;
+};
+
 class DomDocument_Impl : public DomNode_Impl
 {
 /// \name Construction
@@ -60,20 +74,52 @@ public:
 	std::string system_id;
 	std::string internal_subset;
 	BlockAllocator node_allocator;
+	BlockAllocator string_allocator;
 	std::vector<DomTreeNode *> nodes;
 	std::vector<int> free_nodes;
 	std::vector<DomNode_Impl *> free_dom_nodes;
 	std::vector<DomNamedNodeMap_Impl *> free_named_node_maps;
 
+	// Interned element/attribute names and namespace URIs
+	std::deque<DomString> name_strings;
+	std::vector<unsigned int> name_table;
+
+	// Incremented by every change to the tree or its values
+	unsigned int modification_count;
+
+	// Memoized XPathExpression results by expression id and context node index,
+	// valid while modification_count equals xpath_memo_modification_count
+	std::map<std::pair<unsigned int, unsigned int>, DomXPathMemoEntry> xpath_memo;
+	unsigned int xpath_memo_modification_count;
+
 /// \}
 /// \name Operations
 /// \{
 
 public:
-	static DomString find_namespace_uri(
-		const DomString &qualified_name,
-		const XMLToken &search_token,
-		const DomNode &search_node);
+	/// \brief Searches the token and then the ancestors of search_node_index for the namespace of a name
+	///
+	/// Skips the ancestor search unless check_ancestors is set, for documents without namespace declarations.
+	const DomString *find_namespace_uri(
+		const XMLStringView &qualified_name,
+		const XMLTokenView &search_token,
+		unsigned int search_node_index,
+		bool check_ancestors);
+
+	/// \brief Returns the document's single copy of a name
+	const DomString *intern_name(const char *data, DomString::size_type length);
+
+	/// \brief Returns the document's copy of a name, or null if no node uses it
+	const DomString *find_name(const char *data, DomString::size_type length) const;
+
+	/// \brief Allocates string data that lives as long as the document
+	char *allocate_string(DomString::size_type length);
+
+	/// \brief Creates a node and appends it to the children of parent_index
+	unsigned int append_tree_node(unsigned int parent_index, unsigned short node_type);
+
+	/// \brief Adds or replaces an attribute, like DomElement::set_attribute_ns
+	void set_tree_attribute(unsigned int element_index, const DomString *namespace_uri, const DomString *qualified_name, const char *value, DomString::size_type length);
 
 	unsigned int allocate_tree_node();
 	void free_tree_node(unsigned int node_index);
@@ -99,6 +145,13 @@ public:
 	};
 
 /// \}
+/// \name Implementation
+/// \{
+
+private:
+	void grow_name_table();
+	static unsigned int hash_name(const char *data, DomString::size_type length);
+/// \}
 };
 
 }
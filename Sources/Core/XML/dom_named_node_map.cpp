@@ -142,6 +142,7 @@ DomNode DomNamedNodeMap::set_named_item(const DomNode &node)
 	DomTreeNode *tree_node = impl->get_tree_node();
 	if (new_tree_node == tree_node)
 		return node;
+	doc_impl->modification_count++;
 	unsigned int cur_index = tree_node->first_attribute;
 	unsigned int last_index = cl_null_node_index;
 	DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
@@ -195,6 +196,7 @@ DomNode DomNamedNodeMap::set_named_item_ns(const DomNode &node)
 	DomTreeNode *tree_node = impl->get_tree_node();
 	if (new_tree_node == tree_node)
 		return node;
+	doc_impl->modification_count++;
 	unsigned int cur_index = tree_node->first_attribute;
 	unsigned int last_index = cl_null_node_index;
 	DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
@@ -264,6 +266,7 @@ DomNode DomNamedNodeMap::remove_named_item(const DomString &name)
 			cur_attribute->parent = cl_null_node_index;
 			cur_attribute->previous_sibling = cl_null_node_index;
 			cur_attribute->next_sibling = cl_null_node_index;
+			doc_impl->modification_count++;
 
 			DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
 			dom_node->node_index = cur_index;
@@ -306,6 +309,7 @@ DomNode DomNamedNodeMap::remove_named_item_ns(
 			cur_attribute->parent = cl_null_node_index;
 			cur_attribute->previous_sibling = cl_null_node_index;
 			cur_attribute->next_sibling = cl_null_node_index;
+			doc_impl->modification_count++;
 
 			DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
 			dom_node->node_index = cur_index;
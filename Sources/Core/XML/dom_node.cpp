@@ -449,6 +449,7 @@ DomNode DomNode::insert_before(DomNode &new_child, DomNode &ref_child)
 		DomTreeNode *tree_node = impl->get_tree_node();
 		DomTreeNode *new_tree_node = new_child.impl->get_tree_node();
 		DomTreeNode *ref_tree_node = ref_child.impl->get_tree_node();
+		doc_impl->modification_count++;
 
 		new_tree_node->previous_sibling = ref_tree_node->previous_sibling;
 		new_tree_node->next_sibling = ref_child.impl->node_index;
@@ -468,9 +469,11 @@ DomNode DomNode::replace_child(DomNode &new_child, DomNode &old_child)
 {
 	if (impl && new_child.impl && old_child.impl)
 	{
+		DomDocument_Impl *doc_impl = (DomDocument_Impl *) impl->owner_document.lock().get();
 		DomTreeNode *tree_node = impl->get_tree_node();
 		DomTreeNode *new_tree_node = new_child.impl->get_tree_node();
 		DomTreeNode *old_tree_node = old_child.impl->get_tree_node();
+		doc_impl->modification_count++;
 
 		new_tree_node->previous_sibling = old_tree_node->previous_sibling;
 		new_tree_node->next_sibling = old_tree_node->next_sibling;
@@ -495,6 +498,7 @@ DomNode DomNode::remove_child(DomNode &old_child)
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *) impl->owner_document.lock().get();
 		DomTreeNode *tree_node = impl->get_tree_node();
 		DomTreeNode *old_tree_node = old_child.impl->get_tree_node();
+		doc_impl->modification_count++;
 		unsigned int prev_index = old_tree_node->previous_sibling;
 		unsigned int next_index = old_tree_node->next_sibling;
 		DomTreeNode *prev = old_tree_node->get_previous_sibling(doc_impl);
@@ -521,6 +525,7 @@ DomNode DomNode::append_child(DomNode new_child)
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *) impl->owner_document.lock().get();
 		DomTreeNode *tree_node = impl->get_tree_node();
 		DomTreeNode *new_tree_node = new_child.impl->get_tree_node();
+		doc_impl->modification_count++;
 		if (tree_node->last_child != cl_null_node_index)
 		{
 			DomTreeNode *last_tree_node = tree_node->get_last_child(doc_impl);
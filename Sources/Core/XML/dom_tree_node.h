@@ -30,6 +30,8 @@
 
 #include "API/Core/System/block_allocator.h"
 #include "dom_document_generic.h"
+#include <cstring>
+#include <algorithm>
 
 namespace clan
 {
@@ -44,23 +46,26 @@ class DomTreeNode : public BlockAllocated
 /// \{
 public:
 	DomTreeNode()
-	: node_type(0), parent(cl_null_node_index), first_child(cl_null_node_index),
+	: node_name(0), namespace_uri(0), node_value(0), node_value_length(0), node_value_capacity(0),
+	  node_type(0), parent(cl_null_node_index), first_child(cl_null_node_index),
 	  last_child(cl_null_node_index), previous_sibling(cl_null_node_index),
 	  next_sibling(cl_null_node_index), first_attribute(cl_null_node_index)
 	{
 	}
-
-	virtual ~DomTreeNode()
-	{
-	}
 /// \}
 
 /// \name Attributes
 /// \{
 public:
-	std::string node_name;
-	std::string node_value;
-	std::string namespace_uri;
+	/// \brief Interned by DomDocument_Impl::intern_name, or null if empty
+	const DomString *node_name;
+	const DomString *namespace_uri;
+
+	/// \brief Allocated from DomDocument_Impl::string_allocator
+	char *node_value;
+	unsigned int node_value_length;
+	unsigned int node_value_capacity;
+
 	unsigned short node_type;
 	unsigned int parent;
 	unsigned int first_child;
@@ -68,6 +73,8 @@ public:
 	unsigned int previous_sibling;
 	unsigned int next_sibling;
 	unsigned int first_attribute;
+
+	static const DomString empty_string;
 /// \}
 
 /// \name Operations
@@ -75,9 +82,10 @@ public:
 public:
 	void reset()
 	{
-		node_name.clear();
-		node_value.clear();
-		namespace_uri.clear();
+		// The value buffer is kept for reuse by the next owner of this node
+		node_name = 0;
+		namespace_uri = 0;
+		node_value_length = 0;
 		node_type = 0;
 		parent = cl_null_node_index;
 		first_child = cl_null_node_index;
@@ -87,34 +95,51 @@ public:
 		first_attribute = cl_null_node_index;
 	}
 
-	std::string get_node_name() const
+	const DomString &get_node_name() const
 	{
-		return node_name;
+		return node_name ? *node_name : empty_string;
 	}
 
-	std::string get_node_value() const
+	DomString get_node_value() const
 	{
-		return node_value;
+		return node_value_length ? DomString(node_value, node_value_length) : DomString();
 	}
 
-	std::string get_namespace_uri() const
+	const DomString &get_namespace_uri() const
 	{
-		return namespace_uri;
+		return namespace_uri ? *namespace_uri : empty_string;
 	}
 
 	void set_node_name(DomDocument_Impl *owner_document, const DomString &str)
 	{
-		node_name = str;
+		node_name = owner_document->intern_name(str.data(), str.length());
+		owner_document->modification_count++;
 	}
 
 	void set_node_value(DomDocument_Impl *owner_document, const DomString &str)
 	{
-		node_value = str;
+		set_node_value(owner_document, str.data(), str.length());
+	}
+
+	void set_node_value(DomDocument_Impl *owner_document, const char *data, DomString::size_type length)
+	{
+		if (length > node_value_capacity)
+		{
+			// Grow geometrically when an existing value is extended, as the old buffer is not reclaimed
+			DomString::size_type capacity = node_value_capacity ? std::max(length, (DomString::size_type)node_value_capacity * 2) : length;
+			node_value = owner_document->allocate_string(capacity);
+			node_value_capacity = capacity;
+		}
+		if (length > 0)
+			memcpy(node_value, data, length);
+		node_value_length = length;
+		owner_document->modification_count++;
 	}
 
 	void set_namespace_uri(DomDocument_Impl *owner_document, const DomString &str)
 	{
-		namespace_uri = str;
+		namespace_uri = owner_document->intern_name(str.data(), str.length());
+		owner_document->modification_count++;
 	}
 
 	DomTreeNode *get_parent(DomDocument_Impl *owner_document)
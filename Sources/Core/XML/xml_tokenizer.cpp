@@ -29,12 +29,12 @@
 #include "Core/precomp.h"
 #include "API/Core/XML/xml_tokenizer.h"
 #include "API/Core/XML/xml_token.h"
-#include "API/Core/System/databuffer.h"
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Text/string_help.h"
 #include "xml_tokenizer_generic.h"
 #include <algorithm>
 #include <utility>
+#include <cstring>
 
 namespace clan
 {
@@ -50,35 +50,15 @@ XMLTokenizer::XMLTokenizer(const XMLTokenizer &copy) : impl(copy.impl)
 {
 }
 
-XMLTokenizer::XMLTokenizer(IODevice &input) : impl(std::make_shared<XMLTokenizer_Impl>())
+XMLTokenizer::XMLTokenizer(IODevice &input) : impl(std::make_shared<XMLTokenizer_Impl>(input, input.get_size()))
 {
-	impl->input = input;
-	impl->size = input.get_size();
-	impl->pos = 0;
-
-	DataBuffer buffer(impl->size);
-	input.receive(buffer.get_data(), buffer.get_size(), true);
-
-	StringHelp::BOMType bom_type = StringHelp::detect_bom(buffer.get_data(), buffer.get_size());
-	switch (bom_type)
-	{
-	default:
-	case StringHelp::bom_none:
-		impl->data = StringHelp::utf8_to_text(std::string(buffer.get_data(), buffer.get_size()));
-		break;
-	case StringHelp::bom_utf32_be:
-	case StringHelp::bom_utf32_le:
-		throw Exception("UTF-16 XML files not supported yet");
-		break;
-	case StringHelp::bom_utf16_be:
-	case StringHelp::bom_utf16_le:
-		throw Exception("UTF-32 XML files not supported yet");
-		break;
-	case StringHelp::bom_utf8:
-		impl->data = StringHelp::utf8_to_text(std::string(buffer.get_data()+3, buffer.get_size()-3));
-		break;
-	}
+	// The first block already holds the entire input
+	if (input.get_size() >= 0)
+		impl->input_eof = true;
+}
 
+XMLTokenizer::XMLTokenizer(IODevice &input, int buffer_size) : impl(std::make_shared<XMLTokenizer_Impl>(input, buffer_size))
+{
 }
 
 XMLTokenizer::~XMLTokenizer()
@@ -111,12 +91,30 @@ void XMLTokenizer::next(XMLToken *out_token)
 
 	if (impl)
 	{
-		if (impl->next_text_node(out_token))
-			return;
-		impl->next_tag_node(out_token);
+		const XMLTokenView &view = impl->view_token;
+		impl->next(&impl->view_token);
+
+		out_token->type = view.type;
+		out_token->variant = view.variant;
+		out_token->name.assign(view.name.data, view.name.length);
+		out_token->value.assign(view.value.data, view.value.length);
+		for (size_t i = 0; i < view.attributes.size(); i++)
+			out_token->attributes.push_back(XMLToken::Attribute(view.attributes[i].first.to_string(), view.attributes[i].second.to_string()));
 	}
 }
 
+void XMLTokenizer::next(XMLTokenView *out_token)
+{
+	out_token->type = XMLToken::NULL_TOKEN;
+	out_token->variant = XMLToken::SINGLE;
+	out_token->name = XMLStringView();
+	out_token->value = XMLStringView();
+	out_token->attributes.clear();
+
+	if (impl)
+		impl->next(out_token);
+}
+
 XMLToken XMLTokenizer::next()
 {
 	XMLToken token;
@@ -127,33 +125,77 @@ XMLToken XMLTokenizer::next()
 /////////////////////////////////////////////////////////////////////////////
 // XMLTokenizer implementation:
 
-bool XMLTokenizer_Impl::next_text_node(XMLToken *out_token)
+XMLTokenizer_Impl::XMLTokenizer_Impl(const IODevice &input, int buffer_size)
+: input(input), pos(0), size(0), eat_whitespace(true), buffer_size(buffer_size), input_eof(false), discarded_bytes(0), discarded_lines(0), unescape_buffers_used(0)
 {
-	while (pos < size && data[pos] != '<')
+	if (this->buffer_size <= 0)
+		this->buffer_size = 64*1024;
+
+	// The byte order mark needs up to 4 bytes
+	while (read_input() && data.size() < 4)
 	{
-		std::string::size_type start_pos = pos;
-		std::string::size_type end_pos = data.find('<', start_pos);
-		if (end_pos == data.npos) end_pos = size;
-		pos = end_pos;
+	}
+	check_bom();
+}
 
-		std::string text;
-		std::string text_orig = data.substr(start_pos, end_pos-start_pos);
-		unescape(text, text_orig);
-		if (eat_whitespace)
+void XMLTokenizer_Impl::next(XMLTokenView *out_token)
+{
+	out_token->type = XMLToken::NULL_TOKEN;
+	out_token->variant = XMLToken::SINGLE;
+	out_token->name = XMLStringView();
+	out_token->value = XMLStringView();
+	out_token->attributes.clear();
+	unescape_buffers_used = 0;
+
+	while (true)
+	{
+		while (!is_token_complete() && read_input())
 		{
-			text = trim_whitespace(text);
-			if (text.empty())
-				continue;
 		}
 
-		out_token->type = XMLToken::TEXT_TOKEN;
-		out_token->value = text;
-		return true;
+		if (pos == size)
+			return;
+
+		if (data[pos] != '<')
+		{
+			if (next_text_node(out_token))
+				return;
+		}
+		else
+		{
+			next_tag_node(out_token);
+			return;
+		}
 	}
-	return false;
 }
 
-bool XMLTokenizer_Impl::next_tag_node(XMLToken *out_token)
+bool XMLTokenizer_Impl::next_text_node(XMLTokenView *out_token)
+{
+	std::string::size_type start_pos = pos;
+	std::string::size_type end_pos = data.find('<', start_pos);
+	if (end_pos == data.npos) end_pos = size;
+	pos = end_pos;
+
+	XMLStringView text;
+	if (eat_whitespace)
+	{
+		// Entities never expand to whitespace, so trimming before unescaping gives the same result
+		XMLStringView trimmed = trim_whitespace(XMLStringView(data.data() + start_pos, end_pos - start_pos));
+		if (trimmed.empty())
+			return false;
+		text = unescape(trimmed.data - data.data(), trimmed.length);
+	}
+	else
+	{
+		text = unescape(start_pos, end_pos - start_pos);
+	}
+
+	out_token->type = XMLToken::TEXT_TOKEN;
+	out_token->value = text;
+	return true;
+}
+
+bool XMLTokenizer_Impl::next_tag_node(XMLTokenView *out_token)
 {
 	if (pos == size || data[pos] != '<')
 		return false;
@@ -189,7 +231,7 @@ bool XMLTokenizer_Impl::next_tag_node(XMLToken *out_token)
 
 	out_token->type = questionMark ? XMLToken::PROCESSING_INSTRUCTION_TOKEN : XMLToken::ELEMENT_TOKEN;
 	out_token->variant = closing ? XMLToken::END : XMLToken::BEGIN;
-	out_token->name = data.substr(start_pos, end_pos - start_pos);
+	out_token->name = XMLStringView(data.data() + start_pos, end_pos - start_pos);
 
 	if (out_token->type == XMLToken::PROCESSING_INSTRUCTION_TOKEN)
 	{
@@ -201,7 +243,7 @@ bool XMLTokenizer_Impl::next_tag_node(XMLToken *out_token)
 		end_pos = data.find_first_of("?", pos);
 		if (end_pos == data.npos)
 			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-		out_token->value = data.substr(pos, end_pos - pos);
+		out_token->value = XMLStringView(data.data() + pos, end_pos - pos);
 		pos = end_pos;
 	}
 	else // out_token->type == XMLToken::ELEMENT_TOKEN
@@ -225,14 +267,14 @@ bool XMLTokenizer_Impl::next_tag_node(XMLToken *out_token)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 			pos = end_pos;
 
-			std::string attributeName = data.substr(start_pos, end_pos-start_pos);
+			XMLStringView attributeName(data.data() + start_pos, end_pos-start_pos);
 
 			// Find seperator:
 			pos = data.find_first_not_of(" \r\n\t", pos);
 			if (pos == data.npos || pos == size-1)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 			if (data[pos++] != '=')
-				XMLTokenizer_Impl::throw_exception(string_format("XML error(s), parser confused at line %1 (tag=%2, attributeName=%3)", get_line_number(), out_token->name, attributeName));
+				XMLTokenizer_Impl::throw_exception(string_format("XML error(s), parser confused at line %1 (tag=%2, attributeName=%3)", get_line_number(), out_token->name.to_string(), attributeName.to_string()));
 
 			// Strip whitespace:
 			pos = data.find_first_not_of(" \r\n\t", pos);
@@ -262,16 +304,14 @@ bool XMLTokenizer_Impl::next_tag_node(XMLToken *out_token)
 				if (end_pos == data.npos)
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
-				std::string attributeValue;
-				std::string attributeValueOrig = data.substr(start_pos, end_pos-start_pos);
-				unescape(attributeValue, attributeValueOrig);
+				XMLStringView attributeValue = unescape(start_pos, end_pos-start_pos);
 
 				pos = end_pos + 1;
 				if (pos == size)
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 				// Finally apply attribute to token:
-				out_token->attributes.push_back(XMLToken::Attribute(attributeName, attributeValue));
+				out_token->attributes.push_back(XMLTokenView::Attribute(attributeName, attributeValue));
 		}
 	}
 
@@ -292,7 +332,7 @@ bool XMLTokenizer_Impl::next_tag_node(XMLToken *out_token)
 	return true;
 }
 
-bool XMLTokenizer_Impl::next_exclamation_mark_node(XMLToken *out_token)
+bool XMLTokenizer_Impl::next_exclamation_mark_node(XMLTokenView *out_token)
 {
 	if (pos+2 >= size)
 		XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
@@ -305,9 +345,7 @@ bool XMLTokenizer_Impl::next_exclamation_mark_node(XMLToken *out_token)
 			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 		pos = end_pos+3;
 
-		std::string text;
-		std::string text_orig = data.substr(start_pos, end_pos-start_pos);
-		unescape(text, text_orig);
+		XMLStringView text = unescape(start_pos, end_pos-start_pos);
 		if (eat_whitespace)
 			text = trim_whitespace(text);
 
@@ -461,7 +499,7 @@ bool XMLTokenizer_Impl::next_exclamation_mark_node(XMLToken *out_token)
 			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 		pos = end_pos+3;
 
-		std::string value = data.substr(start_pos, end_pos-start_pos);
+		XMLStringView value(data.data() + start_pos, end_pos-start_pos);
 
 		out_token->type = XMLToken::CDATA_SECTION_TOKEN;
 		out_token->variant = XMLToken::SINGLE;
@@ -470,7 +508,7 @@ bool XMLTokenizer_Impl::next_exclamation_mark_node(XMLToken *out_token)
 	}
 	else
 	{
-		XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream at position %1", static_cast<int>(pos)));
+		XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream at position %1", static_cast<int>(discarded_bytes + pos)));
 		return false;
 	}
 }
@@ -482,67 +520,195 @@ void XMLTokenizer_Impl::throw_exception(const std::string &str)
 
 int XMLTokenizer_Impl::get_line_number()
 {
-	int line = 1;
-	std::string::size_type tmp_pos = 0;
+	std::string::size_type end_pos = std::min(pos + 1, size);
+	return discarded_lines + 1 + static_cast<int>(std::count(data.begin(), data.begin() + end_pos, '\n'));
+}
 
-	std::string::const_iterator it;
-	for( it = data.begin(); it != data.end() && tmp_pos <= pos; ++it, tmp_pos++ )
+XMLStringView XMLTokenizer_Impl::unescape(std::string::size_type start, std::string::size_type length)
+{
+	const char *text = data.data() + start;
+	const char *text_end = text + length;
+	const char *amp = static_cast<const char *>(memchr(text, '&', length));
+	if (amp == 0)
+		return XMLStringView(text, length);
+
+	if (unescape_buffers_used == unescape_buffers.size())
+		unescape_buffers.push_back(std::string());
+	std::string &unescaped = unescape_buffers[unescape_buffers_used++];
+	unescaped.assign(text, amp);
+
+	static const struct { const char *name; std::string::size_type length; char replace; } entities[] =
 	{
-		if( (*it) == '\n' )
-			line++;
+		{ "&quot;", 6, '"' },
+		{ "&apos;", 6, '\'' },
+		{ "&lt;", 4, '<' },
+		{ "&gt;", 4, '>' },
+		{ "&amp;", 5, '&' }
+	};
+
+	const char *p = amp;
+	while (p != text_end)
+	{
+		if (*p == '&')
+		{
+			std::string::size_type remaining = text_end - p;
+			bool found = false;
+			for (const auto &entity : entities)
+			{
+				if (remaining >= entity.length && memcmp(p, entity.name, entity.length) == 0)
+				{
+					unescaped.push_back(entity.replace);
+					p += entity.length;
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+			{
+				unescaped.push_back('&');
+				p++;
+			}
+		}
+		else
+		{
+			const char *next_amp = static_cast<const char *>(memchr(p, '&', text_end - p));
+			if (next_amp == 0)
+				next_amp = text_end;
+			unescaped.append(p, next_amp);
+			p = next_amp;
+		}
 	}
 
-	return line;
+	return XMLStringView(unescaped.data(), unescaped.length());
 }
 
-inline void XMLTokenizer_Impl::unescape(std::string &unescaped, const std::string &text)
+XMLStringView XMLTokenizer_Impl::trim_whitespace(const XMLStringView &text)
 {
-	static const std::string quot("&quot;");
-	static const std::string apos("&apos;");
-	static const std::string lt("&lt;");
-	static const std::string gt("&gt;");
-	static const std::string amp("&amp;");
-
-	unescaped = text;
-	unescape(unescaped, quot, '"');
-	unescape(unescaped, apos, '\'');
-	unescape(unescaped, lt, '<');
-	unescape(unescaped, gt, '>');
-	unescape(unescaped, amp, '&');
+	static const char whitespace[] = " \t\r\n";
+	std::string::size_type pos_start = 0;
+	while (pos_start < text.length && memchr(whitespace, text.data[pos_start], 4))
+		pos_start++;
+	std::string::size_type pos_end = text.length;
+	while (pos_end > pos_start && memchr(whitespace, text.data[pos_end - 1], 4))
+		pos_end--;
+	return XMLStringView(text.data + pos_start, pos_end - pos_start);
 }
 
-inline void XMLTokenizer_Impl::unescape(std::string &text, const std::string &search, std::string::value_type replace)
+bool XMLTokenizer_Impl::is_token_complete()
 {
-	std::string::size_type read_pos = 0;
-	std::string::size_type length = text.length();
-	std::string::size_type search_length = search.length();
-	while (true)
+	// Checks if the next token is fully contained in the buffer, using the same rules as the parser
+	if (input_eof)
+		return true;
+	if (pos == size)
+		return false;
+
+	if (data[pos] != '<')
+		return data.find('<', pos) != data.npos;
+
+	// Enough to tell a comment, CDATA section and DOCTYPE apart
+	if (size - pos < 9)
+		return false;
+
+	if (data[pos + 1] == '!')
+	{
+		if (data.compare(pos + 2, 2, "--") == 0)
+			return data.find("-->", pos + 4) != data.npos;
+		if (data.compare(pos + 2, 7, "[CDATA[") == 0)
+			return data.find("]]>", pos + 9) != data.npos;
+
+		std::string::size_type end_pos = data.find('>', pos);
+		if (end_pos == data.npos)
+			return false;
+		std::string::size_type subset_pos = data.find('[', pos);
+		if (subset_pos != data.npos && subset_pos < end_pos)
+		{
+			std::string::size_type subset_end = data.find(']', subset_pos);
+			return subset_end != data.npos && data.find('>', subset_end) != data.npos;
+		}
+		return true;
+	}
+	else if (data[pos + 1] == '?')
 	{
-		std::string::size_type next_match = text.find(search, read_pos);
-		if (next_match == std::string::npos)
-			break;
-
-		std::string::size_type copy_size = length - (next_match + search_length);
-		if (copy_size > 0)
-			memmove(&text[next_match + 1], &text[next_match + search_length], copy_size * sizeof(std::string::value_type));
-		text[next_match] = replace;
-		length -= search_length - 1;
-		read_pos = next_match + 1;
-		if (read_pos > length)
-			break;
+		return data.find("?>", pos + 2) != data.npos;
 	}
-	text.resize(length);
+
+	// Element. Look for the closing '>', skipping quoted attribute values
+	for (std::string::size_type i = pos + 1; i < size; i++)
+	{
+		if (data[i] == '>')
+		{
+			return true;
+		}
+		else if (data[i] == '=')
+		{
+			i = data.find_first_not_of(" \r\n\t", i + 1);
+			if (i == data.npos)
+				return false;
+			if (data[i] == '"' || data[i] == '\'')
+			{
+				i = data.find(data[i], i + 1);
+				if (i == data.npos)
+					return false;
+			}
+			else
+			{
+				i--;
+			}
+		}
+	}
+	return false;
+}
+
+bool XMLTokenizer_Impl::read_input()
+{
+	if (input_eof)
+		return false;
+
+	// Drop the consumed part of the buffer
+	if (pos > 0)
+	{
+		discarded_lines += static_cast<int>(std::count(data.begin(), data.begin() + pos, '\n'));
+		discarded_bytes += pos;
+		data.erase(0, pos);
+		pos = 0;
+	}
+
+	// Grow the read size along with the buffer when a single token does not fit
+	std::string::size_type old_size = data.size();
+	int read_size = std::max(buffer_size, static_cast<int>(old_size));
+	data.resize(old_size + read_size);
+	int received = input.receive(&data[old_size], read_size, true);
+	if (received < 0)
+		received = 0;
+	data.resize(old_size + received);
+	size = data.size();
+
+	if (received < read_size)
+		input_eof = true;
+	return received > 0;
 }
 
-inline std::string XMLTokenizer_Impl::trim_whitespace(const std::string &text)
+void XMLTokenizer_Impl::check_bom()
 {
-	std::string::size_type pos_start = text.find_first_not_of(" \t\r\n");
-	if (pos_start == std::string::npos)
-		return std::string();
-	std::string::size_type pos_end = text.find_last_not_of(" \t\r\n");
-	if (pos_end == std::string::npos)
-		return std::string();
-	return text.substr(pos_start, pos_end - pos_start + 1);
+	StringHelp::BOMType bom_type = StringHelp::detect_bom(data.data(), data.size());
+	switch (bom_type)
+	{
+	default:
+	case StringHelp::bom_none:
+		break;
+	case StringHelp::bom_utf32_be:
+	case StringHelp::bom_utf32_le:
+		throw Exception("UTF-16 XML files not supported yet");
+		break;
+	case StringHelp::bom_utf16_be:
+	case StringHelp::bom_utf16_le:
+		throw Exception("UTF-32 XML files not supported yet");
+		break;
+	case StringHelp::bom_utf8:
+		pos = 3;
+		break;
+	}
 }
 
 }
@@ -29,6 +29,8 @@
 #pragma once
 
 #include "API/Core/IOData/iodevice.h"
+#include "API/Core/XML/xml_token_view.h"
+#include <deque>
 
 namespace clan
 {
@@ -38,7 +40,7 @@ class XMLTokenizer_Impl
 /// \name Construction
 /// \{
 public:
-	XMLTokenizer_Impl() : pos(0), size(0), eat_whitespace(true) { }
+	XMLTokenizer_Impl(const IODevice &input, int buffer_size);
 /// \}
 
 /// \name Attributes
@@ -48,27 +50,42 @@ public:
 	std::string::size_type pos, size;
 	std::string data;
 	bool eat_whitespace;
+
+	// Streaming state. data only holds the part of the input not yet consumed.
+	int buffer_size;
+	bool input_eof;
+	std::string::size_type discarded_bytes;
+	int discarded_lines;
+
+	XMLTokenView view_token;
+
+	// Storage for unescaped strings referenced by view_token
+	std::deque<std::string> unescape_buffers;
+	size_t unescape_buffers_used;
 /// \}
 
 /// \name Operations
 /// \{
 public:
 	static void throw_exception(const std::string &str);
-	bool next_text_node(XMLToken *out_token);
-	bool next_tag_node(XMLToken *out_token);
-	bool next_exclamation_mark_node(XMLToken *out_token);
+	void next(XMLTokenView *out_token);
+	bool next_text_node(XMLTokenView *out_token);
+	bool next_tag_node(XMLTokenView *out_token);
+	bool next_exclamation_mark_node(XMLTokenView *out_token);
 
 	// used to get the line number when there is an error in the xml file
 	int get_line_number();
 
-	void unescape(std::string &text_out, const std::string &text_in);
-	void unescape(std::string &text, const std::string &search, std::string::value_type replace);
-	std::string trim_whitespace(const std::string &text);
+	XMLStringView unescape(std::string::size_type start, std::string::size_type length);
+	static XMLStringView trim_whitespace(const XMLStringView &text);
 /// \}
 
 /// \name Implementation
 /// \{
 private:
+	bool is_token_complete();
+	bool read_input();
+	void check_bom();
 /// \}
 };
 
@@ -227,6 +227,77 @@ XPathEvaluateResult XPathEvaluator_Impl::evaluate(
 	return result;
 }
 
+void XPathEvaluator_Impl::set_cached_expression(const std::string &expression)
+{
+	cached_expression = expression;
+	cached_tokens.clear();
+	cached_token_index.clear();
+
+	std::vector<int> token_index(expression.length() + 1, -1);
+	XPathToken prev_token;
+	while (true)
+	{
+		XPathToken cur_token = read_token(cached_expression, prev_token);
+		token_index[prev_token.pos + prev_token.length] = cached_tokens.size();
+		cached_tokens.push_back(cur_token);
+		if (cur_token.type == XPathToken::type_none)
+			break;
+		prev_token = cur_token;
+	}
+	cached_token_index.swap(token_index);
+}
+
+bool XPathEvaluator_Impl::read_simple_location_path(const std::string &expression, bool &absolute, std::vector<XPathLocationStep> &steps) const
+{
+	steps.clear();
+	absolute = false;
+
+	XPathToken cur_token = read_token(expression);
+	if (cur_token.type == XPathToken::type_operator && cur_token.value.oper == XPathToken::operator_slash)
+	{
+		absolute = true;
+		cur_token = read_token(expression, cur_token);
+		if (cur_token.type == XPathToken::type_none)
+			return true;
+	}
+	else if (cur_token.type == XPathToken::type_operator && cur_token.value.oper == XPathToken::operator_double_slash)
+	{
+		absolute = true;
+	}
+
+	while (true)
+	{
+		if (cur_token.type != XPathToken::type_axis_name &&
+			cur_token.type != XPathToken::type_name_test &&
+			cur_token.type != XPathToken::type_node_type &&
+			cur_token.type != XPathToken::type_at_sign &&
+			cur_token.type != XPathToken::type_dot &&
+			cur_token.type != XPathToken::type_double_dot &&
+			!(cur_token.type == XPathToken::type_operator && cur_token.value.oper == XPathToken::operator_double_slash))
+			return false;
+
+		XPathLocationStep step;
+		cur_token = read_location_step(expression, cur_token, step);
+		if (!step.predicates.empty())
+			return false;
+		if (step.axis != "child" && step.axis != "attribute" && step.axis != "self" && step.axis != "parent" &&
+			step.axis != "descendant" && step.axis != "descendant-or-self")
+			return false;
+		steps.push_back(step);
+
+		bool double_slash = (cur_token.type == XPathToken::type_operator && cur_token.value.oper == XPathToken::operator_double_slash);
+		XPathToken next_token = read_token(expression, cur_token);
+		if (double_slash)
+			cur_token = next_token;
+		else if (next_token.type == XPathToken::type_operator && next_token.value.oper == XPathToken::operator_slash)
+			cur_token = read_token(expression, next_token);
+		else if (next_token.type == XPathToken::type_operator && next_token.value.oper == XPathToken::operator_double_slash)
+			cur_token = next_token;
+		else
+			return next_token.type == XPathToken::type_none;
+	}
+}
+
 XPathObject XPathEvaluator_Impl::call_function(const XPathNodeSet& context, XPathNodeSet::size_type context_node_index, const std::string &name, const std::vector<XPathObject> &parameters) const
 {
 	if (name == "last")
@@ -939,7 +1010,12 @@ XPathToken XPathEvaluator_Impl::read_location_steps(
 		steps.push_back(step);
 
 		XPathToken next_token = read_token(expression, cur_token);
-		if ((next_token.type == XPathToken::type_operator && next_token.value.oper == XPathToken::operator_slash) ||
+		if (next_token.type == XPathToken::type_operator && next_token.value.oper == XPathToken::operator_double_slash)
+		{
+			// '//' within a path is read as a descendant-or-self::node() step
+			cur_token = next_token;
+		}
+		else if ((next_token.type == XPathToken::type_operator && next_token.value.oper == XPathToken::operator_slash) ||
 			(cur_token.type == XPathToken::type_operator && cur_token.value.oper == XPathToken::operator_double_slash))
 		{
 			if (next_token.value.oper == XPathToken::operator_slash)
@@ -1120,7 +1196,7 @@ void XPathEvaluator_Impl::evaluate_location_step(const XPathNodeSet &context, XP
 			select_nodes_descendant_or_self(context, context_node_index, steps, step_index, expression, nodes);
 		else if (steps[step_index].axis == "following")
 			select_nodes_following(context, context_node_index, steps, step_index, expression, nodes);
-		else if (steps[step_index].axis == "follwing-sibling")
+		else if (steps[step_index].axis == "following-sibling")
 			select_nodes_following_sibling(context, context_node_index, steps, step_index, expression, nodes);
 		else if (steps[step_index].axis == "namespace")
 			select_nodes_namespace(context, context_node_index, steps, step_index, expression, nodes);
@@ -1241,7 +1317,8 @@ void XPathEvaluator_Impl::select_nodes_descendant_or_self(const XPathNodeSet &co
 		cur_node = cur_node.get_first_child();
 		while (cur_node.is_null())
 		{
-			if (parentNodes.empty())
+			// Stop at the context node rather than continuing with its siblings
+			if (parentNodes.size() <= 1)
 				break;
 			cur_node = parentNodes.back();
 			parentNodes.pop_back();
@@ -1420,7 +1497,12 @@ bool XPathEvaluator_Impl::confirm_step_requirements(const DomNode &node, const X
 
 bool XPathEvaluator_Impl::confirm_step_predicate(XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const XPathLocationStep::Predicate &predicate, const std::string &expression) const
 {
-	XPathEvaluateResult result = evaluate(expression.substr(predicate.pos, predicate.length), context, context_node_index, XPathToken());
+	// Evaluate in place, so that cached tokens are used. The evaluation ends at the closing ']'
+	XPathToken bracket_token;
+	bracket_token.type = XPathToken::type_bracket_begin;
+	bracket_token.pos = predicate.pos - 1;
+	bracket_token.length = 1;
+	XPathEvaluateResult result = evaluate(expression, context, context_node_index, bracket_token);
 	bool include_in_nodeset = false;
 	switch (result.result.get_type())
 	{
@@ -1465,6 +1547,9 @@ XPathToken XPathEvaluator_Impl::read_token(
 	const XPathToken &previous_token) const
 {
 	std::string::size_type pos = previous_token.pos + previous_token.length;
+	if (&expression == &cached_expression && pos < cached_token_index.size() && cached_token_index[pos] != -1)
+		return cached_tokens[cached_token_index[pos]];
+
 	pos = expression.find_first_not_of(" \t\r\n", pos);
 	if (pos == std::string::npos || expression.length() == pos)
 	{
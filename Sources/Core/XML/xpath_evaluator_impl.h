@@ -55,6 +55,17 @@ public:
 		XPathNodeSet::size_type context_node_index,
 		XPathToken prev_token) const;
 
+	/// \brief Tokenizes an expression up front, so that evaluating it reads tokens from a table
+	void set_cached_expression(const std::string &expression);
+
+	const std::string &get_cached_expression() const { return cached_expression; }
+
+	/// \brief Reads an expression that is nothing but a location path of child, attribute, self,
+	/// parent and descendant steps without predicates
+	///
+	/// \return false if the expression is anything else
+	bool read_simple_location_path(const std::string &expression, bool &absolute, std::vector<XPathLocationStep> &steps) const;
+
 private:
 	typedef XPathToken::Operator Operator;
 	typedef XPathObject Operand;
@@ -165,6 +176,10 @@ private:
 	static inline bool boolean(const DomNode &node);
 	static inline double number(const DomNode &node);
 	static inline std::string string(const DomNode &node);
+
+	std::string cached_expression;
+	std::vector<XPathToken> cached_tokens;
+	std::vector<int> cached_token_index;
 };
 
 }
@@ -0,0 +1,332 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/XML/xpath_expression.h"
+#include "API/Core/XML/xpath_exception.h"
+#include "API/Core/XML/dom_node.h"
+#include "xpath_expression_impl.h"
+#include "dom_document_generic.h"
+#include "dom_tree_node.h"
+#include <atomic>
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// XPathExpression Construction:
+
+XPathExpression::XPathExpression()
+{
+}
+
+XPathExpression::XPathExpression(const std::string &expression)
+: impl(std::make_shared<XPathExpression_Impl>(expression))
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// XPathExpression Attributes:
+
+std::string XPathExpression::get_expression() const
+{
+	return impl ? impl->evaluator.get_cached_expression() : std::string();
+}
+
+bool XPathExpression::is_memoized() const
+{
+	return impl ? impl->memoized : false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// XPathExpression Operations:
+
+XPathObject XPathExpression::evaluate(const DomNode &context_node) const
+{
+	if (!impl)
+		throw Exception("XPathExpression is null");
+	return impl->evaluate(context_node);
+}
+
+void XPathExpression::set_memoized(bool enable)
+{
+	if (!impl)
+		throw Exception("XPathExpression is null");
+	impl->memoized = enable;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// XPathExpression_Impl Construction:
+
+XPathExpression_Impl::XPathExpression_Impl(const std::string &expression)
+: memoized(false), simple_path(false), absolute_path(false)
+{
+	// Memo entries are keyed by id rather than address, so that a new expression never sees the results of a destroyed one
+	static std::atomic<unsigned int> next_id(0);
+	id = next_id++;
+
+	evaluator.set_cached_expression(expression);
+
+	std::vector<XPathLocationStep> location_steps;
+	simple_path = evaluator.read_simple_location_path(evaluator.get_cached_expression(), absolute_path, location_steps);
+	if (simple_path)
+	{
+		for (size_t i = 0; i < location_steps.size(); i++)
+		{
+			const XPathLocationStep &location_step = location_steps[i];
+
+			XPathCompiledStep step;
+			if (location_step.axis == "child")
+				step.axis = XPathCompiledStep::axis_child;
+			else if (location_step.axis == "attribute")
+				step.axis = XPathCompiledStep::axis_attribute;
+			else if (location_step.axis == "self")
+				step.axis = XPathCompiledStep::axis_self;
+			else if (location_step.axis == "parent")
+				step.axis = XPathCompiledStep::axis_parent;
+			else if (location_step.axis == "descendant")
+				step.axis = XPathCompiledStep::axis_descendant;
+			else
+				step.axis = XPathCompiledStep::axis_descendant_or_self;
+
+			step.test_type = location_step.test_type;
+			step.node_type = location_step.node_type;
+			step.test_str = location_step.test_str;
+			step.wildcard = (location_step.test_str == "*");
+			steps.push_back(step);
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// XPathExpression_Impl Operations:
+
+XPathObject XPathExpression_Impl::evaluate(const DomNode &context_node) const
+{
+	DomDocument_Impl *doc_impl = 0;
+	unsigned int context_index = cl_null_node_index;
+	if (!context_node.is_null())
+	{
+		doc_impl = static_cast<DomDocument_Impl *>(context_node.impl->owner_document.lock().get());
+		context_index = context_node.impl->node_index;
+	}
+
+	if (memoized && doc_impl)
+	{
+		if (doc_impl->xpath_memo_modification_count != doc_impl->modification_count)
+		{
+			doc_impl->xpath_memo.clear();
+			doc_impl->xpath_memo_modification_count = doc_impl->modification_count;
+		}
+
+		std::map<std::pair<unsigned int, unsigned int>, DomXPathMemoEntry>::const_iterator it;
+		it = doc_impl->xpath_memo.find(std::make_pair(id, context_index));
+		if (it != doc_impl->xpath_memo.end())
+			return it->second.is_node_set ? create_node_set(doc_impl, it->second.node_set) : it->second.result;
+	}
+
+	if (simple_path && doc_impl)
+	{
+		std::vector<unsigned int> node_indexes;
+		evaluate_simple_path(doc_impl, context_index, node_indexes);
+
+		if (memoized)
+		{
+			DomXPathMemoEntry &entry = doc_impl->xpath_memo[std::make_pair(id, context_index)];
+			entry.is_node_set = true;
+			entry.node_set = node_indexes;
+		}
+
+		return create_node_set(doc_impl, node_indexes);
+	}
+
+	const std::string &expression = evaluator.get_cached_expression();
+	std::vector<DomNode> nodelist(1, context_node);
+	XPathEvaluateResult result = evaluator.evaluate(expression, nodelist, 0, XPathToken());
+	if (result.next_token.type != XPathToken::type_none)
+		throw XPathException("Expected end of expression", expression, result.next_token);
+
+	if (memoized && doc_impl)
+	{
+		DomXPathMemoEntry &entry = doc_impl->xpath_memo[std::make_pair(id, context_index)];
+		if (result.result.get_type() == XPathObject::type_node_set)
+		{
+			std::vector<DomNode> nodes = result.result.get_node_set();
+			entry.is_node_set = true;
+			entry.node_set.reserve(nodes.size());
+			for (size_t i = 0; i < nodes.size(); i++)
+				entry.node_set.push_back(nodes[i].impl->node_index);
+		}
+		else
+		{
+			entry.result = result.result;
+		}
+	}
+
+	return result.result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// XPathExpression_Impl Implementation:
+
+void XPathExpression_Impl::evaluate_simple_path(DomDocument_Impl *doc_impl, unsigned int context_index, std::vector<unsigned int> &nodes) const
+{
+	unsigned int start_index = context_index;
+	if (absolute_path)
+	{
+		while (doc_impl->nodes[start_index]->parent != cl_null_node_index)
+			start_index = doc_impl->nodes[start_index]->parent;
+	}
+
+	// Selecting one step at a time for all nodes gives the same order as the
+	// interpreter, which evaluates the remaining steps for each node in turn
+	nodes.assign(1, start_index);
+	std::vector<unsigned int> next_nodes;
+	for (size_t step_index = 0; step_index < steps.size() && !nodes.empty(); step_index++)
+	{
+		const XPathCompiledStep &step = steps[step_index];
+
+		// Names are interned, so a name test is a pointer compare
+		const DomString *test_name = 0;
+		if (step.test_type == XPathLocationStep::type_name && !step.wildcard)
+		{
+			test_name = doc_impl->find_name(step.test_str.data(), step.test_str.length());
+			if (test_name == 0)
+			{
+				nodes.clear();
+				break;
+			}
+		}
+
+		next_nodes.clear();
+		for (size_t i = 0; i < nodes.size(); i++)
+			select_nodes(doc_impl, step, test_name, nodes[i], next_nodes);
+		nodes.swap(next_nodes);
+	}
+}
+
+void XPathExpression_Impl::select_nodes(DomDocument_Impl *doc_impl, const XPathCompiledStep &step, const DomString *test_name, unsigned int node_index, std::vector<unsigned int> &out_nodes) const
+{
+	const DomTreeNode *node = doc_impl->nodes[node_index];
+	switch (step.axis)
+	{
+	case XPathCompiledStep::axis_child:
+		for (unsigned int cur_index = node->first_child; cur_index != cl_null_node_index; cur_index = doc_impl->nodes[cur_index]->next_sibling)
+		{
+			if (confirm_step_requirements(doc_impl->nodes[cur_index], step, test_name))
+				out_nodes.push_back(cur_index);
+		}
+		break;
+
+	case XPathCompiledStep::axis_attribute:
+		for (unsigned int cur_index = node->first_attribute; cur_index != cl_null_node_index; cur_index = doc_impl->nodes[cur_index]->next_sibling)
+		{
+			if (confirm_step_requirements(doc_impl->nodes[cur_index], step, test_name))
+				out_nodes.push_back(cur_index);
+		}
+		break;
+
+	case XPathCompiledStep::axis_self:
+		if (confirm_step_requirements(node, step, test_name))
+			out_nodes.push_back(node_index);
+		break;
+
+	case XPathCompiledStep::axis_parent:
+		if (node->parent != cl_null_node_index && confirm_step_requirements(doc_impl->nodes[node->parent], step, test_name))
+			out_nodes.push_back(node->parent);
+		break;
+
+	case XPathCompiledStep::axis_descendant:
+	case XPathCompiledStep::axis_descendant_or_self:
+		{
+			if (step.axis == XPathCompiledStep::axis_descendant_or_self && confirm_step_requirements(node, step, test_name))
+				out_nodes.push_back(node_index);
+
+			// Document order walk of the subtree
+			unsigned int cur_index = node->first_child;
+			while (cur_index != cl_null_node_index)
+			{
+				const DomTreeNode *cur_node = doc_impl->nodes[cur_index];
+				if (confirm_step_requirements(cur_node, step, test_name))
+					out_nodes.push_back(cur_index);
+
+				if (cur_node->first_child != cl_null_node_index)
+				{
+					cur_index = cur_node->first_child;
+					continue;
+				}
+
+				while (cur_index != node_index && doc_impl->nodes[cur_index]->next_sibling == cl_null_node_index)
+					cur_index = doc_impl->nodes[cur_index]->parent;
+				if (cur_index == node_index)
+					break;
+				cur_index = doc_impl->nodes[cur_index]->next_sibling;
+			}
+		}
+		break;
+	}
+}
+
+bool XPathExpression_Impl::confirm_step_requirements(const DomTreeNode *node, const XPathCompiledStep &step, const DomString *test_name)
+{
+	switch (step.test_type)
+	{
+	default:
+	case XPathLocationStep::type_none:
+		return true;
+	case XPathLocationStep::type_name:
+		return (node->node_type == DomNode::ELEMENT_NODE || node->node_type == DomNode::ATTRIBUTE_NODE) && (step.wildcard || node->node_name == test_name);
+	case XPathLocationStep::type_node:
+		switch (step.node_type)
+		{
+		case XPathToken::node_type_comment:
+			return node->node_type == DomNode::COMMENT_NODE;
+		case XPathToken::node_type_text:
+			return node->node_type == DomNode::TEXT_NODE;
+		case XPathToken::node_type_processing_instruction:
+			return node->node_type == DomNode::PROCESSING_INSTRUCTION_NODE;
+		default:
+			return true;
+		}
+	}
+}
+
+XPathObject XPathExpression_Impl::create_node_set(DomDocument_Impl *doc_impl, const std::vector<unsigned int> &node_indexes)
+{
+	std::vector<DomNode> nodes;
+	nodes.reserve(node_indexes.size());
+	for (size_t i = 0; i < node_indexes.size(); i++)
+	{
+		DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
+		dom_node->node_index = node_indexes[i];
+		nodes.push_back(DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl))));
+	}
+	return XPathObject(nodes);
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/XML/xpath_object.h"
+#include "xpath_evaluator_impl.h"
+#include "xpath_location_step.h"
+
+namespace clan
+{
+
+class DomDocument_Impl;
+class DomTreeNode;
+
+class XPathCompiledStep
+{
+public:
+	enum Axis
+	{
+		axis_child,
+		axis_attribute,
+		axis_self,
+		axis_parent,
+		axis_descendant,
+		axis_descendant_or_self
+	};
+
+	Axis axis;
+	XPathLocationStep::TestType test_type;
+	XPathToken::NodeType node_type;
+	std::string test_str;
+	bool wildcard;
+};
+
+class XPathExpression_Impl
+{
+public:
+	XPathExpression_Impl(const std::string &expression);
+
+	XPathObject evaluate(const DomNode &context_node) const;
+
+	unsigned int id;
+	bool memoized;
+
+	// Set if the expression is a location path that is evaluated directly on the tree nodes
+	bool simple_path;
+	bool absolute_path;
+	std::vector<XPathCompiledStep> steps;
+
+	XPathEvaluator_Impl evaluator;
+
+private:
+	void evaluate_simple_path(DomDocument_Impl *doc_impl, unsigned int context_index, std::vector<unsigned int> &out_nodes) const;
+	void select_nodes(DomDocument_Impl *doc_impl, const XPathCompiledStep &step, const DomString *test_name, unsigned int node_index, std::vector<unsigned int> &out_nodes) const;
+	static bool confirm_step_requirements(const DomTreeNode *node, const XPathCompiledStep &step, const DomString *test_name);
+	static XPathObject create_node_set(DomDocument_Impl *doc_impl, const std::vector<unsigned int> &node_indexes);
+};
+
+}
@@ -32,16 +32,22 @@
 #include "API/Core/IOData/file.h"
 #include "API/Core/IOData/iodevice_memory.h"
 #include "API/Core/IOData/path_help.h"
+#include "API/Core/System/work_queue.h"
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Text/string_help.h"
+#include "API/Core/Zip/zip_writer.h"
+#include "API/Core/Zip/zlib_compression.h"
 #include "API/Core/System/mutex.h"
 #include "zip_archive_impl.h"
 #include "zip_file_header.h"
+#include "zip_local_file_header.h"
 #include "zip_64_end_of_central_directory_record.h"
 #include "zip_64_end_of_central_directory_locator.h"
 #include "zip_end_of_central_directory_record.h"
 #include "zip_file_entry_impl.h"
 #include "zip_iodevice_fileentry.h"
+#include "zip_iodevice_mappedentry.h"
+#include "zip_memory_map.h"
 #include "zip_compression_method.h"
 #include "zip_digital_signature.h"
 #include <ctime>
@@ -57,12 +63,25 @@ ZipArchive::ZipArchive()
 {
 }
 	
-ZipArchive::ZipArchive(const std::string &filename)
+ZipArchive::ZipArchive(const std::string &filename, bool memory_map)
 : impl(std::make_shared<ZipArchive_Impl>())
 {
-	IODevice input = File(filename);
-	impl->input = input;
-	load(input);
+	if (memory_map)
+	{
+		// The central directory is read through a memory device viewing the mapping
+		impl->memory_map = std::make_shared<ZipMemoryMap>(filename);
+		if (impl->memory_map->get_size() > 0x7fffffff)
+			throw Exception(string_format("Zip file %1 is too large to be memory mapped", filename));
+		DataBuffer view(impl->memory_map, impl->memory_map->get_data(), (unsigned int) impl->memory_map->get_size());
+		IODevice input = IODevice_Memory(view);
+		load(input);
+	}
+	else
+	{
+		IODevice input = File(filename);
+		impl->input = input;
+		load(input);
+	}
 }
 
 ZipArchive::ZipArchive(IODevice &input)
@@ -98,94 +117,89 @@ std::vector<ZipFileEntry> ZipArchive::get_file_list(const std::string &dirpath)
 	path = PathHelp::add_trailing_slash(path, PathHelp::path_type_virtual);
 
 	std::vector<ZipFileEntry> files;
-	std::vector<std::string> added_directories;
 
-	for (std::vector<ZipFileEntry>::size_type i=0; i<impl->files.size(); i++)
+	std::unordered_map<std::string, ZipArchive_Directory>::const_iterator it = impl->directories.find(impl->get_index_key(path));
+	if (it != impl->directories.end())
 	{
-		std::string filename = impl->files[i].get_archive_filename();
-		if (filename[0] != '/')
-		{
-			filename.insert(filename.begin(), '/');
-			impl->files[i].set_archive_filename(filename);
-		}
-		
-		if (filename.substr(0, path.size()) == path)
+		const std::vector<ZipArchive_Directory::Child> &children = it->second.children;
+		files.reserve(children.size());
+		for (size_t i = 0; i < children.size(); i++)
 		{
-			std::string::size_type subdir_slash_pos = filename.find('/', path.size());
-
-			if (subdir_slash_pos != std::string::npos) // subdirectory or files in a subdirectory
-			{
-				bool dir_added = false;
-				std::string directory_name = filename.substr(path.size(), subdir_slash_pos-path.size());
-
-				for (std::vector<std::string>::size_type j = 0; j < added_directories.size(); j++)
-				{
-					if (added_directories[j] == directory_name)
-						dir_added = true;
-				}
-
-				if (!dir_added)
-				{
-					ZipFileEntry dir_entry;
-					dir_entry.set_archive_filename(directory_name);
-					dir_entry.set_directory(true);
-					files.push_back(dir_entry);
-
-					added_directories.push_back(directory_name);
-				}
-			}
-			else if (impl->files[i].get_archive_filename() != path)
-			{
-				std::string file_name = filename.substr(path.size(), std::string::npos);
-				ZipFileEntry file_entry;
-				file_entry.set_archive_filename(file_name);
-				files.push_back(file_entry);
-			}
+			ZipFileEntry entry;
+			entry.set_archive_filename(children[i].name);
+			if (children[i].is_directory)
+				entry.set_directory(true);
+			files.push_back(entry);
 		}
 	}
 
 	return files;
 }
 
+bool ZipArchive::is_case_sensitive() const
+{
+	return impl->case_sensitive;
+}
+
+bool ZipArchive::is_memory_mapped() const
+{
+	return impl->memory_map != 0;
+}
+
+int ZipArchive::get_compression_level() const
+{
+	return impl->compression_level;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // ZipArchive operations:
 
 IODevice ZipArchive::open_file(const std::string &filename)
 {
-	int size = impl->files.size();
-	for (int i=0; i<size; i++)
+	int index = impl->find_file(filename);
+	if (index == -1)
+		throw Exception(string_format("Unable to find zip index %1", filename));
+
+	ZipFileEntry &entry = impl->files[index];
+	switch (entry.impl->type)
 	{
-		ZipFileEntry &entry = impl->files[i];
+	case ZipFileEntry_Impl::type_file:
+	{
+		if (impl->memory_map)
+			return impl->open_mapped_file(entry.impl->record);
 
-		std::string entry_filename = entry.impl->record.filename;
-		if (entry_filename[0] == '/')
-			entry_filename = entry_filename.substr(1,std::string::npos);
+		IODevice dupe = impl->input.duplicate();
+		return IODevice(new ZipIODevice_FileEntry(dupe, entry));
+	}
 
-		if (entry_filename == filename)
-		{
-			switch (entry.impl->type)
-			{
-			case ZipFileEntry_Impl::type_file:
-			{
-				IODevice dupe = impl->input.duplicate();
-				return IODevice(new ZipIODevice_FileEntry(dupe, entry));
-			}
+	case ZipFileEntry_Impl::type_removed:
+		throw Exception(string_format("Unable to zip open file entry %1. The entry has been removed!", filename));
+		break;
 
-			case ZipFileEntry_Impl::type_removed:
-				throw Exception(string_format("Unable to zip open file entry %1. The entry has been removed!", filename));
-				break;
+	case ZipFileEntry_Impl::type_added_memory:
+		return IODevice_Memory(entry.impl->data);
 
-			case ZipFileEntry_Impl::type_added_memory:
-				return IODevice_Memory(entry.impl->data);
+	case ZipFileEntry_Impl::type_added_file:
+		return File(entry.impl->filename);
+	}
+	throw Exception(string_format("Unknown zip file entry type %1", filename));
+}
 
-			case ZipFileEntry_Impl::type_added_file:
-				return File(entry.impl->filename);
-			}
-			throw Exception(string_format("Unknown zip file entry type %1", filename));
-		}
+DataBuffer ZipArchive::get_file_data(const std::string &filename)
+{
+	int index = impl->find_file(filename);
+	if (index != -1 && impl->memory_map)
+	{
+		const ZipFileEntry &entry = impl->files[index];
+		if (entry.impl->type == ZipFileEntry_Impl::type_file && entry.impl->record.compression_method == zip_compress_store)
+			return DataBuffer(impl->memory_map, impl->get_mapped_file_data(entry.impl->record), entry.impl->record.uncompressed_size);
 	}
-	throw Exception(string_format("Unable to find zip index %1", filename));
-} 
+
+	IODevice file = open_file(filename);
+	DataBuffer data(file.get_size());
+	data.set_size(file.read(data.get_data(), data.get_size()));
+	return data;
+}
 
 std::string ZipArchive::get_pathname(const std::string &filename)
 {
@@ -197,12 +211,28 @@ IODevice ZipArchive::create_file(const std::string &filename, bool compress)
 	throw Exception("ZipArchive::create_file: function not implemented.");
 }
 
-void ZipArchive::add_file(const std::string &input_filename, const std::string &archive_filename)
+void ZipArchive::add_file(const std::string &input_filename, const std::string &archive_filename, bool compress)
 {
 	ZipFileEntry file_entry;
+	file_entry.impl->type = ZipFileEntry_Impl::type_added_file;
+	file_entry.impl->compress = compress;
 	file_entry.set_input_filename(input_filename);
 	file_entry.set_archive_filename(archive_filename);
 	impl->files.push_back(file_entry);
+	impl->add_to_index(impl->files.size() - 1);
+}
+
+void ZipArchive::set_case_sensitive(bool enable)
+{
+	impl->case_sensitive = enable;
+	impl->build_index();
+}
+
+void ZipArchive::set_compression_level(int level)
+{
+	if (level < 0 || level > 9)
+		throw Exception(string_format("Invalid zip compression level %1", level));
+	impl->compression_level = level;
 }
 
 void ZipArchive::save()
@@ -213,97 +243,82 @@ void ZipArchive::save()
 void ZipArchive::save(const std::string &filename)
 {
 	File output(filename, File::create_always, File::access_read_write);
+	save(output);
+}
 
-	std::vector<int> local_header_offsets;
-	std::vector<ubyte32> crc32_codes;
+void ZipArchive::save(IODevice iodev)
+{
+	WorkQueue work_queue;
+	save(iodev, work_queue);
+}
 
-	byte16 dos_date = 0, dos_time = 0;
-	ZipArchive_Impl::calc_time_and_date(dos_date, dos_time);
+void ZipArchive::save(IODevice iodev, WorkQueue &work_queue)
+{
+	// Added files are packed ahead of the output, limited by count and by the bytes read but not written yet
+	const std::vector<ZipFileEntry>::size_type max_files_ahead = (work_queue.get_num_threads() + 1) * 4;
+	const byte64 max_bytes_ahead = 64 * 1024 * 1024;
 
-	std::vector<ZipFileEntry>::iterator it;
-	for (it=impl->files.begin(); it!=impl->files.end(); ++it)
-	{
-		local_header_offsets.push_back(output.get_position());
-
-		std::string input_filename = (*it).get_input_filename();
-		std::string archive_filename = (*it).get_archive_filename();
-		File input(input_filename);
-
-		DataBuffer data(input.get_size());
-		input.read(data.get_data(), data.get_size());
-
-		ubyte32 crc32 = ZipArchive_Impl::calc_crc32(data.get_data(), data.get_size());
-		crc32_codes.push_back(crc32);
-
-		// 1. local file header
-		ZipLocalFileHeader local_header;
-		local_header.version_needed_to_extract = 20;
-		local_header.general_purpose_bit_flag = ZIP_USE_UTF8;
-		local_header.compression_method = zip_compress_store;
-		local_header.last_mod_file_time = dos_time;
-		local_header.last_mod_file_date = dos_date;
-		local_header.crc32 = crc32;
-		local_header.uncompressed_size = data.get_size();
-		local_header.compressed_size = data.get_size();
-		local_header.file_name_length = archive_filename.size();
-		local_header.extra_field_length = 0;
-		local_header.filename = archive_filename;
-		local_header.extra_field = DataBuffer();
-		local_header.save(output);
-
-		// 2. Data (uncompressed for now)
-		output.write(data.get_data(), data.get_size());
-	}
+	std::vector<std::shared_ptr<ZipArchive_PackedFile> > packed_files(impl->files.size());
+	std::shared_ptr<std::atomic<byte64> > pending_bytes = std::make_shared<std::atomic<byte64> >(0);
+	int compression_level = impl->compression_level;
 
-	int index = 0;
-	int offset_start_central_dir = output.get_position();
+	ZipWriter writer(iodev, true);
 
-	// write central directory entries.
-	for (it=impl->files.begin(); it!=impl->files.end(); ++it)
+	std::vector<ZipFileEntry>::size_type next_queued = 0;
+	for (std::vector<ZipFileEntry>::size_type index = 0; index < impl->files.size(); index++)
 	{
-		std::string input_filename = (*it).get_input_filename();
-		std::string filename = (*it).get_archive_filename();
-		File input(input_filename);
-
-		(*it).impl->record.version_made_by = 20;
-		(*it).impl->record.version_needed_to_extract = 20;
-		(*it).impl->record.general_purpose_bit_flag = ZIP_USE_UTF8;
-		(*it).impl->record.compression_method = zip_compress_store;
-		(*it).impl->record.last_mod_file_time = dos_time;
-		(*it).impl->record.last_mod_file_date = dos_date;
-		(*it).impl->record.crc32 = crc32_codes[index];
-		(*it).impl->record.uncompressed_size = input.get_size();
-		(*it).impl->record.compressed_size = input.get_size(); // todo
-		(*it).impl->record.file_name_length = filename.size();
-		(*it).impl->record.extra_field_length = 0;
-		(*it).impl->record.filename = filename;
-		(*it).impl->record.extra_field = DataBuffer();
-		(*it).impl->record.file_comment_length = 0;
-		(*it).impl->record.disk_number_start = 0;
-		(*it).impl->record.internal_file_attributes = 0;
-		(*it).impl->record.external_file_attributes = 0;
-		(*it).impl->record.relative_offset_of_local_header = local_header_offsets[index];
-		(*it).impl->record.save(output);
-		index++;
-	}
+		while (next_queued < impl->files.size() && (next_queued == index || (next_queued < index + max_files_ahead && *pending_bytes < max_bytes_ahead)))
+		{
+			std::shared_ptr<ZipFileEntry_Impl> queued_entry = impl->files[next_queued].impl;
+			if (!queued_entry->is_directory && (queued_entry->type == ZipFileEntry_Impl::type_added_file || queued_entry->type == ZipFileEntry_Impl::type_added_memory))
+			{
+				std::shared_ptr<ZipArchive_PackedFile> packed_file = std::make_shared<ZipArchive_PackedFile>();
+				work_queue.queue([=]() { ZipArchive_Impl::pack_file(*packed_file, *queued_entry, compression_level, *pending_bytes); });
+				packed_files[next_queued] = packed_file;
+			}
+			next_queued++;
+		}
+
+		ZipFileEntry_Impl &entry = *impl->files[index].impl;
+		std::string archive_filename = entry.record.filename;
 
-/*	ZipDigitalSignature digi_sign;
-	digi_sign.size_of_data = 0;
-	digi_sign.save(output);*/
+		if (entry.type == ZipFileEntry_Impl::type_removed)
+		{
+			continue;
+		}
+		else if (entry.is_directory)
+		{
+			if (archive_filename.empty() || archive_filename[archive_filename.length() - 1] != '/')
+				archive_filename += "/";
+			writer.write_file(archive_filename, 0, 0, 0, 0, false);
+		}
+		else if (entry.type == ZipFileEntry_Impl::type_file)
+		{
+			// Loaded entries are copied as they are
+			DataBuffer data = impl->get_packed_file_data(entry.record);
+			bool deflated = entry.record.compression_method == zip_compress_deflate;
+			writer.write_file(archive_filename, data.get_data(), data.get_size(), (ubyte32) entry.record.uncompressed_size, entry.record.crc32, deflated);
+		}
+		else
+		{
+			std::shared_ptr<ZipArchive_PackedFile> packed_file = packed_files[index];
+			packed_files[index].reset();
 
-	int central_dir_size = output.get_position() - offset_start_central_dir;
+			packed_file->done_event.wait();
+			if (packed_file->exception)
+				std::rethrow_exception(packed_file->exception);
 
-	ZipEndOfCentralDirectoryRecord central_dir_end;
+			writer.write_file(archive_filename, packed_file->data.get_data(), packed_file->data.get_size(), packed_file->uncompressed_size, packed_file->crc32, packed_file->deflated);
+			*pending_bytes -= packed_file->uncompressed_size;
 
-	central_dir_end.number_of_this_disk = 0;
-	central_dir_end.number_of_disk_with_start_of_central_directory=0;
-	central_dir_end.number_of_entries_on_this_disk=local_header_offsets.size();
-	central_dir_end.number_of_entries_in_central_directory=local_header_offsets.size();
-	central_dir_end.size_of_central_directory = central_dir_size;
-	central_dir_end.offset_to_start_of_central_directory = offset_start_central_dir;
-	central_dir_end.file_comment_length = 0;
-	central_dir_end.file_comment = "";
-	central_dir_end.save(output);
+			entry.record.compression_method = packed_file->deflated ? zip_compress_deflate : zip_compress_store;
+			entry.record.crc32 = packed_file->crc32;
+			entry.record.uncompressed_size = packed_file->uncompressed_size;
+			entry.record.compressed_size = packed_file->data.get_size();
+		}
+	}
+
+	writer.write_toc();
 }
 
 void ZipArchive::load(IODevice &input)
@@ -361,7 +376,8 @@ void ZipArchive::load(IODevice &input)
 		input.seek(end64_locator, IODevice::seek_set);
 		zip64_locator.load(input);
 
-		input.seek(int(end64_locator+zip64_locator.relative_offset_of_zip64_end_of_central_directory), IODevice::seek_set);
+		// The offset of the zip64 record is relative to the start of the file
+		input.seek(int(zip64_locator.relative_offset_of_zip64_end_of_central_directory), IODevice::seek_set);
 		zip64_end_of_directory.load(input);
 
 		zip64 = true;
@@ -372,20 +388,183 @@ void ZipArchive::load(IODevice &input)
 	if (zip64) input.seek(int(zip64_end_of_directory.offset_to_start_of_central_directory), IODevice::seek_set);
 	else input.seek(int(end_of_directory.offset_to_start_of_central_directory), IODevice::seek_set);
 
-	byte64 num_entries = end_of_directory.number_of_entries_in_central_directory;
+	byte64 num_entries = (ubyte16) end_of_directory.number_of_entries_in_central_directory;
 	if (zip64) num_entries = zip64_end_of_directory.number_of_entries_in_central_directory;
 
+	impl->files.reserve(impl->files.size() + (size_t) num_entries);
 	for (int i=0; i<num_entries; i++)
 	{
 		ZipFileEntry entry;
 		entry.impl->record.load(input);
 		impl->files.push_back(entry);
 	}
+
+	impl->build_index();
 }
 
 /////////////////////////////////////////////////////////////////////////////
 // ZipArchive implementation:
 
+void ZipArchive_Impl::build_index()
+{
+	name_index.clear();
+	directories.clear();
+	name_index.reserve(files.size());
+	directories[get_index_key("/")];
+
+	for (size_t i = 0; i < files.size(); i++)
+		add_to_index(i);
+}
+
+void ZipArchive_Impl::add_to_index(int file_index)
+{
+	std::string filename = files[file_index].get_archive_filename();
+	if (!filename.empty() && filename[0] == '/')
+		filename.erase(0, 1);
+
+	name_index.insert(std::make_pair(get_index_key(filename), file_index));
+
+	// Add the file to its directory, creating the directories on the way that are not in the tree yet
+	std::string path = "/" + filename;
+	std::string::size_type slash_pos = 0;
+	while (true)
+	{
+		ZipArchive_Directory &directory = directories[get_index_key(path.substr(0, slash_pos + 1))];
+
+		std::string::size_type next_slash_pos = path.find('/', slash_pos + 1);
+		if (next_slash_pos == std::string::npos)
+		{
+			// Directory entries end with a slash and have no name here
+			if (slash_pos + 1 < path.length())
+				directory.children.push_back(ZipArchive_Directory::Child(path.substr(slash_pos + 1), false));
+			break;
+		}
+
+		std::string subdirectory_key = get_index_key(path.substr(0, next_slash_pos + 1));
+		if (directories.find(subdirectory_key) == directories.end())
+		{
+			directory.children.push_back(ZipArchive_Directory::Child(path.substr(slash_pos + 1, next_slash_pos - slash_pos - 1), true));
+			directories[subdirectory_key];
+		}
+
+		slash_pos = next_slash_pos;
+	}
+}
+
+int ZipArchive_Impl::find_file(const std::string &filename) const
+{
+	std::unordered_map<std::string, int>::const_iterator it;
+	if (!filename.empty() && filename[0] == '/')
+		it = name_index.find(get_index_key(filename.substr(1)));
+	else
+		it = name_index.find(get_index_key(filename));
+	return (it != name_index.end()) ? it->second : -1;
+}
+
+IODevice ZipArchive_Impl::open_mapped_file(const ZipFileHeader &record)
+{
+	const char *file_data = get_mapped_file_data(record);
+	switch (record.compression_method)
+	{
+	case zip_compress_store:
+		return IODevice(new ZipIODevice_MappedEntry(memory_map, file_data, record.uncompressed_size, record.uncompressed_size, false));
+
+	case zip_compress_deflate:
+		return IODevice(new ZipIODevice_MappedEntry(memory_map, file_data, record.compressed_size, record.uncompressed_size, true));
+
+	default:
+		throw Exception(string_format("Unsupported compression method %1", record.compression_method));
+	}
+}
+
+const char *ZipArchive_Impl::get_mapped_file_data(const ZipFileHeader &record)
+{
+	// Only the length of the local header is needed. The sizes are taken from the central directory record.
+	ubyte64 header_offset = (ubyte32) record.relative_offset_of_local_header;
+	if (header_offset + 30 > (ubyte64) memory_map->get_size())
+		throw Exception(string_format("Local file header of %1 is outside the zip file", record.filename));
+
+	const unsigned char *header = reinterpret_cast<const unsigned char *>(memory_map->get_data() + header_offset);
+	if (header[0] != 0x50 || header[1] != 0x4b || header[2] != 0x03 || header[3] != 0x04)
+		throw Exception(string_format("Incorrect local file header signature for %1", record.filename));
+
+	ubyte64 file_name_length = header[26] + (header[27] << 8);
+	ubyte64 extra_field_length = header[28] + (header[29] << 8);
+	ubyte64 data_offset = header_offset + 30 + file_name_length + extra_field_length;
+	if (data_offset + (ubyte32) record.compressed_size > (ubyte64) memory_map->get_size())
+		throw Exception(string_format("Data of %1 is outside the zip file", record.filename));
+	if (record.compression_method == zip_compress_store && record.compressed_size != record.uncompressed_size)
+		throw Exception(string_format("Sizes of stored file %1 do not match", record.filename));
+
+	return memory_map->get_data() + data_offset;
+}
+
+DataBuffer ZipArchive_Impl::get_packed_file_data(const ZipFileHeader &record)
+{
+	if (record.compression_method != zip_compress_store && record.compression_method != zip_compress_deflate)
+		throw Exception(string_format("Unsupported compression method %1", record.compression_method));
+
+	ubyte32 compressed_size = record.compressed_size;
+	if (memory_map)
+		return DataBuffer(memory_map, get_mapped_file_data(record), compressed_size);
+
+	IODevice file = input.duplicate();
+	file.set_little_endian_mode();
+	file.seek((ubyte32) record.relative_offset_of_local_header);
+
+	ZipLocalFileHeader local_header;
+	local_header.load(file);
+
+	DataBuffer data(compressed_size);
+	if (file.read(data.get_data(), data.get_size()) != (int) data.get_size())
+		throw Exception(string_format("Unexpected end of zip file reading %1", record.filename));
+	return data;
+}
+
+void ZipArchive_Impl::pack_file(ZipArchive_PackedFile &packed_file, const ZipFileEntry_Impl &entry, int compression_level, std::atomic<byte64> &pending_bytes)
+{
+	try
+	{
+		DataBuffer data;
+		if (entry.type == ZipFileEntry_Impl::type_added_memory)
+		{
+			data = entry.data;
+		}
+		else
+		{
+			File input(entry.filename);
+			data = DataBuffer(input.get_size());
+			data.set_size(input.read(data.get_data(), data.get_size()));
+		}
+		pending_bytes += data.get_size();
+
+		packed_file.uncompressed_size = data.get_size();
+		packed_file.crc32 = calc_crc32(data.get_data(), data.get_size());
+		packed_file.data = data;
+
+		// Store the file if deflating does not make it smaller
+		if (entry.compress && compression_level > 0 && data.get_size() > 0)
+		{
+			DataBuffer deflated = ZLibCompression::compress(data, true, compression_level);
+			if (deflated.get_size() < data.get_size())
+			{
+				packed_file.data = deflated;
+				packed_file.deflated = true;
+			}
+		}
+	}
+	catch (...)
+	{
+		packed_file.exception = std::current_exception();
+	}
+	packed_file.done_event.set();
+}
+
+std::string ZipArchive_Impl::get_index_key(const std::string &name) const
+{
+	return case_sensitive ? name : StringHelp::text_to_lower(name);
+}
+
 void ZipArchive_Impl::calc_time_and_date(byte16 &out_date, byte16 &out_time)
 {
 	ubyte32 day_of_month = 0;
@@ -30,18 +30,68 @@
 
 #include "API/Core/Zip/zip_file_entry.h"
 #include "API/Core/IOData/iodevice.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/System/event.h"
 #include "zip_flags.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace clan
 {
 
+class ZipFileHeader;
+class ZipFileEntry_Impl;
+class ZipMemoryMap;
+
+/// \brief Directory of a zip archive, listing the names of its files and subdirectories in archive order
+class ZipArchive_Directory
+{
+public:
+	class Child
+	{
+	public:
+		Child(const std::string &name, bool is_directory) : name(name), is_directory(is_directory) { }
+
+		std::string name;
+		bool is_directory;
+	};
+
+	std::vector<Child> children;
+};
+
+/// \brief File entry compressed by a work queue thread while ZipArchive::save writes the entries before it
+class ZipArchive_PackedFile
+{
+public:
+	ZipArchive_PackedFile() : uncompressed_size(0), crc32(0), deflated(false) { }
+
+	/// \brief Set when the entry has been packed or failed
+	Event done_event;
+
+	/// \brief Entry data as it is written to the archive
+	DataBuffer data;
+
+	byte64 uncompressed_size;
+	ubyte32 crc32;
+
+	/// \brief True if data is deflated, false if it is stored
+	bool deflated;
+
+	/// \brief Exception thrown while packing, rethrown by the saving thread
+	std::exception_ptr exception;
+};
+
 class ZipArchive_Impl
 {
 /// \name Construction
 /// \{
 
 public:
-
+	ZipArchive_Impl() : case_sensitive(true), compression_level(6) { }
 
 /// \}
 /// \name Attributes
@@ -52,12 +102,53 @@ public:
 
 	IODevice input;
 
+	/// \brief Mapping of the archive file, if it was opened memory mapped
+	std::shared_ptr<ZipMemoryMap> memory_map;
+
+	/// \brief True if filenames are compared case sensitively
+	bool case_sensitive;
+
+	/// \brief Deflate compression level used when saving added files
+	int compression_level;
+
+	/// \brief Index into files for each filename, without a leading slash. The first entry wins when a name is repeated.
+	std::unordered_map<std::string, int> name_index;
+
+	/// \brief Directories of the archive, keyed by their path in the form "/Folder/"
+	std::unordered_map<std::string, ZipArchive_Directory> directories;
+
 
 /// \}
 /// \name Operations
 /// \{
 
 public:
+	/// \brief Rebuilds name_index and directories from files
+	void build_index();
+
+	/// \brief Adds files[file_index] to name_index and directories
+	void add_to_index(int file_index);
+
+	/// \brief Returns the index of a file in files, or -1 if it is not in the archive
+	int find_file(const std::string &filename) const;
+
+	/// \brief Opens a file entry of a memory mapped archive
+	IODevice open_mapped_file(const ZipFileHeader &record);
+
+	/// \brief Returns the start of the data of a file entry in the memory mapping
+	const char *get_mapped_file_data(const ZipFileHeader &record);
+
+	/// \brief Returns the data of a loaded file entry as it is stored in the archive, without inflating it
+	DataBuffer get_packed_file_data(const ZipFileHeader &record);
+
+	/// \brief Reads and compresses an added file entry. Called on a work queue thread.
+	///
+	/// The number of bytes read is added to pending_bytes.
+	static void pack_file(ZipArchive_PackedFile &packed_file, const ZipFileEntry_Impl &entry, int compression_level, std::atomic<byte64> &pending_bytes);
+
+	/// \brief Returns the key of a filename or directory path in the index
+	std::string get_index_key(const std::string &name) const;
+
 	static ubyte32 calc_crc32(const void *data, byte64 size, ubyte32 crc = ZIP_CRC_START_VALUE, bool last_block = true);
 
 	static void calc_time_and_date(byte16 &out_date, byte16 &out_time);
@@ -41,6 +41,7 @@ ZipFileEntry::ZipFileEntry()
 {
 	impl->type = ZipFileEntry_Impl::type_file;
 	impl->is_directory = false;
+	impl->compress = false;
 }
 	
 ZipFileEntry::ZipFileEntry(const ZipFileEntry &copy)
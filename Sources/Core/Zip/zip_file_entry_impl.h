@@ -67,6 +67,9 @@ public:
 
 	/// \brief True, if this entry is a directory.
 	bool is_directory;
+
+	/// \brief True, if an added entry is deflated when saved (unless that does not make it smaller).
+	bool compress;
 /// \}
 };
 
@@ -0,0 +1,204 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "zip_iodevice_mappedentry.h"
+#include "zip_memory_map.h"
+#include "API/Core/Math/cl_math.h"
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// ZipIODevice_MappedEntry construction:
+
+ZipIODevice_MappedEntry::ZipIODevice_MappedEntry(const std::shared_ptr<ZipMemoryMap> &memory_map, const char *compressed_data, ubyte32 compressed_size, ubyte32 uncompressed_size, bool deflated)
+: memory_map(memory_map), compressed_data(compressed_data), compressed_size(compressed_size), uncompressed_size(uncompressed_size), deflated(deflated), pos(0), zstream_open(false)
+{
+	init();
+}
+
+ZipIODevice_MappedEntry::~ZipIODevice_MappedEntry()
+{
+	deinit();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ZipIODevice_MappedEntry attributes:
+
+int ZipIODevice_MappedEntry::get_size() const
+{
+	return uncompressed_size;
+}
+
+int ZipIODevice_MappedEntry::get_position() const
+{
+	return pos - peeked_data.get_size();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ZipIODevice_MappedEntry operations:
+
+int ZipIODevice_MappedEntry::send(const void * /*data*/, int /*len*/, bool /*send_all*/)
+{
+	throw Exception("Read-only device.");
+}
+
+int ZipIODevice_MappedEntry::receive(void *buffer, int size, bool /*receive_all*/)
+{
+	int received = 0;
+	if (peeked_data.get_size() > 0)
+	{
+		received = min(size, (int) peeked_data.get_size());
+		memcpy(buffer, peeked_data.get_data(), received);
+		memmove(peeked_data.get_data(), peeked_data.get_data() + received, peeked_data.get_size() - received);
+		peeked_data.set_size(peeked_data.get_size() - received);
+	}
+
+	if (received < size)
+		received += lowlevel_read((char *) buffer + received, size - received);
+	return received;
+}
+
+int ZipIODevice_MappedEntry::peek(void *data, int len)
+{
+	int old_size = peeked_data.get_size();
+	if (old_size < len)
+	{
+		peeked_data.set_size(len);
+		int bytes_read = lowlevel_read(peeked_data.get_data() + old_size, len - old_size);
+		peeked_data.set_size(old_size + bytes_read);
+	}
+
+	int peeked = min(len, (int) peeked_data.get_size());
+	memcpy(data, peeked_data.get_data(), peeked);
+	return peeked;
+}
+
+bool ZipIODevice_MappedEntry::seek(int seek_pos, IODevice::SeekMode mode)
+{
+	ubyte32 absolute_pos = 0;
+	switch (mode)
+	{
+	case IODevice::seek_set:
+		absolute_pos = seek_pos;
+		break;
+
+	case IODevice::seek_cur:
+		absolute_pos = get_position() + seek_pos;
+		break;
+
+	case IODevice::seek_end:
+		absolute_pos = uncompressed_size + seek_pos;
+		break;
+	}
+
+	peeked_data.set_size(0);
+
+	if (!deflated)
+	{
+		pos = min(absolute_pos, uncompressed_size);
+		return true;
+	}
+
+	// Restart the stream when seeking backwards
+	if (absolute_pos < pos)
+	{
+		deinit();
+		init();
+	}
+
+	char buffer[4*1024];
+	while (absolute_pos > pos)
+	{
+		if (lowlevel_read(buffer, (int) min(absolute_pos - pos, (ubyte32) sizeof(buffer))) == 0)
+			break;
+	}
+	return true;
+}
+
+IODeviceProvider *ZipIODevice_MappedEntry::duplicate()
+{
+	return new ZipIODevice_MappedEntry(memory_map, compressed_data, compressed_size, uncompressed_size, deflated);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ZipIODevice_MappedEntry implementation:
+
+void ZipIODevice_MappedEntry::init()
+{
+	pos = 0;
+	if (!deflated)
+		return;
+
+	memset(&zs, 0, sizeof(mz_stream));
+	int result = mz_inflateInit2(&zs, -15); // Undocumented: if wbits is negative, zlib skips header check
+	if (result != MZ_OK) throw Exception("Zlib inflateInit failed for zip index!");
+	zstream_open = true;
+
+	// The whole entry is available, so zlib reads it straight from the mapping
+	zs.next_in = (const unsigned char *) compressed_data;
+	zs.avail_in = compressed_size;
+}
+
+void ZipIODevice_MappedEntry::deinit()
+{
+	if (zstream_open)
+		mz_inflateEnd(&zs);
+	zstream_open = false;
+}
+
+int ZipIODevice_MappedEntry::lowlevel_read(void *data, int size)
+{
+	if (!deflated)
+	{
+		int received = (int) min((ubyte32) size, uncompressed_size - pos);
+		memcpy(data, compressed_data + pos, received);
+		pos += received;
+		return received;
+	}
+
+	zs.next_out = (unsigned char *) data;
+	zs.avail_out = size;
+	while (zs.avail_out > 0)
+	{
+		int result = mz_inflate(&zs, 0);
+		if (result == MZ_STREAM_END) break;
+		if (result == MZ_NEED_DICT) throw Exception("Zlib inflate wants a dictionary!");
+		if (result == MZ_DATA_ERROR) throw Exception("Zip data stream is corrupted");
+		if (result == MZ_STREAM_ERROR) throw Exception("Zip stream structure was inconsistent!");
+		if (result == MZ_MEM_ERROR) throw Exception("Zlib did not have enough memory to decompress file!");
+		if (result == MZ_BUF_ERROR) throw Exception("Zip data stream ended unexpectedly");
+		if (result != MZ_OK) throw Exception("Zlib inflate failed while decompressing zip file!");
+	}
+	int received = size - zs.avail_out;
+	pos += received;
+	return received;
+}
+
+}
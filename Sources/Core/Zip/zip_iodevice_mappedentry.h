@@ -0,0 +1,115 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/IOData/iodevice_provider.h"
+#include "API/Core/System/databuffer.h"
+#include "Core/Zip/miniz.h"
+#include <memory>
+
+namespace clan
+{
+
+class ZipMemoryMap;
+
+/// \brief Read-only zip file entry read straight from a memory mapped archive
+///
+/// Stored entries are copied from the mapping and deflated entries are inflated from it.
+/// Each device has its own position, so entries can be read from several threads at once.
+class ZipIODevice_MappedEntry : public IODeviceProvider
+{
+/// \name Construction
+/// \{
+
+public:
+	ZipIODevice_MappedEntry(const std::shared_ptr<ZipMemoryMap> &memory_map, const char *compressed_data, ubyte32 compressed_size, ubyte32 uncompressed_size, bool deflated);
+
+	~ZipIODevice_MappedEntry();
+
+
+/// \}
+/// \name Attributes
+/// \{
+
+public:
+	virtual int get_size() const;
+
+	virtual int get_position() const;
+
+
+/// \}
+/// \name Operations
+/// \{
+
+public:
+	virtual int send(const void *data, int len, bool send_all);
+
+	virtual int receive(void *data, int len, bool receive_all);
+
+	virtual int peek(void *data, int len);
+
+	virtual bool seek(int position, IODevice::SeekMode mode);
+
+	IODeviceProvider *duplicate();
+
+
+/// \}
+/// \name Implementation
+/// \{
+
+private:
+	void init();
+
+	void deinit();
+
+	/// \brief Copies or inflates the next bytes of the entry into data
+	int lowlevel_read(void *data, int size);
+
+	std::shared_ptr<ZipMemoryMap> memory_map;
+
+	const char *compressed_data;
+
+	ubyte32 compressed_size;
+
+	ubyte32 uncompressed_size;
+
+	bool deflated;
+
+	/// \brief Number of bytes inflated, including the peeked bytes
+	ubyte32 pos;
+
+	mz_stream zs;
+
+	bool zstream_open;
+
+	DataBuffer peeked_data;
+/// \}
+};
+
+}
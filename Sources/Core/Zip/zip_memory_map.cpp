@@ -0,0 +1,104 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "zip_memory_map.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/Text/string_help.h"
+#include "API/Core/Text/string_format.h"
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// ZipMemoryMap construction:
+
+ZipMemoryMap::ZipMemoryMap(const std::string &filename)
+: data(0), size(0)
+{
+#ifdef WIN32
+	file_handle = CreateFile(StringHelp::utf8_to_ucs2(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, 0);
+	if (file_handle == INVALID_HANDLE_VALUE)
+		throw Exception(string_format("Unable to open zip file %1", filename));
+
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file_handle, &file_size);
+	size = file_size.QuadPart;
+
+	mapping_handle = CreateFileMapping(file_handle, 0, PAGE_WRITECOPY, 0, 0, 0);
+	if (mapping_handle)
+		data = static_cast<const char *>(MapViewOfFile(mapping_handle, FILE_MAP_COPY, 0, 0, 0));
+	if (data == 0)
+	{
+		if (mapping_handle)
+			CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+		throw Exception(string_format("Unable to memory map zip file %1", filename));
+	}
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw Exception(string_format("Unable to open zip file %1", filename));
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == -1)
+	{
+		close(fd);
+		throw Exception(string_format("Unable to get the size of zip file %1", filename));
+	}
+	size = file_stat.st_size;
+
+	// The mapping stays valid after the file descriptor is closed.
+	// Pages are copied on write, so buffers viewing the mapping can be written to without changing the file.
+	void *mapping = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+		throw Exception(string_format("Unable to memory map zip file %1", filename));
+	data = static_cast<const char *>(mapping);
+#endif
+}
+
+ZipMemoryMap::~ZipMemoryMap()
+{
+#ifdef WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+#else
+	munmap(const_cast<char *>(data), size);
+#endif
+}
+
+}
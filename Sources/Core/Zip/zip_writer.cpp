@@ -34,6 +34,8 @@
 #include "zip_compression_method.h"
 #include "zip_file_header.h"
 #include "zip_end_of_central_directory_record.h"
+#include "zip_64_end_of_central_directory_record.h"
+#include "zip_64_end_of_central_directory_locator.h"
 #include "zip_flags.h"
 #include "Core/Zip/miniz.h"
 
@@ -60,6 +62,54 @@ public:
 		}
 	}
 
+	void init_local_header(const std::string &filename, bool compress)
+	{
+		local_header = ZipLocalFileHeader();
+		local_header.version_needed_to_extract = 20;
+		if (storeFilenamesAsUTF8)
+			local_header.general_purpose_bit_flag = ZIP_USE_UTF8;
+		else
+			local_header.general_purpose_bit_flag = 0;
+		local_header.compression_method = compress ? zip_compress_deflate : zip_compress_store;
+		ZipArchive_Impl::calc_time_and_date(
+			local_header.last_mod_file_date,
+			local_header.last_mod_file_time);
+		local_header.crc32 = 0;
+		local_header.uncompressed_size = 0;
+		local_header.compressed_size = 0;
+		local_header.file_name_length = filename.length();
+		local_header.filename = filename;
+
+		if (!storeFilenamesAsUTF8) // Add UTF-8 as extra field if we aren't storing normal UTF-8 filenames
+		{
+			// -Info-ZIP Unicode Path Extra Field (0x7075)
+			std::string filename_cp437 = StringHelp::text_to_cp437(filename);
+			std::string filename_utf8 = StringHelp::text_to_utf8(filename);
+			DataBuffer unicode_path(9 + filename_utf8.length());
+			ubyte16 *extra_id = (ubyte16 *) (unicode_path.get_data());
+			ubyte16 *extra_len = (ubyte16 *) (unicode_path.get_data() + 2);
+			ubyte8 *extra_version = (ubyte8 *) (unicode_path.get_data() + 4);
+			ubyte32 *extra_crc32 = (ubyte32 *) (unicode_path.get_data() + 5);
+			*extra_id = 0x7075;
+			*extra_len = 5 + filename_utf8.length();
+			*extra_version = 1;
+			*extra_crc32 = ZipArchive_Impl::calc_crc32(filename_cp437.data(), filename_cp437.size());
+			memcpy(unicode_path.get_data() + 9, filename_utf8.data(), filename_utf8.length());
+			local_header.extra_field_length = unicode_path.get_size();
+			local_header.extra_field = unicode_path;
+		}
+	}
+
+	/// \brief Throws if writing size more bytes moves the output past max_zip_size
+	void check_output_size(byte64 size)
+	{
+		if (size > max_zip_size || output.get_position() + size > max_zip_size)
+			throw Exception("Zip file is too large. ZipWriter does not write zip files larger than 2 GB");
+	}
+
+	/// \brief Largest zip file written. Positions of IODevice are int, and zip64 file entries are not written.
+	static const byte64 max_zip_size = 0x7fffffff;
+
 	struct FileEntry
 	{
 		ZipLocalFileHeader local_header;
@@ -103,41 +153,8 @@ void ZipWriter::begin_file(const std::string &filename, bool compress)
 	impl->crc32 = ZIP_CRC_START_VALUE;
 
 	impl->local_header_offset = impl->output.get_position();
-	impl->local_header = ZipLocalFileHeader();
-	impl->local_header.version_needed_to_extract = 20;
-	if (impl->storeFilenamesAsUTF8)
-		impl->local_header.general_purpose_bit_flag = ZIP_USE_UTF8;
-	else
-		impl->local_header.general_purpose_bit_flag = 0;
-	impl->local_header.compression_method = compress ? zip_compress_deflate : zip_compress_store;
-	ZipArchive_Impl::calc_time_and_date(
-		impl->local_header.last_mod_file_date,
-		impl->local_header.last_mod_file_time);
-	impl->local_header.crc32 = 0;
-	impl->local_header.uncompressed_size = 0;
-	impl->local_header.compressed_size = 0;
-	impl->local_header.file_name_length = filename.length();
-	impl->local_header.filename = filename;
-
-	if (!impl->storeFilenamesAsUTF8) // Add UTF-8 as extra field if we aren't storing normal UTF-8 filenames
-	{
-		// -Info-ZIP Unicode Path Extra Field (0x7075)
-		std::string filename_cp437 = StringHelp::text_to_cp437(filename);
-		std::string filename_utf8 = StringHelp::text_to_utf8(filename);
-		DataBuffer unicode_path(9 + filename_utf8.length());
-		ubyte16 *extra_id = (ubyte16 *) (unicode_path.get_data());
-		ubyte16 *extra_len = (ubyte16 *) (unicode_path.get_data() + 2);
-		ubyte8 *extra_version = (ubyte8 *) (unicode_path.get_data() + 4);
-		ubyte32 *extra_crc32 = (ubyte32 *) (unicode_path.get_data() + 5);
-		*extra_id = 0x7075;
-		*extra_len = 5 + filename_utf8.length();
-		*extra_version = 1;
-		*extra_crc32 = ZipArchive_Impl::calc_crc32(filename_cp437.data(), filename_cp437.size());
-		memcpy(unicode_path.get_data() + 9, filename_utf8.data(), filename_utf8.length());
-		impl->local_header.extra_field_length = unicode_path.get_size();
-		impl->local_header.extra_field = unicode_path;
-	}
-
+	impl->init_local_header(filename, compress);
+	impl->check_output_size(30 + impl->local_header.file_name_length + impl->local_header.extra_field_length);
 	impl->local_header.save(impl->output);
 
 	if (compress)
@@ -155,6 +172,8 @@ void ZipWriter::write_file_data(const void *data, byte64 size)
 		throw Exception("ZipWriter::begin_file not called prior ZipWriter::write_file_data");
 
 	impl->uncompressed_length += size;
+	if (impl->uncompressed_length > ZipWriter_Impl::max_zip_size)
+		throw Exception("Zip file entry is too large. ZipWriter does not write file entries larger than 2 GB");
 
 	if (impl->compress)
 	{
@@ -176,6 +195,7 @@ void ZipWriter::write_file_data(const void *data, byte64 size)
 			byte64 zsize = 16*1024 - impl->zs.avail_out;
 			if (zsize > 0)
 			{
+				impl->check_output_size(zsize);
 				impl->compressed_length += zsize;
 				impl->output.write(impl->zbuffer, zsize);
 			}
@@ -183,6 +203,7 @@ void ZipWriter::write_file_data(const void *data, byte64 size)
 	}
 	else
 	{
+		impl->check_output_size(size);
 		impl->compressed_length += size;
 		impl->output.write(data, size);
 	}
@@ -214,6 +235,7 @@ void ZipWriter::end_file()
 			byte64 zsize = 16*1024 - impl->zs.avail_out;
 			if (zsize == 0)
 				break;
+			impl->check_output_size(zsize);
 			impl->output.write(impl->zbuffer, zsize);
 			impl->compressed_length += zsize;
 
@@ -242,6 +264,29 @@ void ZipWriter::end_file()
 	impl->file_begun = false;
 }
 
+void ZipWriter::write_file(const std::string &filename, const void *data, byte64 size, byte64 uncompressed_size, ubyte32 crc32, bool deflated)
+{
+	if (impl->file_begun)
+		throw Exception("ZipWriter already writing a file");
+
+	if (uncompressed_size > ZipWriter_Impl::max_zip_size)
+		throw Exception("Zip file entry is too large. ZipWriter does not write file entries larger than 2 GB");
+
+	impl->local_header_offset = impl->output.get_position();
+	impl->init_local_header(filename, deflated);
+	impl->check_output_size(30 + impl->local_header.file_name_length + impl->local_header.extra_field_length + size);
+	impl->local_header.crc32 = crc32;
+	impl->local_header.uncompressed_size = uncompressed_size;
+	impl->local_header.compressed_size = size;
+	impl->local_header.save(impl->output);
+	impl->output.write(data, size);
+
+	ZipWriter_Impl::FileEntry file_entry;
+	file_entry.local_header = impl->local_header;
+	file_entry.local_header_offset = impl->local_header_offset;
+	impl->written_files.push_back(file_entry);
+}
+
 void ZipWriter::write_toc()
 {
 	if (impl->file_begun)
@@ -272,6 +317,7 @@ void ZipWriter::write_toc()
 		file_header.internal_file_attributes = 0;
 		file_header.external_file_attributes = 0;
 		file_header.relative_offset_of_local_header = impl->written_files[index].local_header_offset;
+		impl->check_output_size(46 + file_header.file_name_length + file_header.extra_field_length);
 		file_header.save(impl->output);
 	}
 /*
@@ -281,11 +327,37 @@ void ZipWriter::write_toc()
 */
 	byte64 central_dir_size = impl->output.get_position() - offset_start_central_dir;
 
+	// The entry count only fits the end of central directory record up to 0xffff entries
+	bool zip64 = impl->written_files.size() >= 0xffff;
+	impl->check_output_size(zip64 ? 56 + 20 + 22 : 22);
+	if (zip64)
+	{
+		byte64 offset_zip64_end_of_central_dir = impl->output.get_position();
+
+		Zip64EndOfCentralDirectoryRecord zip64_central_dir_end;
+		zip64_central_dir_end.size_of_record = 44;
+		zip64_central_dir_end.version_made_by = 45;
+		zip64_central_dir_end.version_needed_to_extract = 45;
+		zip64_central_dir_end.number_of_this_disk = 0;
+		zip64_central_dir_end.number_of_disk_with_central_directory_start = 0;
+		zip64_central_dir_end.number_of_entries_on_this_disk = impl->written_files.size();
+		zip64_central_dir_end.number_of_entries_in_central_directory = impl->written_files.size();
+		zip64_central_dir_end.size_of_central_directory = central_dir_size;
+		zip64_central_dir_end.offset_to_start_of_central_directory = offset_start_central_dir;
+		zip64_central_dir_end.save(impl->output);
+
+		Zip64EndOfCentralDirectoryLocator zip64_locator;
+		zip64_locator.number_of_disk_with_zip64_end_of_central_directory = 0;
+		zip64_locator.relative_offset_of_zip64_end_of_central_directory = offset_zip64_end_of_central_dir;
+		zip64_locator.total_number_of_disks = 1;
+		zip64_locator.save(impl->output);
+	}
+
 	ZipEndOfCentralDirectoryRecord central_dir_end;
 	central_dir_end.number_of_this_disk = 0;
 	central_dir_end.number_of_disk_with_start_of_central_directory = 0;
-	central_dir_end.number_of_entries_on_this_disk = impl->written_files.size();
-	central_dir_end.number_of_entries_in_central_directory = impl->written_files.size();
+	central_dir_end.number_of_entries_on_this_disk = zip64 ? 0xffff : impl->written_files.size();
+	central_dir_end.number_of_entries_in_central_directory = zip64 ? 0xffff : impl->written_files.size();
 	central_dir_end.size_of_central_directory = central_dir_size;
 	central_dir_end.offset_to_start_of_central_directory = offset_start_central_dir;
 	central_dir_end.file_comment_length = 0;
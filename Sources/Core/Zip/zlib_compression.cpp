@@ -41,9 +41,6 @@ DataBuffer ZLibCompression::compress(const DataBuffer &data, bool raw, int compr
 {
 	const int window_bits = 15;
 
-	DataBuffer zbuffer(1024*1024);
-	IODevice_Memory output;
-
 	int strategy = MZ_DEFAULT_STRATEGY;
 	switch (mode)
 	{
@@ -59,29 +56,26 @@ DataBuffer ZLibCompression::compress(const DataBuffer &data, bool raw, int compr
 	if (result != MZ_OK)
 		throw Exception("Zlib deflateInit failed");
 
+	DataBuffer output;
 	try
 	{
+		// Deflate straight into a buffer large enough for the whole stream
+		output.set_size(mz_deflateBound(&zs, data.get_size()));
+
 		zs.next_in = (unsigned char *) data.get_data();
 		zs.avail_in = data.get_size();
-		while (true)
-		{
-			zs.next_out = (unsigned char *) zbuffer.get_data();
-			zs.avail_out = zbuffer.get_size();
-
-			int result = mz_deflate(&zs, MZ_FINISH);
-			if (result == MZ_NEED_DICT) throw Exception("Zlib deflate wants a dictionary!");
-			if (result == MZ_DATA_ERROR) throw Exception("Zip data stream is corrupted");
-			if (result == MZ_STREAM_ERROR) throw Exception("Zip stream structure was inconsistent!");
-			if (result == MZ_MEM_ERROR) throw Exception("Zlib did not have enough memory to compress file!");
-			if (result == MZ_BUF_ERROR) throw Exception("Not enough data in buffer when Z_FINISH was used");
-			if (result != MZ_OK && result != MZ_STREAM_END) throw Exception("Zlib deflate failed while compressing zip file!");
-			int zsize = zbuffer.get_size() - zs.avail_out;
-			if (zsize == 0)
-				break;
-			output.write(zbuffer.get_data(), zsize);
-			if (result == MZ_STREAM_END)
-				break;
-		}
+		zs.next_out = (unsigned char *) output.get_data();
+		zs.avail_out = output.get_size();
+
+		int result = mz_deflate(&zs, MZ_FINISH);
+		if (result == MZ_NEED_DICT) throw Exception("Zlib deflate wants a dictionary!");
+		if (result == MZ_DATA_ERROR) throw Exception("Zip data stream is corrupted");
+		if (result == MZ_STREAM_ERROR) throw Exception("Zip stream structure was inconsistent!");
+		if (result == MZ_MEM_ERROR) throw Exception("Zlib did not have enough memory to compress file!");
+		if (result == MZ_BUF_ERROR) throw Exception("Not enough data in buffer when Z_FINISH was used");
+		if (result != MZ_STREAM_END) throw Exception("Zlib deflate failed while compressing zip file!");
+
+		output.set_size(output.get_size() - zs.avail_out);
 		mz_deflateEnd(&zs);
 	}
 	catch (...)
@@ -90,7 +84,7 @@ DataBuffer ZLibCompression::compress(const DataBuffer &data, bool raw, int compr
 		throw;
 	}
 
-	return output.get_data();
+	return output;
 }
 
 DataBuffer ZLibCompression::decompress(const DataBuffer &data, bool raw)
@@ -344,6 +344,18 @@ void Canvas::fill_rect(const Rectf &rect, const Colorf &color)
 	fill_rect(rect.left, rect.top, rect.right, rect.bottom, color);
 }
 
+void Canvas::fill_rects(const Rectf *dest_rects, const Rectf *texture_rects, int num_rects, const Texture2D &texture, const Colorf &color)
+{
+	RenderBatchTriangle *batcher = impl->batcher.get_triangle_batcher();
+	batcher->draw_images(*this, texture_rects, dest_rects, num_rects, color, 0, texture);
+}
+
+void Canvas::fill_rects(const Rectf *dest_rects, const Rectf *texture_rects, int num_rects, const Texture2D &texture, const Colorf *colors)
+{
+	RenderBatchTriangle *batcher = impl->batcher.get_triangle_batcher();
+	batcher->draw_images(*this, texture_rects, dest_rects, num_rects, Colorf::white, colors, texture);
+}
+
 void Canvas::fill_rect(float x1, float y1, float x2, float y2, const Gradient &gradient)
 {
 	Vec2f positions[6] =
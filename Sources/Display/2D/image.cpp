@@ -178,6 +178,11 @@ Resource<Image> Image::resource(Canvas &canvas, const std::string &id, const Res
 }
 
 Image Image::load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc)
+{
+	return load(canvas, id, doc, [](GraphicContext &gc, const std::string &filename, const FileSystem &fs) { return Texture2D(gc, filename, fs); });
+}
+
+Image Image::load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(GraphicContext &, const std::string &, const FileSystem &)> &load_texture)
 {
 	Image image;
 
@@ -197,7 +202,7 @@ Image Image::load(Canvas &canvas, const std::string &id, const XMLResourceDocume
 		if (tag_name == "image" || tag_name == "image-file")
 		{
 			std::string image_name = cur_element.get_attribute("file");
-			Texture2D texture = Texture2D(canvas, PathHelp::combine(resource.get_base_path(), image_name), resource.get_file_system());
+			Texture2D texture = load_texture(canvas, PathHelp::combine(resource.get_base_path(), image_name), resource.get_file_system());
 
 			DomNode cur_child(cur_element.get_first_child());
 			if(cur_child.is_null()) 
@@ -29,151 +29,154 @@
 
 #include "Display/precomp.h"
 #include "path_fill_renderer.h"
-#include <algorithm>
+#include "API/Display/2D/canvas.h"
 
 namespace clan
 {
-	PathFillRenderer::PathFillRenderer(GraphicContext &gc)
+	PathFillRenderer::PathFillRenderer(GraphicContext &gc, RenderBatchBuffer *batch_buffer) : batch_buffer(batch_buffer)
 	{
+		vertices = reinterpret_cast<Vertex *>(batch_buffer->buffer);
+
 		BlendStateDescription blend_desc;
 		blend_desc.set_blend_function(blend_one, blend_one_minus_src_alpha, blend_one, blend_one_minus_src_alpha);
 		blend_state = BlendState(gc, blend_desc);
+
+		// Slot 0 is the shared solid tile used by all fully covered tiles
+		mask_buffer = PixelBuffer(mask_texture_size, mask_texture_size, tf_r8);
+		for (int y = 0; y < tile_size; y++)
+			memset(mask_buffer.get_line_uint8(y), 255, tile_size);
 	}
 
-	void PathFillRenderer::set_size(int new_width, int new_height)
+	void PathFillRenderer::fill(Canvas &canvas, PathFillMode mode, const Brush &brush)
 	{
-		if (width != new_width || height != new_height)
+		rasterize(mode);
+		if (tile_columns == 0 || tile_rows == 0) return;
+
+		Vec4f solid_color;
+
+		if (brush.type == BrushType::solid)
 		{
-			width = new_width;
-			height = new_height;
-			scanlines.resize(height * 2);
-			mask = PixelBuffer(width, height, tf_r8);
-			memset(mask.get_data(), 0, mask.get_height() * mask.get_pitch());
+			solid_color = Vec4f(brush.color.r, brush.color.g, brush.color.b, brush.color.a);
 		}
-	}
-
-	void PathFillRenderer::clear()
-	{
-		for (size_t y = 0; y < scanlines.size(); y++)
+		else if (brush.type == BrushType::linear)
 		{
-			auto &scanline = scanlines[y];
-			if (!scanline.edges.empty())
-			{
-				memset(mask.get_line(y / 2), 0, width);
-				scanline.edges.clear();
-			}
+			solid_color = Vec4f(brush.stops.front().color.r, brush.stops.front().color.g, brush.stops.front().color.b, brush.stops.front().color.a);
 		}
-	}
-
-	void PathFillRenderer::end(bool close)
-	{
-		if (close)
+		else if (brush.type == BrushType::radial)
 		{
-			line(start_x, start_y);
+			solid_color = Vec4f(1.0f, 1.0f, 0.0f, 1.0f);
+		}
+		else if (brush.type == BrushType::image)
+		{
+			solid_color = Vec4f(1.0f, 0.0f, 0.0f, 1.0f);
 		}
-	}
-
-	void PathFillRenderer::line(float x1, float y1)
-	{
-		float x0 = last_x;
-		float y0 = last_y;
-
-		last_x = x1;
-		last_y = y1;
-
-		x0 *= 2.0f;
-		x1 *= 2.0f;
-		y0 *= 2.0f;
-		y1 *= 2.0f;
-
-		bool up_direction = y1 < y0;
-		float dy = y1 - y0;
 
-		const float epsilon = std::numeric_limits<float>::epsilon();
-		if (dy < -epsilon || dy > epsilon)
+		for (int tile_y = 0; tile_y < tile_rows; tile_y++)
 		{
-			int start_y = static_cast<int>(std::floor(min(y0, y1) + 0.5f));
-			int end_y = static_cast<int>(std::floor(max(y0, y1) - 0.5f)) + 1;
+			int y0 = (tile_top + tile_y) * tile_size;
+			int y1 = y0 + tile_size;
 
-			start_y = max(start_y, 0);
-			end_y = min(end_y, height * 2);
+			int tile_x = 0;
+			while (tile_x < tile_columns)
+			{
+				PathTileCoverage coverage = get_tile_coverage(tile_x, tile_y);
+				int x0 = (tile_left + tile_x) * tile_size;
 
-			float rcp_dy = 1.0f / dy;
+				if (coverage == PathTileCoverage::full)
+				{
+					// Merge runs of full tiles into one quad stretching the solid slot
+					int run_end = tile_x + 1;
+					while (run_end < tile_columns && get_tile_coverage(run_end, tile_y) == PathTileCoverage::full)
+						run_end++;
 
-			for (int y = start_y; y < end_y; y++)
-			{
-				float ypos = y + 0.5f;
-				float x = x0 + (x1 - x0) * (ypos - y0) * rcp_dy;
-				scanlines[y].edges.push_back(PathScanlineEdge(x, up_direction));
+					add_quad(canvas, x0, y0, (tile_left + run_end) * tile_size, y1, 0, solid_color);
+					tile_x = run_end;
+				}
+				else
+				{
+					if (coverage == PathTileCoverage::partial)
+					{
+						int slot = allocate_mask_slot(canvas, tile_x, tile_y);
+						add_quad(canvas, x0, y0, x0 + tile_size, y1, slot, solid_color);
+					}
+					tile_x++;
+				}
 			}
 		}
 	}
 
-	void PathFillRenderer::fill(RenderBatchBuffer *batch_buffer, Canvas &canvas, PathFillMode mode, const Brush &brush)
+	int PathFillRenderer::allocate_mask_slot(const Canvas &canvas, int tile_x, int tile_y)
 	{
-		if (scanlines.empty()) return;
-
-		canvas.flush();
-
-		for (size_t y = 0; y < scanlines.size(); y++)
+		if (next_mask_slot == max_mask_slots)
 		{
-			auto &scanline = scanlines[y];
-			std::sort(scanline.edges.begin(), scanline.edges.end(), [](const PathScanlineEdge &a, const PathScanlineEdge &b) { return a.x < b.x; });
-
-			unsigned char *line = mask.get_line_uint8(y / 2);
+			GraphicContext gc = canvas.get_gc();
+			flush(gc);
+		}
 
-			PathRasterRange range(scanline, mode);
-			while (true)
-			{
-				range.next();
-				if (!range.found) break;
+		int slot = next_mask_slot++;
+		int slot_x = (slot % mask_slots_per_row) * tile_size;
+		int slot_y = (slot / mask_slots_per_row) * tile_size;
 
-				int x0 = static_cast<int>(range.x0 + 0.5f);
-				int x1 = static_cast<int>(range.x1 - 0.5f) + 1;
+		for (int y = 0; y < tile_size; y++)
+			memcpy(mask_buffer.get_line_uint8(slot_y + y) + slot_x, get_tile_line(tile_x, tile_y, y), tile_size);
 
-				x0 = max(x0, 0);
-				x1 = min(x1, width * 2);
+		return slot;
+	}
 
-				for (int x = x0; x < x1; x++)
-				{
-					int pixel = line[x / 2];
-					pixel = min(pixel + 64, 255);
-					line[x / 2] = pixel;
-				}
-			}
+	void PathFillRenderer::add_quad(Canvas &canvas, int x0, int y0, int x1, int y1, int slot, const Vec4f &color)
+	{
+		if (position + 6 > max_vertices)
+		{
+			// The mask slot of this quad was already written, so keep the atlas contents
+			GraphicContext gc = canvas.get_gc();
+			int saved_mask_slot = next_mask_slot;
+			flush(gc);
+			next_mask_slot = saved_mask_slot;
 		}
 
-		GraphicContext gc = canvas.get_gc();
-		Texture2D texture(gc, mask);
-		texture.set_min_filter(filter_nearest);
-		texture.set_mag_filter(filter_nearest);
-
-		Vec4f solid_color;
+		float rcp_width = 2.0f / width;
+		float rcp_height = 2.0f / height;
+		float left = x0 * rcp_width - 1.0f;
+		float right = x1 * rcp_width - 1.0f;
+		float top = 1.0f - y0 * rcp_height;
+		float bottom = 1.0f - y1 * rcp_height;
+
+		const float rcp_mask_size = 1.0f / mask_texture_size;
+		float tex_left = (slot % mask_slots_per_row) * tile_size * rcp_mask_size;
+		float tex_top = (slot / mask_slots_per_row) * tile_size * rcp_mask_size;
+		float tex_right = tex_left + tile_size * rcp_mask_size;
+		float tex_bottom = tex_top + tile_size * rcp_mask_size;
+
+		Vertex *v = vertices + position;
+		v[0] = Vertex(Vec4f(left, bottom, 0.0f, 1.0f), color, Vec2f(tex_left, tex_bottom));
+		v[1] = Vertex(Vec4f(right, bottom, 0.0f, 1.0f), color, Vec2f(tex_right, tex_bottom));
+		v[2] = Vertex(Vec4f(left, top, 0.0f, 1.0f), color, Vec2f(tex_left, tex_top));
+		v[3] = Vertex(Vec4f(right, bottom, 0.0f, 1.0f), color, Vec2f(tex_right, tex_bottom));
+		v[4] = Vertex(Vec4f(right, top, 0.0f, 1.0f), color, Vec2f(tex_right, tex_top));
+		v[5] = Vertex(Vec4f(left, top, 0.0f, 1.0f), color, Vec2f(tex_left, tex_top));
+		position += 6;
+	}
 
-		if (brush.type == BrushType::solid)
-		{
-			solid_color = Vec4f(brush.color.r, brush.color.g, brush.color.b, brush.color.a);
-		}
-		else if (brush.type == BrushType::linear)
-		{
-			solid_color = Vec4f(brush.stops.front().color.r, brush.stops.front().color.g, brush.stops.front().color.b, brush.stops.front().color.a);
-		}
-		else if (brush.type == BrushType::radial)
+	void PathFillRenderer::flush(GraphicContext &gc)
+	{
+		if (position == 0)
 		{
-			solid_color = Vec4f(1.0f, 1.0f, 0.0f, 1.0f);
+			next_mask_slot = 1;
+			return;
 		}
-		else if (brush.type == BrushType::image)
+
+		if (mask_texture.is_null())
 		{
-			solid_color = Vec4f(1.0f, 0.0f, 0.0f, 1.0f);
+			mask_texture = Texture2D(gc, mask_texture_size, mask_texture_size, tf_r8);
+			mask_texture.set_min_filter(filter_nearest);
+			mask_texture.set_mag_filter(filter_nearest);
+			mask_texture.set_subimage(gc, 0, 0, mask_buffer, Rect(0, 0, tile_size, tile_size));
 		}
 
-		std::vector<Vertex> vertices;
-		vertices.push_back(Vertex(Vec4f(-1.0f, -1.0f, 0.0f, 1.0f), solid_color, Vec2f(0.0f, 1.0f)));
-		vertices.push_back(Vertex(Vec4f(1.0f, -1.0f, 0.0f, 1.0f), solid_color, Vec2f(1.0f, 1.0f)));
-		vertices.push_back(Vertex(Vec4f(-1.0f, 1.0f, 0.0f, 1.0f), solid_color, Vec2f(0.0f, 0.0f)));
-		vertices.push_back(Vertex(Vec4f(1.0f, -1.0f, 0.0f, 1.0f), solid_color, Vec2f(1.0f, 1.0f)));
-		vertices.push_back(Vertex(Vec4f(1.0f, 1.0f, 0.0f, 1.0f), solid_color, Vec2f(1.0f, 0.0f)));
-		vertices.push_back(Vertex(Vec4f(-1.0f, 1.0f, 0.0f, 1.0f), solid_color, Vec2f(0.0f, 0.0f)));
+		// Only the atlas rows used since the last flush are uploaded
+		int used_rows = (next_mask_slot + mask_slots_per_row - 1) / mask_slots_per_row;
+		if (next_mask_slot > 1)
+			mask_texture.set_subimage(gc, 0, 0, mask_buffer, Rect(0, 0, mask_texture_size, used_rows * tile_size));
 
 		int gpu_index;
 		VertexArrayVector<Vertex> gpu_vertices(batch_buffer->get_vertex_buffer(gc, gpu_index));
@@ -186,58 +189,17 @@ namespace clan
 			prim_array[gpu_index].set_attributes(2, gpu_vertices, cl_offsetof(Vertex, texcoord));
 		}
 
-		gpu_vertices.upload_data(gc, 0, vertices);
+		gpu_vertices.upload_data(gc, 0, vertices, position);
 
 		gc.set_blend_state(blend_state);
 		gc.set_program_object(program_path);
-		gc.set_texture(0, texture);
-		gc.draw_primitives(type_triangles, 6, prim_array[gpu_index]);
+		gc.set_texture(0, mask_texture);
+		gc.draw_primitives(type_triangles, position, prim_array[gpu_index]);
 		gc.reset_texture(0);
 		gc.reset_program_object();
 		gc.reset_blend_state();
-	}
-
-	/////////////////////////////////////////////////////////////////////////////
-
-	PathRasterRange::PathRasterRange(const PathScanline &scanline, PathFillMode mode) : scanline(scanline), mode(mode)
-	{
-	}
 
-	void PathRasterRange::next()
-	{
-		if (i + 1 >= scanline.edges.size())
-		{
-			found = false;
-			return;
-		}
-
-		if (mode == PathFillMode::alternate)
-		{
-			x0 = scanline.edges[i].x;
-			x1 = scanline.edges[i + 1].x;
-
-			i += 2;
-			found = true;
-		}
-		else
-		{
-			x0 = scanline.edges[i].x;
-			nonzero_rule += scanline.edges[i].up_direction ? 1 : -1;
-			i++;
-
-			while (i < scanline.edges.size())
-			{
-				nonzero_rule += scanline.edges[i].up_direction ? 1 : -1;
-				x1 = scanline.edges[i].x;
-				i++;
-
-				if (nonzero_rule == 0)
-				{
-					found = true;
-					return;
-				}
-			}
-			found = false;
-		}
+		position = 0;
+		next_mask_slot = 1;
 	}
 }
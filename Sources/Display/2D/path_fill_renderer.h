@@ -40,42 +40,23 @@
 #include "API/Display/Image/pixel_buffer.h"
 #include "API/Display/Render/program_object.h"
 #include "render_batch_buffer.h"
-#include "path_renderer.h"
+#include "path_rasterizer.h"
 
 namespace clan
 {
-	enum class PathFillMode;
 	class Brush;
 
-	class PathScanlineEdge
+	/// \brief Draws path fills as quads over the tiles they cover
+	///
+	/// Coverage of partially covered tiles is packed into a persistent mask atlas that is uploaded once per flush.
+	/// Fully covered tiles share a single solid atlas slot.
+	class PathFillRenderer : public PathRasterizer
 	{
 	public:
-		PathScanlineEdge() { }
-		PathScanlineEdge(float x, bool up_direction) : x(x), up_direction(up_direction) { }
+		PathFillRenderer(GraphicContext &gc, RenderBatchBuffer *batch_buffer);
 
-		float x = 0.0f;
-		bool up_direction = false;
-	};
-
-	class PathScanline
-	{
-	public:
-		std::vector<PathScanlineEdge> edges;
-		std::vector<unsigned char> pixels;
-	};
-
-	class PathFillRenderer : public PathRenderer
-	{
-	public:
-		PathFillRenderer(GraphicContext &gc);
-
-		void set_size(int width, int height);
-		void clear();
-
-		void line(float x, float y) override;
-		void end(bool close) override;
-
-		void fill(RenderBatchBuffer *batch_buffer, Canvas &canvas, PathFillMode mode, const Brush &brush);
+		void fill(Canvas &canvas, PathFillMode mode, const Brush &brush);
+		void flush(GraphicContext &gc);
 
 	private:
 		struct Vertex
@@ -88,29 +69,23 @@ namespace clan
 			Vec2f texcoord;
 		};
 
-		int width = 0;
-		int height = 0;
-		std::vector<PathScanline> scanlines;
-		PixelBuffer mask;
-		PrimitivesArray prim_array[RenderBatchBuffer::num_vertex_buffers];
-		BlendState blend_state;
-	};
+		static const int mask_texture_size = 1024;
+		static const int mask_slots_per_row = mask_texture_size / tile_size;
+		static const int max_mask_slots = mask_slots_per_row * mask_slots_per_row;
+		static const int max_vertices = RenderBatchBuffer::vertex_buffer_size / sizeof(Vertex);
 
-	class PathRasterRange
-	{
-	public:
-		PathRasterRange(const PathScanline &scanline, PathFillMode mode);
+		int allocate_mask_slot(const Canvas &canvas, int tile_x, int tile_y);
+		void add_quad(Canvas &canvas, int x0, int y0, int x1, int y1, int slot, const Vec4f &color);
 
-		void next();
+		RenderBatchBuffer *batch_buffer;
+		Vertex *vertices;
+		int position = 0;
 
-		bool found = false;
-		float x0 = 0.0f;
-		float x1 = 0.0f;
+		PixelBuffer mask_buffer;
+		Texture2D mask_texture;
+		int next_mask_slot = 1;
 
-	private:
-		const PathScanline &scanline;
-		PathFillMode mode;
-		size_t i = 0;
-		int nonzero_rule = 0;
+		PrimitivesArray prim_array[RenderBatchBuffer::num_vertex_buffers];
+		BlendState blend_state;
 	};
 }
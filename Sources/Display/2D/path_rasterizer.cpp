@@ -0,0 +1,389 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    Mark Page
+*/
+
+#include "Display/precomp.h"
+#include "path_rasterizer.h"
+#include "API/Core/System/system.h"
+#include <algorithm>
+#include <cmath>
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	PathRasterizer::PathRasterizer()
+	{
+#ifndef CL_DISABLE_SSE2
+		use_sse2 = System::detect_cpu_extension(System::sse2);
+#endif
+	}
+
+	void PathRasterizer::set_size(int new_width, int new_height)
+	{
+		width = new_width;
+		height = new_height;
+	}
+
+	void PathRasterizer::clear()
+	{
+		segments.clear();
+	}
+
+	void PathRasterizer::end(bool /*close*/)
+	{
+		// Fills always enclose an area, so open subpaths are closed as well
+		line(start_x, start_y);
+	}
+
+	void PathRasterizer::line(float x1, float y1)
+	{
+		float x0 = last_x;
+		float y0 = last_y;
+
+		last_x = x1;
+		last_y = y1;
+
+		// Horizontal edges do not cover any area
+		if (y0 == y1)
+			return;
+
+		if (segments.empty())
+		{
+			min_x = min(x0, x1);
+			max_x = max(x0, x1);
+			min_y = min(y0, y1);
+			max_y = max(y0, y1);
+		}
+		else
+		{
+			min_x = min(min_x, min(x0, x1));
+			max_x = max(max_x, max(x0, x1));
+			min_y = min(min_y, min(y0, y1));
+			max_y = max(max_y, max(y0, y1));
+		}
+
+		segments.push_back(PathSegment(x0, y0, x1, y1));
+	}
+
+	void PathRasterizer::rasterize(PathFillMode mode)
+	{
+		tile_columns = 0;
+		tile_rows = 0;
+		if (segments.empty())
+			return;
+
+		// Edges to the left of the canvas still decide the coverage of the pixels to their right
+		int pixel_left = clamp(static_cast<int>(std::floor(min_x)), 0, width);
+		int pixel_right = clamp(static_cast<int>(std::ceil(max_x)), 0, width);
+		int pixel_top = clamp(static_cast<int>(std::floor(min_y)), 0, height);
+		int pixel_bottom = clamp(static_cast<int>(std::ceil(max_y)), 0, height);
+		if (pixel_top >= pixel_bottom || pixel_right <= 0 || pixel_left >= width)
+			return;
+		pixel_right = max(pixel_right, pixel_left + 1);
+
+		tile_left = pixel_left / tile_size;
+		tile_top = pixel_top / tile_size;
+		tile_columns = (pixel_right - 1) / tile_size + 1 - tile_left;
+		tile_rows = (pixel_bottom - 1) / tile_size + 1 - tile_top;
+
+		clip_left = static_cast<float>(tile_left * tile_size);
+		clip_top = static_cast<float>(tile_top * tile_size);
+		clip_right = clip_left + tile_columns * tile_size;
+		clip_bottom = clip_top + tile_rows * tile_size;
+
+		// Edges may end on the right clip border, so each row has room for two extra areas
+		int rows = tile_rows * tile_size;
+		coverage_pitch = tile_columns * tile_size;
+		areas_pitch = coverage_pitch + 4;
+		areas.assign(areas_pitch * rows, 0.0f);
+		coverage.resize(coverage_pitch * rows);
+		row_start.assign(rows, coverage_pitch);
+		row_end.assign(rows, 0);
+
+		for (const auto &segment : segments)
+			accumulate_clipped(segment.x0, segment.y0, segment.x1, segment.y1);
+
+		// The sum is zero before the first area of a row and constant after the last, so only
+		// the part in between needs a prefix sum
+		for (int y = 0; y < rows; y++)
+		{
+			const float *area_line = areas.data() + y * areas_pitch;
+			unsigned char *line = coverage.data() + y * coverage_pitch;
+
+			int start = row_start[y] & ~3;
+			int end = min((row_end[y] + 3) & ~3, coverage_pitch);
+			if (start >= end)
+			{
+				memset(line, 0, coverage_pitch);
+				continue;
+			}
+
+			unsigned char last;
+#ifndef CL_DISABLE_SSE2
+			if (use_sse2)
+				last = fill_coverage_line_sse2(area_line, line, start, end, mode);
+			else
+				last = fill_coverage_line(area_line, line, start, end, mode);
+#else
+			last = fill_coverage_line(area_line, line, start, end, mode);
+#endif
+			memset(line, 0, start);
+			memset(line + end, last, coverage_pitch - end);
+		}
+
+		classify_tiles();
+	}
+
+	void PathRasterizer::accumulate_clipped(float x0, float y0, float x1, float y1)
+	{
+		if (max(y0, y1) <= clip_top || min(y0, y1) >= clip_bottom)
+			return;
+
+		// Split the edge where it crosses the left and right clip borders. The parts outside
+		// are moved onto the border, where they still add the same winding to the pixels inside.
+		float t[4] = { 0.0f, 1.0f, 1.0f, 1.0f };
+		int count = 1;
+		float dx = x1 - x0;
+		if (dx != 0.0f)
+		{
+			float t_left = (clip_left - x0) / dx;
+			float t_right = (clip_right - x0) / dx;
+			if (t_left > 0.0f && t_left < 1.0f)
+				t[count++] = t_left;
+			if (t_right > 0.0f && t_right < 1.0f)
+				t[count++] = t_right;
+			if (count == 3 && t[1] > t[2])
+				std::swap(t[1], t[2]);
+		}
+		t[count] = 1.0f;
+
+		float dy = y1 - y0;
+		float start_x = x0;
+		float start_y = y0;
+		for (int i = 1; i <= count; i++)
+		{
+			float end_x = (i == count) ? x1 : x0 + dx * t[i];
+			float end_y = (i == count) ? y1 : y0 + dy * t[i];
+			accumulate(
+				clamp(start_x, clip_left, clip_right) - clip_left,
+				start_y - clip_top,
+				clamp(end_x, clip_left, clip_right) - clip_left,
+				end_y - clip_top);
+			start_x = end_x;
+			start_y = end_y;
+		}
+	}
+
+	void PathRasterizer::accumulate(float x0, float y0, float x1, float y1)
+	{
+		if (y0 == y1)
+			return;
+
+		float direction = 1.0f;
+		if (y0 > y1)
+		{
+			direction = -1.0f;
+			std::swap(x0, x1);
+			std::swap(y0, y1);
+		}
+
+		float dxdy = (x1 - x0) / (y1 - y0);
+		float x = x0;
+		if (y0 < 0.0f)
+		{
+			x -= y0 * dxdy;
+			y0 = 0.0f;
+		}
+
+		// Keeps rounding errors from stepping outside the clip rectangle
+		float clip_width = static_cast<float>(coverage_pitch);
+
+		int rows = tile_rows * tile_size;
+		int start_y = static_cast<int>(y0);
+		int end_y = min(static_cast<int>(std::ceil(y1)), rows);
+		for (int y = start_y; y < end_y; y++)
+		{
+			float *line = areas.data() + y * areas_pitch;
+
+			// Height of the part of the edge within this row, and where it enters and leaves it
+			float dy = min(static_cast<float>(y + 1), y1) - max(static_cast<float>(y), y0);
+			float x_next = clamp(x + dxdy * dy, 0.0f, clip_width);
+			float d = dy * direction;
+
+			// x is never negative here, so truncation rounds down
+			float left = min(x, x_next);
+			float right = max(x, x_next);
+			int left_index = static_cast<int>(left);
+			float left_floor = static_cast<float>(left_index);
+			int right_index = static_cast<int>(right);
+			if (static_cast<float>(right_index) < right)
+				right_index++;
+
+			row_start[y] = min(row_start[y], left_index);
+
+			if (right_index <= left_index + 1)
+			{
+				row_end[y] = max(row_end[y], left_index + 2);
+				// The edge stays within one pixel column
+				float middle = 0.5f * (x + x_next) - left_floor;
+				line[left_index] += d - d * middle;
+				line[left_index + 1] += d * middle;
+			}
+			else
+			{
+				// The edge crosses several columns. Each one gets the trapezoid area to the right of the edge
+				float rcp_width = 1.0f / (right - left);
+				float left_fraction = left - left_floor;
+				float area_first = 0.5f * rcp_width * (1.0f - left_fraction) * (1.0f - left_fraction);
+				float right_fraction = right - right_index + 1.0f;
+				float area_last = 0.5f * rcp_width * right_fraction * right_fraction;
+
+				line[left_index] += d * area_first;
+				if (right_index == left_index + 2)
+				{
+					line[left_index + 1] += d * (1.0f - area_first - area_last);
+				}
+				else
+				{
+					float area_second = rcp_width * (1.5f - left_fraction);
+					line[left_index + 1] += d * (area_second - area_first);
+					for (int i = left_index + 2; i < right_index - 1; i++)
+						line[i] += d * rcp_width;
+					float area_before_last = area_second + (right_index - left_index - 3) * rcp_width;
+					line[right_index - 1] += d * (1.0f - area_before_last - area_last);
+				}
+				line[right_index] += d * area_last;
+				row_end[y] = max(row_end[y], right_index + 1);
+			}
+
+			x = x_next;
+		}
+	}
+
+	unsigned char PathRasterizer::fill_coverage_line(const float *areas, unsigned char *line, int start, int end, PathFillMode mode)
+	{
+		float sum = 0.0f;
+		if (mode == PathFillMode::alternate)
+		{
+			for (int x = start; x < end; x++)
+			{
+				sum += areas[x];
+				float value = std::abs(sum);
+				value -= 2.0f * static_cast<int>(value * 0.5f);
+				value = min(value, 2.0f - value);
+				line[x] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+			}
+		}
+		else
+		{
+			for (int x = start; x < end; x++)
+			{
+				sum += areas[x];
+				float value = min(std::abs(sum), 1.0f);
+				line[x] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+			}
+		}
+		return line[end - 1];
+	}
+
+	unsigned char PathRasterizer::fill_coverage_line_sse2(const float *areas, unsigned char *line, int start, int end, PathFillMode mode)
+	{
+#ifndef CL_DISABLE_SSE2
+		const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		bool alternate = mode == PathFillMode::alternate;
+
+		__m128 offset = _mm_setzero_ps();
+		for (int x = start; x < end; x += 4)
+		{
+			// Prefix sum of four areas, continuing from the last sum of the previous four
+			__m128 sum = _mm_loadu_ps(areas + x);
+			sum = _mm_add_ps(sum, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(sum), 4)));
+			sum = _mm_add_ps(sum, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(sum), 8)));
+			sum = _mm_add_ps(sum, offset);
+			offset = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(3, 3, 3, 3));
+
+			__m128 value = _mm_and_ps(sum, sign_mask);
+			if (alternate)
+			{
+				__m128 pairs = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(value, half)));
+				value = _mm_sub_ps(value, _mm_mul_ps(pairs, two));
+				value = _mm_min_ps(value, _mm_sub_ps(two, value));
+			}
+			else
+			{
+				value = _mm_min_ps(value, one);
+			}
+
+			__m128i values = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+			values = _mm_packs_epi32(values, values);
+			values = _mm_packus_epi16(values, values);
+			*reinterpret_cast<int *>(line + x) = _mm_cvtsi128_si32(values);
+		}
+		return line[end - 1];
+#else
+		return 0;
+#endif
+	}
+
+	void PathRasterizer::classify_tiles()
+	{
+		tiles.resize(tile_columns * tile_rows);
+		for (int tile_y = 0; tile_y < tile_rows; tile_y++)
+		{
+			for (int tile_x = 0; tile_x < tile_columns; tile_x++)
+			{
+				// Any bit set means a covered pixel, any bit cleared a pixel that is not fully covered
+				unsigned char any_bits = 0;
+				unsigned char all_bits = 255;
+				for (int y = 0; y < tile_size; y++)
+				{
+					const unsigned char *line = get_tile_line(tile_x, tile_y, y);
+					for (int x = 0; x < tile_size; x++)
+					{
+						any_bits |= line[x];
+						all_bits &= line[x];
+					}
+				}
+
+				PathTileCoverage &tile = tiles[tile_x + tile_y * tile_columns];
+				if (any_bits == 0)
+					tile = PathTileCoverage::empty;
+				else if (all_bits == 255)
+					tile = PathTileCoverage::full;
+				else
+					tile = PathTileCoverage::partial;
+			}
+		}
+	}
+}
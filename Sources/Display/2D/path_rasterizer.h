@@ -0,0 +1,128 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    Mark Page
+*/
+
+#pragma once
+
+#include <vector>
+#include "API/Display/2D/path.h"
+#include "path_renderer.h"
+
+namespace clan
+{
+	enum class PathFillMode;
+
+	class PathSegment
+	{
+	public:
+		PathSegment() { }
+		PathSegment(float x0, float y0, float x1, float y1) : x0(x0), y0(y0), x1(x1), y1(y1) { }
+
+		float x0 = 0.0f;
+		float y0 = 0.0f;
+		float x1 = 0.0f;
+		float y1 = 0.0f;
+	};
+
+	enum class PathTileCoverage : unsigned char
+	{
+		empty,
+		partial,
+		full
+	};
+
+	/// \brief Rasterizes path outlines into an anti-aliased coverage mask for the tiles the path touches
+	///
+	/// Each edge adds the signed area it covers to an accumulation buffer, and a prefix sum along
+	/// every row turns the areas into exact pixel coverage. Only the tiles within the bounds of the
+	/// edges are cleared and filled. Pixels where overlapping contours have edges of their own are approximated.
+	class PathRasterizer : public PathRenderer
+	{
+	public:
+		PathRasterizer();
+
+		static const int tile_size = 16;
+
+		void set_size(int width, int height);
+		void clear();
+
+		void line(float x, float y) override;
+
+		/// \brief Ends a subpath. It is always closed, as fills enclose an area whether the subpath was closed or not.
+		void end(bool close) override;
+
+		/// \brief Calculates the coverage of the tiles within the bounds of the path
+		void rasterize(PathFillMode mode);
+
+		PathTileCoverage get_tile_coverage(int tile_x, int tile_y) const { return tiles[tile_x + tile_y * tile_columns]; }
+
+		/// \brief Returns tile_size coverage values for row y of a tile
+		const unsigned char *get_tile_line(int tile_x, int tile_y, int y) const { return coverage.data() + (tile_y * tile_size + y) * coverage_pitch + tile_x * tile_size; }
+
+		/// \brief Selects the SSE2 coverage pass, which is used by default when the CPU supports it
+		void set_sse2_enabled(bool enable) { use_sse2 = enable; }
+
+		// Tile bounds of the last rasterized path. Tile (0,0) has its top left corner at pixel (tile_left * tile_size, tile_top * tile_size)
+		int tile_left = 0;
+		int tile_top = 0;
+		int tile_columns = 0;
+		int tile_rows = 0;
+
+	protected:
+		int width = 0;
+		int height = 0;
+
+	private:
+		void accumulate_clipped(float x0, float y0, float x1, float y1);
+		void accumulate(float x0, float y0, float x1, float y1);
+		unsigned char fill_coverage_line(const float *areas, unsigned char *line, int start, int end, PathFillMode mode);
+		unsigned char fill_coverage_line_sse2(const float *areas, unsigned char *line, int start, int end, PathFillMode mode);
+		void classify_tiles();
+
+		std::vector<PathSegment> segments;
+		float min_x = 0.0f;
+		float max_x = 0.0f;
+		float min_y = 0.0f;
+		float max_y = 0.0f;
+
+		// Clip rectangle in pixels, relative to which areas are stored
+		float clip_left = 0.0f;
+		float clip_top = 0.0f;
+		float clip_right = 0.0f;
+		float clip_bottom = 0.0f;
+
+		std::vector<float> areas;
+		int areas_pitch = 0;
+		std::vector<int> row_start;
+		std::vector<int> row_end;
+		std::vector<unsigned char> coverage;
+		int coverage_pitch = 0;
+		std::vector<PathTileCoverage> tiles;
+		bool use_sse2 = false;
+	};
+}
@@ -0,0 +1,198 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/Math/mat4.h"
+#include "API/Core/Math/rect.h"
+#include "API/Display/2D/color.h"
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+
+/// \brief Generates the triangle vertices for textured quads
+///
+/// Every quad becomes two triangles with the corners in the order top-left, top-right,
+/// bottom-left, top-right, bottom-right, bottom-left. Each corner is transformed once,
+/// four columns at a time when SSE2 is available.
+class RenderBatchQuadWriter
+{
+public:
+	struct Vertex
+	{
+		Vec4f position;
+		Vec2f texcoord;
+		Vec4f color;
+		int texindex;
+	};
+
+	RenderBatchQuadWriter(const Mat4f &transform)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			column_x[i] = transform.matrix[0 * 4 + i];
+			column_y[i] = transform.matrix[1 * 4 + i];
+			column_w[i] = transform.matrix[3 * 4 + i];
+		}
+	}
+
+	/// \brief Writes 6 vertices for corners given in the order top-left, top-right, bottom-left, bottom-right
+	void write_quad(Vertex *v, const Pointf dest[4], const Pointf texcoords[4], const Vec4f &color, int texindex) const
+	{
+#ifndef CL_DISABLE_SSE2
+		__m128 x = _mm_loadu_ps(column_x);
+		__m128 y = _mm_loadu_ps(column_y);
+		__m128 w = _mm_loadu_ps(column_w);
+		__m128 corners[4];
+		for (int i = 0; i < 4; i++)
+			corners[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(dest[i].x)), _mm_mul_ps(y, _mm_set1_ps(dest[i].y))), w);
+		__m128 c = _mm_loadu_ps(&color.x);
+		write_vertex(v[0], corners[0], texcoords[0].x, texcoords[0].y, c, texindex);
+		write_vertex(v[1], corners[1], texcoords[1].x, texcoords[1].y, c, texindex);
+		write_vertex(v[2], corners[2], texcoords[2].x, texcoords[2].y, c, texindex);
+		write_vertex(v[3], corners[1], texcoords[1].x, texcoords[1].y, c, texindex);
+		write_vertex(v[4], corners[3], texcoords[3].x, texcoords[3].y, c, texindex);
+		write_vertex(v[5], corners[2], texcoords[2].x, texcoords[2].y, c, texindex);
+#else
+		Vec4f corners[4];
+		for (int i = 0; i < 4; i++)
+			corners[i] = transform_point(dest[i].x, dest[i].y);
+		write_vertex(v[0], corners[0], texcoords[0], color, texindex);
+		write_vertex(v[1], corners[1], texcoords[1], color, texindex);
+		write_vertex(v[2], corners[2], texcoords[2], color, texindex);
+		write_vertex(v[3], corners[1], texcoords[1], color, texindex);
+		write_vertex(v[4], corners[3], texcoords[3], color, texindex);
+		write_vertex(v[5], corners[2], texcoords[2], color, texindex);
+#endif
+	}
+
+	/// \brief Writes 6 vertices for a rectangle with normalized texture coordinates
+	void write_rect(Vertex *v, const Rectf &dest, const Rectf &texcoords, const Vec4f &color, int texindex) const
+	{
+#ifndef CL_DISABLE_SSE2
+		__m128 x = _mm_loadu_ps(column_x);
+		__m128 y = _mm_loadu_ps(column_y);
+		__m128 w = _mm_loadu_ps(column_w);
+		write_rect(v, x, y, w, dest, texcoords.left, texcoords.top, texcoords.right, texcoords.bottom, _mm_loadu_ps(&color.x), texindex);
+#else
+		Pointf corners[4] = { Pointf(dest.left, dest.top), Pointf(dest.right, dest.top), Pointf(dest.left, dest.bottom), Pointf(dest.right, dest.bottom) };
+		Pointf texcoord_corners[4] = { Pointf(texcoords.left, texcoords.top), Pointf(texcoords.right, texcoords.top), Pointf(texcoords.left, texcoords.bottom), Pointf(texcoords.right, texcoords.bottom) };
+		write_quad(v, corners, texcoord_corners, color, texindex);
+#endif
+	}
+
+	/// \brief Writes 6 vertices per rectangle, with source rectangles in texels
+	///
+	/// If colors is null, every rectangle uses color.
+	void write_rects(Vertex *v, const Rectf *dest, const Rectf *src, const Colorf *colors, const Colorf &color, int count, const Sizef &texture_size, int texindex) const
+	{
+		float scale_x = 1.0f / texture_size.width;
+		float scale_y = 1.0f / texture_size.height;
+#ifndef CL_DISABLE_SSE2
+		__m128 x = _mm_loadu_ps(column_x);
+		__m128 y = _mm_loadu_ps(column_y);
+		__m128 w = _mm_loadu_ps(column_w);
+		__m128 scale = _mm_setr_ps(scale_x, scale_y, scale_x, scale_y);
+		__m128 c = _mm_loadu_ps(&color.x);
+		for (int i = 0; i < count; i++)
+		{
+			if (colors)
+				c = _mm_loadu_ps(&colors[i].x);
+			__m128 texcoords = _mm_mul_ps(_mm_loadu_ps(&src[i].left), scale);
+			float t[4];
+			_mm_storeu_ps(t, texcoords);
+			write_rect(v + i * 6, x, y, w, dest[i], t[0], t[1], t[2], t[3], c, texindex);
+		}
+#else
+		for (int i = 0; i < count; i++)
+		{
+			Rectf texcoords(src[i].left * scale_x, src[i].top * scale_y, src[i].right * scale_x, src[i].bottom * scale_y);
+			write_rect(v + i * 6, dest[i], texcoords, colors ? colors[i] : color, texindex);
+		}
+#endif
+	}
+
+private:
+#ifndef CL_DISABLE_SSE2
+	static void write_rect(Vertex *v, __m128 x, __m128 y, __m128 w, const Rectf &dest, float tex_left, float tex_top, float tex_right, float tex_bottom, __m128 color, int texindex)
+	{
+		// The corners share their x and y terms, so only two of each are computed.
+		// Summed in the same order as the scalar transform to give identical results.
+		__m128 left = _mm_mul_ps(x, _mm_set1_ps(dest.left));
+		__m128 right = _mm_mul_ps(x, _mm_set1_ps(dest.right));
+		__m128 top = _mm_mul_ps(y, _mm_set1_ps(dest.top));
+		__m128 bottom = _mm_mul_ps(y, _mm_set1_ps(dest.bottom));
+		__m128 top_left = _mm_add_ps(_mm_add_ps(left, top), w);
+		__m128 top_right = _mm_add_ps(_mm_add_ps(right, top), w);
+		__m128 bottom_left = _mm_add_ps(_mm_add_ps(left, bottom), w);
+		__m128 bottom_right = _mm_add_ps(_mm_add_ps(right, bottom), w);
+		write_vertex(v[0], top_left, tex_left, tex_top, color, texindex);
+		write_vertex(v[1], top_right, tex_right, tex_top, color, texindex);
+		write_vertex(v[2], bottom_left, tex_left, tex_bottom, color, texindex);
+		write_vertex(v[3], top_right, tex_right, tex_top, color, texindex);
+		write_vertex(v[4], bottom_right, tex_right, tex_bottom, color, texindex);
+		write_vertex(v[5], bottom_left, tex_left, tex_bottom, color, texindex);
+	}
+
+	static void write_vertex(Vertex &v, __m128 position, float tex_x, float tex_y, __m128 color, int texindex)
+	{
+		// Vertex is not 16 byte aligned
+		_mm_storeu_ps(&v.position.x, position);
+		v.texcoord.x = tex_x;
+		v.texcoord.y = tex_y;
+		_mm_storeu_ps(&v.color.x, color);
+		v.texindex = texindex;
+	}
+#else
+	Vec4f transform_point(float x, float y) const
+	{
+		return Vec4f(
+			column_x[0] * x + column_y[0] * y + column_w[0],
+			column_x[1] * x + column_y[1] * y + column_w[1],
+			column_x[2] * x + column_y[2] * y + column_w[2],
+			column_x[3] * x + column_y[3] * y + column_w[3]);
+	}
+
+	static void write_vertex(Vertex &v, const Vec4f &position, const Pointf &texcoord, const Vec4f &color, int texindex)
+	{
+		v.position = position;
+		v.texcoord = texcoord;
+		v.color = color;
+		v.texindex = texindex;
+	}
+#endif
+
+	float column_x[4];
+	float column_y[4];
+	float column_w[4];
+};
+
+}
@@ -42,7 +42,7 @@ namespace clan
 int RenderBatchTriangle::max_textures = 4;
 
 RenderBatchTriangle::RenderBatchTriangle(GraphicContext &gc, RenderBatchBuffer *batch_buffer)
-: position(0), num_current_textures(0), use_glyph_program(false), batch_buffer(batch_buffer)
+: quad_writer(modelview_projection_matrix), position(0), num_current_textures(0), use_glyph_program(false), batch_buffer(batch_buffer)
 {
 	vertices = (SpriteVertex *) batch_buffer->buffer;
 }
@@ -50,13 +50,8 @@ RenderBatchTriangle::RenderBatchTriangle(GraphicContext &gc, RenderBatchBuffer *
 void RenderBatchTriangle::draw_sprite(Canvas &canvas, const Pointf texture_position[4], const Pointf dest_position[4], const Texture2D &texture, const Colorf &color)
 {
 	int texindex = set_batcher_active(canvas, texture);
-
-	to_sprite_vertex(texture_position[0], dest_position[0], vertices[position++], texindex, color);
-	to_sprite_vertex(texture_position[1], dest_position[1], vertices[position++], texindex, color);
-	to_sprite_vertex(texture_position[2], dest_position[2], vertices[position++], texindex, color);
-	to_sprite_vertex(texture_position[1], dest_position[1], vertices[position++], texindex, color);
-	to_sprite_vertex(texture_position[3], dest_position[3], vertices[position++], texindex, color);
-	to_sprite_vertex(texture_position[2], dest_position[2], vertices[position++], texindex, color);
+	quad_writer.write_quad(vertices + position, dest_position, texture_position, color, texindex);
+	position += 6;
 }
 
 void RenderBatchTriangle::fill_triangle(Canvas &canvas, const Vec2f *triangle_positions, const Vec4f *triangle_colors, int num_vertices)
@@ -122,67 +117,48 @@ void RenderBatchTriangle::fill_triangles(Canvas &canvas, const Vec2f *positions,
 	}
 }
 
-inline void RenderBatchTriangle::to_sprite_vertex(const Pointf &texture_position, const Pointf &dest_position, RenderBatchTriangle::SpriteVertex &v, int texindex, const Colorf &color) const
-{
-	v.position = to_position(dest_position.x, dest_position.y);
-	v.color = color;
-	v.texcoord = texture_position;
-	v.texindex = texindex;
-}
-
 void RenderBatchTriangle::draw_image(Canvas &canvas, const Rectf &src, const Rectf &dest, const Colorf &color, const Texture2D &texture)
 {
 	int texindex = set_batcher_active(canvas, texture);
 
-	vertices[position+0].position = to_position(dest.left, dest.top);
-	vertices[position+1].position = to_position(dest.right, dest.top);
-	vertices[position+2].position = to_position(dest.left, dest.bottom);
-	vertices[position+3].position = to_position(dest.right, dest.top);
-	vertices[position+4].position = to_position(dest.right, dest.bottom);
-	vertices[position+5].position = to_position(dest.left, dest.bottom);
 	float src_left = (src.left)/tex_sizes[texindex].width;
 	float src_top = (src.top) / tex_sizes[texindex].height;
 	float src_right = (src.right)/tex_sizes[texindex].width;
 	float src_bottom = (src.bottom) / tex_sizes[texindex].height;
-	vertices[position+0].texcoord = Vec2f(src_left, src_top);
-	vertices[position+1].texcoord = Vec2f(src_right, src_top);
-	vertices[position+2].texcoord = Vec2f(src_left, src_bottom);
-	vertices[position+3].texcoord = Vec2f(src_right, src_top);
-	vertices[position+4].texcoord = Vec2f(src_right, src_bottom);
-	vertices[position+5].texcoord = Vec2f(src_left, src_bottom);
-	for (int i=0; i<6; i++)
+	quad_writer.write_rect(vertices + position, dest, Rectf(src_left, src_top, src_right, src_bottom), color, texindex);
+	position += 6;
+}
+
+void RenderBatchTriangle::draw_images(Canvas &canvas, const Rectf *src, const Rectf *dest, int count, const Colorf &color, const Colorf *colors, const Texture2D &texture)
+{
+	while (count > 0)
 	{
-		vertices[position+i].color = Vec4f(color.r, color.g, color.b, color.a);
-		vertices[position+i].texindex = texindex;
+		// Fill the remaining vertex buffer space in one go
+		int texindex = set_batcher_active(canvas, texture);
+		int batch_count = min(count, (max_vertices - position) / 6);
+
+		quad_writer.write_rects(vertices + position, dest, src, colors, color, batch_count, tex_sizes[texindex], texindex);
+		position += batch_count * 6;
+
+		src += batch_count;
+		dest += batch_count;
+		if (colors)
+			colors += batch_count;
+		count -= batch_count;
 	}
-	position += 6;
 }
 
 void RenderBatchTriangle::draw_image(Canvas &canvas, const Rectf &src, const Quadf &dest, const Colorf &color, const Texture2D &texture)
 {
 	int texindex = set_batcher_active(canvas, texture);
 
-	vertices[position+0].position = to_position(dest.p.x, dest.p.y);
-	vertices[position+1].position = to_position(dest.q.x, dest.q.y);
-	vertices[position+2].position = to_position(dest.s.x, dest.s.y);
-	vertices[position+3].position = to_position(dest.q.x, dest.q.y);
-	vertices[position+4].position = to_position(dest.r.x, dest.r.y);
-	vertices[position+5].position = to_position(dest.s.x, dest.s.y);
 	float src_left = (src.left)/tex_sizes[texindex].width;
 	float src_top = (src.top) / tex_sizes[texindex].height;
 	float src_right = (src.right)/tex_sizes[texindex].width;
 	float src_bottom = (src.bottom) / tex_sizes[texindex].height;
-	vertices[position+0].texcoord = Vec2f(src_left, src_top);
-	vertices[position+1].texcoord = Vec2f(src_right, src_top);
-	vertices[position+2].texcoord = Vec2f(src_left, src_bottom);
-	vertices[position+3].texcoord = Vec2f(src_right, src_top);
-	vertices[position+4].texcoord = Vec2f(src_right, src_bottom);
-	vertices[position+5].texcoord = Vec2f(src_left, src_bottom);
-	for (int i=0; i<6; i++)
-	{
-		vertices[position+i].color = Vec4f(color.r, color.g, color.b, color.a);
-		vertices[position+i].texindex = texindex;
-	}
+	Pointf dest_position[4] = { dest.p, dest.q, dest.s, dest.r };
+	Pointf texture_position[4] = { Pointf(src_left, src_top), Pointf(src_right, src_top), Pointf(src_left, src_bottom), Pointf(src_right, src_bottom) };
+	quad_writer.write_quad(vertices + position, dest_position, texture_position, color, texindex);
 	position += 6;
 }
 
@@ -190,46 +166,18 @@ void RenderBatchTriangle::draw_glyph_subpixel(Canvas &canvas, const Rectf &src,
 {
 	int texindex = set_batcher_active(canvas, texture, true, color);
 
-	vertices[position+0].position = to_position(dest.left, dest.top);
-	vertices[position+1].position = to_position(dest.right, dest.top);
-	vertices[position+2].position = to_position(dest.left, dest.bottom);
-	vertices[position+3].position = to_position(dest.right, dest.top);
-	vertices[position+4].position = to_position(dest.right, dest.bottom);
-	vertices[position+5].position = to_position(dest.left, dest.bottom);
 	float src_left = (src.left)/tex_sizes[texindex].width;
 	float src_top = (src.top) / tex_sizes[texindex].height;
 	float src_right = (src.right)/tex_sizes[texindex].width;
 	float src_bottom = (src.bottom) / tex_sizes[texindex].height;
-	vertices[position+0].texcoord = Vec2f(src_left, src_top);
-	vertices[position+1].texcoord = Vec2f(src_right, src_top);
-	vertices[position+2].texcoord = Vec2f(src_left, src_bottom);
-	vertices[position+3].texcoord = Vec2f(src_right, src_top);
-	vertices[position+4].texcoord = Vec2f(src_right, src_bottom);
-	vertices[position+5].texcoord = Vec2f(src_left, src_bottom);
-	for (int i=0; i<6; i++)
-	{
-		vertices[position+i].color = Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
-		vertices[position+i].texindex = texindex;
-	}
+	quad_writer.write_rect(vertices + position, dest, Rectf(src_left, src_top, src_right, src_bottom), Vec4f(1.0f, 1.0f, 1.0f, 1.0f), texindex);
 	position += 6;
 }
 
 void RenderBatchTriangle::fill(Canvas &canvas, float x1, float y1, float x2, float y2, const Colorf &color)
 {
 	int texindex = set_batcher_active(canvas);
-
-	vertices[position+0].position = to_position(x1, y1);
-	vertices[position+1].position = to_position(x2, y1);
-	vertices[position+2].position = to_position(x1, y2);
-	vertices[position+3].position = to_position(x2, y1);
-	vertices[position+4].position = to_position(x2, y2);
-	vertices[position+5].position = to_position(x1, y2);
-	for (int i=0; i<6; i++)
-	{
-		vertices[position+i].color = Vec4f(color.r, color.g, color.b, color.a);
-		vertices[position+i].texcoord = Vec2f(0.0f, 0.0f);
-		vertices[position+i].texindex = texindex;
-	}
+	quad_writer.write_rect(vertices + position, Rectf(x1, y1, x2, y2), Rectf(0.0f, 0.0f, 0.0f, 0.0f), color, texindex);
 	position += 6;
 }
 
@@ -369,6 +317,7 @@ void RenderBatchTriangle::flush(GraphicContext &gc)
 void RenderBatchTriangle::matrix_changed(const Mat4f &new_modelview, const Mat4f &new_projection)
 {
 	modelview_projection_matrix = new_projection * new_modelview;
+	quad_writer = RenderBatchQuadWriter(modelview_projection_matrix);
 }
 
 }
@@ -35,6 +35,7 @@
 #include "API/Display/Render/render_batcher.h"
 #include "API/Display/Render/texture_2d.h"
 #include "render_batch_buffer.h"
+#include "render_batch_quad_writer.h"
 
 namespace clan
 {
@@ -50,6 +51,7 @@ public:
 	void draw_sprite(Canvas &canvas, const Pointf texture_position[4], const Pointf dest_position[4], const Texture2D &texture, const Colorf &color);
 	void draw_image(Canvas &canvas, const Rectf &src, const Rectf &dest, const Colorf &color, const Texture2D &texture);
 	void draw_image(Canvas &canvas, const Rectf &src, const Quadf &dest, const Colorf &color, const Texture2D &texture);
+	void draw_images(Canvas &canvas, const Rectf *src, const Rectf *dest, int count, const Colorf &color, const Colorf *colors, const Texture2D &texture);
 	void draw_glyph_subpixel(Canvas &canvas, const Rectf &src, const Rectf &dest, const Colorf &color, const Texture2D &texture);
 	void fill_triangle(Canvas &canvas, const Vec2f *triangle_positions, const Vec4f *triangle_colors, int num_vertices);
 	void fill_triangle(Canvas &canvas, const Vec2f *triangle_positions, const Colorf &color, int num_vertices);
@@ -61,13 +63,7 @@ public:
 	static int max_textures;	// For use by the GL1 target, so it can reduce the number of textures
 
 private:
-	struct SpriteVertex
-	{
-		Vec4f position;
-		Vec2f texcoord;
-		Vec4f color;
-		int texindex;
-	};
+	typedef RenderBatchQuadWriter::Vertex SpriteVertex;
 
 	int set_batcher_active(Canvas &canvas, const Texture2D &texture, bool glyph_program = false, const Colorf &constant_color = Colorf::black);
 	int set_batcher_active(Canvas &canvas);
@@ -75,10 +71,10 @@ private:
 	void flush(GraphicContext &gc);
 	void matrix_changed(const Mat4f &modelview, const Mat4f &projection);
 
-	inline void to_sprite_vertex(const Pointf &texture_position, const Pointf &dest_position, RenderBatchTriangle::SpriteVertex &v, int texindex, const Colorf &color) const;
 	inline Vec4f to_position(float x, float y) const;
 
 	Mat4f modelview_projection_matrix;
+	RenderBatchQuadWriter quad_writer;
 	int position;
 	enum { max_vertices = RenderBatchBuffer::vertex_buffer_size / sizeof(SpriteVertex) };
 	SpriteVertex *vertices;
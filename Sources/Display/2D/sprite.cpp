@@ -98,6 +98,11 @@ Resource<Sprite> Sprite::resource(Canvas &canvas, const std::string &id, const R
 }
 
 Sprite Sprite::load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc)
+{
+	return load(canvas, id, doc, [](GraphicContext &gc, const std::string &filename, const FileSystem &fs) { return Texture2D(gc, filename, fs); });
+}
+
+Sprite Sprite::load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(GraphicContext &, const std::string &, const FileSystem &)> &load_texture)
 {
 	Sprite sprite(canvas);
 
@@ -161,7 +166,7 @@ Sprite Sprite::load(Canvas &canvas, const std::string &id, const XMLResourceDocu
 
 					try
 					{
-						Texture2D texture = Texture2D(canvas, PathHelp::combine(resource.get_base_path(), file_name), fs);
+						Texture2D texture = load_texture(canvas, PathHelp::combine(resource.get_base_path(), file_name), fs);
 						sprite.add_frame(texture);
 						found_initial = true;
 					}
@@ -181,7 +186,7 @@ Sprite Sprite::load(Canvas &canvas, const std::string &id, const XMLResourceDocu
 			{
 				std::string image_name = cur_element.get_attribute("file");
 				FileSystem fs = resource.get_file_system();
-				Texture2D texture = Texture2D(canvas, PathHelp::combine(resource.get_base_path(), image_name), fs);
+				Texture2D texture = load_texture(canvas, PathHelp::combine(resource.get_base_path(), image_name), fs);
 
 				DomNode cur_child(cur_element.get_first_child());
 				if(cur_child.is_null()) 
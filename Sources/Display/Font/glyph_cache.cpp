@@ -56,8 +56,12 @@ namespace clan
 // GlyphCache Construction:
 
 GlyphCache::GlyphCache()
+: glyph_hash_used(0)
 {
 	glyph_list.reserve(256);
+	for (unsigned int cnt = 0; cnt < latin_glyph_count; cnt++)
+		latin_glyph_index[cnt] = glyph_not_cached;
+	glyph_hash.resize(256);
 
 	// Note, the user can specify a different texture group size using set_texture_group()
 	texture_group = TextureGroup(Size(256,256));
@@ -73,8 +77,6 @@ GlyphCache::GlyphCache()
 
 GlyphCache::~GlyphCache()
 {
-	for (int cnt = 0; cnt < glyph_list.size(); cnt++)
-		delete glyph_list[cnt];
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -113,25 +115,22 @@ Size GlyphCache::get_text_size(FontEngine *font_engine, GraphicContext &gc, cons
 
 Font_TextureGlyph *GlyphCache::get_glyph(FontEngine *font_engine, GraphicContext &gc, unsigned int glyph)
 {
-	std::vector< Font_TextureGlyph * >::size_type size = glyph_list.size();
-	for (int cnt=0; cnt<size; cnt++)
-	{
-		if (glyph_list[cnt]->glyph == glyph)
-			return &(*glyph_list[cnt]);
-	}
+	int index = find_glyph(glyph);
+	if (index >= 0)
+		return &glyph_list[index];
+	if (index == glyph_missing)
+		return NULL;
 
 	// If glyph does not exist, create one automatically
 
 	insert_glyph(font_engine, gc, glyph);
 
-	// Search for the glyph again
-	size = glyph_list.size();
-	for (int cnt=0; cnt<size; cnt++)
-	{
-		if (glyph_list[cnt]->glyph == glyph)
-			return &(*glyph_list[cnt]);
-	}
+	index = find_glyph(glyph);
+	if (index >= 0)
+		return &glyph_list[index];
 
+	// Remember that the font engine does not have this glyph, so we do not ask again for every draw
+	set_glyph_index(glyph, glyph_missing);
 	return NULL;
 }
 
@@ -235,17 +234,10 @@ int GlyphCache::get_character_index(FontEngine *font_engine, GraphicContext &gc,
 void GlyphCache::insert_glyph(GraphicContext &gc, FontPixelBuffer &pb)
 {
 	// Search for duplicated glyph's, if found silently ignore them
-	std::vector< Font_TextureGlyph * >::size_type size = glyph_list.size();
-	for (int cnt=0; cnt<size; cnt++)
-	{
-		if (glyph_list[cnt]->glyph == pb.glyph)
-			return ;
-	}
+	if (find_glyph(pb.glyph) >= 0)
+		return;
 
-	Font_TextureGlyph *font_glyph = new Font_TextureGlyph();
-	
-	glyph_list.push_back(font_glyph);
-	font_glyph->glyph = pb.glyph;
+	Font_TextureGlyph *font_glyph = add_glyph(pb.glyph);
 	font_glyph->offset = pb.offset;
 	font_glyph->metrics = pb.metrics;
 
@@ -271,17 +263,10 @@ void GlyphCache::insert_glyph(FontEngine *font_engine, GraphicContext &gc, const
 void GlyphCache::insert_glyph(GraphicContext &gc, unsigned int glyph, Subtexture &sub_texture, const Point &offset, const GlyphMetrics &glyph_metrics)
 {
 	// Search for duplicated glyph's, if found silently ignore them
-	std::vector< Font_TextureGlyph * >::size_type size = glyph_list.size();
-	for (int cnt=0; cnt<size; cnt++)
-	{
-		if (glyph_list[cnt]->glyph == glyph)
-			return;
-	}
+	if (find_glyph(glyph) >= 0)
+		return;
 
-	Font_TextureGlyph *font_glyph = new Font_TextureGlyph();
-	
-	glyph_list.push_back(font_glyph);
-	font_glyph->glyph = glyph;
+	Font_TextureGlyph *font_glyph = add_glyph(glyph);
 	font_glyph->offset = offset;
 	font_glyph->metrics = glyph_metrics;
 
@@ -375,4 +360,72 @@ void GlyphCache::set_font_metrics(const FontMetrics &metrics)
 /////////////////////////////////////////////////////////////////////////////
 // GlyphCache Implementation:
 
+int GlyphCache::find_glyph(unsigned int glyph) const
+{
+	if (glyph < latin_glyph_count)
+		return latin_glyph_index[glyph];
+
+	unsigned int mask = glyph_hash.size() - 1;
+	for (unsigned int pos = hash_glyph(glyph, mask); ; pos = (pos + 1) & mask)
+	{
+		const GlyphHashEntry &entry = glyph_hash[pos];
+		if (entry.index == glyph_not_cached || entry.glyph == glyph)
+			return entry.index;
+	}
+}
+
+Font_TextureGlyph *GlyphCache::add_glyph(unsigned int glyph)
+{
+	glyph_list.push_back(Font_TextureGlyph());
+	Font_TextureGlyph *font_glyph = &glyph_list.back();
+	font_glyph->glyph = glyph;
+	set_glyph_index(glyph, glyph_list.size() - 1);
+	return font_glyph;
+}
+
+void GlyphCache::set_glyph_index(unsigned int glyph, int index)
+{
+	if (glyph < latin_glyph_count)
+	{
+		latin_glyph_index[glyph] = index;
+		return;
+	}
+
+	// Keep the load factor below 50%, so probe sequences stay short
+	if ((glyph_hash_used + 1) * 2 > glyph_hash.size())
+		grow_glyph_hash();
+
+	unsigned int mask = glyph_hash.size() - 1;
+	for (unsigned int pos = hash_glyph(glyph, mask); ; pos = (pos + 1) & mask)
+	{
+		GlyphHashEntry &entry = glyph_hash[pos];
+		if (entry.index == glyph_not_cached)
+		{
+			entry.glyph = glyph;
+			entry.index = index;
+			glyph_hash_used++;
+			return;
+		}
+		else if (entry.glyph == glyph)
+		{
+			entry.index = index;
+			return;
+		}
+	}
+}
+
+void GlyphCache::grow_glyph_hash()
+{
+	std::vector<GlyphHashEntry> old_hash;
+	old_hash.swap(glyph_hash);
+	glyph_hash.resize(old_hash.size() * 2);
+	glyph_hash_used = 0;
+
+	for (size_t cnt = 0; cnt < old_hash.size(); cnt++)
+	{
+		if (old_hash[cnt].index != glyph_not_cached)
+			set_glyph_index(old_hash[cnt].glyph, old_hash[cnt].index);
+	}
+}
+
 }
@@ -93,6 +93,8 @@ public:
 	FontMetrics get_font_metrics();
 
 	/// \brief Get a glyph. Returns NULL if the glyph was not found
+	///
+	/// The returned pointer is only valid until the next glyph is inserted into the cache
 	Font_TextureGlyph *get_glyph(FontEngine *font_engine, GraphicContext &gc, unsigned int glyph);
 
 	Path get_glyph_path(FontEngine *font_engine, unsigned int glyph);
@@ -129,7 +131,44 @@ private:
 	/// \brief Set the font metrics from the OS font
 	void write_font_metrics(GraphicContext &gc);
 
-	std::vector<Font_TextureGlyph* > glyph_list;
+	/// \brief Returns the glyph_list index of a glyph, glyph_not_cached or glyph_missing
+	int find_glyph(unsigned int glyph) const;
+
+	/// \brief Adds a new glyph to the cache and returns it
+	Font_TextureGlyph *add_glyph(unsigned int glyph);
+
+	/// \brief Sets the glyph_list index (or glyph_missing) for a glyph in the index
+	void set_glyph_index(unsigned int glyph, int index);
+
+	void grow_glyph_hash();
+
+	static unsigned int hash_glyph(unsigned int glyph, unsigned int mask)
+	{
+		glyph = (glyph ^ (glyph >> 16)) * 0x45d9f3b;
+		return (glyph ^ (glyph >> 16)) & mask;
+	}
+
+	static const int glyph_not_cached = -1;
+	static const int glyph_missing = -2;	// The font engine has no such glyph
+	static const unsigned int latin_glyph_count = 256;
+
+	/// \brief Glyphs stored in the order they were inserted
+	std::vector<Font_TextureGlyph> glyph_list;
+
+	/// \brief Direct mapped glyph_list index for glyphs below latin_glyph_count
+	int latin_glyph_index[latin_glyph_count];
+
+	class GlyphHashEntry
+	{
+	public:
+		GlyphHashEntry() : glyph(0), index(glyph_not_cached) { }
+		unsigned int glyph;
+		int index;
+	};
+
+	/// \brief Open addressed (linear probing) glyph_list index for all other glyphs
+	std::vector<GlyphHashEntry> glyph_hash;
+	unsigned int glyph_hash_used;
 
 	TextureGroup texture_group;
 
@@ -173,6 +173,12 @@ Resource<Texture> Texture::resource(GraphicContext &gc, const std::string &id, c
 }
 
 Texture Texture::load(GraphicContext &gc, const std::string &id, const XMLResourceDocument &doc)
+{
+	ImageImportDescription import_desc; // The infamous ImageImportDescription strikes again!
+	return load(gc, id, doc, [&](GraphicContext &gc, const std::string &filename, const FileSystem &fs) { return Texture2D(gc, filename, fs, import_desc); });
+}
+
+Texture Texture::load(GraphicContext &gc, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(GraphicContext &, const std::string &, const FileSystem &)> &load_texture)
 {
 	XMLResourceNode resource = doc.get_resource(id);
 
@@ -181,12 +187,10 @@ Texture Texture::load(GraphicContext &gc, const std::string &id, const XMLResour
 	if (type != "texture")
 		throw Exception(string_format("Resource '%1' is not of type 'texture'", id));
 
-	ImageImportDescription import_desc; // The infamous ImageImportDescription strikes again!
-
 	std::string filename = resource.get_element().get_attribute("file");
 	FileSystem fs = resource.get_file_system();
 
-	Texture2D texture(gc, PathHelp::combine(resource.get_base_path(), filename), fs, import_desc);
+	Texture2D texture = load_texture(gc, PathHelp::combine(resource.get_base_path(), filename), fs);
 
 	return Resource<Texture>(texture);
 }
@@ -29,6 +29,7 @@
 #include "Display/precomp.h"
 #include "API/Display/Resources/display_cache.h"
 #include "API/Core/Resources/resource_manager.h"
+#include "display_cache_preload_impl.h"
 
 namespace clan
 {
@@ -43,4 +44,61 @@ void DisplayCache::set(ResourceManager &resources, const std::shared_ptr<Display
 	resources.set_cache("clan.display", cache);
 }
 
+DisplayCachePreload DisplayCache::preload(Canvas &canvas, const std::vector<std::string> &ids)
+{
+	return DisplayCachePreload(std::make_shared<DisplayCachePreload_Impl>(0));
+}
+
+DisplayCachePreload DisplayCache::preload_section(Canvas &canvas, const std::string &section)
+{
+	return DisplayCachePreload(std::make_shared<DisplayCachePreload_Impl>(0));
+}
+
+DisplayCacheStatistics DisplayCache::get_statistics() const
+{
+	return DisplayCacheStatistics();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DisplayCachePreload construction:
+
+DisplayCachePreload::DisplayCachePreload()
+{
+}
+
+DisplayCachePreload::DisplayCachePreload(const std::shared_ptr<DisplayCachePreload_Impl> &impl)
+: impl(impl)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DisplayCachePreload attributes:
+
+bool DisplayCachePreload::is_done() const
+{
+	return !impl || impl->loaded_count == impl->resource_count;
+}
+
+int DisplayCachePreload::get_resource_count() const
+{
+	return impl ? impl->resource_count : 0;
+}
+
+int DisplayCachePreload::get_loaded_count() const
+{
+	return impl ? impl->loaded_count : 0;
+}
+
+float DisplayCachePreload::get_progress() const
+{
+	if (!impl || impl->resource_count == 0)
+		return 1.0f;
+	return impl->loaded_count / (float)impl->resource_count;
+}
+
+std::vector<std::string> DisplayCachePreload::get_errors() const
+{
+	return impl ? impl->errors : std::vector<std::string>();
+}
+
 }
@@ -0,0 +1,61 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace clan
+{
+
+class DisplayCachePreload_Impl
+{
+public:
+	DisplayCachePreload_Impl(int resource_count) : resource_count(resource_count), loaded_count(0) { }
+
+	void resource_loaded()
+	{
+		loaded_count++;
+	}
+
+	void resource_failed(const std::string &message)
+	{
+		errors.push_back(message);
+		loaded_count++;
+	}
+
+	int resource_count;
+
+	/// \brief Number of resources loaded or failed
+	int loaded_count;
+
+	std::vector<std::string> errors;
+};
+
+}
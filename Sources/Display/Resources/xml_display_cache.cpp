@@ -35,18 +35,23 @@
 #include "API/Display/Font/font_description.h"
 #include "API/Display/Font/font_metrics.h"
 #include "API/Display/Render/texture.h"
+#include "API/Display/ImageProviders/provider_factory.h"
+#include "API/Display/Image/image_import_description.h"
+#include "API/Core/System/system.h"
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/XML/dom_element.h"
 #include "API/Core/IOData/path_help.h"
 #include "xml_display_cache.h"
+#include "display_cache_preload_impl.h"
 #include "../Font/font_impl.h"
+#include <algorithm>
 
 namespace clan
 {
 
 XMLDisplayCache::XMLDisplayCache(const XMLResourceDocument &doc)
-	: doc(doc)
+	: doc(doc), upload_budget(4 * 1024 * 1024), decoded_event(false), images_decoded(0), total_decode_time(0), max_decode_time(0)
 {
 }
 
@@ -64,7 +69,9 @@ Resource<Sprite> XMLDisplayCache::get_sprite(Canvas &canvas, const std::string &
 		return sprite;
 	}
 
-	Resource<Sprite> sprite = Sprite::load(canvas, id, doc);
+	ubyte64 start_time = System::get_microseconds();
+	Resource<Sprite> sprite = Sprite::load(canvas, id, doc, bind_member(this, &XMLDisplayCache::load_texture));
+	end_sync_load(start_time);
 	sprites[id] = sprite;
 	sprite.get() = sprite.get().clone();
 	return sprite;
@@ -80,7 +87,9 @@ Resource<Image> XMLDisplayCache::get_image(Canvas &canvas, const std::string &id
 		return image;
 	}
 	
-	Resource<Image> image = Image::load(canvas, id, doc);
+	ubyte64 start_time = System::get_microseconds();
+	Resource<Image> image = Image::load(canvas, id, doc, bind_member(this, &XMLDisplayCache::load_texture));
+	end_sync_load(start_time);
 	images[id] = image;
 	image.get() = image.get().clone();
 	return image;
@@ -108,7 +117,9 @@ Resource<Texture> XMLDisplayCache::get_texture(GraphicContext &gc, const std::st
 	if (it != textures.end())
 		return it->second;
 
-	Resource<Texture> texture = Texture::load(gc, id, doc);
+	ubyte64 start_time = System::get_microseconds();
+	Resource<Texture> texture = Texture::load(gc, id, doc, bind_member(this, &XMLDisplayCache::load_texture));
+	end_sync_load(start_time);
 	textures[id] = texture;
 	return texture;
 }
@@ -150,4 +161,323 @@ Resource<Font> XMLDisplayCache::load_font(Canvas &canvas, const FontDescription
 	}
 }
 
+DisplayCachePreload XMLDisplayCache::preload(Canvas &canvas, const std::vector<std::string> &ids)
+{
+	std::shared_ptr<DisplayCachePreload_Impl> preload = std::make_shared<DisplayCachePreload_Impl>(ids.size());
+	for (size_t i = 0; i < ids.size(); i++)
+	{
+		try
+		{
+			add_preload_resource(canvas, ids[i], preload);
+		}
+		catch (Exception &e)
+		{
+			preload->resource_failed(e.message);
+		}
+	}
+	complete_preload_resources();
+	return DisplayCachePreload(preload);
+}
+
+DisplayCachePreload XMLDisplayCache::preload_section(Canvas &canvas, const std::string &section)
+{
+	std::vector<std::string> ids;
+	std::vector<std::string> names = doc.get_resource_names(section);
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		std::string type = doc.get_resource(names[i]).get_type();
+		if (type == "sprite" || type == "image" || type == "texture" || type == "font")
+			ids.push_back(names[i]);
+	}
+	return preload(canvas, ids);
+}
+
+void XMLDisplayCache::process_preloads()
+{
+	ubyte64 start_time = System::get_microseconds();
+	ubyte64 bytes_uploaded = statistics.bytes_uploaded;
+	int resources_preloaded = statistics.resources_preloaded;
+
+	upload_preload_images(upload_budget);
+	complete_preload_resources();
+
+	if (statistics.bytes_uploaded != bytes_uploaded || statistics.resources_preloaded != resources_preloaded)
+	{
+		ubyte64 upload_time = System::get_microseconds() - start_time;
+		statistics.upload_calls++;
+		statistics.total_upload_time += upload_time;
+		statistics.max_upload_time = max(statistics.max_upload_time, upload_time);
+	}
+}
+
+void XMLDisplayCache::finish_preload(DisplayCachePreload &preload)
+{
+	while (!preload.is_done())
+	{
+		upload_preload_images(0);
+		complete_preload_resources();
+		if (!preload.is_done())
+			decoded_event.wait();
+	}
+}
+
+void XMLDisplayCache::set_preload_upload_budget(int bytes)
+{
+	upload_budget = bytes;
+}
+
+DisplayCacheStatistics XMLDisplayCache::get_statistics() const
+{
+	DisplayCacheStatistics result = statistics;
+	result.images_decoded = images_decoded;
+	result.total_decode_time = total_decode_time;
+	result.max_decode_time = max_decode_time;
+	return result;
+}
+
+void XMLDisplayCache::reset_statistics()
+{
+	statistics = DisplayCacheStatistics();
+	images_decoded = 0;
+	total_decode_time = 0;
+	max_decode_time = 0;
+}
+
+Texture2D XMLDisplayCache::load_texture(GraphicContext &gc, const std::string &filename, const FileSystem &fs)
+{
+	std::map<std::string, std::shared_ptr<XMLDisplayCache_PreloadImage> >::iterator it = preload_images.find(get_texture_key(filename, fs));
+	if (it != preload_images.end() && !it->second->texture.is_null() && it->second->uploaded_lines == it->second->texture.get_height())
+		return it->second->texture;
+
+	return Texture2D(gc, filename, fs);
+}
+
+void XMLDisplayCache::add_preload_resource(Canvas &canvas, const std::string &id, const std::shared_ptr<DisplayCachePreload_Impl> &preload)
+{
+	XMLResourceNode resource = doc.get_resource(id);
+	std::string type = resource.get_type();
+
+	// A sprite font is preloaded by preloading its glyph sprite
+	std::string resource_id = id;
+	if (type == "font")
+	{
+		DomElement sprite_element = resource.get_element().named_item("sprite").to_element();
+		if (sprite_element.is_null() || !sprite_element.has_attribute("glyphs"))
+		{
+			// System fonts have nothing to preload
+			preload->resource_loaded();
+			return;
+		}
+		resource_id = sprite_element.get_attribute("glyphs");
+		resource = doc.get_resource(resource_id);
+		type = resource.get_type();
+	}
+
+	if ((type == "sprite" && sprites.find(resource_id) != sprites.end()) ||
+		(type == "image" && images.find(resource_id) != images.end()) ||
+		(type == "texture" && textures.find(resource_id) != textures.end()))
+	{
+		preload->resource_loaded();
+		return;
+	}
+
+	std::vector<std::string> filenames;
+	if (type == "texture")
+	{
+		filenames.push_back(PathHelp::combine(resource.get_base_path(), resource.get_element().get_attribute("file")));
+	}
+	else if (type == "sprite" || type == "image")
+	{
+		// Image sequences (fileseq) are not preloaded and load when the resource is completed
+		for (DomNode cur_node = resource.get_element().get_first_child(); !cur_node.is_null(); cur_node = cur_node.get_next_sibling())
+		{
+			if (!cur_node.is_element())
+				continue;
+			DomElement cur_element = cur_node.to_element();
+			std::string tag_name = cur_element.get_tag_name();
+			if ((tag_name == "image" || tag_name == "image-file") && cur_element.has_attribute("file"))
+				filenames.push_back(PathHelp::combine(resource.get_base_path(), cur_element.get_attribute("file")));
+		}
+	}
+	else
+	{
+		throw Exception(string_format("Resource '%1' of type '%2' cannot be preloaded", id, type));
+	}
+
+	std::shared_ptr<XMLDisplayCache_PreloadResource> preload_resource = std::make_shared<XMLDisplayCache_PreloadResource>(canvas, resource_id, type, preload);
+	for (size_t i = 0; i < filenames.size(); i++)
+	{
+		std::shared_ptr<XMLDisplayCache_PreloadImage> image = get_preload_image(canvas, filenames[i], resource.get_file_system());
+		if (image->texture.is_null() || image->uploaded_lines < image->texture.get_height())
+		{
+			image->waiting.push_back(preload_resource);
+			preload_resource->pending_images++;
+		}
+	}
+
+	if (preload_resource->pending_images == 0)
+		ready_resources.push_back(preload_resource);
+}
+
+std::shared_ptr<XMLDisplayCache_PreloadImage> XMLDisplayCache::get_preload_image(GraphicContext &gc, const std::string &filename, const FileSystem &fs)
+{
+	std::string key = get_texture_key(filename, fs);
+	std::map<std::string, std::shared_ptr<XMLDisplayCache_PreloadImage> >::iterator it = preload_images.find(key);
+	if (it != preload_images.end())
+		return it->second;
+
+	std::shared_ptr<XMLDisplayCache_PreloadImage> image = std::make_shared<XMLDisplayCache_PreloadImage>(gc, filename, fs);
+	preload_images[key] = image;
+
+	if (!work_queue)
+		work_queue.reset(new WorkQueue());
+	work_queue->queue([=]() { decode_preload_image(image); });
+
+	return image;
+}
+
+void XMLDisplayCache::decode_preload_image(const std::shared_ptr<XMLDisplayCache_PreloadImage> &image)
+{
+	ubyte64 start_time = System::get_microseconds();
+	try
+	{
+		// Decode with the import description Texture2D uses by default
+		PixelBuffer pixels = ImageProviderFactory::load(image->filename, image->fs, std::string());
+		pixels = ImageImportDescription().process(pixels);
+		if (pixels.get_format() != tf_rgba8)
+			pixels = pixels.to_format(tf_rgba8);
+		image->pixels = pixels;
+	}
+	catch (Exception &e)
+	{
+		image->error = e.message;
+	}
+	ubyte64 decode_time = System::get_microseconds() - start_time;
+
+	images_decoded++;
+	total_decode_time += decode_time;
+	update_max(max_decode_time, decode_time);
+
+	MutexSection mutex_lock(&decoded_mutex);
+	decoded_images.push_back(image);
+	mutex_lock.unlock();
+	decoded_event.set();
+}
+
+bool XMLDisplayCache::upload_preload_images(int budget)
+{
+	MutexSection mutex_lock(&decoded_mutex);
+	upload_queue.insert(upload_queue.end(), decoded_images.begin(), decoded_images.end());
+	decoded_images.clear();
+	mutex_lock.unlock();
+
+	int bytes_uploaded = 0;
+	size_t num_uploaded = 0;
+	while (num_uploaded < upload_queue.size())
+	{
+		if (budget > 0 && bytes_uploaded >= budget)
+			break;
+
+		XMLDisplayCache_PreloadImage &image = *upload_queue[num_uploaded];
+		bytes_uploaded += upload_preload_image(image, budget > 0 ? budget - bytes_uploaded : 0);
+
+		bool failed = image.pixels.is_null();
+		if (failed || image.uploaded_lines == image.texture.get_height())
+		{
+			// Failed images complete their resources too. Loading them again reports the error.
+			image.pixels = PixelBuffer();
+			for (size_t i = 0; i < image.waiting.size(); i++)
+			{
+				if (--image.waiting[i]->pending_images == 0)
+					ready_resources.push_back(image.waiting[i]);
+			}
+			image.waiting.clear();
+
+			// Forget failed images, so later preloads of the file decode it again instead of waiting for it
+			if (failed)
+				preload_images.erase(get_texture_key(image.filename, image.fs));
+			num_uploaded++;
+		}
+	}
+	upload_queue.erase(upload_queue.begin(), upload_queue.begin() + num_uploaded);
+
+	statistics.bytes_uploaded += bytes_uploaded;
+	return upload_queue.empty();
+}
+
+int XMLDisplayCache::upload_preload_image(XMLDisplayCache_PreloadImage &image, int max_bytes)
+{
+	if (image.pixels.is_null())
+		return 0;
+
+	if (image.texture.is_null())
+		image.texture = Texture2D(image.gc, image.pixels.get_width(), image.pixels.get_height(), tf_rgba8);
+
+	// Upload at least one line, and as many more as the budget allows
+	int remaining_lines = image.pixels.get_height() - image.uploaded_lines;
+	int lines = remaining_lines;
+	if (max_bytes > 0)
+		lines = clamp(max_bytes / image.pixels.get_pitch(), 1, remaining_lines);
+
+	image.texture.set_subimage(image.gc, Point(0, image.uploaded_lines), image.pixels, Rect(0, image.uploaded_lines, image.pixels.get_width(), image.uploaded_lines + lines), 0);
+	image.uploaded_lines += lines;
+	return lines * image.pixels.get_pitch();
+}
+
+void XMLDisplayCache::complete_preload_resources()
+{
+	std::vector<std::shared_ptr<XMLDisplayCache_PreloadResource> > resources;
+	resources.swap(ready_resources);
+
+	for (size_t i = 0; i < resources.size(); i++)
+	{
+		XMLDisplayCache_PreloadResource &resource = *resources[i];
+		try
+		{
+			if (resource.type == "sprite")
+			{
+				if (sprites.find(resource.id) == sprites.end())
+					sprites[resource.id] = Sprite::load(resource.canvas, resource.id, doc, bind_member(this, &XMLDisplayCache::load_texture));
+			}
+			else if (resource.type == "image")
+			{
+				if (images.find(resource.id) == images.end())
+					images[resource.id] = Image::load(resource.canvas, resource.id, doc, bind_member(this, &XMLDisplayCache::load_texture));
+			}
+			else if (resource.type == "texture")
+			{
+				if (textures.find(resource.id) == textures.end())
+					textures[resource.id] = Texture::load(resource.canvas, resource.id, doc, bind_member(this, &XMLDisplayCache::load_texture));
+			}
+			statistics.resources_preloaded++;
+			resource.preload->resource_loaded();
+		}
+		catch (Exception &e)
+		{
+			resource.preload->resource_failed(e.message);
+		}
+	}
+}
+
+void XMLDisplayCache::end_sync_load(ubyte64 start_time)
+{
+	ubyte64 load_time = System::get_microseconds() - start_time;
+	statistics.sync_loads++;
+	statistics.total_sync_load_time += load_time;
+	statistics.max_sync_load_time = max(statistics.max_sync_load_time, load_time);
+}
+
+std::string XMLDisplayCache::get_texture_key(const std::string &filename, const FileSystem &fs)
+{
+	return fs.get_identifier() + "|" + filename;
+}
+
+void XMLDisplayCache::update_max(std::atomic<ubyte64> &max_value, ubyte64 value)
+{
+	ubyte64 current = max_value.load();
+	while (value > current && !max_value.compare_exchange_weak(current, value))
+	{
+	}
+}
+
 }
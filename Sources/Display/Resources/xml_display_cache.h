@@ -29,11 +29,65 @@
 #pragma once
 
 #include "API/Display/Resources/display_cache.h"
+#include "API/Display/Render/graphic_context.h"
+#include "API/Display/Render/texture_2d.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "API/Display/2D/canvas.h"
 #include "API/Core/Resources/xml_resource_document.h"
+#include "API/Core/IOData/file_system.h"
+#include "API/Core/System/event.h"
+#include "API/Core/System/mutex.h"
+#include "API/Core/System/work_queue.h"
+#include <atomic>
+#include <map>
 
 namespace clan
 {
 
+class XMLDisplayCache_PreloadResource;
+
+/// \brief Image file of a preload, decoded on a worker thread and uploaded in strips by process_preloads
+class XMLDisplayCache_PreloadImage
+{
+public:
+	XMLDisplayCache_PreloadImage(GraphicContext &gc, const std::string &filename, const FileSystem &fs)
+	: gc(gc), filename(filename), fs(fs), uploaded_lines(0)
+	{
+	}
+
+	GraphicContext gc;
+	std::string filename;
+	FileSystem fs;
+
+	/// \brief Decoded image in tf_rgba8, released once uploaded
+	PixelBuffer pixels;
+
+	/// \brief Error message if the image could not be decoded
+	std::string error;
+
+	Texture2D texture;
+	int uploaded_lines;
+
+	/// \brief Resources waiting for the image to be uploaded
+	std::vector<std::shared_ptr<XMLDisplayCache_PreloadResource> > waiting;
+};
+
+/// \brief Resource of a preload waiting for its image files
+class XMLDisplayCache_PreloadResource
+{
+public:
+	XMLDisplayCache_PreloadResource(Canvas &canvas, const std::string &id, const std::string &type, const std::shared_ptr<DisplayCachePreload_Impl> &preload)
+	: canvas(canvas), id(id), type(type), preload(preload), pending_images(0)
+	{
+	}
+
+	Canvas canvas;
+	std::string id;
+	std::string type;
+	std::shared_ptr<DisplayCachePreload_Impl> preload;
+	int pending_images;
+};
+
 class XMLDisplayCache : public DisplayCache
 {
 public:
@@ -46,9 +100,36 @@ public:
 	Resource<Font> get_font(Canvas &canvas, const FontDescription &desc);
 	Resource<CollisionOutline> get_collision(const std::string &id);
 
+	DisplayCachePreload preload(Canvas &canvas, const std::vector<std::string> &ids);
+	DisplayCachePreload preload_section(Canvas &canvas, const std::string &section);
+	void process_preloads();
+	void finish_preload(DisplayCachePreload &preload);
+	void set_preload_upload_budget(int bytes);
+	DisplayCacheStatistics get_statistics() const;
+	void reset_statistics();
+
 private:
 	Resource<Font> load_font(Canvas &canvas, const FontDescription &desc);
 
+	/// \brief Creates the texture of an image file, using the preloaded texture if there is one
+	Texture2D load_texture(GraphicContext &gc, const std::string &filename, const FileSystem &fs);
+
+	void add_preload_resource(Canvas &canvas, const std::string &id, const std::shared_ptr<DisplayCachePreload_Impl> &preload);
+	std::shared_ptr<XMLDisplayCache_PreloadImage> get_preload_image(GraphicContext &gc, const std::string &filename, const FileSystem &fs);
+	void decode_preload_image(const std::shared_ptr<XMLDisplayCache_PreloadImage> &image);
+
+	/// \brief Uploads decoded images, returning false if the budget ran out before all of them were uploaded
+	bool upload_preload_images(int budget);
+
+	/// \brief Uploads the next strip of an image, returning the number of bytes uploaded
+	int upload_preload_image(XMLDisplayCache_PreloadImage &image, int max_bytes);
+
+	void complete_preload_resources();
+	void end_sync_load(ubyte64 start_time);
+
+	static std::string get_texture_key(const std::string &filename, const FileSystem &fs);
+	static void update_max(std::atomic<ubyte64> &max_value, ubyte64 value);
+
 	XMLResourceDocument doc;
 
 	std::map<std::string, Resource<Sprite> > sprites;
@@ -56,6 +137,31 @@ private:
 	std::map<std::string, Resource<CollisionOutline> > collisions;
 	std::map<std::string, Resource<Texture> > textures;
 	std::map<std::string, Resource<Font> > fonts;
+
+	/// \brief Image files of preloads, by texture key. Uploaded images stay to be found by load_texture, failed images are removed.
+	std::map<std::string, std::shared_ptr<XMLDisplayCache_PreloadImage> > preload_images;
+
+	/// \brief Decoded images in the order they are uploaded
+	std::vector<std::shared_ptr<XMLDisplayCache_PreloadImage> > upload_queue;
+
+	/// \brief Resources with all their images uploaded
+	std::vector<std::shared_ptr<XMLDisplayCache_PreloadResource> > ready_resources;
+
+	int upload_budget;
+
+	Mutex decoded_mutex;
+	std::vector<std::shared_ptr<XMLDisplayCache_PreloadImage> > decoded_images;
+	Event decoded_event;
+
+	std::atomic<int> images_decoded;
+	std::atomic<ubyte64> total_decode_time;
+	std::atomic<ubyte64> max_decode_time;
+	DisplayCacheStatistics statistics;
+
+	/// \brief Worker threads decoding the preloaded images, created on the first preload.
+	///
+	/// Declared last so the workers are stopped before the members they use are destroyed.
+	std::unique_ptr<WorkQueue> work_queue;
 };
 
 }
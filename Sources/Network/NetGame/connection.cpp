@@ -42,6 +42,12 @@ NetGameConnection::NetGameConnection(NetGameConnectionSite *site, const TCPConne
 	impl->start(this, site, connection);
 }
 
+NetGameConnection::NetGameConnection(NetGameConnectionSite *site, const TCPConnection &connection, NetGameConnectionReactor *reactor)
+: impl(new NetGameConnection_Impl)
+{
+	impl->start(this, site, connection, reactor);
+}
+
 NetGameConnection::NetGameConnection(NetGameConnectionSite *site, const SocketName &socket_name)
 : impl(new NetGameConnection_Impl)
 {
@@ -31,14 +31,17 @@
 #include "API/Network/NetGame/connection.h"
 #include "API/Network/NetGame/connection_site.h"
 #include "API/Core/System/databuffer.h"
+#include "API/Core/System/event_wait_set.h"
 #include "network_event.h"
 #include "network_data.h"
 #include "connection_impl.h"
+#include "connection_reactor.h"
 
 namespace clan
 {
 
 NetGameConnection_Impl::NetGameConnection_Impl()
+: reactor(0)
 {
 }
 
@@ -61,10 +64,29 @@ void NetGameConnection_Impl::start(NetGameConnection *xbase, NetGameConnectionSi
 	thread.start(this, &NetGameConnection_Impl::connection_main);
 }
 
+void NetGameConnection_Impl::start(NetGameConnection *xbase, NetGameConnectionSite *xsite, const TCPConnection &xconnection, NetGameConnectionReactor *xreactor)
+{
+	base = xbase;
+	site = xsite;
+	connection = xconnection;
+	socket_name = connection.get_remote_name();
+	is_connected = true;
+	reactor = xreactor;
+	reactor_connection = std::make_shared<NetGameConnectionReactor_Connection>(base, site, connection);
+	reactor->add_connection(reactor_connection);
+}
+
 NetGameConnection_Impl::~NetGameConnection_Impl()
 {
-	stop_event.set();
-	thread.join();
+	if (reactor)
+	{
+		reactor->remove_connection(reactor_connection);
+	}
+	else
+	{
+		stop_event.set();
+		thread.join();
+	}
 }
 
 void NetGameConnection_Impl::set_data(const std::string &name, void *new_data)
@@ -95,6 +117,12 @@ void *NetGameConnection_Impl::get_data(const std::string &name) const
 
 void NetGameConnection_Impl::send_event(const NetGameEvent &game_event)
 {
+	if (reactor)
+	{
+		reactor->send_event(reactor_connection, game_event);
+		return;
+	}
+
 	MutexSection mutex_lock(&mutex);
 	Message message;
 	message.type = Message::type_message;
@@ -105,6 +133,12 @@ void NetGameConnection_Impl::send_event(const NetGameEvent &game_event)
 
 void NetGameConnection_Impl::disconnect()
 {
+	if (reactor)
+	{
+		reactor->disconnect(reactor_connection);
+		return;
+	}
+
 	MutexSection mutex_lock(&mutex);
 	Message message;
 	message.type = Message::type_disconnect;
@@ -135,13 +169,19 @@ void NetGameConnection_Impl::connection_main()
 		bool send_graceful_close = false;
 
 		connection.set_nodelay(true);
+
+		// The send slot switches between the queue and the socket write event as the send buffer fills and drains
+		EventWaitSet wait_set;
+		wait_set.add(stop_event);
+		wait_set.add(connection.get_read_event());
+		wait_set.add(queue_event);
+		Event write_event = connection.get_write_event();
 		while (true)
 		{
 			bool send_buffer_empty = (bytes_sent == send_buffer.get_size());
 
-			Event read_event = connection.get_read_event();
-			Event send_event = send_buffer_empty ? queue_event : connection.get_write_event();
-			int wakeup_reason = Event::wait(stop_event, read_event, send_event);
+			wait_set.replace(2, send_buffer_empty ? queue_event : write_event);
+			int wakeup_reason = wait_set.wait();
 			if (wakeup_reason <= 0)
 			{
 				break;
@@ -29,9 +29,14 @@
 
 #pragma once
 
+#include <memory>
+
 namespace clan
 {
 
+class NetGameConnectionReactor;
+class NetGameConnectionReactor_Connection;
+
 class NetGameConnection_Impl
 {
 public:
@@ -39,6 +44,7 @@ public:
 	~NetGameConnection_Impl();
 	void start(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection);
 	void start(NetGameConnection *base, NetGameConnectionSite *site, const SocketName &socket_name);
+	void start(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection, NetGameConnectionReactor *reactor);
 	void set_data(const std::string &name, void *data);
 	void *get_data(const std::string &name) const;
 	void send_event(const NetGameEvent &game_event);
@@ -77,6 +83,9 @@ private:
 		void *data;
 	};
 	std::vector<AttachedData> data;
+
+	NetGameConnectionReactor *reactor;
+	std::shared_ptr<NetGameConnectionReactor_Connection> reactor_connection;
 };
 
 }
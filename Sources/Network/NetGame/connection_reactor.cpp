@@ -0,0 +1,589 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    Mark Page
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/NetGame/connection.h"
+#include "API/Network/NetGame/connection_site.h"
+#include "API/Core/System/exception.h"
+#include "network_event.h"
+#include "network_data.h"
+#include "connection_reactor.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+namespace clan
+{
+
+NetGameConnectionReactor_Connection::NetGameConnectionReactor_Connection(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection)
+: base(base), site(site), disconnect_requested(false), send_scheduled(false),
+  connection(connection), handle(-1), thread(0), thread_slot(-1), bytes_received(0),
+  send_packet_index(0), send_packet_offset(0), close_after_send(false), want_write(false), closed(false)
+{
+}
+
+#ifdef __linux__
+
+class NetGameConnectionReactor_Thread
+{
+public:
+	NetGameConnectionReactor_Thread();
+	~NetGameConnectionReactor_Thread();
+
+	void add_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection);
+	void remove_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection);
+	void schedule_send(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection);
+
+private:
+	void thread_main();
+	void wake_up();
+	bool process_requests();
+
+	void register_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection);
+	void unregister_connection(NetGameConnectionReactor_Connection *connection);
+
+	void read_connection(NetGameConnectionReactor_Connection *connection);
+	void write_connection(NetGameConnectionReactor_Connection *connection);
+	void fetch_send_queue(NetGameConnectionReactor_Connection *connection);
+	void set_write_interest(NetGameConnectionReactor_Connection *connection, bool enable);
+	void close_connection(NetGameConnectionReactor_Connection *connection, const std::string &reason);
+	void post_event(NetGameConnectionReactor_Connection *connection, NetGameNetworkEvent::Type type, const NetGameEvent &game_event);
+
+	int epoll_handle;
+	int wakeup_handle;
+	Thread thread;
+
+	Mutex mutex;
+	bool stop_flag;
+	bool wakeup_pending;
+	std::vector<std::shared_ptr<NetGameConnectionReactor_Connection> > add_requests;
+	std::vector<std::shared_ptr<NetGameConnectionReactor_Connection> > remove_requests;
+	std::vector<std::shared_ptr<NetGameConnectionReactor_Connection> > send_requests;
+
+	// Only accessed by the I/O thread
+	std::vector<std::shared_ptr<NetGameConnectionReactor_Connection> > connections;
+
+	static const int max_events_per_wait = 256;
+	static const int max_packets_per_write = 64;
+	static const int max_event_packet_size = 32000 + 2;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// NetGameConnectionReactor Construction:
+
+NetGameConnectionReactor::NetGameConnectionReactor(int num_threads)
+: next_thread(0)
+{
+	if (num_threads < 1)
+		num_threads = 1;
+	for (int i = 0; i < num_threads; i++)
+		threads.push_back(std::unique_ptr<NetGameConnectionReactor_Thread>(new NetGameConnectionReactor_Thread()));
+}
+
+NetGameConnectionReactor::~NetGameConnectionReactor()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NetGameConnectionReactor Attributes:
+
+bool NetGameConnectionReactor::is_supported()
+{
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NetGameConnectionReactor Operations:
+
+void NetGameConnectionReactor::add_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+	// Connections are only added from the server listen thread, so round robin needs no locking
+	NetGameConnectionReactor_Thread *thread = threads[next_thread].get();
+	next_thread = (next_thread + 1) % threads.size();
+
+	connection->thread = thread;
+	thread->add_connection(connection);
+}
+
+void NetGameConnectionReactor::remove_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+	// Detach from the NetGameConnection so no further network events are posted for it
+	MutexSection site_lock(&connection->site_mutex);
+	connection->base = 0;
+	connection->site = 0;
+	site_lock.unlock();
+
+	connection->thread->remove_connection(connection);
+}
+
+void NetGameConnectionReactor::send_event(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection, const NetGameEvent &game_event)
+{
+	MutexSection send_lock(&connection->send_mutex);
+	if (connection->disconnect_requested)
+		return;
+	connection->send_queue.push_back(game_event);
+	bool schedule = !connection->send_scheduled;
+	connection->send_scheduled = true;
+	send_lock.unlock();
+
+	if (schedule)
+		connection->thread->schedule_send(connection);
+}
+
+void NetGameConnectionReactor::disconnect(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+	MutexSection send_lock(&connection->send_mutex);
+	connection->disconnect_requested = true;
+	bool schedule = !connection->send_scheduled;
+	connection->send_scheduled = true;
+	send_lock.unlock();
+
+	if (schedule)
+		connection->thread->schedule_send(connection);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NetGameConnectionReactor_Thread Construction:
+
+NetGameConnectionReactor_Thread::NetGameConnectionReactor_Thread()
+: epoll_handle(-1), wakeup_handle(-1), stop_flag(false), wakeup_pending(false)
+{
+	epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_handle == -1)
+		throw Exception("Unable to create epoll instance");
+
+	wakeup_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakeup_handle == -1)
+	{
+		close(epoll_handle);
+		throw Exception("Unable to create eventfd");
+	}
+
+	epoll_event wakeup_event;
+	memset(&wakeup_event, 0, sizeof(epoll_event));
+	wakeup_event.events = EPOLLIN;
+	wakeup_event.data.ptr = 0;
+	epoll_ctl(epoll_handle, EPOLL_CTL_ADD, wakeup_handle, &wakeup_event);
+
+	thread.start(this, &NetGameConnectionReactor_Thread::thread_main);
+}
+
+NetGameConnectionReactor_Thread::~NetGameConnectionReactor_Thread()
+{
+	MutexSection mutex_lock(&mutex);
+	stop_flag = true;
+	mutex_lock.unlock();
+	wake_up();
+	thread.join();
+
+	close(wakeup_handle);
+	close(epoll_handle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NetGameConnectionReactor_Thread Operations:
+
+void NetGameConnectionReactor_Thread::add_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+	MutexSection mutex_lock(&mutex);
+	add_requests.push_back(connection);
+	mutex_lock.unlock();
+	wake_up();
+}
+
+void NetGameConnectionReactor_Thread::remove_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+	MutexSection mutex_lock(&mutex);
+	remove_requests.push_back(connection);
+	mutex_lock.unlock();
+	wake_up();
+}
+
+void NetGameConnectionReactor_Thread::schedule_send(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+	MutexSection mutex_lock(&mutex);
+	send_requests.push_back(connection);
+	mutex_lock.unlock();
+	wake_up();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NetGameConnectionReactor_Thread Implementation:
+
+void NetGameConnectionReactor_Thread::wake_up()
+{
+	// Many requests arriving before the I/O thread gets to run only cost one eventfd write
+	MutexSection mutex_lock(&mutex);
+	if (wakeup_pending)
+		return;
+	wakeup_pending = true;
+	mutex_lock.unlock();
+
+	uint64_t value = 1;
+	int result = write(wakeup_handle, &value, sizeof(uint64_t));
+	(void)result;
+}
+
+void NetGameConnectionReactor_Thread::thread_main()
+{
+	Thread::set_thread_name("NetGame I/O");
+
+	epoll_event events[max_events_per_wait];
+	while (true)
+	{
+		int count = epoll_wait(epoll_handle, events, max_events_per_wait, -1);
+		if (count < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		bool requests_pending = false;
+		for (int i = 0; i < count; i++)
+		{
+			NetGameConnectionReactor_Connection *connection = static_cast<NetGameConnectionReactor_Connection *>(events[i].data.ptr);
+			if (connection == 0)
+			{
+				uint64_t value = 0;
+				int result = read(wakeup_handle, &value, sizeof(uint64_t));
+				(void)result;
+				requests_pending = true;
+				continue;
+			}
+
+			if (!connection->closed && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+				read_connection(connection);
+			if (!connection->closed && (events[i].events & EPOLLOUT))
+				write_connection(connection);
+		}
+
+		if (requests_pending && !process_requests())
+			break;
+	}
+
+	for (size_t i = 0; i < connections.size(); i++)
+		connections[i]->thread_slot = -1;
+	connections.clear();
+}
+
+bool NetGameConnectionReactor_Thread::process_requests()
+{
+	MutexSection mutex_lock(&mutex);
+	wakeup_pending = false;
+	if (stop_flag)
+		return false;
+	std::vector<std::shared_ptr<NetGameConnectionReactor_Connection> > new_connections, removed_connections, send_connections;
+	new_connections.swap(add_requests);
+	removed_connections.swap(remove_requests);
+	send_connections.swap(send_requests);
+	mutex_lock.unlock();
+
+	for (size_t i = 0; i < new_connections.size(); i++)
+		register_connection(new_connections[i]);
+
+	for (size_t i = 0; i < send_connections.size(); i++)
+	{
+		NetGameConnectionReactor_Connection *connection = send_connections[i].get();
+		if (connection->closed)
+			continue;
+		fetch_send_queue(connection);
+		if (!connection->closed && !connection->want_write)
+			write_connection(connection);
+	}
+
+	for (size_t i = 0; i < removed_connections.size(); i++)
+		unregister_connection(removed_connections[i].get());
+
+	return true;
+}
+
+void NetGameConnectionReactor_Thread::register_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+	connection->thread_slot = connections.size();
+	connections.push_back(connection);
+
+	connection->handle = connection->connection.get_handle();
+
+	// Accepted sockets do not inherit the non-blocking mode of the listen socket
+	fcntl(connection->handle, F_SETFL, fcntl(connection->handle, F_GETFL) | O_NONBLOCK);
+
+	connection->receive_buffer.set_size(max_event_packet_size);
+	connection->connection.set_nodelay(true);
+
+	epoll_event event;
+	memset(&event, 0, sizeof(epoll_event));
+	event.events = EPOLLIN;
+	event.data.ptr = connection.get();
+	if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, connection->handle, &event) == -1)
+	{
+		connection->closed = true;
+		post_event(connection.get(), NetGameNetworkEvent::client_disconnected, NetGameEvent("Unable to add connection to epoll"));
+		return;
+	}
+
+	post_event(connection.get(), NetGameNetworkEvent::client_connected, NetGameEvent(std::string()));
+}
+
+void NetGameConnectionReactor_Thread::unregister_connection(NetGameConnectionReactor_Connection *connection)
+{
+	if (connection->thread_slot < 0)
+		return;
+
+	if (!connection->closed)
+	{
+		connection->closed = true;
+		epoll_ctl(epoll_handle, EPOLL_CTL_DEL, connection->handle, 0);
+	}
+
+	// Swap with the last connection to remove it in constant time
+	int slot = connection->thread_slot;
+	connections[slot] = connections.back();
+	connections[slot]->thread_slot = slot;
+	connections.pop_back();
+	connection->thread_slot = -1;
+}
+
+void NetGameConnectionReactor_Thread::read_connection(NetGameConnectionReactor_Connection *connection)
+{
+	int bytes = recv(connection->handle, connection->receive_buffer.get_data() + connection->bytes_received, connection->receive_buffer.get_size() - connection->bytes_received, 0);
+	if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		return;
+	if (bytes <= 0)
+	{
+		close_connection(connection, std::string());
+		return;
+	}
+
+	connection->bytes_received += bytes;
+
+	int bytes_consumed = 0;
+	try
+	{
+		while (bytes_consumed != connection->bytes_received)
+		{
+			int packet_bytes = 0;
+			NetGameEvent incoming_event = NetGameNetworkData::receive_data(connection->receive_buffer.get_data() + bytes_consumed, connection->bytes_received - bytes_consumed, packet_bytes);
+			bytes_consumed += packet_bytes;
+
+			if (packet_bytes == 0)
+				break;
+
+			if (incoming_event.get_name() == "_close")
+			{
+				close_connection(connection, std::string());
+				return;
+			}
+
+			post_event(connection, NetGameNetworkEvent::event_received, incoming_event);
+		}
+	}
+	catch (const Exception &e)
+	{
+		close_connection(connection, e.message);
+		return;
+	}
+
+	memmove(connection->receive_buffer.get_data(), connection->receive_buffer.get_data() + bytes_consumed, connection->bytes_received - bytes_consumed);
+	connection->bytes_received -= bytes_consumed;
+}
+
+void NetGameConnectionReactor_Thread::fetch_send_queue(NetGameConnectionReactor_Connection *connection)
+{
+	MutexSection send_lock(&connection->send_mutex);
+	std::vector<NetGameEvent> events;
+	events.swap(connection->send_queue);
+	bool disconnect_requested = connection->disconnect_requested;
+	connection->send_scheduled = false;
+	send_lock.unlock();
+
+	if (connection->close_after_send)
+		return;
+
+	try
+	{
+		for (size_t i = 0; i < events.size(); i++)
+			connection->send_packets.push_back(NetGameNetworkData::send_data(events[i]));
+	}
+	catch (const Exception &e)
+	{
+		close_connection(connection, e.message);
+		return;
+	}
+
+	if (disconnect_requested)
+		connection->close_after_send = true;
+}
+
+void NetGameConnectionReactor_Thread::write_connection(NetGameConnectionReactor_Connection *connection)
+{
+	// Send as many queued packets as possible with one system call per max_packets_per_write packets
+	while (connection->send_packet_index < connection->send_packets.size())
+	{
+		iovec vectors[max_packets_per_write];
+		int num_vectors = 0;
+		for (size_t i = connection->send_packet_index; i < connection->send_packets.size() && num_vectors < max_packets_per_write; i++)
+		{
+			int offset = (i == connection->send_packet_index) ? connection->send_packet_offset : 0;
+			vectors[num_vectors].iov_base = connection->send_packets[i].get_data() + offset;
+			vectors[num_vectors].iov_len = connection->send_packets[i].get_size() - offset;
+			num_vectors++;
+		}
+
+		// sendmsg is writev with MSG_NOSIGNAL, so a closed peer does not raise SIGPIPE
+		msghdr message;
+		memset(&message, 0, sizeof(msghdr));
+		message.msg_iov = vectors;
+		message.msg_iovlen = num_vectors;
+		ssize_t bytes = sendmsg(connection->handle, &message, MSG_NOSIGNAL);
+		if (bytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			close_connection(connection, std::string());
+			return;
+		}
+
+		while (bytes > 0)
+		{
+			int remaining = connection->send_packets[connection->send_packet_index].get_size() - connection->send_packet_offset;
+			if (bytes >= remaining)
+			{
+				bytes -= remaining;
+				connection->send_packet_index++;
+				connection->send_packet_offset = 0;
+			}
+			else
+			{
+				connection->send_packet_offset += bytes;
+				bytes = 0;
+			}
+		}
+	}
+
+	bool all_sent = (connection->send_packet_index == connection->send_packets.size());
+	if (all_sent)
+	{
+		connection->send_packets.clear();
+		connection->send_packet_index = 0;
+		connection->send_packet_offset = 0;
+
+		if (connection->close_after_send)
+		{
+			close_connection(connection, std::string());
+			return;
+		}
+	}
+
+	set_write_interest(connection, !all_sent);
+}
+
+void NetGameConnectionReactor_Thread::set_write_interest(NetGameConnectionReactor_Connection *connection, bool enable)
+{
+	if (connection->want_write == enable)
+		return;
+
+	connection->want_write = enable;
+
+	epoll_event event;
+	memset(&event, 0, sizeof(epoll_event));
+	event.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+	event.data.ptr = connection;
+	epoll_ctl(epoll_handle, EPOLL_CTL_MOD, connection->handle, &event);
+}
+
+void NetGameConnectionReactor_Thread::close_connection(NetGameConnectionReactor_Connection *connection, const std::string &reason)
+{
+	if (connection->closed)
+		return;
+
+	connection->closed = true;
+	epoll_ctl(epoll_handle, EPOLL_CTL_DEL, connection->handle, 0);
+	shutdown(connection->handle, SHUT_RDWR);
+	connection->send_packets.clear();
+
+	post_event(connection, NetGameNetworkEvent::client_disconnected, NetGameEvent(reason));
+}
+
+void NetGameConnectionReactor_Thread::post_event(NetGameConnectionReactor_Connection *connection, NetGameNetworkEvent::Type type, const NetGameEvent &game_event)
+{
+	MutexSection site_lock(&connection->site_mutex);
+	if (connection->base)
+		connection->site->add_network_event(NetGameNetworkEvent(connection->base, type, game_event));
+}
+
+#else
+
+class NetGameConnectionReactor_Thread
+{
+};
+
+NetGameConnectionReactor::NetGameConnectionReactor(int num_threads)
+: next_thread(0)
+{
+	throw Exception("NetGameConnectionReactor is not supported on this platform");
+}
+
+NetGameConnectionReactor::~NetGameConnectionReactor()
+{
+}
+
+bool NetGameConnectionReactor::is_supported()
+{
+	return false;
+}
+
+void NetGameConnectionReactor::add_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+}
+
+void NetGameConnectionReactor::remove_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+}
+
+void NetGameConnectionReactor::send_event(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection, const NetGameEvent &game_event)
+{
+}
+
+void NetGameConnectionReactor::disconnect(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection)
+{
+}
+
+#endif
+
+}
@@ -0,0 +1,113 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    Mark Page
+*/
+
+#pragma once
+
+#include "API/Network/NetGame/event.h"
+#include "API/Network/Socket/tcp_connection.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/System/mutex.h"
+#include "API/Core/System/thread.h"
+#include <vector>
+#include <memory>
+
+namespace clan
+{
+
+class NetGameConnection;
+class NetGameConnectionSite;
+class NetGameConnectionReactor_Thread;
+
+/// \brief State of a connection served by a NetGameConnectionReactor
+class NetGameConnectionReactor_Connection
+{
+public:
+	NetGameConnectionReactor_Connection(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection);
+
+	/// \brief Guards base and site. Held while network events are posted to the site
+	Mutex site_mutex;
+	NetGameConnection *base;
+	NetGameConnectionSite *site;
+
+	/// \brief Guards send_queue, disconnect_requested and send_scheduled
+	Mutex send_mutex;
+	std::vector<NetGameEvent> send_queue;
+	bool disconnect_requested;
+
+	/// \brief True while the I/O thread has a pending request to pick up send_queue
+	bool send_scheduled;
+
+	// The following is only accessed by the I/O thread serving the connection:
+
+	TCPConnection connection;
+	int handle;
+	NetGameConnectionReactor_Thread *thread;
+	int thread_slot;
+
+	DataBuffer receive_buffer;
+	int bytes_received;
+
+	std::vector<DataBuffer> send_packets;
+	size_t send_packet_index;
+	int send_packet_offset;
+	bool close_after_send;
+	bool want_write;
+	bool closed;
+};
+
+/// \brief Serves many NetGameConnection sockets on a small fixed pool of I/O threads
+///
+/// Uses epoll and is only available on Linux.
+class NetGameConnectionReactor
+{
+public:
+	NetGameConnectionReactor(int num_threads);
+	~NetGameConnectionReactor();
+
+	/// \brief Returns true if the reactor can be used on this platform
+	static bool is_supported();
+
+	/// \brief Starts serving a connection. Posts client_connected to the site
+	void add_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection);
+
+	/// \brief Stops serving a connection. No network events are posted for it after this returns
+	void remove_connection(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection);
+
+	/// \brief Queues an event to be sent to the connection
+	void send_event(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection, const NetGameEvent &game_event);
+
+	/// \brief Gracefully closes the connection after all queued events have been sent
+	void disconnect(const std::shared_ptr<NetGameConnectionReactor_Connection> &connection);
+
+private:
+	std::vector<std::unique_ptr<NetGameConnectionReactor_Thread> > threads;
+	int next_thread;
+};
+
+}
@@ -30,6 +30,7 @@
 #include "API/Network/NetGame/server.h"
 #include "API/Network/NetGame/connection.h"
 #include "API/Network/Socket/socket_name.h"
+#include "API/Core/System/event_wait_set.h"
 #include "network_event.h"
 #include "server_impl.h"
 #include <algorithm>
@@ -68,11 +69,17 @@ void NetGameServer::send_event(const NetGameEvent &game_event)
 	}
 }
 
+void NetGameServer::set_io_thread_count(int count)
+{
+	impl->io_thread_count = count;
+}
+
 void NetGameServer::start(const std::string &port)
 {
 	stop();
 	impl->stop_event.reset();
-	impl->tcp_listen.reset(new TCPListen(SocketName(port)));
+	impl->start_reactor();
+	impl->tcp_listen.reset(new TCPListen(SocketName(port), impl->get_listen_queue_size()));
 	impl->listen_thread.start(this, &NetGameServer::listen_thread_main);
 }
 
@@ -80,7 +87,8 @@ void NetGameServer::start(const std::string &address, const std::string &port)
 {
 	stop();
 	impl->stop_event.reset();
-	impl->tcp_listen.reset(new TCPListen(SocketName(address, port)));
+	impl->start_reactor();
+	impl->tcp_listen.reset(new TCPListen(SocketName(address, port), impl->get_listen_queue_size()));
 	impl->listen_thread.start(this, &NetGameServer::listen_thread_main);
 }
 
@@ -95,20 +103,27 @@ void NetGameServer::stop()
 		delete impl->connections[i];
 	}
 	impl->connections.clear();
+	impl->reactor.reset();
 }
 
 void NetGameServer::listen_thread_main()
 {
+	EventWaitSet wait_set;
+	wait_set.add(impl->stop_event);
+	wait_set.add(impl->tcp_listen->get_accept_event());
 	while (true)
 	{
-		Event accept_event = impl->tcp_listen->get_accept_event();
-		int wakeup_reason = Event::wait(impl->stop_event, accept_event);
+		int wakeup_reason = wait_set.wait();
 		if (wakeup_reason != 1)
 			break;
 
 		TCPConnection connection = impl->tcp_listen->accept();
-		std::unique_ptr<NetGameConnection> game_connection(new NetGameConnection(this, connection));
 		MutexSection mutex_lock(&impl->mutex);
+		std::unique_ptr<NetGameConnection> game_connection;
+		if (impl->reactor)
+			game_connection.reset(new NetGameConnection(this, connection, impl->reactor.get()));
+		else
+			game_connection.reset(new NetGameConnection(this, connection));
 		impl->connections.push_back(game_connection.release());
 	}
 }
@@ -128,6 +143,18 @@ Signal<void(NetGameConnection *, const NetGameEvent &)> &NetGameServer::sig_even
 	return impl->sig_game_event_received;
 }
 
+void NetGameServer_Impl::start_reactor()
+{
+	if (io_thread_count > 0 && NetGameConnectionReactor::is_supported())
+		reactor.reset(new NetGameConnectionReactor(io_thread_count));
+}
+
+int NetGameServer_Impl::get_listen_queue_size() const
+{
+	// The reactor is meant for many clients, so allow more pending connections than the default
+	return reactor ? 128 : 5;
+}
+
 void NetGameServer_Impl::process()
 {
 	MutexSection mutex_lock(&mutex);
@@ -151,7 +178,7 @@ void NetGameServer_Impl::process()
 				sig_game_client_disconnected(new_events[i].connection, reason);
 			}
 
-			// Destroy connection object
+			// Destroy connection object. This is done outside the lock as the connection may be posting events to us meanwhile
 			{
 				MutexSection mutex_lock(&mutex);
 				std::vector<NetGameConnection *>::iterator connection_it;
@@ -160,6 +187,7 @@ void NetGameServer_Impl::process()
 				{
 					connections.erase( connection_it );
 				}
+				mutex_lock.unlock();
 				delete new_events[i].connection;
 			}
 			break;
@@ -30,6 +30,7 @@
 
 #include "API/Network/Socket/tcp_listen.h"
 #include "API/Core/System/keep_alive.h"
+#include "connection_reactor.h"
 #include <memory>
 
 namespace clan
@@ -38,7 +39,11 @@ namespace clan
 class NetGameServer_Impl : public KeepAliveObject
 {
 public:
+	NetGameServer_Impl() : io_thread_count(0) { }
+
 	void process();
+	void start_reactor();
+	int get_listen_queue_size() const;
 
 	std::unique_ptr<TCPListen> tcp_listen;
 	Thread listen_thread;
@@ -48,6 +53,9 @@ public:
 	std::vector<NetGameConnection *> connections;
 	std::vector<NetGameNetworkEvent> events;
 
+	int io_thread_count;
+	std::unique_ptr<NetGameConnectionReactor> reactor;
+
 	Signal<void(NetGameConnection *)> sig_game_client_connected;
 	Signal<void(NetGameConnection *, const std::string &)> sig_game_client_disconnected;
 	Signal<void(NetGameConnection *, const NetGameEvent &)> sig_game_event_received;
@@ -43,9 +43,7 @@ HTTPRequestHandler_Impl::HTTPRequestHandler_Impl()
 
 HTTPRequestHandler_Impl::~HTTPRequestHandler_Impl()
 {
-	if (provider)
-		delete provider;
-		delete provider;
+	delete provider;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -29,6 +29,7 @@
 #include "Network/precomp.h"
 #include "API/Network/Web/http_server.h"
 #include "http_server_impl.h"
+#include "http_server_reactor.h"
 
 namespace clan
 {
@@ -51,10 +52,32 @@ HTTPServer::~HTTPServer()
 /////////////////////////////////////////////////////////////////////////////
 // HTTPServer Operations:
 
+void HTTPServer::set_io_thread_count(int count)
+{
+	MutexSection mutex_lock(&impl->mutex);
+	if (!impl->listen_ports.empty())
+		throw Exception("HTTPServer::set_io_thread_count must be called before bind");
+
+	impl->reactor.reset();
+	if (count > 0 && HTTPServerReactor::is_supported())
+		impl->reactor.reset(new HTTPServerReactor(impl.get(), count));
+}
+
+void HTTPServer::set_max_request_body_size(unsigned int size)
+{
+	MutexSection mutex_lock(&impl->mutex);
+	if (!impl->listen_ports.empty())
+		throw Exception("HTTPServer::set_max_request_body_size must be called before bind");
+
+	impl->max_request_body_size = size;
+}
+
 void HTTPServer::bind(const SocketName &name)
 {
-	TCPListen tcp_listen(name);
 	MutexSection mutex_lock(&impl->mutex);
+
+	// The event loop is meant for many clients, so allow more pending connections than the default
+	TCPListen tcp_listen(name, impl->reactor ? 128 : 5);
 	impl->listen_ports.push_back(tcp_listen);
 	impl->update_event.set();
 }
@@ -32,6 +32,8 @@
 #include "API/Core/IOData/iodevice_provider.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/Text/string_format.h"
+#include "API/Core/IOData/file.h"
+#include "API/Core/IOData/path_help.h"
 #include "http_server_connection_impl.h"
 #include "http_server_impl.h"
 #include <memory>
@@ -62,18 +64,23 @@ public:
 	int send(const void *data, int len, bool send_all)
 	{
 		impl.lock()->performed_write = true;
+		if (impl.lock()->buffered)
+		{
+			impl.lock()->write(data, len);
+			return len;
+		}
 		return impl.lock()->connection.send(data, len, send_all);
 	}
 
 	int receive(void *data, int len, bool receive_all)
 	{
 		impl.lock()->performed_read = true;
-		return impl.lock()->connection.receive(data, len, receive_all);
+		return impl.lock()->receive(data, len, receive_all);
 	}
 
 	int peek(void *data, int len)
 	{
-		return impl.lock()->connection.peek(data, len);
+		return impl.lock()->peek(data, len);
 	}
 
 	bool seek(int position, IODevice::SeekMode mode)
@@ -218,7 +225,8 @@ void HTTPServerConnection::write_response_status(int status_code, const std::str
 	status_line.append(" ");
 	status_line.append(status_text);
 	status_line.append("\r\n");
-	impl->connection.write(status_line.data(), status_line.length(), true);
+	impl->write(status_line.data(), status_line.length());
+	impl->wrote_status = true;
 }
 
 void HTTPServerConnection::write_response_headers(const std::string &headers)
@@ -262,7 +270,11 @@ void HTTPServerConnection::write_response_headers(const std::string &headers)
 			if (name == "Server")
 				server_line = true;
 			else if (name == "Connection")
+			{
 				connection_line = true;
+				if (StringHelp::compare(StringHelp::trim(line.substr(pos + 1)), "close", true) == 0)
+					impl->keep_alive = false;
+			}
 			else if (name == "Date")
 				date_line = true;
 			else if (name == "Expires")
@@ -270,20 +282,23 @@ void HTTPServerConnection::write_response_headers(const std::string &headers)
 			else if (name == "Vary")
 				vary_line = true;
 
-			impl->connection.write(line.data(), line.length(), true);
-			impl->connection.write("\r\n", 2, true);
+			impl->write(line.data(), line.length());
+			impl->write("\r\n", 2);
 		}
 	}
 
 	static std::string str_server_line("Server: ClanLib HTTP Server\r\n");
 	static std::string str_connection_line("Connection: close\r\n");
+	static std::string str_keep_alive_line("Connection: keep-alive\r\n");
 	static std::string str_vary_line("Vary: *\r\n");
 	if (!server_line)
-		impl->connection.write(str_server_line.data(), str_server_line.length(), true);
-	if (!connection_line)
-		impl->connection.write(str_connection_line.data(), str_connection_line.length(), true);
+		impl->write(str_server_line.data(), str_server_line.length());
+	if (!connection_line && impl->keep_alive)
+		impl->write(str_keep_alive_line.data(), str_keep_alive_line.length());
+	else if (!connection_line)
+		impl->write(str_connection_line.data(), str_connection_line.length());
 	if (!date_line && !expires_line && !vary_line)
-		impl->connection.write(str_vary_line.data(), str_vary_line.length(), true);
+		impl->write(str_vary_line.data(), str_vary_line.length());
 //	write_line(connection, "Date: Sun, 16 Oct 2005 20:13:00 GMT");
 //	write_line(connection, "Expires: Sun, 16 Oct 2005 20:13:00 GMT");
 
@@ -305,16 +320,60 @@ void HTTPServerConnection::write_response_data(const DataBuffer &data)
 			length.append("Content-Length: ");
 			length.append(StringHelp::int_to_local8(data.get_size()));
 			length.append("\r\n");
-			impl->connection.write(length.data(), length.length(), true);
+			impl->write(length.data(), length.length());
 		}
-		impl->connection.write("\r\n", 2, true);
+		impl->write("\r\n", 2);
+	}
+	else
+	{
+		// Data written after the Content-Length was sent breaks the message framing
+		impl->keep_alive = false;
 	}
 	impl->writing_header = false;
+	impl->wrote_data = true;
 	if (impl->written_content_length >= 0 && data.get_size() != impl->written_content_length)
 		throw Exception("HTTP Content-Length in header does not match response data size!");
 
 	// Header should be ok.  Write the actual data:
-	impl->connection.write(data.get_data(), data.get_size(), true);
+	impl->write(data.get_data(), data.get_size());
+}
+
+void HTTPServerConnection::write_response_file(const std::string &filename)
+{
+	if (!impl->buffered)
+	{
+		write_response_data(File::read_bytes(filename));
+		return;
+	}
+
+	std::shared_ptr<HTTPServerResponseFile> file(new HTTPServerResponseFile(PathHelp::normalize(filename, PathHelp::path_type_file)));
+
+	if (impl->performed_write)
+		throw Exception("Cannot write reponse data if manual writing has been performed first.");
+	if (!impl->writing_header)
+		write_response_headers(std::string());
+	if (impl->writing_header)
+	{
+		if (impl->written_content_length == -1)
+		{
+			std::string length;
+			length.append("Content-Length: ");
+			length.append(StringHelp::ll_to_local8(file->size));
+			length.append("\r\n");
+			impl->write(length.data(), length.length());
+		}
+		impl->write("\r\n", 2);
+	}
+	else
+	{
+		impl->keep_alive = false;
+	}
+	impl->writing_header = false;
+	impl->wrote_data = true;
+	if (impl->written_content_length >= 0 && file->size != impl->written_content_length)
+		throw Exception("HTTP Content-Length in header does not match response data size!");
+
+	impl->write_file(file);
 }
 
 /////////////////////////////////////////////////////////////////////////////
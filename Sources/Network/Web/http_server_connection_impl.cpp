@@ -28,16 +28,66 @@
 
 #include "Network/precomp.h"
 #include "http_server_connection_impl.h"
+#include "API/Core/Math/cl_math.h"
+#include "API/Core/Text/string_format.h"
+
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace clan
 {
 
+/////////////////////////////////////////////////////////////////////////////
+// HTTPServerResponseFile Construction:
+
+#ifdef WIN32
+
+HTTPServerResponseFile::HTTPServerResponseFile(const std::string &filename)
+: handle(-1), size(0)
+{
+	throw Exception("HTTPServerResponseFile is not supported on this platform");
+}
+
+HTTPServerResponseFile::~HTTPServerResponseFile()
+{
+}
+
+#else
+
+HTTPServerResponseFile::HTTPServerResponseFile(const std::string &filename)
+: handle(-1), size(0)
+{
+	handle = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (handle == -1)
+		throw Exception(string_format("Unable to open file %1", filename));
+
+	struct stat file_stat;
+	if (fstat(handle, &file_stat) == -1 || !S_ISREG(file_stat.st_mode))
+	{
+		close(handle);
+		throw Exception(string_format("Unable to open file %1", filename));
+	}
+	size = file_stat.st_size;
+}
+
+HTTPServerResponseFile::~HTTPServerResponseFile()
+{
+	close(handle);
+}
+
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 // HTTPServerConnection_Impl Construction:
 
 HTTPServerConnection_Impl::HTTPServerConnection_Impl()
 : request_read(false), performed_read(false), performed_write(false),
-  writing_header(false), written_content_length(-1)
+  writing_header(false), written_content_length(-1), buffered(false), keep_alive(false),
+  wrote_status(false), wrote_data(false), request_data_position(0)
 {
 }
 
@@ -84,6 +134,55 @@ std::string HTTPServerConnection_Impl::get_header_value(
 	return std::string();
 }
 
+void HTTPServerConnection_Impl::write(const void *data, int length)
+{
+	if (buffered)
+	{
+		if (response_chunks.empty() || response_chunks.back().file)
+			response_chunks.push_back(HTTPServerResponseChunk());
+		response_chunks.back().data.append(static_cast<const char *>(data), length);
+	}
+	else
+	{
+		connection.write(data, length, true);
+	}
+}
+
+void HTTPServerConnection_Impl::write_file(const std::shared_ptr<HTTPServerResponseFile> &file)
+{
+	HTTPServerResponseChunk chunk;
+	chunk.file = file;
+	response_chunks.push_back(chunk);
+}
+
+int HTTPServerConnection_Impl::receive(void *data, int length, bool receive_all)
+{
+	if (buffered)
+	{
+		int bytes = peek(data, length);
+		request_data_position += bytes;
+		return bytes;
+	}
+	else
+	{
+		return connection.receive(data, length, receive_all);
+	}
+}
+
+int HTTPServerConnection_Impl::peek(void *data, int length)
+{
+	if (buffered)
+	{
+		int bytes = clamp(length, 0, (int) request_data.get_size() - request_data_position);
+		memcpy(data, request_data.get_data() + request_data_position, bytes);
+		return bytes;
+	}
+	else
+	{
+		return connection.peek(data, length);
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // HTTPServerConnection_Impl Implementation:
 
@@ -30,10 +30,34 @@
 
 #include "API/Network/Socket/tcp_connection.h"
 #include "API/Core/System/databuffer.h"
+#include <memory>
+#include <vector>
 
 namespace clan
 {
 
+/// \brief File opened for a response sent with sendfile() by the HTTP server event loop
+class HTTPServerResponseFile
+{
+public:
+	HTTPServerResponseFile(const std::string &filename);
+	~HTTPServerResponseFile();
+
+	int handle;
+	byte64 size;
+};
+
+/// \brief Piece of a queued response. Either a block of data or a range of a file
+class HTTPServerResponseChunk
+{
+public:
+	HTTPServerResponseChunk() : file_offset(0) { }
+
+	std::string data;
+	std::shared_ptr<HTTPServerResponseFile> file;
+	byte64 file_offset;
+};
+
 class HTTPServerConnection_Impl
 {
 /// \name Construction
@@ -68,6 +92,20 @@ public:
 
 	byte64 written_content_length;
 
+	/// \brief True when served by the event loop
+	///
+	/// The request body is then read before the handler is called and the response is
+	/// queued in response_chunks until the handler returns.
+	bool buffered;
+
+	bool keep_alive;
+
+	bool wrote_status, wrote_data;
+
+	int request_data_position;
+
+	std::vector<HTTPServerResponseChunk> response_chunks;
+
 
 /// \}
 /// \name Operations
@@ -78,6 +116,14 @@ public:
 		const std::string &name,
 		const std::string &header_lines);
 
+	void write(const void *data, int length);
+
+	void write_file(const std::shared_ptr<HTTPServerResponseFile> &file);
+
+	int receive(void *data, int length, bool receive_all);
+
+	int peek(void *data, int length);
+
 
 /// \}
 /// \name Implementation
@@ -28,12 +28,14 @@
 
 #include "Network/precomp.h"
 #include "API/Core/System/databuffer.h"
+#include "API/Core/System/event_wait_set.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Text/logger.h"
 #include "API/Network/Web/http_server_connection.h"
 #include "http_server_impl.h"
 #include "http_server_connection_impl.h"
+#include "http_server_reactor.h"
 
 namespace clan
 {
@@ -42,6 +44,7 @@ namespace clan
 // HTTPServer_Impl Construction:
 
 HTTPServer_Impl::HTTPServer_Impl()
+: max_request_body_size(default_max_request_body_size)
 {
 	accept_thread.start(this, &HTTPServer_Impl::accept_thread_main);
 }
@@ -50,6 +53,7 @@ HTTPServer_Impl::~HTTPServer_Impl()
 {
 	stop_event.set();
 	accept_thread.join();
+	reactor.reset();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -121,37 +125,68 @@ bool HTTPServer_Impl::read_lines(TCPConnection &connection, std::string &out_hea
 	return false;
 }
 
+bool HTTPServer_Impl::find_handler(const std::string &command, const std::string &url, const std::string &headers, HTTPRequestHandler &out_handler)
+{
+	MutexSection mutex_lock(&mutex);
+	std::vector<HTTPRequestHandler>::size_type index, size;
+	size = handlers.size();
+	for (index = 0; index < size; index++)
+	{
+		if (handlers[index].is_handling_request(command, url, headers))
+		{
+			out_handler = handlers[index];
+			return true;
+		}
+	}
+	return false;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // HTTPServer_Impl Implementation:
 
 void HTTPServer_Impl::accept_thread_main()
 {
+	// Only rebuilt when the update event signals a change in the listen ports
+	EventWaitSet wait_set;
+	bool listen_ports_changed = true;
 	while (true)
 	{
 		MutexSection mutex_lock(&mutex);
-		std::vector<Event> events;
-		events.push_back(stop_event);
-		events.push_back(update_event);
-		std::vector<TCPListen>::size_type i;
-		for (i = 0; i < listen_ports.size(); i++)
-			events.push_back(listen_ports[i].get_accept_event());
+		if (listen_ports_changed)
+		{
+			wait_set.clear();
+			wait_set.add(stop_event);
+			wait_set.add(update_event);
+			std::vector<TCPListen>::size_type i;
+			for (i = 0; i < listen_ports.size(); i++)
+				wait_set.add(listen_ports[i].get_accept_event());
+			listen_ports_changed = false;
+		}
 
 		mutex_lock.unlock();
-		int result = Event::wait(events);
+		int result = wait_set.wait();
 		if (result <= 0)
 			break;
 		mutex_lock.lock();
 		if (update_event.wait(0))
 		{
 			update_event.reset();
+			listen_ports_changed = true;
 			continue;
 		}
 
-		Thread connection_thread;
-		connection_thread.start(
-			this,
-			&HTTPServer_Impl::connection_thread_main,
-			listen_ports[result-2].accept());
+		if (reactor)
+		{
+			reactor->add_connection(listen_ports[result-2].accept());
+		}
+		else
+		{
+			Thread connection_thread;
+			connection_thread.start(
+				this,
+				&HTTPServer_Impl::connection_thread_main,
+				listen_ports[result-2].accept());
+		}
 	}
 }
 
@@ -198,36 +233,26 @@ void HTTPServer_Impl::connection_thread_main(TCPConnection connection)
 		// Handle request:
 
 		// Look for a request handler that will deal with the HTTP request:
-		MutexSection mutex_lock(&mutex);
-		std::vector<HTTPRequestHandler>::size_type index, size;
-		size = handlers.size();
+		HTTPRequestHandler handler;
 		bool handled = false;
-		for (index = 0; index < size; index++)
+		if (find_handler(command, url, headers, handler))
 		{
-			if (handlers[index].is_handling_request(command, url, headers))
+			if (command == "POST")
 			{
-				HTTPRequestHandler handler = handlers[index];
-				mutex_lock.unlock();
-
-				if (command == "POST")
-				{
-					write_line(connection, "HTTP/1.1 100 Continue");
-					// write_line(connection, "Content-Length: 0");
-					write_line(connection, "");
-				}
-
-				std::shared_ptr<HTTPServerConnection_Impl> connection_impl(std::make_shared<HTTPServerConnection_Impl>());
-				connection_impl->connection = connection;
-				connection_impl->request_type = command;
-				connection_impl->request_url = url;
-				connection_impl->request_headers = headers;
-				HTTPServerConnection http_connection(connection_impl);
-				handler.handle_request(http_connection);
-				handled = true;
-				break;
+				write_line(connection, "HTTP/1.1 100 Continue");
+				// write_line(connection, "Content-Length: 0");
+				write_line(connection, "");
 			}
+
+			std::shared_ptr<HTTPServerConnection_Impl> connection_impl(std::make_shared<HTTPServerConnection_Impl>());
+			connection_impl->connection = connection;
+			connection_impl->request_type = command;
+			connection_impl->request_url = url;
+			connection_impl->request_headers = headers;
+			HTTPServerConnection http_connection(connection_impl);
+			handler.handle_request(http_connection);
+			handled = true;
 		}
-		mutex_lock.unlock();
 
 		if (!handled)
 		{
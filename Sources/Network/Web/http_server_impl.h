@@ -35,10 +35,13 @@
 #include "API/Core/System/thread.h"
 #include "API/Core/System/event.h"
 #include <vector>
+#include <memory>
 
 namespace clan
 {
 
+class HTTPServerReactor;
+
 class HTTPServer_Impl
 {
 /// \name Construction
@@ -65,6 +68,13 @@ public:
 
 	std::vector<TCPListen> listen_ports;
 
+	std::unique_ptr<HTTPServerReactor> reactor;
+
+	/// \brief Largest request body read by the I/O threads
+	unsigned int max_request_body_size;
+
+	static const unsigned int default_max_request_body_size = 8*1024*1024;
+
 
 /// \}
 /// \name Operations
@@ -77,6 +87,8 @@ public:
 
 	static bool read_lines(TCPConnection &connection, std::string &out_header_lines);
 
+	bool find_handler(const std::string &command, const std::string &url, const std::string &headers, HTTPRequestHandler &out_handler);
+
 
 /// \}
 /// \name Implementation
@@ -0,0 +1,979 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/System/mutex.h"
+#include "API/Core/System/thread.h"
+#include "API/Core/System/system.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/Text/string_help.h"
+#include "API/Core/Text/logger.h"
+#include "API/Core/Math/cl_math.h"
+#include "API/Network/Web/http_server_connection.h"
+#include "http_server_impl.h"
+#include "http_server_connection_impl.h"
+#include "http_server_reactor.h"
+#include "ring_buffer.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <deque>
+#include <new>
+#endif
+
+namespace clan
+{
+
+#ifdef __linux__
+
+class HTTPServerReactor_Connection
+{
+public:
+	HTTPServerReactor_Connection(const TCPConnection &connection)
+	: connection(connection), handle(connection.get_handle()), thread_slot(-1), last_activity(0),
+	  input(input_buffer_size), input_closed(false), header_search_offset(0),
+	  state(state_header), body_position(0), body_end(0),
+	  output_offset(0), output_bytes(0), close_after_output(false), write_shutdown(false),
+	  epoll_events(0), closed(false)
+	{
+	}
+
+	enum State
+	{
+		state_header,
+		state_body,
+		state_chunk_size,
+		state_chunk_data,
+		state_chunk_end,
+		state_trailer
+	};
+
+	static const int input_buffer_size = 16*1024;
+
+	TCPConnection connection;
+	int handle;
+	int thread_slot;
+	ubyte64 last_activity;
+
+	RingBuffer input;
+	bool input_closed;
+	size_t header_search_offset;
+
+	State state;
+	std::shared_ptr<HTTPServerConnection_Impl> request;
+
+	/// \brief Position in the request data where the next body byte goes, and where the body or current chunk ends
+	unsigned int body_position;
+	unsigned int body_end;
+
+	std::deque<HTTPServerResponseChunk> output;
+	size_t output_offset;
+	byte64 output_bytes;
+	bool close_after_output;
+
+	/// \brief True once the response side is shut down and remaining input is discarded until the peer closes
+	bool write_shutdown;
+
+	unsigned int epoll_events;
+	bool closed;
+};
+
+class HTTPServerReactor_Thread
+{
+public:
+	HTTPServerReactor_Thread(HTTPServer_Impl *server);
+	~HTTPServerReactor_Thread();
+
+	void add_connection(const TCPConnection &connection);
+
+private:
+	void thread_main();
+	void wake_up();
+	bool process_requests();
+	void register_connection(const TCPConnection &connection);
+
+	void serve_connection(HTTPServerReactor_Connection *connection);
+	void read_connection(HTTPServerReactor_Connection *connection);
+	void write_connection(HTTPServerReactor_Connection *connection);
+	void update_interest(HTTPServerReactor_Connection *connection);
+	void close_connection(HTTPServerReactor_Connection *connection);
+	void close_idle_connections();
+	void delete_closed_connections();
+
+	void process_input(HTTPServerReactor_Connection *connection);
+	bool parse_header(HTTPServerReactor_Connection *connection);
+	bool read_body_data(HTTPServerReactor_Connection *connection);
+	bool parse_chunk_size(HTTPServerReactor_Connection *connection);
+	bool parse_chunk_end(HTTPServerReactor_Connection *connection);
+	bool parse_trailer(HTTPServerReactor_Connection *connection);
+	void dispatch_request(HTTPServerReactor_Connection *connection);
+
+	static bool parse_size(const std::string &text, int base, ubyte64 &out_size);
+
+	void queue_output(HTTPServerReactor_Connection *connection, const HTTPServerResponseChunk &chunk);
+	void queue_error_response(HTTPServerReactor_Connection *connection, int status_code, const std::string &status_text);
+
+	HTTPServer_Impl *server;
+
+	int epoll_handle;
+	int wakeup_handle;
+	Thread thread;
+
+	Mutex mutex;
+	bool stop_flag;
+	bool wakeup_pending;
+	std::vector<TCPConnection> add_requests;
+
+	// Only accessed by the I/O thread
+	std::vector<HTTPServerReactor_Connection *> connections;
+	std::vector<HTTPServerReactor_Connection *> closed_connections;
+	ubyte64 last_idle_check;
+
+	static const int max_events_per_wait = 256;
+	static const int max_chunks_per_write = 64;
+	static const int max_output_backlog = 1024*1024;
+	static const int idle_timeout = 15000;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// HTTPServerReactor Construction:
+
+HTTPServerReactor::HTTPServerReactor(HTTPServer_Impl *server, int num_threads)
+: next_thread(0)
+{
+	if (num_threads < 1)
+		num_threads = 1;
+	for (int i = 0; i < num_threads; i++)
+		threads.push_back(std::unique_ptr<HTTPServerReactor_Thread>(new HTTPServerReactor_Thread(server)));
+}
+
+HTTPServerReactor::~HTTPServerReactor()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// HTTPServerReactor Attributes:
+
+bool HTTPServerReactor::is_supported()
+{
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// HTTPServerReactor Operations:
+
+void HTTPServerReactor::add_connection(const TCPConnection &connection)
+{
+	// Connections are only added from the server accept thread, so round robin needs no locking
+	threads[next_thread]->add_connection(connection);
+	next_thread = (next_thread + 1) % threads.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// HTTPServerReactor_Thread Construction:
+
+HTTPServerReactor_Thread::HTTPServerReactor_Thread(HTTPServer_Impl *server)
+: server(server), epoll_handle(-1), wakeup_handle(-1), stop_flag(false), wakeup_pending(false), last_idle_check(0)
+{
+	epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_handle == -1)
+		throw Exception("Unable to create epoll instance");
+
+	wakeup_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakeup_handle == -1)
+	{
+		close(epoll_handle);
+		throw Exception("Unable to create eventfd");
+	}
+
+	epoll_event wakeup_event;
+	memset(&wakeup_event, 0, sizeof(epoll_event));
+	wakeup_event.events = EPOLLIN;
+	wakeup_event.data.ptr = 0;
+	epoll_ctl(epoll_handle, EPOLL_CTL_ADD, wakeup_handle, &wakeup_event);
+
+	thread.start(this, &HTTPServerReactor_Thread::thread_main);
+}
+
+HTTPServerReactor_Thread::~HTTPServerReactor_Thread()
+{
+	MutexSection mutex_lock(&mutex);
+	stop_flag = true;
+	mutex_lock.unlock();
+	wake_up();
+	thread.join();
+
+	close(wakeup_handle);
+	close(epoll_handle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// HTTPServerReactor_Thread Operations:
+
+void HTTPServerReactor_Thread::add_connection(const TCPConnection &connection)
+{
+	MutexSection mutex_lock(&mutex);
+	add_requests.push_back(connection);
+	mutex_lock.unlock();
+	wake_up();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// HTTPServerReactor_Thread Implementation:
+
+void HTTPServerReactor_Thread::wake_up()
+{
+	MutexSection mutex_lock(&mutex);
+	if (wakeup_pending)
+		return;
+	wakeup_pending = true;
+	mutex_lock.unlock();
+
+	uint64_t value = 1;
+	int result = write(wakeup_handle, &value, sizeof(uint64_t));
+	(void)result;
+}
+
+void HTTPServerReactor_Thread::thread_main()
+{
+	Thread::set_thread_name("HTTP I/O");
+
+	last_idle_check = System::get_time();
+
+	epoll_event events[max_events_per_wait];
+	while (true)
+	{
+		int count = epoll_wait(epoll_handle, events, max_events_per_wait, 1000);
+		if (count < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		bool requests_pending = false;
+		for (int i = 0; i < count; i++)
+		{
+			HTTPServerReactor_Connection *connection = static_cast<HTTPServerReactor_Connection *>(events[i].data.ptr);
+			if (connection == 0)
+			{
+				uint64_t value = 0;
+				int result = read(wakeup_handle, &value, sizeof(uint64_t));
+				(void)result;
+				requests_pending = true;
+				continue;
+			}
+
+			if (!connection->closed && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+				read_connection(connection);
+			if (!connection->closed && (events[i].events & EPOLLOUT))
+				write_connection(connection);
+			if (!connection->closed)
+				serve_connection(connection);
+		}
+
+		delete_closed_connections();
+
+		if (requests_pending && !process_requests())
+			break;
+
+		close_idle_connections();
+	}
+
+	for (size_t i = 0; i < connections.size(); i++)
+		delete connections[i];
+	connections.clear();
+	delete_closed_connections();
+}
+
+bool HTTPServerReactor_Thread::process_requests()
+{
+	MutexSection mutex_lock(&mutex);
+	wakeup_pending = false;
+	if (stop_flag)
+		return false;
+	std::vector<TCPConnection> new_connections;
+	new_connections.swap(add_requests);
+	mutex_lock.unlock();
+
+	for (size_t i = 0; i < new_connections.size(); i++)
+		register_connection(new_connections[i]);
+
+	return true;
+}
+
+void HTTPServerReactor_Thread::register_connection(const TCPConnection &tcp_connection)
+{
+	HTTPServerReactor_Connection *connection = new HTTPServerReactor_Connection(tcp_connection);
+	connection->last_activity = System::get_time();
+
+	// Accepted sockets do not inherit the non-blocking mode of the listen socket
+	fcntl(connection->handle, F_SETFL, fcntl(connection->handle, F_GETFL) | O_NONBLOCK);
+
+	epoll_event event;
+	memset(&event, 0, sizeof(epoll_event));
+	event.events = EPOLLIN;
+	event.data.ptr = connection;
+	if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, connection->handle, &event) == -1)
+	{
+		delete connection;
+		return;
+	}
+	connection->epoll_events = EPOLLIN;
+
+	connection->thread_slot = connections.size();
+	connections.push_back(connection);
+}
+
+void HTTPServerReactor_Thread::serve_connection(HTTPServerReactor_Connection *connection)
+{
+	while (true)
+	{
+		process_input(connection);
+		if (connection->closed)
+			return;
+
+		// Pipelined requests may still be waiting in the input buffer if the
+		// backlog limit paused parsing. Keep going while the socket drains it.
+		bool paused = connection->output_bytes >= max_output_backlog;
+		write_connection(connection);
+		if (connection->closed)
+			return;
+
+		if (!paused || connection->output_bytes >= max_output_backlog)
+			break;
+	}
+
+	// Nothing more will arrive once the peer has shut down its side
+	if (connection->input_closed && connection->output.empty())
+	{
+		close_connection(connection);
+		return;
+	}
+
+	update_interest(connection);
+}
+
+void HTTPServerReactor_Thread::read_connection(HTTPServerReactor_Connection *connection)
+{
+	if (connection->write_shutdown)
+		connection->input.read(connection->input.get_length());
+
+	while (true)
+	{
+		size_t space = connection->input.get_write_size();
+		if (space == 0)
+			break;
+
+		ssize_t bytes = recv(connection->handle, connection->input.get_write_pos(), space, 0);
+		if (bytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			close_connection(connection);
+			return;
+		}
+		else if (bytes == 0)
+		{
+			connection->input_closed = true;
+			break;
+		}
+
+		connection->input.write(bytes);
+		connection->last_activity = System::get_time();
+
+		// A short read means the socket is drained. Otherwise continue with the wrapped part of the ring buffer
+		if ((size_t)bytes < space)
+			break;
+	}
+}
+
+void HTTPServerReactor_Thread::write_connection(HTTPServerReactor_Connection *connection)
+{
+	while (!connection->output.empty())
+	{
+		HTTPServerResponseChunk &front = connection->output.front();
+		if (front.file)
+		{
+			off_t offset = front.file_offset;
+			byte64 remaining = front.file->size - front.file_offset;
+			ssize_t bytes = remaining > 0 ? sendfile(connection->handle, front.file->handle, &offset, remaining > 0x40000000 ? 0x40000000 : remaining) : 0;
+			if (bytes < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					break;
+				close_connection(connection);
+				return;
+			}
+			else if (bytes == 0 && remaining > 0)
+			{
+				// File was truncated while being sent
+				close_connection(connection);
+				return;
+			}
+
+			front.file_offset += bytes;
+			connection->output_bytes -= bytes;
+			if (front.file_offset == front.file->size)
+				connection->output.pop_front();
+		}
+		else
+		{
+			// Gather the data chunks up to the next file and send them with one system call
+			iovec vectors[max_chunks_per_write];
+			int num_vectors = 0;
+			size_t index;
+			for (index = 0; index < connection->output.size() && num_vectors < max_chunks_per_write && !connection->output[index].file; index++)
+			{
+				size_t offset = (index == 0) ? connection->output_offset : 0;
+				vectors[num_vectors].iov_base = const_cast<char *>(connection->output[index].data.data()) + offset;
+				vectors[num_vectors].iov_len = connection->output[index].data.length() - offset;
+				num_vectors++;
+			}
+			bool file_follows = (index < connection->output.size() && connection->output[index].file);
+
+			msghdr message;
+			memset(&message, 0, sizeof(msghdr));
+			message.msg_iov = vectors;
+			message.msg_iovlen = num_vectors;
+			ssize_t bytes = sendmsg(connection->handle, &message, MSG_NOSIGNAL | (file_follows ? MSG_MORE : 0));
+			if (bytes < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					break;
+				close_connection(connection);
+				return;
+			}
+
+			connection->output_bytes -= bytes;
+			while (bytes > 0)
+			{
+				size_t remaining = connection->output.front().data.length() - connection->output_offset;
+				if ((size_t)bytes >= remaining)
+				{
+					bytes -= remaining;
+					connection->output.pop_front();
+					connection->output_offset = 0;
+				}
+				else
+				{
+					connection->output_offset += bytes;
+					bytes = 0;
+				}
+			}
+		}
+		connection->last_activity = System::get_time();
+	}
+
+	// Closing the socket right away could reset the connection before the client read the response.
+	// Instead signal the end of the response and wait for the client to close its side
+	if (connection->output.empty() && connection->close_after_output && !connection->write_shutdown)
+	{
+		shutdown(connection->handle, SHUT_WR);
+		connection->write_shutdown = true;
+		connection->last_activity = System::get_time();
+	}
+}
+
+void HTTPServerReactor_Thread::update_interest(HTTPServerReactor_Connection *connection)
+{
+	// Stop reading while the input buffer is full or the client is not reading its responses
+	unsigned int events = 0;
+	if (connection->write_shutdown)
+		events |= EPOLLIN;
+	else if (!connection->input_closed && !connection->close_after_output && connection->input.get_write_size() > 0 && connection->output_bytes < max_output_backlog)
+		events |= EPOLLIN;
+	if (!connection->output.empty())
+		events |= EPOLLOUT;
+
+	if (events != connection->epoll_events)
+	{
+		epoll_event event;
+		memset(&event, 0, sizeof(epoll_event));
+		event.events = events;
+		event.data.ptr = connection;
+		epoll_ctl(epoll_handle, EPOLL_CTL_MOD, connection->handle, &event);
+		connection->epoll_events = events;
+	}
+}
+
+void HTTPServerReactor_Thread::close_connection(HTTPServerReactor_Connection *connection)
+{
+	if (connection->closed)
+		return;
+
+	connection->closed = true;
+	epoll_ctl(epoll_handle, EPOLL_CTL_DEL, connection->handle, 0);
+
+	// Swap with the last connection to remove it in constant time
+	int slot = connection->thread_slot;
+	connections[slot] = connections.back();
+	connections[slot]->thread_slot = slot;
+	connections.pop_back();
+	connection->thread_slot = -1;
+
+	// Deleted after the current batch of epoll events has been processed
+	closed_connections.push_back(connection);
+}
+
+void HTTPServerReactor_Thread::close_idle_connections()
+{
+	ubyte64 current_time = System::get_time();
+	if (current_time - last_idle_check < 1000)
+		return;
+	last_idle_check = current_time;
+
+	for (size_t i = connections.size(); i > 0; i--)
+	{
+		if (current_time - connections[i - 1]->last_activity > idle_timeout)
+			close_connection(connections[i - 1]);
+	}
+	delete_closed_connections();
+}
+
+void HTTPServerReactor_Thread::delete_closed_connections()
+{
+	for (size_t i = 0; i < closed_connections.size(); i++)
+		delete closed_connections[i];
+	closed_connections.clear();
+}
+
+void HTTPServerReactor_Thread::process_input(HTTPServerReactor_Connection *connection)
+{
+	while (!connection->closed && !connection->close_after_output && connection->output_bytes < max_output_backlog)
+	{
+		bool progress = false;
+		switch (connection->state)
+		{
+		case HTTPServerReactor_Connection::state_header:
+			progress = parse_header(connection);
+			break;
+		case HTTPServerReactor_Connection::state_body:
+		case HTTPServerReactor_Connection::state_chunk_data:
+			progress = read_body_data(connection);
+			break;
+		case HTTPServerReactor_Connection::state_chunk_size:
+			progress = parse_chunk_size(connection);
+			break;
+		case HTTPServerReactor_Connection::state_chunk_end:
+			progress = parse_chunk_end(connection);
+			break;
+		case HTTPServerReactor_Connection::state_trailer:
+			progress = parse_trailer(connection);
+			break;
+		}
+
+		if (!progress)
+			break;
+	}
+}
+
+bool HTTPServerReactor_Thread::parse_header(HTTPServerReactor_Connection *connection)
+{
+	RingBuffer &input = connection->input;
+
+	// Ignore empty lines in front of the request line, as some clients send an extra CRLF after a POST body
+	while (input.get_length() >= 2 && input.find("\r\n", 2) == 0)
+		input.read(2);
+
+	size_t header_length = input.find("\r\n\r\n", 4, connection->header_search_offset);
+	if (header_length == RingBuffer::npos)
+	{
+		// Continue searching where this search ended when more data arrives
+		size_t length = input.get_length();
+		connection->header_search_offset = length > 3 ? length - 3 : 0;
+		if (input.get_write_size() == 0)
+			queue_error_response(connection, 431, "Request Header Fields Too Large");
+		return false;
+	}
+	connection->header_search_offset = 0;
+
+	std::string header = input.read_to_string(header_length + 4);
+	std::string::size_type request_line_length = header.find("\r\n");
+	std::string request = header.substr(0, request_line_length);
+	std::string headers = header.substr(request_line_length + 2);
+
+	// Extract request command, url and version:
+
+	std::string::size_type pos1 = request.find(' ');
+	std::string::size_type pos2 = (pos1 != std::string::npos) ? request.find(' ', pos1 + 1) : std::string::npos;
+	if (pos2 == std::string::npos || request.find(' ', pos2 + 1) != std::string::npos)
+	{
+		queue_error_response(connection, 400, "Bad Request");
+		return false;
+	}
+	std::string command = request.substr(0, pos1);
+	std::string url = request.substr(pos1+1, pos2-pos1-1);
+	std::string version = request.substr(pos2 + 1);
+
+	if (command != "POST" && command != "GET")
+	{
+		queue_error_response(connection, 501, "Not Implemented");
+		return false;
+	}
+
+	std::shared_ptr<HTTPServerConnection_Impl> connection_impl(std::make_shared<HTTPServerConnection_Impl>());
+	connection_impl->connection = connection->connection;
+	connection_impl->buffered = true;
+	connection_impl->request_type = command;
+	connection_impl->request_url = url;
+	connection_impl->request_headers = headers;
+
+	// HTTP/1.1 connections are persistent unless the client asks otherwise. HTTP/1.0 only when asked for
+	std::string connection_header = HTTPServerConnection_Impl::get_header_value("Connection", headers);
+	if (version == "HTTP/1.1")
+		connection_impl->keep_alive = (StringHelp::compare(connection_header, "close", true) != 0);
+	else
+		connection_impl->keep_alive = (StringHelp::compare(connection_header, "keep-alive", true) == 0);
+
+	connection->request = connection_impl;
+
+	// Find out how the request body is transferred:
+
+	std::string content_length = HTTPServerConnection_Impl::get_header_value("Content-Length", headers);
+	std::string transfer_encoding = HTTPServerConnection_Impl::get_header_value("Transfer-Encoding", headers);
+	std::string::size_type extension_pos = transfer_encoding.find_first_of(" \t\r\n;");
+	if (extension_pos != std::string::npos)
+		transfer_encoding = transfer_encoding.substr(0, extension_pos);
+
+	if (transfer_encoding == "chunked")
+	{
+		connection->state = HTTPServerReactor_Connection::state_chunk_size;
+	}
+	else if (!transfer_encoding.empty())
+	{
+		queue_error_response(connection, 501, "Not Implemented");
+		return false;
+	}
+	else if (!content_length.empty())
+	{
+		ubyte64 body_size = 0;
+		if (!parse_size(content_length, 10, body_size))
+		{
+			queue_error_response(connection, 400, "Bad Request");
+			return false;
+		}
+		else if (body_size > server->max_request_body_size)
+		{
+			queue_error_response(connection, 413, "Payload Too Large");
+			return false;
+		}
+		else if (body_size == 0)
+		{
+			dispatch_request(connection);
+			return true;
+		}
+
+		// The buffer grows as the body arrives, so a client can not make the server allocate memory for data it never sends
+		connection->body_position = 0;
+		connection->body_end = (unsigned int)body_size;
+		connection->state = HTTPServerReactor_Connection::state_body;
+	}
+	else
+	{
+		dispatch_request(connection);
+		return true;
+	}
+
+	std::string expect = HTTPServerConnection_Impl::get_header_value("Expect", headers);
+	if (StringHelp::compare(expect, "100-continue", true) == 0)
+	{
+		HTTPServerResponseChunk chunk;
+		chunk.data = "HTTP/1.1 100 Continue\r\n\r\n";
+		queue_output(connection, chunk);
+	}
+
+	return true;
+}
+
+bool HTTPServerReactor_Thread::read_body_data(HTTPServerReactor_Connection *connection)
+{
+	RingBuffer &input = connection->input;
+	DataBuffer &data = connection->request->request_data;
+
+	while (connection->body_position < connection->body_end && input.get_length() > 0)
+	{
+		unsigned int available = (unsigned int)min((size_t)(connection->body_end - connection->body_position), input.get_read_size());
+		unsigned int new_size = connection->body_position + available;
+		if (new_size > data.get_capacity())
+		{
+			// Grow by doubling. The total size is known up front for Content-Length bodies, but not for chunked ones
+			unsigned int limit = (connection->state == HTTPServerReactor_Connection::state_body) ? connection->body_end : server->max_request_body_size;
+			unsigned int new_capacity = max(new_size, (unsigned int)min((ubyte64)data.get_capacity() * 2, (ubyte64)limit));
+			try
+			{
+				data.set_capacity(new_capacity);
+			}
+			catch (const std::bad_alloc &)
+			{
+				queue_error_response(connection, 503, "Service Unavailable");
+				return false;
+			}
+		}
+		data.set_size(new_size);
+		memcpy(data.get_data() + connection->body_position, input.get_read_pos(), available);
+		input.read(available);
+		connection->body_position = new_size;
+	}
+
+	if (connection->body_position < connection->body_end)
+		return false;
+
+	if (connection->state == HTTPServerReactor_Connection::state_body)
+		dispatch_request(connection);
+	else
+		connection->state = HTTPServerReactor_Connection::state_chunk_end;
+	return true;
+}
+
+bool HTTPServerReactor_Thread::parse_chunk_size(HTTPServerReactor_Connection *connection)
+{
+	RingBuffer &input = connection->input;
+	size_t line_length = input.find("\r\n", 2);
+	if (line_length == RingBuffer::npos)
+	{
+		if (input.get_write_size() == 0)
+			queue_error_response(connection, 400, "Bad Request");
+		return false;
+	}
+
+	std::string line = input.read_to_string(line_length);
+	input.read(2);
+
+	std::string::size_type size_length = line.find(';');
+	ubyte64 chunk_size = 0;
+	if (!parse_size(line.substr(0, size_length), 16, chunk_size))
+	{
+		queue_error_response(connection, 400, "Bad Request");
+		return false;
+	}
+
+	DataBuffer &data = connection->request->request_data;
+	if (data.get_size() + chunk_size > server->max_request_body_size)
+	{
+		queue_error_response(connection, 413, "Payload Too Large");
+		return false;
+	}
+
+	if (chunk_size == 0)
+	{
+		connection->state = HTTPServerReactor_Connection::state_trailer;
+	}
+	else
+	{
+		connection->body_position = data.get_size();
+		connection->body_end = data.get_size() + (unsigned int)chunk_size;
+		connection->state = HTTPServerReactor_Connection::state_chunk_data;
+	}
+	return true;
+}
+
+bool HTTPServerReactor_Thread::parse_chunk_end(HTTPServerReactor_Connection *connection)
+{
+	RingBuffer &input = connection->input;
+	if (input.get_length() < 2)
+		return false;
+
+	if (input.find("\r\n", 2) != 0)
+	{
+		queue_error_response(connection, 400, "Bad Request");
+		return false;
+	}
+
+	input.read(2);
+	connection->state = HTTPServerReactor_Connection::state_chunk_size;
+	return true;
+}
+
+bool HTTPServerReactor_Thread::parse_trailer(HTTPServerReactor_Connection *connection)
+{
+	RingBuffer &input = connection->input;
+	size_t line_length = input.find("\r\n", 2);
+	if (line_length == RingBuffer::npos)
+	{
+		if (input.get_write_size() == 0)
+			queue_error_response(connection, 400, "Bad Request");
+		return false;
+	}
+
+	// Trailer fields are not passed on to the handler
+	input.read(line_length + 2);
+	if (line_length == 0)
+		dispatch_request(connection);
+	return true;
+}
+
+void HTTPServerReactor_Thread::dispatch_request(HTTPServerReactor_Connection *connection)
+{
+	std::shared_ptr<HTTPServerConnection_Impl> connection_impl = connection->request;
+	connection->request.reset();
+	connection->state = HTTPServerReactor_Connection::state_header;
+
+	connection_impl->request_read = true;
+	HTTPServerConnection http_connection(connection_impl);
+	try
+	{
+		HTTPRequestHandler handler;
+		if (server->find_handler(connection_impl->request_type, connection_impl->request_url, connection_impl->request_headers, handler))
+		{
+			handler.handle_request(http_connection);
+
+			if (connection_impl->performed_write || (!connection_impl->wrote_status && !connection_impl->writing_header && !connection_impl->wrote_data))
+			{
+				// The end of the response is only known by closing the connection
+				connection_impl->keep_alive = false;
+			}
+			else if (!connection_impl->wrote_data)
+			{
+				http_connection.write_response_data(DataBuffer());
+			}
+		}
+		else
+		{
+			// No handler wants it.  Reply with 404 Not Found:
+			http_connection.write_response_status(404, "Not Found");
+			http_connection.write_response_headers("Content-Type: text/plain");
+			std::string error_msg("404 Not Found\r\n");
+			http_connection.write_response_data(DataBuffer(error_msg.data(), error_msg.length()));
+		}
+	}
+	catch (const Exception& e)
+	{
+		log_event("error", e.message);
+		close_connection(connection);
+		return;
+	}
+
+	for (size_t i = 0; i < connection_impl->response_chunks.size(); i++)
+		queue_output(connection, connection_impl->response_chunks[i]);
+	connection_impl->response_chunks.clear();
+
+	if (!connection_impl->keep_alive)
+		connection->close_after_output = true;
+}
+
+bool HTTPServerReactor_Thread::parse_size(const std::string &text, int base, ubyte64 &out_size)
+{
+	std::string::size_type start = text.find_first_not_of(" \t");
+	std::string::size_type end = text.find_last_not_of(" \t");
+	if (start == std::string::npos)
+		return false;
+
+	// Values larger than any body size limit stop accumulating, so the result can not overflow
+	const ubyte64 saturation = ((ubyte64)1) << 40;
+	ubyte64 size = 0;
+	for (std::string::size_type i = start; i <= end; i++)
+	{
+		int digit;
+		char c = text[i];
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (base == 16 && c >= 'a' && c <= 'f')
+			digit = 10 + c - 'a';
+		else if (base == 16 && c >= 'A' && c <= 'F')
+			digit = 10 + c - 'A';
+		else
+			return false;
+
+		if (size < saturation)
+			size = size * base + digit;
+	}
+
+	out_size = size;
+	return true;
+}
+
+void HTTPServerReactor_Thread::queue_output(HTTPServerReactor_Connection *connection, const HTTPServerResponseChunk &chunk)
+{
+	connection->output.push_back(chunk);
+	if (chunk.file)
+		connection->output_bytes += chunk.file->size - chunk.file_offset;
+	else
+		connection->output_bytes += chunk.data.length();
+}
+
+void HTTPServerReactor_Thread::queue_error_response(HTTPServerReactor_Connection *connection, int status_code, const std::string &status_text)
+{
+	std::string body = StringHelp::int_to_local8(status_code) + " " + status_text + "\r\n";
+
+	HTTPServerResponseChunk chunk;
+	chunk.data.append("HTTP/1.1 " + StringHelp::int_to_local8(status_code) + " " + status_text + "\r\n");
+	chunk.data.append("Server: ClanLib HTTP Server\r\n");
+	chunk.data.append("Connection: close\r\n");
+	chunk.data.append("Content-Type: text/plain\r\n");
+	chunk.data.append("Content-Length: " + StringHelp::int_to_local8(body.length()) + "\r\n");
+	chunk.data.append("\r\n");
+	chunk.data.append(body);
+	queue_output(connection, chunk);
+
+	connection->request.reset();
+	connection->close_after_output = true;
+}
+
+#else
+
+class HTTPServerReactor_Thread
+{
+};
+
+HTTPServerReactor::HTTPServerReactor(HTTPServer_Impl *server, int num_threads)
+: next_thread(0)
+{
+	throw Exception("HTTPServerReactor is not supported on this platform");
+}
+
+HTTPServerReactor::~HTTPServerReactor()
+{
+}
+
+bool HTTPServerReactor::is_supported()
+{
+	return false;
+}
+
+void HTTPServerReactor::add_connection(const TCPConnection &connection)
+{
+}
+
+#endif
+
+}
@@ -0,0 +1,62 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Network/Socket/tcp_connection.h"
+#include <vector>
+#include <memory>
+
+namespace clan
+{
+
+class HTTPServer_Impl;
+class HTTPServerReactor_Thread;
+
+/// \brief Serves HTTP connections on a small fixed pool of event loop threads
+///
+/// Supports HTTP/1.1 keep-alive and request pipelining. Request handlers are called
+/// on the I/O threads. Uses epoll and is only available on Linux.
+class HTTPServerReactor
+{
+public:
+	HTTPServerReactor(HTTPServer_Impl *server, int num_threads);
+	~HTTPServerReactor();
+
+	/// \brief Returns true if the reactor can be used on this platform
+	static bool is_supported();
+
+	/// \brief Starts serving an accepted connection
+	void add_connection(const TCPConnection &connection);
+
+private:
+	std::vector<std::unique_ptr<HTTPServerReactor_Thread> > threads;
+	int next_thread;
+};
+
+}
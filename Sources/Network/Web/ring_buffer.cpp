@@ -51,14 +51,22 @@ char *RingBuffer::get_write_pos()
 
 size_t RingBuffer::get_write_size()
 {
+	if (length == size)
+		return 0;
+
 	size_t end_pos = pos + length;
 	if (end_pos >= size)
 		end_pos -= size;
 
-	if (pos < end_pos)
-		return end_pos - pos;
-	else
+	if (end_pos >= pos)
 		return size - end_pos;
+	else
+		return pos - end_pos;
+}
+
+size_t RingBuffer::get_length()
+{
+	return length;
 }
 
 void RingBuffer::write(size_t written_length)
@@ -92,9 +100,14 @@ std::string RingBuffer::read_to_string(size_t length)
 
 size_t RingBuffer::find(const char *search_data, size_t search_size)
 {
-	if (search_size <= length)
+	return find(search_data, search_size, 0);
+}
+
+size_t RingBuffer::find(const char *search_data, size_t search_size, size_t start_offset)
+{
+	if (start_offset + search_size <= length)
 	{
-		for (size_t i = pos; i <= pos+length-search_size; i++)
+		for (size_t i = pos + start_offset; i <= pos+length-search_size; i++)
 		{
 			bool found = true;
 			for (size_t j = 0; j < search_size; j++)
@@ -17,10 +17,12 @@ public:
 	size_t get_read_size();
 	char *get_write_pos();
 	size_t get_write_size();
+	size_t get_length();
 	void write(size_t length);
 	void read(size_t length);
 	std::string read_to_string(size_t length);
 	size_t find(const char *data, size_t size);
+	size_t find(const char *data, size_t size, size_t start_offset);
 
 	static const size_t npos = (size_t)(-1);
 
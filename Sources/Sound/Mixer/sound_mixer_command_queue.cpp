@@ -0,0 +1,82 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_mixer_command_queue.h"
+#include "../soundbuffer_session_impl.h"
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundMixerCommandQueue construction:
+
+SoundMixerCommandQueue::SoundMixerCommandQueue()
+: head(0)
+{
+}
+
+SoundMixerCommandQueue::~SoundMixerCommandQueue()
+{
+	SoundMixerCommand *command = pop_all();
+	while (command)
+	{
+		SoundMixerCommand *next = command->next;
+		delete command;
+		command = next;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundMixerCommandQueue operations:
+
+void SoundMixerCommandQueue::push(SoundMixerCommand *command)
+{
+	SoundMixerCommand *old_head = head.load(std::memory_order_relaxed);
+	do
+	{
+		command->next = old_head;
+	} while (!head.compare_exchange_weak(old_head, command, std::memory_order_release, std::memory_order_relaxed));
+}
+
+SoundMixerCommand *SoundMixerCommandQueue::pop_all()
+{
+	// Commands are pushed newest first, so the list is reversed to restore the order they were queued in
+	SoundMixerCommand *command = head.exchange(0, std::memory_order_acquire);
+	SoundMixerCommand *oldest_first = 0;
+	while (command)
+	{
+		SoundMixerCommand *next = command->next;
+		command->next = oldest_first;
+		oldest_first = command;
+		command = next;
+	}
+	return oldest_first;
+}
+
+}
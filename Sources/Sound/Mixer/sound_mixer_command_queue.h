@@ -0,0 +1,110 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/soundfilter.h"
+#include <atomic>
+#include <memory>
+
+namespace clan
+{
+
+class SoundBuffer_Session_Impl;
+
+/// \brief Change to a sound session, passed from the application to the mixer thread
+class SoundMixerCommand
+{
+/// \name Construction
+/// \{
+public:
+	enum Type
+	{
+		type_play,
+		type_stop,
+		type_set_volume,
+		type_set_pan,
+		type_set_frequency,
+		type_set_resample_quality,
+		type_add_filter,
+		type_remove_filter
+	};
+
+	SoundMixerCommand(Type type, const std::shared_ptr<SoundBuffer_Session_Impl> &session, float value = 0.0f)
+	: type(type), session(session), value(value), next(0)
+	{
+	}
+/// \}
+
+/// \name Attributes
+/// \{
+public:
+	Type type;
+	std::shared_ptr<SoundBuffer_Session_Impl> session;
+	float value;
+	SoundFilter filter;
+
+	/// \brief Next command in the list returned by SoundMixerCommandQueue::pop_all
+	SoundMixerCommand *next;
+/// \}
+};
+
+/// \brief Lock-free queue of commands from any number of threads to the mixer thread
+class SoundMixerCommandQueue
+{
+/// \name Construction
+/// \{
+public:
+	SoundMixerCommandQueue();
+	~SoundMixerCommandQueue();
+/// \}
+
+/// \name Operations
+/// \{
+public:
+	/// \brief Adds a command to the queue. Transfers ownership of the command.
+	void push(SoundMixerCommand *command);
+
+	/// \brief Removes all queued commands, returning them oldest first linked by SoundMixerCommand::next
+	///
+	/// Must only be called by one thread at a time. The caller becomes owner of the commands.
+	SoundMixerCommand *pop_all();
+/// \}
+
+/// \name Implementation
+/// \{
+private:
+	SoundMixerCommandQueue(const SoundMixerCommandQueue &);
+	SoundMixerCommandQueue &operator =(const SoundMixerCommandQueue &);
+
+	/// \brief Most recently pushed command
+	std::atomic<SoundMixerCommand *> head;
+/// \}
+};
+
+}
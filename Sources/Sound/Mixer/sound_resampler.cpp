@@ -0,0 +1,236 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_resampler.h"
+#include "API/Core/System/mutex.h"
+#include "API/Core/Math/cl_math.h"
+#include <map>
+#include <cmath>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+
+/// \brief Windowed sinc filter taps for each phase between two input samples
+class SoundResamplerKernel
+{
+public:
+	SoundResamplerKernel(float cutoff);
+
+	const float *get_taps(ubyte64 position) const { return &taps[((unsigned int)position >> (32 - SoundResampler::phase_bits)) * SoundResampler::num_taps]; }
+
+	std::vector<float> taps;
+};
+
+SoundResamplerKernel::SoundResamplerKernel(float cutoff)
+: taps(SoundResampler::num_phases * SoundResampler::num_taps)
+{
+	const double pi = 3.14159265358979323846;
+	const double half_width = SoundResampler::num_taps / 2;
+
+	for (int phase = 0; phase < SoundResampler::num_phases; phase++)
+	{
+		// Tap i is applied to the input sample at offset i - history from the position
+		double fraction = phase / double(SoundResampler::num_phases);
+		float *phase_taps = &taps[phase * SoundResampler::num_taps];
+		double sum = 0.0;
+		for (int i = 0; i < SoundResampler::num_taps; i++)
+		{
+			double t = i - SoundResampler::history - fraction;
+			double sinc = (t == 0.0) ? 1.0 : std::sin(pi * cutoff * t) / (pi * cutoff * t);
+			double x = t / half_width;
+			double window = (std::abs(x) < 1.0) ? 0.42 + 0.5 * std::cos(pi * x) + 0.08 * std::cos(2.0 * pi * x) : 0.0;
+			double tap = sinc * window;
+			phase_taps[i] = (float)tap;
+			sum += tap;
+		}
+
+		// Unity gain for every phase, so constant input stays constant
+		for (int i = 0; i < SoundResampler::num_taps; i++)
+			phase_taps[i] = (float)(phase_taps[i] / sum);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundResampler Construction:
+
+SoundResampler::SoundResampler()
+: quality(resample_linear), speed(1.0), step(ubyte64(1) << 32)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundResampler Operations:
+
+void SoundResampler::set_quality(SoundResampleQuality new_quality)
+{
+	quality = new_quality;
+	update_kernel();
+}
+
+void SoundResampler::set_speed(double new_speed)
+{
+	if (new_speed != speed)
+	{
+		speed = new_speed;
+		step = (ubyte64)(speed * 4294967296.0 + 0.5);
+		if (step == 0)
+			step = 1;
+		update_kernel();
+	}
+}
+
+int SoundResampler::process(float **input, int num_channels, int input_length, ubyte64 &position, float **output, int output_offset, int count)
+{
+	// Output is only produced for positions that have all their lookahead samples in the input
+	if (input_length <= lookahead)
+		return 0;
+	ubyte64 end_position = ((ubyte64)(input_length - lookahead)) << 32;
+	if (position >= end_position || count <= 0)
+		return 0;
+	ubyte64 available = (end_position - position - 1) / step + 1;
+	if (available < (ubyte64)count)
+		count = (int)available;
+
+	for (int chan = 0; chan < num_channels; chan++)
+	{
+		if (step == (ubyte64(1) << 32) && (position & 0xffffffff) == 0)
+			process_copy(input[chan], position, output[chan] + output_offset, count);
+		else if (quality == resample_sinc)
+			process_sinc(input[chan], position, output[chan] + output_offset, count);
+		else
+			process_linear(input[chan], position, output[chan] + output_offset, count);
+	}
+
+	position += step * count;
+	return count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundResampler Implementation:
+
+void SoundResampler::update_kernel()
+{
+	if (quality != resample_sinc)
+	{
+		kernel.reset();
+		return;
+	}
+
+	// When the input is played faster, the filter cutoff is lowered to the output Nyquist frequency.
+	// Kernels are shared by all resamplers with the same cutoff, in steps of 1/64.
+	int cutoff_index = speed <= 1.0 ? 64 : max((int)(64.0 / speed + 0.5), 1);
+
+	static Mutex mutex;
+	static std::map<int, std::shared_ptr<SoundResamplerKernel> > kernels;
+
+	MutexSection mutex_lock(&mutex);
+	std::shared_ptr<SoundResamplerKernel> &cached_kernel = kernels[cutoff_index];
+	if (!cached_kernel)
+		cached_kernel = std::make_shared<SoundResamplerKernel>(cutoff_index / 64.0f);
+	kernel = cached_kernel;
+}
+
+void SoundResampler::process_copy(const float *input, ubyte64 position, float *output, int count)
+{
+	memcpy(output, input + (position >> 32), count * sizeof(float));
+}
+
+void SoundResampler::process_linear(const float *input, ubyte64 position, float *output, int count)
+{
+	// The top 24 bits of the fraction are exact in a float
+	const float fraction_scale = 1.0f / 16777216.0f;
+	int i = 0;
+
+#ifndef CL_DISABLE_SSE2
+	__m128 mfraction_scale = _mm_set1_ps(fraction_scale);
+	for (; i + 4 <= count; i += 4)
+	{
+		ubyte64 p0 = position, p1 = p0 + step, p2 = p1 + step, p3 = p2 + step;
+		const float *s0 = input + (p0 >> 32), *s1 = input + (p1 >> 32), *s2 = input + (p2 >> 32), *s3 = input + (p3 >> 32);
+
+		__m128 a = _mm_set_ps(s3[0], s2[0], s1[0], s0[0]);
+		__m128 b = _mm_set_ps(s3[1], s2[1], s1[1], s0[1]);
+		__m128i ifraction = _mm_set_epi32(((unsigned int)p3) >> 8, ((unsigned int)p2) >> 8, ((unsigned int)p1) >> 8, ((unsigned int)p0) >> 8);
+		__m128 fraction = _mm_mul_ps(_mm_cvtepi32_ps(ifraction), mfraction_scale);
+
+		_mm_storeu_ps(output + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fraction)));
+		position = p3 + step;
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const float *s = input + (position >> 32);
+		float fraction = (((unsigned int)position) >> 8) * fraction_scale;
+		output[i] = s[0] + (s[1] - s[0]) * fraction;
+		position += step;
+	}
+}
+
+void SoundResampler::process_sinc(const float *input, ubyte64 position, float *output, int count)
+{
+	int i = 0;
+
+#ifndef CL_DISABLE_SSE2
+	for (; i + 4 <= count; i += 4)
+	{
+		// Four output samples at a time, each a 16 tap dot product, summed horizontally with a transpose
+		__m128 sums[4];
+		for (int j = 0; j < 4; j++)
+		{
+			const float *s = input + (position >> 32) - history;
+			const float *taps = kernel->get_taps(position);
+			__m128 sum0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s), _mm_loadu_ps(taps)), _mm_mul_ps(_mm_loadu_ps(s + 4), _mm_loadu_ps(taps + 4)));
+			__m128 sum1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s + 8), _mm_loadu_ps(taps + 8)), _mm_mul_ps(_mm_loadu_ps(s + 12), _mm_loadu_ps(taps + 12)));
+			sums[j] = _mm_add_ps(sum0, sum1);
+			position += step;
+		}
+
+		_MM_TRANSPOSE4_PS(sums[0], sums[1], sums[2], sums[3]);
+		_mm_storeu_ps(output + i, _mm_add_ps(_mm_add_ps(sums[0], sums[1]), _mm_add_ps(sums[2], sums[3])));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const float *s = input + (position >> 32) - history;
+		const float *taps = kernel->get_taps(position);
+		float sum = 0.0f;
+		for (int j = 0; j < num_taps; j++)
+			sum += s[j] * taps[j];
+		output[i] = sum;
+		position += step;
+	}
+}
+
+}
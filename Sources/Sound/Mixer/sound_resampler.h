@@ -0,0 +1,99 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+#include "API/Sound/soundbuffer_session.h"
+#include <vector>
+#include <memory>
+
+namespace clan
+{
+
+class SoundResamplerKernel;
+
+/// \brief Converts blocks of sound data from one frequency to another
+///
+/// Positions are 32.32 fixed point sample indexes into the input buffers. The input must
+/// contain 'history' samples before and 'lookahead' samples after each position used.
+class SoundResampler
+{
+/// \name Construction
+/// \{
+public:
+	SoundResampler();
+/// \}
+
+/// \name Attributes
+/// \{
+public:
+	static const int num_taps = 16;
+	static const int phase_bits = 8;
+	static const int num_phases = 1 << phase_bits;
+	static const int history = num_taps / 2 - 1;
+	static const int lookahead = num_taps / 2;
+
+	SoundResampleQuality get_quality() const { return quality; }
+
+	/// \brief Returns the input samples advanced per output sample, in 32.32 fixed point
+	ubyte64 get_step() const { return step; }
+/// \}
+
+/// \name Operations
+/// \{
+public:
+	void set_quality(SoundResampleQuality quality);
+
+	/// \brief Sets the ratio between the input and output frequencies
+	void set_speed(double speed);
+
+	/// \brief Resamples as much of the input as possible into output[channel][output_offset...]
+	///
+	/// \param position Position of the first output sample in the input. Advanced past the samples produced.
+	/// \return Number of output samples produced, at most count
+	int process(float **input, int num_channels, int input_length, ubyte64 &position, float **output, int output_offset, int count);
+/// \}
+
+/// \name Implementation
+/// \{
+private:
+	void update_kernel();
+
+	void process_copy(const float *input, ubyte64 position, float *output, int count);
+	void process_linear(const float *input, ubyte64 position, float *output, int count);
+	void process_sinc(const float *input, ubyte64 position, float *output, int count);
+
+	SoundResampleQuality quality;
+	double speed;
+	ubyte64 step;
+	std::shared_ptr<SoundResamplerKernel> kernel;
+/// \}
+};
+
+}
@@ -0,0 +1,96 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "soundoutput_null.h"
+#include "API/Core/System/system.h"
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundOutput_Null construction:
+
+SoundOutput_Null::SoundOutput_Null(int mixing_frequency, int mixing_latency, bool real_time, bool start_mixer) :
+	SoundOutput_Impl(mixing_frequency, mixing_latency), frag_size(0), real_time(real_time), start_time(0), fragments_written(0)
+{
+	name = "Null";
+
+	// Fragments of half the latency, a multiple of 4 samples as the SSE mixing functions prefer
+	frag_size = (mixing_frequency * mixing_latency / 2000) & ~3;
+	if (frag_size < 64)
+		frag_size = 64;
+
+	if (start_mixer)
+		start_mixer_thread();
+}
+
+SoundOutput_Null::~SoundOutput_Null()
+{
+	stop_mixer_thread();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundOutput_Null attributes:
+
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundOutput_Null operations:
+
+void SoundOutput_Null::silence()
+{
+}
+
+int SoundOutput_Null::get_fragment_size()
+{
+	return frag_size;
+}
+
+void SoundOutput_Null::write_fragment(float *data)
+{
+	if (fragments_written == 0)
+		start_time = System::get_microseconds();
+	fragments_written++;
+}
+
+void SoundOutput_Null::wait()
+{
+	if (!real_time)
+		return;
+
+	// Wait until the fragments written so far would have been played
+	ubyte64 play_time = fragments_written * frag_size * 1000000 / mixing_frequency;
+	ubyte64 elapsed = System::get_microseconds() - start_time;
+	if (elapsed < play_time)
+		System::sleep((int) ((play_time - elapsed) / 1000));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundOutput_Null implementation:
+
+}
@@ -0,0 +1,102 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "soundoutput_wave_file.h"
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundOutput_WaveFile construction:
+
+SoundOutput_WaveFile::SoundOutput_WaveFile(int mixing_frequency, int mixing_latency, bool real_time, const std::string &filename) :
+	SoundOutput_Null(mixing_frequency, mixing_latency, real_time, false), file(filename, File::create_always, File::access_write), samples_written(0)
+{
+	name = "Wave file";
+	write_header();
+	start_mixer_thread();
+}
+
+SoundOutput_WaveFile::~SoundOutput_WaveFile()
+{
+	stop_mixer_thread();
+
+	// Update the sizes in the header now the length is known
+	file.seek(0);
+	write_header();
+	file.close();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundOutput_WaveFile operations:
+
+void SoundOutput_WaveFile::write_fragment(float *data)
+{
+	SoundOutput_Null::write_fragment(data);
+
+	pcm_buffer.resize(frag_size * 2);
+	for (int i = 0; i < frag_size * 2; i++)
+		pcm_buffer[i] = (short) (data[i] * 32767.0f);
+
+	file.write(&pcm_buffer[0], frag_size * 2 * sizeof(short));
+	samples_written += frag_size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundOutput_WaveFile implementation:
+
+void SoundOutput_WaveFile::write_header()
+{
+	const int num_channels = 2;
+	const int bytes_per_sample = 2;
+	ubyte64 data_size = samples_written * num_channels * bytes_per_sample;
+
+	// RIFF sizes are 32 bit. Samples past the limit are still written, but the header only covers whole samples up to 4 GB
+	const ubyte64 max_data_size = (ubyte64)(0xffffffff - 36) / (num_channels * bytes_per_sample) * (num_channels * bytes_per_sample);
+	if (data_size > max_data_size)
+		data_size = max_data_size;
+
+	file.write("RIFF", 4);
+	file.write_uint32((ubyte32)(36 + data_size));
+	file.write("WAVE", 4);
+
+	file.write("fmt ", 4);
+	file.write_uint32(16);
+	file.write_uint16(1); // PCM
+	file.write_uint16(num_channels);
+	file.write_uint32(mixing_frequency);
+	file.write_uint32(mixing_frequency * num_channels * bytes_per_sample);
+	file.write_uint16(num_channels * bytes_per_sample);
+	file.write_uint16(bytes_per_sample * 8);
+
+	file.write("data", 4);
+	file.write_uint32((ubyte32)data_size);
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "soundoutput_null.h"
+#include "API/Core/IOData/file.h"
+
+namespace clan
+{
+
+/// \brief Sound output writing the mix to a 16 bit stereo wave file
+class SoundOutput_WaveFile : public SoundOutput_Null
+{
+/// \name Construction
+/// \{
+
+public:
+	SoundOutput_WaveFile(int mixing_frequency, int mixing_latency, bool real_time, const std::string &filename);
+
+	~SoundOutput_WaveFile();
+
+
+/// \}
+/// \name Operations
+/// \{
+
+public:
+	/// \brief Writes a fragment to the wave file.
+	virtual void write_fragment(float *data);
+
+
+/// \}
+/// \name Implementation
+/// \{
+
+private:
+	/// \brief Writes the RIFF header for the samples written so far
+	void write_header();
+
+	File file;
+
+	/// \brief Number of stereo samples written to the file
+	ubyte64 samples_written;
+
+	std::vector<short> pcm_buffer;
+/// \}
+};
+
+}
@@ -0,0 +1,159 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_decode_thread.h"
+#include "soundprovider_decode_ahead_session.h"
+#include "API/Sound/soundoutput.h"
+#include <algorithm>
+
+namespace clan
+{
+
+Mutex SoundDecodeThread::instance_mutex;
+std::weak_ptr<SoundDecodeThread> SoundDecodeThread::instance;
+
+std::atomic<int> SoundDecodeThread::decode_chunks(0);
+std::atomic<ubyte64> SoundDecodeThread::total_decode_time(0);
+std::atomic<ubyte64> SoundDecodeThread::max_decode_time(0);
+std::atomic<int> SoundDecodeThread::decode_underruns(0);
+std::atomic<ubyte64> SoundDecodeThread::min_decode_headroom(~(ubyte64)0);
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundDecodeThread construction:
+
+SoundDecodeThread::SoundDecodeThread()
+: stop_event(true, false), wake_event(true, false), wake_pending(false)
+{
+	thread.start(this, &SoundDecodeThread::decode_thread);
+}
+
+SoundDecodeThread::~SoundDecodeThread()
+{
+	stop_event.set();
+	thread.join();
+}
+
+std::shared_ptr<SoundDecodeThread> SoundDecodeThread::get_instance()
+{
+	MutexSection mutex_lock(&instance_mutex);
+	std::shared_ptr<SoundDecodeThread> decode_thread = instance.lock();
+	if (!decode_thread)
+	{
+		decode_thread = std::make_shared<SoundDecodeThread>();
+		instance = decode_thread;
+	}
+	return decode_thread;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundDecodeThread operations:
+
+void SoundDecodeThread::add_session(SoundProvider_DecodeAhead_Session *session)
+{
+	MutexSection mutex_lock(&sessions_mutex);
+	sessions.push_back(session);
+	mutex_lock.unlock();
+	wake();
+}
+
+void SoundDecodeThread::remove_session(SoundProvider_DecodeAhead_Session *session)
+{
+	MutexSection mutex_lock(&sessions_mutex);
+	sessions.erase(std::remove(sessions.begin(), sessions.end(), session), sessions.end());
+}
+
+void SoundDecodeThread::wake()
+{
+	// Only the first wake since the thread started decoding has to signal the event
+	if (!wake_pending.exchange(true))
+		wake_event.set();
+}
+
+void SoundDecodeThread::add_decode_time(ubyte64 decode_time)
+{
+	decode_chunks++;
+	total_decode_time += decode_time;
+	ubyte64 max_time = max_decode_time.load(std::memory_order_relaxed);
+	while (decode_time > max_time && !max_decode_time.compare_exchange_weak(max_time, decode_time, std::memory_order_relaxed))
+	{
+	}
+}
+
+void SoundDecodeThread::add_underrun()
+{
+	decode_underruns++;
+}
+
+void SoundDecodeThread::add_headroom(ubyte64 headroom)
+{
+	ubyte64 min_headroom = min_decode_headroom.load(std::memory_order_relaxed);
+	while (headroom < min_headroom && !min_decode_headroom.compare_exchange_weak(min_headroom, headroom, std::memory_order_relaxed))
+	{
+	}
+}
+
+void SoundDecodeThread::get_statistics(SoundOutputStatistics &statistics)
+{
+	statistics.decode_chunks = decode_chunks;
+	statistics.total_decode_time = total_decode_time;
+	statistics.max_decode_time = max_decode_time;
+	statistics.decode_underruns = decode_underruns;
+	ubyte64 min_headroom = min_decode_headroom;
+	statistics.min_decode_headroom = (min_headroom != ~(ubyte64)0) ? min_headroom : 0;
+}
+
+void SoundDecodeThread::reset_statistics()
+{
+	decode_chunks = 0;
+	total_decode_time = 0;
+	max_decode_time = 0;
+	decode_underruns = 0;
+	min_decode_headroom = ~(ubyte64)0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundDecodeThread implementation:
+
+void SoundDecodeThread::decode_thread()
+{
+	Thread::set_thread_name("clanSound decoder");
+
+	while (Event::wait(stop_event, wake_event) != 0)
+	{
+		// Wakes arriving from here on are handled by the pass below or the next one
+		wake_event.reset();
+		wake_pending = false;
+
+		MutexSection mutex_lock(&sessions_mutex);
+		for (size_t i = 0; i < sessions.size(); i++)
+			sessions[i]->decode_ahead();
+	}
+}
+
+}
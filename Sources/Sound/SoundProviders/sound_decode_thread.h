@@ -0,0 +1,116 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+#include "API/Core/System/thread.h"
+#include "API/Core/System/mutex.h"
+#include "API/Core/System/event.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace clan
+{
+
+class SoundProvider_DecodeAhead_Session;
+class SoundOutputStatistics;
+
+/// \brief Background thread decoding the sessions of streamed sound providers ahead of the mixer
+///
+/// One thread is shared by all decode-ahead sessions. It runs while any of them exists.
+class SoundDecodeThread
+{
+/// \name Construction
+/// \{
+public:
+	SoundDecodeThread();
+	~SoundDecodeThread();
+
+	/// \brief Returns the decode thread, starting it if no session is using it
+	static std::shared_ptr<SoundDecodeThread> get_instance();
+/// \}
+
+/// \name Operations
+/// \{
+public:
+	void add_session(SoundProvider_DecodeAhead_Session *session);
+
+	/// \brief Removes a session. Returns after the decode thread has stopped using it.
+	void remove_session(SoundProvider_DecodeAhead_Session *session);
+
+	/// \brief Makes the thread refill the ring buffers of its sessions
+	void wake();
+
+	/// \brief Records the time spent decoding a chunk, in microseconds
+	static void add_decode_time(ubyte64 decode_time);
+
+	/// \brief Records that the mixer had to decode samples itself
+	static void add_underrun();
+
+	/// \brief Records the amount of audio, in microseconds, decoded ahead when the mixer read from a session
+	static void add_headroom(ubyte64 headroom);
+
+	/// \brief Copies the decode counters into the statistics of a sound output
+	static void get_statistics(SoundOutputStatistics &statistics);
+
+	static void reset_statistics();
+/// \}
+
+/// \name Implementation
+/// \{
+private:
+	SoundDecodeThread(const SoundDecodeThread &);
+	SoundDecodeThread &operator =(const SoundDecodeThread &);
+
+	void decode_thread();
+
+	Thread thread;
+	Event stop_event;
+	Event wake_event;
+
+	/// \brief True when wake_event has been set since the thread last started decoding
+	std::atomic<bool> wake_pending;
+
+	/// \brief Guards sessions. Held while the sessions are decoded.
+	Mutex sessions_mutex;
+	std::vector<SoundProvider_DecodeAhead_Session *> sessions;
+
+	static Mutex instance_mutex;
+	static std::weak_ptr<SoundDecodeThread> instance;
+
+	static std::atomic<int> decode_chunks;
+	static std::atomic<ubyte64> total_decode_time;
+	static std::atomic<ubyte64> max_decode_time;
+	static std::atomic<int> decode_underruns;
+	static std::atomic<ubyte64> min_decode_headroom;
+/// \}
+};
+
+}
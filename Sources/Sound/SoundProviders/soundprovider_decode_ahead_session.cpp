@@ -0,0 +1,250 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "soundprovider_decode_ahead_session.h"
+#include "sound_decode_thread.h"
+#include "API/Core/System/system.h"
+#include "API/Core/Math/cl_math.h"
+#include <algorithm>
+#include <cstring>
+
+namespace clan
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundProvider_DecodeAhead_Session construction:
+
+SoundProvider_DecodeAhead_Session::SoundProvider_DecodeAhead_Session(SoundProvider_Session *session, int decode_ahead)
+: session(session), write_pos(0), read_pos(0), flush_pos(no_flush), decoder_eof(false), position(0)
+{
+	num_channels = session->get_num_channels();
+	frequency = session->get_frequency();
+	position = session->get_position();
+	channel_ptrs.resize(num_channels);
+
+	unsigned int ring_size = 1024;
+	while (ring_size < (unsigned int) decode_ahead && ring_size < (1 << 24))
+		ring_size <<= 1;
+	ring_mask = ring_size - 1;
+	ring.resize(num_channels, std::vector<float>(ring_size));
+
+	decode_thread = SoundDecodeThread::get_instance();
+	decode_thread->add_session(this);
+}
+
+SoundProvider_DecodeAhead_Session::~SoundProvider_DecodeAhead_Session()
+{
+	decode_thread->remove_session(this);
+	delete session;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundProvider_DecodeAhead_Session attributes:
+
+int SoundProvider_DecodeAhead_Session::get_num_samples() const
+{
+	MutexSection mutex_lock(&mutex);
+	return session->get_num_samples();
+}
+
+int SoundProvider_DecodeAhead_Session::get_frequency() const
+{
+	return frequency;
+}
+
+int SoundProvider_DecodeAhead_Session::get_num_channels() const
+{
+	return num_channels;
+}
+
+int SoundProvider_DecodeAhead_Session::get_position() const
+{
+	return position;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundProvider_DecodeAhead_Session operations:
+
+bool SoundProvider_DecodeAhead_Session::set_looping(bool loop)
+{
+	MutexSection mutex_lock(&mutex);
+	return session->set_looping(loop);
+}
+
+bool SoundProvider_DecodeAhead_Session::eof() const
+{
+	return decoder_eof.load(std::memory_order_acquire) && flush_pos.load(std::memory_order_relaxed) == no_flush &&
+		write_pos.load(std::memory_order_relaxed) == read_pos.load(std::memory_order_relaxed);
+}
+
+void SoundProvider_DecodeAhead_Session::stop()
+{
+	MutexSection mutex_lock(&mutex);
+	session->stop();
+}
+
+bool SoundProvider_DecodeAhead_Session::play()
+{
+	MutexSection mutex_lock(&mutex);
+	return session->play();
+}
+
+bool SoundProvider_DecodeAhead_Session::set_position(int pos)
+{
+	MutexSection mutex_lock(&mutex);
+	if (!session->set_position(pos))
+		return false;
+
+	// The decode thread is not writing while the mutex is held, so the samples decoded from here on start at write_pos
+	flush_pos.store(write_pos.load(std::memory_order_relaxed), std::memory_order_release);
+	decoder_eof.store(false, std::memory_order_release);
+	position = pos;
+	mutex_lock.unlock();
+
+	decode_thread->wake();
+	return true;
+}
+
+bool SoundProvider_DecodeAhead_Session::set_end_position(int pos)
+{
+	// Samples already decoded ahead are still played
+	MutexSection mutex_lock(&mutex);
+	return session->set_end_position(pos);
+}
+
+int SoundProvider_DecodeAhead_Session::get_data(float **data_ptr, int data_requested)
+{
+	apply_flush();
+
+	if (!decoder_eof.load(std::memory_order_relaxed))
+	{
+		unsigned int available = write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_relaxed);
+		SoundDecodeThread::add_headroom(available * (ubyte64) 1000000 / frequency);
+	}
+
+	int samples_read = 0;
+	while (samples_read < data_requested)
+	{
+		// Everything the decoder wrote before reaching the end is visible once decoder_eof is
+		bool at_end = decoder_eof.load(std::memory_order_acquire);
+		int samples = read_ring(data_ptr, samples_read, data_requested - samples_read);
+		samples_read += samples;
+		if (samples_read == data_requested || at_end)
+			break;
+		if (samples > 0)
+			continue;
+
+		// The ring buffer ran dry. As the decode thread only writes while holding the mutex, it stays empty while we decode here.
+		MutexSection mutex_lock(&mutex);
+		apply_flush();
+		if (decoder_eof.load(std::memory_order_relaxed) || write_pos.load(std::memory_order_acquire) != read_pos.load(std::memory_order_relaxed))
+			continue;
+
+		for (int i = 0; i < num_channels; i++)
+			channel_ptrs[i] = data_ptr[i] + samples_read;
+		samples = session->get_data(&channel_ptrs[0], data_requested - samples_read);
+		if (session->eof())
+			decoder_eof.store(true, std::memory_order_release);
+		SoundDecodeThread::add_underrun();
+
+		samples_read += samples;
+		position += samples;
+		if (samples == 0)
+			break;
+	}
+
+	return samples_read;
+}
+
+void SoundProvider_DecodeAhead_Session::decode_ahead()
+{
+	unsigned int ring_size = ring_mask + 1;
+	unsigned int chunk_size = min((unsigned int) decode_chunk_size, ring_size / 2);
+	while (true)
+	{
+		// Locked per chunk, so a mixer decoding an underrun waits for one chunk at most
+		MutexSection mutex_lock(&mutex);
+		if (decoder_eof.load(std::memory_order_relaxed))
+			break;
+
+		unsigned int write = write_pos.load(std::memory_order_relaxed);
+		unsigned int space = ring_size - (write - read_pos.load(std::memory_order_acquire));
+		if (space < chunk_size)
+			break;
+
+		unsigned int ring_offset = write & ring_mask;
+		int samples = min(chunk_size, ring_size - ring_offset);
+		for (int i = 0; i < num_channels; i++)
+			channel_ptrs[i] = &ring[i][ring_offset];
+
+		ubyte64 decode_start = System::get_microseconds();
+		samples = session->get_data(&channel_ptrs[0], samples);
+		SoundDecodeThread::add_decode_time(System::get_microseconds() - decode_start);
+
+		write_pos.store(write + samples, std::memory_order_release);
+		if (session->eof())
+			decoder_eof.store(true, std::memory_order_release);
+		else if (samples == 0)
+			break;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SoundProvider_DecodeAhead_Session implementation:
+
+void SoundProvider_DecodeAhead_Session::apply_flush()
+{
+	ubyte64 flush = flush_pos.exchange(no_flush, std::memory_order_acquire);
+	if (flush != no_flush)
+		read_pos.store((unsigned int) flush, std::memory_order_release);
+}
+
+int SoundProvider_DecodeAhead_Session::read_ring(float **data_ptr, int offset, int num_samples)
+{
+	unsigned int read = read_pos.load(std::memory_order_relaxed);
+	unsigned int available = write_pos.load(std::memory_order_acquire) - read;
+	int samples = (int) min(available, (unsigned int) num_samples);
+	if (samples == 0)
+		return 0;
+
+	unsigned int ring_offset = read & ring_mask;
+	int first = min(samples, (int) (ring_mask + 1 - ring_offset));
+	for (int i = 0; i < num_channels; i++)
+	{
+		memcpy(data_ptr[i] + offset, &ring[i][ring_offset], first * sizeof(float));
+		memcpy(data_ptr[i] + offset + first, &ring[i][0], (samples - first) * sizeof(float));
+	}
+
+	read_pos.store(read + samples, std::memory_order_release);
+	position += samples;
+	decode_thread->wake();
+	return samples;
+}
+
+}
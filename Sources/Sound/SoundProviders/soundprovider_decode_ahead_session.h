@@ -0,0 +1,135 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/SoundProviders/soundprovider_session.h"
+#include "API/Core/System/cl_platform.h"
+#include "API/Core/System/mutex.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace clan
+{
+
+class SoundDecodeThread;
+
+/// \brief Session decoding another provider session ahead of the mixer on the sound decode thread
+///
+/// The decoded samples are passed to the mixer through a single producer, single consumer ring buffer.
+/// If the ring buffer runs dry the mixer decodes the missing samples itself.
+class SoundProvider_DecodeAhead_Session : public SoundProvider_Session
+{
+/// \name Construction
+/// \{
+public:
+	/// \brief Takes ownership of the decoding session
+	SoundProvider_DecodeAhead_Session(SoundProvider_Session *session, int decode_ahead);
+	~SoundProvider_DecodeAhead_Session();
+
+	/// \brief Samples decoded ahead by streamed providers unless set_decode_ahead is called
+	static const int default_decode_ahead = 32768;
+/// \}
+
+/// \name Attributes
+/// \{
+public:
+	int get_num_samples() const;
+	int get_frequency() const;
+	int get_num_channels() const;
+	int get_position() const;
+/// \}
+
+/// \name Operations
+/// \{
+public:
+	bool set_looping(bool loop);
+	bool eof() const;
+	void stop();
+	bool play();
+	bool set_position(int pos);
+	bool set_end_position(int pos);
+	int get_data(float **data_ptr, int data_requested);
+
+	/// \brief Fills the ring buffer. Called by the sound decode thread.
+	void decode_ahead();
+/// \}
+
+/// \name Implementation
+/// \{
+private:
+	SoundProvider_DecodeAhead_Session(const SoundProvider_DecodeAhead_Session &);
+	SoundProvider_DecodeAhead_Session &operator =(const SoundProvider_DecodeAhead_Session &);
+
+	/// \brief Moves the read position to a pending flush position. Only called by the mixer.
+	void apply_flush();
+
+	/// \brief Copies up to num_samples decoded samples out of the ring buffer. Only called by the mixer.
+	int read_ring(float **data_ptr, int offset, int num_samples);
+
+	/// \brief Samples decoded by the decode thread per call to the session
+	static const int decode_chunk_size = 4096;
+
+	/// \brief Marks that no flush is pending
+	static const ubyte64 no_flush = ~(ubyte64)0;
+
+	/// \brief The decoding session. Guarded by mutex.
+	SoundProvider_Session *session;
+
+	/// \brief Serializes the decode thread, the mixer and the application in the decoding session
+	mutable Mutex mutex;
+
+	std::shared_ptr<SoundDecodeThread> decode_thread;
+
+	int num_channels;
+	int frequency;
+
+	/// \brief Channel pointers passed to the decoding session. Guarded by mutex.
+	std::vector<float *> channel_ptrs;
+
+	/// \brief Ring buffer per channel. The size is a power of two.
+	std::vector< std::vector<float> > ring;
+	unsigned int ring_mask;
+
+	/// \brief Free running positions in the ring buffer. write_pos is only written by the decoding side, read_pos only by the mixer.
+	std::atomic<unsigned int> write_pos;
+	std::atomic<unsigned int> read_pos;
+
+	/// \brief Write position the mixer skips to after a seek, or no_flush
+	std::atomic<ubyte64> flush_pos;
+
+	/// \brief True when the decoding session has reached its end
+	std::atomic<bool> decoder_eof;
+
+	/// \brief Position of the next sample returned by get_data
+	std::atomic<int> position;
+/// \}
+};
+
+}
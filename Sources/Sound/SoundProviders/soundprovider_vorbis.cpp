@@ -34,6 +34,7 @@
 #include "API/Core/IOData/path_help.h"
 #include "soundprovider_vorbis_impl.h"
 #include "soundprovider_vorbis_session.h"
+#include "soundprovider_decode_ahead_session.h"
 
 namespace clan
 {
@@ -49,6 +50,8 @@ SoundProvider_Vorbis::SoundProvider_Vorbis(
 {
 	IODevice input = fs.open_file(filename, File::open_existing, File::access_read, File::share_all);
 	impl->load(input);
+	if (stream)
+		impl->decode_ahead = SoundProvider_DecodeAhead_Session::default_decode_ahead;
 }
 
 SoundProvider_Vorbis::SoundProvider_Vorbis(
@@ -60,6 +63,8 @@ SoundProvider_Vorbis::SoundProvider_Vorbis(
 	FileSystem vfs(path);
 	IODevice input = vfs.open_file(filename, File::open_existing, File::access_read, File::share_all);
 	impl->load(input);
+	if (stream)
+		impl->decode_ahead = SoundProvider_DecodeAhead_Session::default_decode_ahead;
 }
 
 SoundProvider_Vorbis::SoundProvider_Vorbis(
@@ -67,18 +72,36 @@ SoundProvider_Vorbis::SoundProvider_Vorbis(
 : impl(std::make_shared<SoundProvider_Vorbis_Impl>())
 {
 	impl->load(file);
+	if (stream)
+		impl->decode_ahead = SoundProvider_DecodeAhead_Session::default_decode_ahead;
 }
 
 SoundProvider_Vorbis::~SoundProvider_Vorbis()
 {
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// SoundProvider_Vorbis attributes:
+
+int SoundProvider_Vorbis::get_decode_ahead() const
+{
+	return impl->decode_ahead;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // SoundProvider_Vorbis operations:
 
+void SoundProvider_Vorbis::set_decode_ahead(int samples)
+{
+	impl->decode_ahead = samples;
+}
+
 SoundProvider_Session *SoundProvider_Vorbis::begin_session()
 {
-	return new SoundProvider_Vorbis_Session(*this);
+	SoundProvider_Session *session = new SoundProvider_Vorbis_Session(*this);
+	if (impl->decode_ahead > 0)
+		session = new SoundProvider_DecodeAhead_Session(session, impl->decode_ahead);
+	return session;
 }
 
 void SoundProvider_Vorbis::end_session(SoundProvider_Session *session)
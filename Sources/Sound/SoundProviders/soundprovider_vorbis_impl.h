@@ -40,10 +40,16 @@ class SoundProvider_Vorbis_Impl
 /// \name Attributes
 /// \{
 public:
+	SoundProvider_Vorbis_Impl()
+	: decode_ahead(0)
+	{
+	}
+
 	void load(IODevice &input);
 
 public:
 	DataBuffer buffer;
+	int decode_ahead;
 /// \}
 };
 
@@ -107,6 +107,11 @@ bool SoundProvider_Vorbis_Session::set_position(int pos)
 	handle = 0;
 	stream_byte_offset = 0;
 
+	// The decoded frame belonged to the closed handle
+	pcm = 0;
+	pcm_position = 0;
+	pcm_samples = 0;
+
 	int error = 0;
 	handle = stb_vorbis_open_pushdata(source.impl->buffer.get_data<unsigned char>(), source.impl->buffer.get_size(), &stream_byte_offset, &error, 0);
 	if (handle == 0)
@@ -114,6 +119,7 @@ bool SoundProvider_Vorbis_Session::set_position(int pos)
 
 	stream_info = stb_vorbis_get_info(handle);
 	stream_eof = false;
+	position = 0;
 	return true;
 }
 
@@ -136,6 +142,10 @@ int SoundProvider_Vorbis_Session::get_data(float **channels, int data_requested)
 			}
 		}
 
+		// Nothing more was decoded at the end of the stream
+		if (pcm_position == pcm_samples)
+			break;
+
 		int samples = pcm_samples - pcm_position;
 		if (samples > data_left) samples = data_left;
 
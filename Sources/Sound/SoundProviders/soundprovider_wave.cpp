@@ -37,6 +37,7 @@
 #include "API/Core/Text/logger.h"
 #include "soundprovider_wave_impl.h"
 #include "soundprovider_wave_session.h"
+#include "soundprovider_decode_ahead_session.h"
 
 namespace clan
 {
@@ -51,6 +52,8 @@ SoundProvider_Wave::SoundProvider_Wave(
 {
 	IODevice source = fs.open_file(filename, File::open_existing, File::access_read, File::share_read);
 	impl->load(source);
+	if (stream)
+		impl->decode_ahead = SoundProvider_DecodeAhead_Session::default_decode_ahead;
 }
 
 SoundProvider_Wave::SoundProvider_Wave(
@@ -62,6 +65,8 @@ SoundProvider_Wave::SoundProvider_Wave(
 	FileSystem vfs(path);
 	IODevice input = vfs.open_file(filename, File::open_existing, File::access_read, File::share_all);
 	impl->load(input);
+	if (stream)
+		impl->decode_ahead = SoundProvider_DecodeAhead_Session::default_decode_ahead;
 }
 
 SoundProvider_Wave::SoundProvider_Wave(
@@ -69,18 +74,36 @@ SoundProvider_Wave::SoundProvider_Wave(
 : impl(std::make_shared<SoundProvider_Wave_Impl>())
 {
 	impl->load(file);
+	if (stream)
+		impl->decode_ahead = SoundProvider_DecodeAhead_Session::default_decode_ahead;
 }
 
 SoundProvider_Wave::~SoundProvider_Wave()
 {
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// SoundProvider_Wave attributes:
+
+int SoundProvider_Wave::get_decode_ahead() const
+{
+	return impl->decode_ahead;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // SoundProvider_Wave operations:
 
+void SoundProvider_Wave::set_decode_ahead(int samples)
+{
+	impl->decode_ahead = samples;
+}
+
 SoundProvider_Session *SoundProvider_Wave::begin_session()
 {
-	return new SoundProvider_Wave_Session(*this);
+	SoundProvider_Session *session = new SoundProvider_Wave_Session(*this);
+	if (impl->decode_ahead > 0)
+		session = new SoundProvider_DecodeAhead_Session(session, impl->decode_ahead);
+	return session;
 }
 
 void SoundProvider_Wave::end_session(SoundProvider_Session *session)
@@ -40,7 +40,7 @@ class SoundProvider_Wave_Impl
 {
 public:
 	SoundProvider_Wave_Impl()
-	: data(0)
+	: data(0), decode_ahead(0)
 	{
 	}
 
@@ -60,6 +60,9 @@ public:
 	int num_channels;
 	int num_samples;
 	int frequency;
+
+	/// \brief Samples sessions decode ahead of the mixer, or 0
+	int decode_ahead;
 /// \}
 
 private:
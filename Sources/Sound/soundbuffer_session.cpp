@@ -32,6 +32,7 @@
 #include "API/Sound/soundfilter.h"
 #include "soundbuffer_session_impl.h"
 #include "soundoutput_impl.h"
+#include "Mixer/sound_mixer_command_queue.h"
 
 namespace clan
 {
@@ -44,7 +45,7 @@ SoundBuffer_Session::SoundBuffer_Session()
 }
 
 SoundBuffer_Session::SoundBuffer_Session(SoundBuffer &soundbuffer, bool looping, SoundOutput &output)
-: impl(std::make_shared<SoundBuffer_Session_Impl>(soundbuffer, looping, output))
+: impl(std::make_shared<SoundBuffer_Session_Impl>(soundbuffer, looping, output.impl))
 {
 }
 
@@ -117,6 +118,19 @@ int SoundBuffer_Session::get_frequency() const
 	}
 }
 
+SoundResampleQuality SoundBuffer_Session::get_resample_quality() const
+{
+	if (impl)
+	{
+		MutexSection mutex_lock(&impl->mutex);
+		return impl->resample_quality;
+	}
+	else
+	{
+		return resample_linear;
+	}
+}
+
 float SoundBuffer_Session::get_volume() const
 {
 	if (impl)
@@ -220,22 +234,40 @@ bool SoundBuffer_Session::set_position_relative(float new_pos)
 	}
 }
 
+void SoundBuffer_Session::set_resample_quality(SoundResampleQuality quality)
+{
+	if (impl)
+	{
+		impl->resample_quality = quality;
+		queue_mixer_command(new SoundMixerCommand(SoundMixerCommand::type_set_resample_quality, impl, (float) quality));
+	}
+}
+
 void SoundBuffer_Session::set_volume(float new_volume)
 {
 	if (impl)
+	{
 		impl->volume = new_volume;
+		queue_mixer_command(new SoundMixerCommand(SoundMixerCommand::type_set_volume, impl, new_volume));
+	}
 }
 
 void SoundBuffer_Session::set_frequency(int new_frequency)
 {
 	if (impl)
+	{
 		impl->frequency = new_frequency;
+		queue_mixer_command(new SoundMixerCommand(SoundMixerCommand::type_set_frequency, impl, (float) new_frequency));
+	}
 }
 
 void SoundBuffer_Session::set_pan(float new_pan)
 {
 	if (impl)
+	{
 		impl->pan = new_pan;
+		queue_mixer_command(new SoundMixerCommand(SoundMixerCommand::type_set_pan, impl, new_pan));
+	}
 }
 
 void SoundBuffer_Session::play()
@@ -248,7 +280,7 @@ void SoundBuffer_Session::play()
 		{
 			impl->playing = true;
 			mutex_lock.unlock();
-			impl->output.impl->play_session(*this);
+			queue_mixer_command(new SoundMixerCommand(SoundMixerCommand::type_play, impl));
 		}
 	}
 }
@@ -259,11 +291,10 @@ void SoundBuffer_Session::stop()
 	{
 		MutexSection mutex_lock(&impl->mutex);
 		if (!impl->playing) return;
-		mutex_lock.unlock();
-		impl->output.impl->stop_session(*this);
-		mutex_lock.lock();
 		impl->playing = false;
 		impl->provider_session->stop();
+		mutex_lock.unlock();
+		queue_mixer_command(new SoundMixerCommand(SoundMixerCommand::type_stop, impl));
 	}
 }
 
@@ -283,6 +314,11 @@ void SoundBuffer_Session::add_filter(SoundFilter &filter)
 	{
 		MutexSection mutex_lock(&impl->mutex);
 		impl->filters.push_back(filter);
+		mutex_lock.unlock();
+
+		SoundMixerCommand *command = new SoundMixerCommand(SoundMixerCommand::type_add_filter, impl);
+		command->filter = filter;
+		queue_mixer_command(command);
 	}
 }
 
@@ -298,10 +334,24 @@ void SoundBuffer_Session::remove_filter(SoundFilter &filter)
 				impl->filters.erase(impl->filters.begin()+i);
 			}
 		}
+		mutex_lock.unlock();
+
+		SoundMixerCommand *command = new SoundMixerCommand(SoundMixerCommand::type_remove_filter, impl);
+		command->filter = filter;
+		queue_mixer_command(command);
 	}
 }
 
 /////////////////////////////////////////////////////////////////////////////
 // SoundBuffer_Session implementation:
 
+void SoundBuffer_Session::queue_mixer_command(SoundMixerCommand *command)
+{
+	std::shared_ptr<SoundOutput_Impl> output = impl->output.lock();
+	if (output)
+		output->queue_command(command);
+	else
+		delete command;
+}
+
 }
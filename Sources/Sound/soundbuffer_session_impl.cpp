@@ -35,6 +35,9 @@
 #include "API/Sound/SoundProviders/soundprovider.h"
 #include "API/Sound/SoundProviders/soundprovider_session.h"
 #include "API/Core/Text/logger.h"
+#include "API/Core/Math/cl_math.h"
+#include "Mixer/sound_mixer_command_queue.h"
+#include <algorithm>
 
 namespace clan
 {
@@ -42,22 +45,35 @@ namespace clan
 /////////////////////////////////////////////////////////////////////////////
 //! Construction:
 
-SoundBuffer_Session_Impl::SoundBuffer_Session_Impl(SoundBuffer &soundbuffer, bool looping, SoundOutput &output)
-: soundbuffer(soundbuffer), provider_session(0), output(output), volume(1.0f), pan(0.0f), looping(looping), playing(false)
+SoundBuffer_Session_Impl::SoundBuffer_Session_Impl(SoundBuffer &soundbuffer, bool looping, const std::shared_ptr<SoundOutput_Impl> &output)
+: soundbuffer(soundbuffer), provider_session(0), output(output), volume(1.0f), pan(0.0f), looping(looping), playing(false),
+  resample_quality(resample_linear), mix_active(false)
 {
 	volume = soundbuffer.get_volume();
 	pan = soundbuffer.get_pan();
 	provider_session = soundbuffer.get_provider()->begin_session();
 	provider_session->set_looping(looping);
 	frequency = provider_session->get_frequency();
+	mixing_frequency = output ? output->mixing_frequency : 44100;
+
+	mix_volume = volume;
+	mix_pan = pan;
+	mix_frequency = frequency;
 
 	num_buffer_samples = 16*1024;
 	num_buffer_channels = provider_session->get_num_channels();
-	buffer_position = 0.0;
-	buffer_samples_written = 0;
+
+	// Playback starts after silent resampler history
+	buffer_position = ((ubyte64) SoundResampler::history) << 32;
+	buffer_samples_written = SoundResampler::history;
+	end_padding_added = false;
 
 	float_buffer_data = new float*[num_buffer_channels];
-	for (int i=0; i<num_buffer_channels; i++) float_buffer_data[i] = new float[num_buffer_samples];
+	for (int i=0; i<num_buffer_channels; i++)
+	{
+		float_buffer_data[i] = new float[num_buffer_samples];
+		memset(float_buffer_data[i], 0, SoundResampler::history * sizeof(float));
+	}
 
 	float_buffer_data_offsetted.resize(num_buffer_channels);
 }
@@ -82,11 +98,37 @@ SoundBuffer_Session_Impl::~SoundBuffer_Session_Impl()
 
 bool SoundBuffer_Session_Impl::mix_to(float **sample_data, float **temp_data, int num_samples, int num_channels)
 {
-	MutexSection mutex_lock(&mutex);
-	get_data_in_mixer_frequency(num_samples, temp_data);
+	bool still_playing = get_data_in_mixer_frequency(num_samples, temp_data);
 	run_filters(temp_data, num_samples);
 	mix_channels(num_channels, num_samples, sample_data, temp_data);
-	return playing;
+	return still_playing;
+}
+
+void SoundBuffer_Session_Impl::apply_command(const SoundMixerCommand &command)
+{
+	switch (command.type)
+	{
+	case SoundMixerCommand::type_set_volume:
+		mix_volume = command.value;
+		break;
+	case SoundMixerCommand::type_set_pan:
+		mix_pan = command.value;
+		break;
+	case SoundMixerCommand::type_set_frequency:
+		mix_frequency = command.value;
+		break;
+	case SoundMixerCommand::type_set_resample_quality:
+		resampler.set_quality((SoundResampleQuality) (int) command.value);
+		break;
+	case SoundMixerCommand::type_add_filter:
+		mix_filters.push_back(command.filter);
+		break;
+	case SoundMixerCommand::type_remove_filter:
+		mix_filters.erase(std::remove(mix_filters.begin(), mix_filters.end(), command.filter), mix_filters.end());
+		break;
+	default:
+		break;
+	}
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -94,6 +136,17 @@ bool SoundBuffer_Session_Impl::mix_to(float **sample_data, float **temp_data, in
 
 void SoundBuffer_Session_Impl::get_data()
 {
+	// Move the samples still needed by the resampler to the beginning of the buffers
+	int keep_from = int(buffer_position >> 32) - SoundResampler::history;
+	if (keep_from > 0)
+	{
+		keep_from = min(keep_from, buffer_samples_written);
+		for (int i = 0; i < num_buffer_channels; i++)
+			memmove(float_buffer_data[i], float_buffer_data[i] + keep_from, (buffer_samples_written - keep_from) * sizeof(float));
+		buffer_samples_written -= keep_from;
+		buffer_position -= ((ubyte64) keep_from) << 32;
+	}
+
 	int num_session_channels = provider_session->get_num_channels();
 	if (num_session_channels != num_buffer_channels)
 	{
@@ -104,7 +157,7 @@ void SoundBuffer_Session_Impl::get_data()
 	if (num_session_channels > 0)
 	{
 		// Copy stream data to working buffer:
-		int samples_left = num_buffer_samples;
+		int samples_left = num_buffer_samples - buffer_samples_written;
 		while (samples_left > 0)
 		{
 			for (int i = 0; i < num_session_channels; i++)
@@ -144,39 +197,47 @@ void SoundBuffer_Session_Impl::get_data()
 	}
 }
 
-void SoundBuffer_Session_Impl::get_data_in_mixer_frequency(int num_samples, float **temp_data)
+bool SoundBuffer_Session_Impl::get_data_in_mixer_frequency(int num_samples, float **temp_data)
 {
 	// Convert from session frequency to mixer frequency:
-	// This is done by copying data from the temporary session buffers (buffer_data) to
+	// This is done by resampling data from the temporary session buffers (buffer_data) to
 	// the temporary mixing buffers (temp_data), and if buffer_data is exhausted, calling
 	// get_data() to fill it with new data from the soundprovider session object.
-	double speed = frequency / double(output.get_mixing_frequency());
-	int sample_count;
-	for (sample_count = 0; sample_count < num_samples; sample_count++)
+	resampler.set_speed(mix_frequency / double(mixing_frequency));
+
+	bool still_playing = true;
+	int sample_count = 0;
+	while (sample_count < num_samples)
 	{
-		if (buffer_position < buffer_samples_written)
+		sample_count += resampler.process(float_buffer_data, num_buffer_channels, buffer_samples_written, buffer_position, temp_data, sample_count, num_samples - sample_count);
+		if (sample_count == num_samples)
+			break;
+
+		// Out of data, get more from provider:
+		MutexSection mutex_lock(&mutex);
+
+		// Compacting the buffers moves buffer_position too, so compare the samples ahead of it
+		int samples_available = buffer_samples_written - int(buffer_position >> 32);
+		get_data();
+
+		if (buffer_samples_written - int(buffer_position >> 32) > samples_available)
+		{
+			end_padding_added = false;
+		}
+		else if (!end_padding_added && buffer_samples_written + SoundResampler::lookahead <= num_buffer_samples)
 		{
+			// Play the last samples of the stream by appending the silence the resampler looks ahead at
 			for (int chan = 0; chan < num_buffer_channels; chan++)
-			{
-				temp_data[chan][sample_count] = float_buffer_data[chan][int(buffer_position)];
-			}
+				memset(float_buffer_data[chan] + buffer_samples_written, 0, SoundResampler::lookahead * sizeof(float));
+			buffer_samples_written += SoundResampler::lookahead;
+			end_padding_added = true;
 		}
 		else
 		{
-			if (provider_session->eof())
-			{
-				playing = false;
-				break;
-			}
-
-			// Out of data, get more from provider:
-			buffer_position -= buffer_samples_written;
-			get_data();
-			sample_count--;
-			continue;
+			playing = false;
+			still_playing = false;
+			break;
 		}
-
-		buffer_position += speed;
 	}
 
 	// Clear the remaining samples (if any)
@@ -187,24 +248,28 @@ void SoundBuffer_Session_Impl::get_data_in_mixer_frequency(int num_samples, floa
 			temp_data[chan][sample_count] = 0.0f;
 		}
 	}
+
+	return still_playing;
 }
 
 void SoundBuffer_Session_Impl::run_filters(float **temp_data, int num_samples)
 {
-	for (std::vector<SoundFilter *>::size_type index_filter = 0; index_filter < filters.size(); index_filter++)
+	for (std::vector<SoundFilter>::size_type index_filter = 0; index_filter < mix_filters.size(); index_filter++)
 	{
-		filters[index_filter].filter(temp_data, num_samples, num_buffer_channels);
+		mix_filters[index_filter].filter(temp_data, num_samples, num_buffer_channels);
 	}
 }
 
 void SoundBuffer_Session_Impl::get_channel_volume(float *channel_volume)
 {
-	float left_pan = 1-pan;
-	float right_pan = 1+pan;
+	float left_pan = 1-mix_pan;
+	float right_pan = 1+mix_pan;
 	if (left_pan < 0.0f) left_pan = 0.0f;
 	if (left_pan > 1.0f) left_pan = 1.0f;
 	if (right_pan < 0.0f) right_pan = 0.0f;
 	if (right_pan > 1.0f) right_pan = 1.0f;
+
+	float volume = mix_volume;
 	if (volume < 0.0f) volume = 0.0f;
 	if (volume > 1.0f) volume = 1.0f;
 
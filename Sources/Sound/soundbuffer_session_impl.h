@@ -33,6 +33,7 @@
 #include "API/Sound/soundformat.h"
 #include "API/Sound/soundoutput.h"
 #include "API/Sound/soundbuffer.h"
+#include "Mixer/sound_resampler.h"
 #include <memory>
 
 namespace clan
@@ -42,6 +43,7 @@ class SoundFilter;
 class SoundBuffer_Impl;
 class SoundProvider_Session;
 class SoundOutput_Impl;
+class SoundMixerCommand;
 
 class SoundBuffer_Session_Impl
 {
@@ -52,7 +54,7 @@ public:
 	SoundBuffer_Session_Impl(
 		SoundBuffer &soundbuffer,
 		bool looping,
-		SoundOutput &output);
+		const std::shared_ptr<SoundOutput_Impl> &output);
 
 	virtual ~SoundBuffer_Session_Impl();
 
@@ -64,23 +66,46 @@ public:
 public:
 	SoundBuffer soundbuffer;
 	SoundProvider_Session *provider_session;
-	SoundOutput output;
+	/// \brief Output mixing the session. Weak, as the output keeps its playing sessions alive.
+	std::weak_ptr<SoundOutput_Impl> output;
 	float volume;
 	float frequency;
 	float pan;
 	bool looping;
 	bool playing;
 	std::vector<SoundFilter> filters;
+	SoundResampleQuality resample_quality;
+
+	/// \brief Guards the provider session and the settings above
 	mutable Mutex mutex;
 
+	/// \brief Mixing frequency of the output
+	int mixing_frequency;
+
+	/// \brief Settings used by the mixer thread, updated by the commands SoundBuffer_Session queues
+	float mix_volume;
+	float mix_frequency;
+	float mix_pan;
+	std::vector<SoundFilter> mix_filters;
+	SoundResampler resampler;
+
+	/// \brief True while the session is in the list of sessions mixed by SoundOutput_Impl
+	bool mix_active;
+
 
 /// \}
 /// \name Operations
 /// \{
 
 public:
+	/// \brief Mixes the next num_samples samples into sample_data. Returns false when the session has stopped playing.
+	///
+	/// Called by the mixer thread or its workers. Sessions can be mixed in parallel with each other.
 	bool mix_to(float **sample_data, float **temp_data, int num_samples, int num_channels);
 
+	/// \brief Applies a settings command on the mixer thread
+	void apply_command(const SoundMixerCommand &command);
+
 /// \}
 /// \name Implementation
 /// \{
@@ -92,8 +117,8 @@ private:
 	/// \brief Returns the volume of left and right channel
 	void get_channel_volume(float *out_volume);
 
-	/// \brief Reads data into temp_data in the mixers native frequency
-	void get_data_in_mixer_frequency( int num_samples, float **temp_data );
+	/// \brief Reads data into temp_data in the mixers native frequency. Returns false at the end of the data.
+	bool get_data_in_mixer_frequency( int num_samples, float **temp_data );
 
 	/// \brief Runs the sample data through attached filters
 	void run_filters( float ** temp_data, int num_samples );
@@ -102,6 +127,8 @@ private:
 	void get_data();
 
 	/// \brief Temporary channel buffers containing sound data in provider frequency.
+	///
+	/// The resampler history before buffer_position is kept when the buffers are refilled.
 	float **float_buffer_data;
 
 	std::vector<float*> float_buffer_data_offsetted;
@@ -112,11 +139,14 @@ private:
 	/// \brief Number of temporary channel buffers;
 	int num_buffer_channels;
 
-	/// \brief Current playback position in temporary buffers.
-	double buffer_position;
+	/// \brief Current playback position in temporary buffers, in 32.32 fixed point.
+	ubyte64 buffer_position;
 
 	/// \brief Number of samples currently written to buffer_data.
 	int buffer_samples_written;
+
+	/// \brief True when silence has been appended after the end of the provider data.
+	bool end_padding_added;
 /// \}
 };
 
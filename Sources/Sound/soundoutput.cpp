@@ -33,6 +33,9 @@
 #include "API/Sound/sound.h"
 #include "API/Core/System/thread.h"
 #include "soundoutput_impl.h"
+#include "Null/soundoutput_null.h"
+#include "Null/soundoutput_wave_file.h"
+#include "SoundProviders/sound_decode_thread.h"
 
 #ifdef WIN32
 #include "Win32/soundoutput_win32.h"
@@ -69,46 +72,59 @@ SoundOutput::SoundOutput(int mixing_frequency, int latency)
 
 SoundOutput::SoundOutput(const SoundOutput_Description &desc)
 {
-#ifdef WIN32
-	try
+	if (desc.get_device() == sound_output_device_null)
 	{
-		std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_Win32>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
-		impl = soundoutput_impl;
+		impl = std::make_shared<SoundOutput_Null>(desc.get_mixing_frequency(), desc.get_mixing_latency(), desc.is_real_time());
 	}
-	catch (...)
+	else if (desc.get_device() == sound_output_device_wave_file)
 	{
-		std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_DirectSound>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
-		impl = soundoutput_impl;
+		impl = std::make_shared<SoundOutput_WaveFile>(desc.get_mixing_frequency(), desc.get_mixing_latency(), desc.is_real_time(), desc.get_filename());
 	}
+	else
+	{
+#ifdef WIN32
+		try
+		{
+			std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_Win32>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
+			impl = soundoutput_impl;
+		}
+		catch (...)
+		{
+			std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_DirectSound>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
+			impl = soundoutput_impl;
+		}
 #else
 #ifdef __APPLE__
-	std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_MacOSX>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
-	impl = soundoutput_impl;
+		std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_MacOSX>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
+		impl = soundoutput_impl;
 #else
 #if defined(__linux__) && defined(HAVE_ALSA_ASOUNDLIB_H)
-	// Try building ALSA
+		// Try building ALSA
 
-	std::shared_ptr<SoundOutput_Impl> alsa_impl(std::make_shared<SoundOutput_alsa>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
-	if ( ( (SoundOutput_alsa *) (alsa_impl.get()))->handle)
-	{
-		impl = alsa_impl;
-	}
-	else
-	{
-		alsa_impl.reset();
-	}
+		std::shared_ptr<SoundOutput_Impl> alsa_impl(std::make_shared<SoundOutput_alsa>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
+		if ( ( (SoundOutput_alsa *) (alsa_impl.get()))->handle)
+		{
+			impl = alsa_impl;
+		}
+		else
+		{
+			alsa_impl.reset();
+		}
 
-	if (!impl)
-	{
+		if (!impl)
+		{
+			std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_OSS>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
+			impl = soundoutput_impl;
+		}
+#else
 		std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_OSS>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
 		impl = soundoutput_impl;
-	}
-#else
-    std::shared_ptr<SoundOutput_Impl> soundoutput_impl(std::make_shared<SoundOutput_OSS>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
-    impl = soundoutput_impl;
 #endif
 #endif
 #endif
+	}
+
+	impl->set_mixing_threads(desc.get_mixing_threads());
 	Sound::select_output(*this);
 }
 
@@ -159,6 +175,16 @@ float SoundOutput::get_global_pan() const
 	return impl->pan;
 }
 
+SoundOutputStatistics SoundOutput::get_statistics() const
+{
+	MutexSection mutex_lock(&impl->mutex);
+	SoundOutputStatistics statistics = impl->statistics;
+	mutex_lock.unlock();
+
+	SoundDecodeThread::get_statistics(statistics);
+	return statistics;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // SoundOutput operations:
 
@@ -209,6 +235,20 @@ void SoundOutput::remove_filter(SoundFilter &filter)
 	}
 }
 
+void SoundOutput::reset_statistics()
+{
+	if (impl)
+	{
+		MutexSection mutex_lock(&impl->mutex);
+		int fragment_size = impl->statistics.fragment_size;
+		impl->statistics = SoundOutputStatistics();
+		impl->statistics.fragment_size = fragment_size;
+		mutex_lock.unlock();
+
+		SoundDecodeThread::reset_statistics();
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // SoundOutput implementation:
 
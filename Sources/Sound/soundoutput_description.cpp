@@ -42,6 +42,14 @@ public:
 	int mixing_frequency;
 
 	int mixing_latency;
+
+	SoundOutputDevice device;
+
+	int mixing_threads;
+
+	std::string filename;
+
+	bool real_time;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -51,6 +59,9 @@ SoundOutput_Description::SoundOutput_Description() : impl(std::make_shared<Sound
 {
 	impl->mixing_frequency = 44100;
 	impl->mixing_latency = 50;
+	impl->device = sound_output_device_default;
+	impl->mixing_threads = 0;
+	impl->real_time = false;
 }
 
 SoundOutput_Description::~SoundOutput_Description()
@@ -70,6 +81,26 @@ int SoundOutput_Description::get_mixing_latency() const
 	return impl->mixing_latency;
 }
 
+SoundOutputDevice SoundOutput_Description::get_device() const
+{
+	return impl->device;
+}
+
+int SoundOutput_Description::get_mixing_threads() const
+{
+	return impl->mixing_threads;
+}
+
+const std::string &SoundOutput_Description::get_filename() const
+{
+	return impl->filename;
+}
+
+bool SoundOutput_Description::is_real_time() const
+{
+	return impl->real_time;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // SoundOutput_Description operations:
 
@@ -83,6 +114,26 @@ void SoundOutput_Description::set_mixing_latency(int latency)
 	impl->mixing_latency = latency;
 }
 
+void SoundOutput_Description::set_device(SoundOutputDevice device)
+{
+	impl->device = device;
+}
+
+void SoundOutput_Description::set_mixing_threads(int num_threads)
+{
+	impl->mixing_threads = num_threads;
+}
+
+void SoundOutput_Description::set_filename(const std::string &filename)
+{
+	impl->filename = filename;
+}
+
+void SoundOutput_Description::set_real_time(bool enable)
+{
+	impl->real_time = enable;
+}
+
 // SoundOutput_Description implementation:
 /////////////////////////////////////////////////////////////////////////////
 
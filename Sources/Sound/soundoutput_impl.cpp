@@ -31,7 +31,10 @@
 #include "soundbuffer_session_impl.h"
 #include "API/Sound/soundfilter.h"
 #include <algorithm>
+#include <map>
 #include "API/Sound/sound_sse.h"
+#include "API/Core/Math/cl_math.h"
+#include "API/Core/System/system.h"
 
 namespace clan
 {
@@ -39,12 +42,31 @@ namespace clan
 Mutex SoundOutput_Impl::singleton_mutex;
 SoundOutput_Impl *SoundOutput_Impl::instance = 0;
 
+/////////////////////////////////////////////////////////////////////////////
+// SoundOutput_MixChunk construction:
+
+SoundOutput_MixChunk::SoundOutput_MixChunk(int buffer_size)
+{
+	mix_buffers[0] = (float *) SoundSSE::aligned_alloc(sizeof(float) * buffer_size);
+	mix_buffers[1] = (float *) SoundSSE::aligned_alloc(sizeof(float) * buffer_size);
+	temp_buffers[0] = (float *) SoundSSE::aligned_alloc(sizeof(float) * buffer_size);
+	temp_buffers[1] = (float *) SoundSSE::aligned_alloc(sizeof(float) * buffer_size);
+}
+
+SoundOutput_MixChunk::~SoundOutput_MixChunk()
+{
+	SoundSSE::aligned_free(mix_buffers[0]);
+	SoundSSE::aligned_free(mix_buffers[1]);
+	SoundSSE::aligned_free(temp_buffers[0]);
+	SoundSSE::aligned_free(temp_buffers[1]);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // SoundOutput_Impl construction:
 
 SoundOutput_Impl::SoundOutput_Impl(int mixing_frequency, int latency)
 : mixing_frequency(mixing_frequency), mixing_latency(latency), volume(1.0f),
-  pan(0.0f), mix_buffer_size(0)
+  pan(0.0f), mixing_threads(0), mix_buffer_size(0)
 {
  	mix_buffers[0] = 0;
 	mix_buffers[1] = 0;
@@ -78,24 +100,15 @@ SoundOutput_Impl::~SoundOutput_Impl()
 /////////////////////////////////////////////////////////////////////////////
 // SoundOutput_Impl operations:
 
-void SoundOutput_Impl::play_session(SoundBuffer_Session &session)
+void SoundOutput_Impl::queue_command(SoundMixerCommand *command)
 {
-	MutexSection mutex_lock(&mutex);
-	sessions.push_back(session);
+	command_queue.push(command);
 }
 
-void SoundOutput_Impl::stop_session(SoundBuffer_Session &session)
+void SoundOutput_Impl::set_mixing_threads(int num_threads)
 {
 	MutexSection mutex_lock(&mutex);
-
-	for (std::vector<SoundBuffer_Session>::iterator it = sessions.begin(); it != sessions.end(); ++it)
-	{
-		if (session.impl.get() == it->impl.get())
-		{
-			sessions.erase(it);
-			break;
-		}
-	}
+	mixing_threads = num_threads;
 }
 
 void SoundOutput_Impl::start_mixer_thread()
@@ -134,7 +147,9 @@ void SoundOutput_Impl::mixer_thread()
 	while (if_continue_mixing())
 	{
 		// Mix some audio:
+		ubyte64 mix_start = System::get_microseconds();
 		mix_fragment();
+		update_statistics(System::get_microseconds() - mix_start);
 
 		// Send mixed data to sound card:
 		write_fragment(stereo_buffer);
@@ -142,6 +157,9 @@ void SoundOutput_Impl::mixer_thread()
 		// Wait for sound card to want more:
 		wait();
 	}
+
+	// The work queue belongs to the thread that created it
+	work_queue.reset();
     
     mixer_thread_stopping();
 }
@@ -155,6 +173,17 @@ bool SoundOutput_Impl::if_continue_mixing()
 		return true;
 }
 
+void SoundOutput_Impl::update_statistics(ubyte64 mix_time)
+{
+	MutexSection mutex_lock(&mutex);
+	statistics.fragment_size = mix_buffer_size;
+	statistics.fragments_mixed++;
+	statistics.total_mix_time += mix_time;
+	statistics.max_mix_time = max(statistics.max_mix_time, mix_time);
+	if (mix_time * mixing_frequency > (ubyte64) mix_buffer_size * 1000000)
+		statistics.late_fragments++;
+}
+
 void SoundOutput_Impl::resize_mix_buffers()
 {
 	if (get_fragment_size() != mix_buffer_size)
@@ -169,6 +198,8 @@ void SoundOutput_Impl::resize_mix_buffers()
 		//if (mix_buffer_size & 3)
 		//	throw Exception("Fragment size must be a multiple of 4");
 
+		mix_chunks.clear();
+
 		mix_buffers[0] = (float *) SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size );
 		mix_buffers[1] = (float *) SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size );
 		temp_buffers[0] = (float *) SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size );
@@ -185,21 +216,159 @@ void SoundOutput_Impl::clear_mix_buffers()
 	SoundSSE::set_float(mix_buffers[1], mix_buffer_size, 0.0f);
 }
 
+void SoundOutput_Impl::process_commands()
+{
+	SoundMixerCommand *command = command_queue.pop_all();
+	while (command)
+	{
+		SoundBuffer_Session_Impl *session = command->session.get();
+		if (command->type == SoundMixerCommand::type_play)
+		{
+			if (!session->mix_active)
+			{
+				session->mix_active = true;
+				sessions.push_back(command->session);
+			}
+		}
+		else if (command->type == SoundMixerCommand::type_stop)
+		{
+			if (session->mix_active)
+			{
+				session->mix_active = false;
+				sessions.erase(std::find(sessions.begin(), sessions.end(), command->session));
+			}
+		}
+		else
+		{
+			session->apply_command(*command);
+		}
+
+		SoundMixerCommand *next = command->next;
+		delete command;
+		command = next;
+	}
+}
+
 void SoundOutput_Impl::fill_mix_buffers()
 {
+	process_commands();
+
+	int num_sessions = sessions.size();
+	sessions_playing.resize(num_sessions);
+
 	MutexSection mutex_lock(&mutex);
-	std::vector< SoundBuffer_Session > ended_sessions;
-	std::vector< SoundBuffer_Session >::iterator it;
-	for (it = sessions.begin(); it != sessions.end(); ++it)
+	bool parallel = num_sessions > sessions_per_chunk && mixing_threads != 1;
+	if (parallel && !work_queue)
+		work_queue.reset(new WorkQueue(false, mixing_threads - 1));
+	mutex_lock.unlock();
+
+	if (parallel)
+	{
+		// Each chunk of sessions is mixed into its own buffers on the worker threads. The chunks
+		// are then added together in order, so the result does not depend on thread scheduling.
+		int num_chunks = assign_mix_chunks();
+		work_queue->parallel_for(0, num_chunks, [this](int begin, int end)
+		{
+			for (int chunk_index = begin; chunk_index < end; chunk_index++)
+				mix_chunk(chunk_index);
+		}, 1);
+
+		for (int chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+		{
+			SoundSSE::mix_one_to_one(mix_chunks[chunk_index]->mix_buffers[0], mix_buffer_size, mix_buffers[0], 1.0f);
+			SoundSSE::mix_one_to_one(mix_chunks[chunk_index]->mix_buffers[1], mix_buffer_size, mix_buffers[1], 1.0f);
+		}
+	}
+	else
 	{
-		SoundBuffer_Session session = *it;
-		bool playing = session.impl->mix_to(mix_buffers, temp_buffers, mix_buffer_size, 2);
-		if (!playing) ended_sessions.push_back(session);
+		for (int i = 0; i < num_sessions; i++)
+			sessions_playing[i] = sessions[i]->mix_to(mix_buffers, temp_buffers, mix_buffer_size, 2);
 	}
 
-	// Release any sessions pending for removal:
-	int size_ended_sessions = ended_sessions.size();
-	for (int i = 0; i < size_ended_sessions; i++) stop_session(ended_sessions[i]);
+	// Release any sessions that ended:
+	int num_playing = 0;
+	for (int i = 0; i < num_sessions; i++)
+	{
+		if (sessions_playing[i])
+			sessions[num_playing++] = sessions[i];
+		else
+			sessions[i]->mix_active = false;
+	}
+	sessions.resize(num_playing);
+}
+
+int SoundOutput_Impl::assign_mix_chunks()
+{
+	int num_sessions = sessions.size();
+	session_groups.resize(num_sessions);
+	session_group_chunks.resize(num_sessions);
+	for (int i = 0; i < num_sessions; i++)
+		session_groups[i] = i;
+
+	// Join the groups of sessions sharing a filter. The first session of a group is always its root.
+	std::map<SoundFilter_Impl *, int> filter_sessions;
+	for (int i = 0; i < num_sessions; i++)
+	{
+		std::vector<SoundFilter> &session_filters = sessions[i]->mix_filters;
+		for (size_t j = 0; j < session_filters.size(); j++)
+		{
+			std::map<SoundFilter_Impl *, int>::iterator it = filter_sessions.find(session_filters[j].impl.get());
+			if (it == filter_sessions.end())
+			{
+				filter_sessions[session_filters[j].impl.get()] = i;
+			}
+			else
+			{
+				int group1 = find_session_group(it->second);
+				int group2 = find_session_group(i);
+				if (group1 != group2)
+					session_groups[max(group1, group2)] = min(group1, group2);
+			}
+		}
+	}
+
+	// Fill the chunks in session order, placing all sessions of a group in the chunk of its first session
+	int num_chunks = 0;
+	for (int i = 0; i < num_sessions; i++)
+	{
+		int group = find_session_group(i);
+		if (group == i)
+		{
+			if (num_chunks == 0 || (int)mix_chunks[num_chunks - 1]->sessions.size() >= sessions_per_chunk)
+			{
+				if ((int)mix_chunks.size() == num_chunks)
+					mix_chunks.push_back(std::unique_ptr<SoundOutput_MixChunk>(new SoundOutput_MixChunk(mix_buffer_size)));
+				mix_chunks[num_chunks]->sessions.clear();
+				num_chunks++;
+			}
+			session_group_chunks[i] = num_chunks - 1;
+		}
+		mix_chunks[session_group_chunks[group]]->sessions.push_back(i);
+	}
+	return num_chunks;
+}
+
+int SoundOutput_Impl::find_session_group(int session_index)
+{
+	while (session_groups[session_index] != session_index)
+	{
+		session_groups[session_index] = session_groups[session_groups[session_index]];
+		session_index = session_groups[session_index];
+	}
+	return session_index;
+}
+
+void SoundOutput_Impl::mix_chunk(int chunk_index)
+{
+	SoundOutput_MixChunk *chunk = mix_chunks[chunk_index].get();
+	SoundSSE::set_float(chunk->mix_buffers[0], mix_buffer_size, 0.0f);
+	SoundSSE::set_float(chunk->mix_buffers[1], mix_buffer_size, 0.0f);
+
+	for (size_t j = 0; j < chunk->sessions.size(); j++)
+	{
+		int i = chunk->sessions[j];
+		sessions_playing[i] = sessions[i]->mix_to(chunk->mix_buffers, chunk->temp_buffers, mix_buffer_size, 2);
+	}
 }
 
 void SoundOutput_Impl::filter_mix_buffers()
@@ -238,11 +407,9 @@ void SoundOutput_Impl::clamp_mix_buffers()
 	// Make sure values stay inside 16 bit range:
 	for (int chan = 0; chan < 2; chan++)
 	{
+		float *buffer = mix_buffers[chan];
 		for (int k=0; k<mix_buffer_size; k++)
-		{
-			if      (mix_buffers[chan][k] > 1.0f)  mix_buffers[chan][k] = 1.0f;
-			else if (mix_buffers[chan][k] < -1.0f) mix_buffers[chan][k] = -1.0f;
-		}
+			buffer[k] = max(-1.0f, min(buffer[k], 1.0f));
 	}
 }
 
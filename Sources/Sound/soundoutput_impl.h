@@ -33,6 +33,9 @@
 #include "API/Core/System/thread.h"
 #include "API/Core/System/mutex.h"
 #include "API/Core/System/event.h"
+#include "API/Core/System/work_queue.h"
+#include "API/Sound/soundoutput.h"
+#include "Mixer/sound_mixer_command_queue.h"
 #include <memory>
 
 namespace clan
@@ -42,6 +45,24 @@ class SoundFilter;
 class SoundBuffer_Session_Impl;
 class SoundBuffer_Session;
 
+/// \brief Buffers a group of sessions is mixed into before being added to the final mix
+class SoundOutput_MixChunk
+{
+public:
+	SoundOutput_MixChunk(int buffer_size);
+	~SoundOutput_MixChunk();
+
+	float *mix_buffers[2];
+	float *temp_buffers[2];
+
+	/// \brief Indexes of the sessions mixed into this chunk
+	std::vector<int> sessions;
+
+private:
+	SoundOutput_MixChunk(const SoundOutput_MixChunk &);
+	SoundOutput_MixChunk &operator =(const SoundOutput_MixChunk &);
+};
+
 class SoundOutput_Impl
 {
 /// \name Construction
@@ -74,10 +95,20 @@ public:
 
 	Event stop_mixer;
 
-	std::vector< SoundBuffer_Session > sessions;
+	/// \brief Sessions being mixed. Only accessed by the mixer thread.
+	std::vector< std::shared_ptr<SoundBuffer_Session_Impl> > sessions;
+
+	/// \brief Changes to the sessions, applied by the mixer thread before each fragment
+	SoundMixerCommandQueue command_queue;
 
 	mutable Mutex mutex;
 
+	/// \brief Number of threads sessions are mixed on. 0 = based on the number of cores.
+	int mixing_threads;
+
+	/// \brief Timing counters updated by the mixer thread
+	SoundOutputStatistics statistics;
+
 	int mix_buffer_size;
 
 	float *mix_buffers[2];
@@ -86,16 +117,19 @@ public:
 
 	float *stereo_buffer;
 
+	/// \brief Maximum number of sessions mixed by one worker thread task
+	static const int sessions_per_chunk = 16;
+
 
 /// \}
 /// \name Operations
 /// \{
 
 public:
+	/// \brief Queues a session change for the mixer thread. Takes ownership of the command.
+	void queue_command(SoundMixerCommand *command);
 
-	void play_session(SoundBuffer_Session &session);
-
-	void stop_session(SoundBuffer_Session &session);
+	void set_mixing_threads(int num_threads);
 
 protected:
 	/// \brief Called when we have no samples to play - and wants to tell the soundcard
@@ -137,15 +171,32 @@ private:
 	/// \brief Returns true if the mixer thread should continue mixing fragments
 	bool if_continue_mixing();
 
+	/// \brief Adds the time spent mixing a fragment to the statistics
+	void update_statistics(ubyte64 mix_time);
+
 	/// \brief Ensures the mixing buffers match the fragment size
 	void resize_mix_buffers();
 
 	/// \brief Clears the content of the mixing buffers
 	void clear_mix_buffers();
 
+	/// \brief Applies the queued session changes
+	void process_commands();
+
 	/// \brief Mixes soundbuffer sessions into the mixing buffers
 	void fill_mix_buffers();
 
+	/// \brief Distributes the sessions on the mixing chunks and returns the number of chunks used
+	///
+	/// Sessions sharing a filter are always placed in the same chunk, as filters keep state between calls and are not thread safe.
+	int assign_mix_chunks();
+
+	/// \brief Returns the first session of the group the session belongs to
+	int find_session_group(int session_index);
+
+	/// \brief Mixes the sessions of a chunk into the buffers of the chunk
+	void mix_chunk(int chunk_index);
+
 	/// \brief Applies filters to the mixing buffers
 	void filter_mix_buffers();
 
@@ -155,6 +206,21 @@ private:
 	/// \brief Clamp mixing buffer values to the -1 to 1 range
 	void clamp_mix_buffers();
 
+	/// \brief Mixing buffers for each group of about sessions_per_chunk sessions
+	std::vector< std::unique_ptr<SoundOutput_MixChunk> > mix_chunks;
+
+	/// \brief Links each session to an earlier session sharing a filter with it, or to itself
+	std::vector<int> session_groups;
+
+	/// \brief Chunk of each session group, indexed by the first session of the group
+	std::vector<int> session_group_chunks;
+
+	/// \brief False for sessions that ended while mixing the current fragment
+	std::vector<char> sessions_playing;
+
+	/// \brief Worker threads mixing chunks. Created and destroyed by the mixer thread.
+	std::unique_ptr<WorkQueue> work_queue;
+
 	static Mutex singleton_mutex;
 	static SoundOutput_Impl *instance;
 /// \}
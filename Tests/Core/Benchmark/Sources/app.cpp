@@ -141,6 +141,12 @@ int App::start(const std::vector<std::string> &args)
 			}
 		}
 
+		for (unsigned int cnt=0; cnt<work_queue_results.size(); cnt++)
+		{
+			font.draw_text(canvas, 10, ypos, clan::string_format("WorkQueue with %1 threads: %2 jobs/sec", work_queue_results[cnt].num_threads, clan::StringHelp::float_to_text(work_queue_results[cnt].jobs_per_second, 0)));
+			ypos += ygap;
+		}
+
 		cb_main.invoke();
 
 		// This call processes user input and other events
@@ -254,7 +260,15 @@ void App::test()
 	testlist[testlist_offset].result = result + 0.05;	// Round up
 	testlist_offset++;
 	if (testlist_offset >= testlist.size())
-		cb_main.set(this, &App::write_result);
+		cb_main.set(this, &App::test_work_queue);
+}
+
+void App::test_work_queue()
+{
+	draw_info("* Running - WorkQueue jobs/sec *");
+
+	work_queue_results = WorkQueueBenchmark::run_all(target_test_run_length_seconds);
+	cb_main.set(this, &App::write_result);
 }
 
 void App::write_result()
@@ -288,6 +302,15 @@ void App::write_result()
 		}
 	}
 
+	output+= newline;
+
+	output += "WorkQueue Threads : Jobs/sec" + newline;
+
+	for (unsigned int cnt=0; cnt<work_queue_results.size(); cnt++)
+	{
+		output += clan::string_format("%1 : %2", work_queue_results[cnt].num_threads, clan::StringHelp::float_to_text(work_queue_results[cnt].jobs_per_second, 0)) + newline;
+	}
+
 	clan::File::write_text("results.txt", output);
 
 	cb_main.set(this, &App::initialise_1);
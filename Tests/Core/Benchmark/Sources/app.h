@@ -29,6 +29,7 @@
 #pragma once
 
 #include "tests.h"
+#include "work_queue_benchmark.h"
 
 // This is the Application class (That is instantiated by the Program Class)
 class App
@@ -44,6 +45,7 @@ private:
 	void initialise_2();
 	void write_result();
 	void test();
+	void test_work_queue();
 	void draw_info(const std::string &text);
 	clan::byte64 run_test();
 	clan::ubyte64 get_start_time() const;
@@ -60,6 +62,7 @@ private:
 	clan::ubyte64 base_line;
 	int testlist_offset;
 	std::vector<TestInfo> testlist;
+	std::vector<WorkQueueBenchmarkResult> work_queue_results;
 	clan::ubyte64 tests_run_length_microseconds;
 	float target_test_run_length_seconds;
 	std::string priority_class;
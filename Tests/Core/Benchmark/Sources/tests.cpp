@@ -77,6 +77,10 @@ void Tests::Init(std::vector<TestInfo> &testlist)
 	testlist.push_back(TestInfo("{string = utils.function();}    : std::string function() {return \"hello world\";}", &Tests::test_return_string_v3));
 	testlist.push_back(TestInfo("{utils.function(string);}    : void function(std::string &out_string) {out_string = string_hello_world;}", &Tests::test_get_string));
 
+	testlist.push_back(TestInfo("{signal(int_seven);}    : 1 slot", &Tests::test_signal_1_slot));
+	testlist.push_back(TestInfo("{signal(int_seven);}    : 8 slots", &Tests::test_signal_8_slots));
+	testlist.push_back(TestInfo("{signal(int_seven);}    : 64 slots", &Tests::test_signal_64_slots));
+
 }
 
 Tests::Tests()
@@ -94,6 +98,12 @@ Tests::Tests()
 	*int_shared_ptr = 123;
 
 	std_vector_int_size16.resize(16, 0);
+
+	signal_slots.push_back(signal_1_slot.connect(this, &Tests::on_signal));
+	for (int cnt=0; cnt<8; cnt++)
+		signal_slots.push_back(signal_8_slots.connect(this, &Tests::on_signal));
+	for (int cnt=0; cnt<64; cnt++)
+		signal_slots.push_back(signal_64_slots.connect(this, &Tests::on_signal));
 }
 
 void Tests::test_empty()
@@ -290,3 +300,23 @@ void Tests::test_get_string()
 {
 	utils.test_get_string(string);
 }
+
+void Tests::test_signal_1_slot()
+{
+	signal_1_slot(int_seven);
+}
+
+void Tests::test_signal_8_slots()
+{
+	signal_8_slots(int_seven);
+}
+
+void Tests::test_signal_64_slots()
+{
+	signal_64_slots(int_seven);
+}
+
+void Tests::on_signal(int value)
+{
+	int_value += value;
+}
@@ -93,6 +93,11 @@ public:
 	void test_return_string_v2();
 	void test_return_string_v3();
 	void test_get_string();
+	void test_signal_1_slot();
+	void test_signal_8_slots();
+	void test_signal_64_slots();
+
+	void on_signal(int value);
 
 	Utils utils;
 	std::string string;
@@ -111,4 +116,8 @@ public:
 	int *int_ptr;
 	std::shared_ptr<int> int_shared_ptr;
 	std::vector<int> std_vector_int_size16;
+	clan::Signal<void(int)> signal_1_slot;
+	clan::Signal<void(int)> signal_8_slots;
+	clan::Signal<void(int)> signal_64_slots;
+	std::vector<clan::Slot> signal_slots;
 };
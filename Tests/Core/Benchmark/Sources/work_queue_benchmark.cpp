@@ -0,0 +1,75 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    Mark Page
+*/
+
+#include "precomp.h"
+#include "work_queue_benchmark.h"
+
+std::vector<WorkQueueBenchmarkResult> WorkQueueBenchmark::run_all(float seconds_per_run)
+{
+	std::vector<WorkQueueBenchmarkResult> results;
+	int num_cores = clan::System::get_num_cores();
+	for (int num_threads = 1; num_threads <= num_cores; num_threads++)
+	{
+		results.push_back(WorkQueueBenchmarkResult(num_threads, run(num_threads, seconds_per_run)));
+	}
+	return results;
+}
+
+double WorkQueueBenchmark::run(int num_threads, float seconds)
+{
+	clan::WorkQueue work_queue(false, num_threads);
+
+	// Warm up the worker threads before timing anything
+	work_queue.parallel_for(0, jobs_per_batch, [](int begin, int end) { for (int i = begin; i < end; i++) job(i); }, 1);
+
+	clan::ubyte64 run_length_microseconds = (clan::ubyte64) (((double) seconds) * 1000000.0);
+	clan::ubyte64 num_jobs = 0;
+	clan::ubyte64 start_time = clan::System::get_microseconds();
+	clan::ubyte64 current_time = start_time;
+	while (current_time - start_time < run_length_microseconds)
+	{
+		clan::WorkGroup group(work_queue);
+		for (int i = 0; i < jobs_per_batch; i++)
+			group.run([i]() { job(i); });
+		group.wait();
+
+		num_jobs += jobs_per_batch;
+		current_time = clan::System::get_microseconds();
+	}
+
+	return (double)num_jobs * 1000000.0 / (double)(current_time - start_time);
+}
+
+void WorkQueueBenchmark::job(int index)
+{
+	// A few hundred nanoseconds of work, similar to a small per object update in a frame
+	volatile float value = (float)index;
+	for (int cnt = 0; cnt < job_iterations; cnt++)
+		value = value * 0.999f + 1.0f;
+}
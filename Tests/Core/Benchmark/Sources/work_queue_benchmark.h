@@ -0,0 +1,53 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    Mark Page
+*/
+
+#pragma once
+
+class WorkQueueBenchmarkResult
+{
+public:
+	WorkQueueBenchmarkResult(int num_threads, double jobs_per_second) : num_threads(num_threads), jobs_per_second(jobs_per_second) { }
+
+	int num_threads;
+	double jobs_per_second;
+};
+
+// Measures how many small jobs per second clan::WorkQueue completes for a given number of worker threads
+class WorkQueueBenchmark
+{
+public:
+	static std::vector<WorkQueueBenchmarkResult> run_all(float seconds_per_run);
+	static double run(int num_threads, float seconds);
+
+private:
+	static void job(int index);
+
+	static const int jobs_per_batch = 1024;
+	static const int job_iterations = 200;
+};
@@ -72,6 +72,7 @@ int TestApp::main(const std::vector<std::string> &args)
 		test_aes128();
 		test_aes192();
 		test_aes256();
+		test_aes_ctr();
 		test_sha1();
 		test_sha224();
 		test_sha256();
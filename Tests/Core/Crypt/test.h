@@ -69,6 +69,8 @@ private:
 	void test_aes192_helper(const char *key_ptr, const char *iv_ptr, const char *plaintext_ptr, const char *ciphertext_ptr);
 	void test_aes256();
 	void test_aes256_helper(const char *key_ptr, const char *iv_ptr, const char *plaintext_ptr, const char *ciphertext_ptr);
+	void test_aes_ctr();
+	void test_aes_ctr_helper(const char *key_ptr, const char *iv_ptr, const char *plaintext_ptr, const char *ciphertext_ptr);
 	void convert_ascii(const char *src, std::vector<unsigned char> &dest);
 
 	void test_rsa();
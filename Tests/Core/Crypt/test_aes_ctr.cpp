@@ -0,0 +1,160 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_aes_ctr()
+{
+	Console::write_line(" Header: aes_ctr.h");
+	Console::write_line("  Class: AES_CTR");
+
+	// Test data from http://csrc.nist.gov/publications/nistpubs/800-38a/sp800-38a.pdf (F.5.1, F.5.3 and F.5.5)
+
+	const char *plaintext =
+		"6bc1bee22e409f96e93d7e117393172a"
+		"ae2d8a571e03ac9c9eb76fac45af8e51"
+		"30c81c46a35ce411e5fbc1191a0a52ef"
+		"f69f2445df4f9b17ad2b417be66c3710";
+
+	test_aes_ctr_helper(
+		"2b7e151628aed2a6abf7158809cf4f3c",	// KEY
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",	// COUNTER
+		plaintext,
+		"874d6191b620e3261bef6864990db6ce"	// CIPHERTEXT
+		"9806f66b7970fdff8617187bb9fffdff"
+		"5ae4df3edbd5d35e5b4f09020db03eab"
+		"1e031dda2fbe03d1792170a0f3009cee"
+		);
+
+	test_aes_ctr_helper(
+		"8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",	// KEY
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",	// COUNTER
+		plaintext,
+		"1abc932417521ca24f2b0459fe7e6e0b"	// CIPHERTEXT
+		"090339ec0aa6faefd5ccc2c6f4ce8e94"
+		"1e36b26bd1ebc670d1bd1d665620abf7"
+		"4f78a7f6d29809585a97daec58c6b050"
+		);
+
+	test_aes_ctr_helper(
+		"603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",	// KEY
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",	// COUNTER
+		plaintext,
+		"601ec313775789a5b7a7f504bbf3d228"	// CIPHERTEXT
+		"f443e3ca4d62b59aca84e990cacaf5c5"
+		"2b0930daa23de94ce87017ba2d84988d"
+		"dfc9c58db67aada613c2dd08457941a6"
+		);
+
+	// The counter must carry over the full 128 bits
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> counter;
+	convert_ascii("2b7e151628aed2a6abf7158809cf4f3c", key);
+	convert_ascii("00000000000000ffffffffffffffffff", counter);
+
+	const int test_data_length = 256;
+	unsigned char test_data[test_data_length];
+	for (int cnt = 0; cnt < test_data_length; cnt++)
+		test_data[cnt] = (unsigned char) cnt;
+
+	AES_CTR aes_ctr;
+	aes_ctr.set_iv(&counter[0]);
+	aes_ctr.set_key(&key[0], key.size());
+	aes_ctr.add(test_data, test_data_length);
+	aes_ctr.calculate();
+	DataBuffer bulk = aes_ctr.get_data();
+
+	// Encrypt block by block with AES128_Encrypt (CBC with a zero IV is a single block encryption)
+	unsigned char zero_iv[16] = { 0 };
+	for (int block = 0; block < test_data_length / 16; block++)
+	{
+		AES128_Encrypt aes128_encrypt;
+		aes128_encrypt.set_padding(false);
+		aes128_encrypt.set_iv(zero_iv);
+		aes128_encrypt.set_key(&key[0]);
+		aes128_encrypt.add(&counter[0], 16);
+		aes128_encrypt.calculate();
+		DataBuffer key_stream = aes128_encrypt.get_data();
+		for (int cnt = 0; cnt < 16; cnt++)
+		{
+			if ((unsigned char) bulk.get_data()[block * 16 + cnt] != (test_data[block * 16 + cnt] ^ (unsigned char) key_stream.get_data()[cnt]))
+				fail();
+		}
+
+		for (int cnt = 15; cnt >= 0; cnt--)
+		{
+			if (++counter[cnt])
+				break;
+		}
+	}
+}
+
+void TestApp::test_aes_ctr_helper(const char *key_ptr, const char *iv_ptr, const char *plaintext_ptr, const char *ciphertext_ptr)
+{
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> iv;
+	std::vector<unsigned char> plaintext;
+	std::vector<unsigned char> ciphertext;
+
+	convert_ascii(key_ptr, key);
+	convert_ascii(iv_ptr, iv);
+	convert_ascii(plaintext_ptr, plaintext);
+	convert_ascii(ciphertext_ptr, ciphertext);
+
+	// Add the data in two parts, split at every position, to test the partial blocks
+	for (unsigned int split = 0; split <= plaintext.size(); split++)
+	{
+		AES_CTR aes_encrypt;
+		aes_encrypt.set_iv(&iv[0]);
+		aes_encrypt.set_key(&key[0], key.size());
+		aes_encrypt.add(&plaintext[0], split);
+		aes_encrypt.add(&plaintext[split], plaintext.size() - split);
+		aes_encrypt.calculate();
+
+		DataBuffer data = aes_encrypt.get_data();
+		if (data.get_size() != ciphertext.size())
+			fail();
+		if (memcmp(data.get_data(), &ciphertext[0], ciphertext.size()))
+			fail();
+
+		AES_CTR aes_decrypt;
+		aes_decrypt.set_iv(&iv[0]);
+		aes_decrypt.set_key(&key[0], key.size());
+		aes_decrypt.add(&ciphertext[0], ciphertext.size() - split);
+		aes_decrypt.add(&ciphertext[ciphertext.size() - split], split);
+		aes_decrypt.calculate();
+
+		data = aes_decrypt.get_data();
+		if (data.get_size() != plaintext.size())
+			fail();
+		if (memcmp(data.get_data(), &plaintext[0], plaintext.size()))
+			fail();
+	}
+}
+
@@ -73,13 +73,14 @@ public:
 
 	void create_keypair()
 	{
-		RSA::create_keypair(m_Random, m_private_exponent, m_public_exponent, m_modulus);
+		RSA::create_keypair(m_Random, m_private_exponent, m_public_exponent, m_modulus, m_prime1, m_prime2);
 	}
 
 	void set_crypt_key(const DataBuffer &public_key)
 	{
 		m_WrappedCryptKey = public_key;
 		m_CryptKey = RSA::decrypt(m_private_exponent, m_modulus, public_key);
+		m_CryptKeyCRT = RSA::decrypt(m_private_exponent, m_prime1, m_prime2, m_modulus, public_key);
 	}
 
 	TestApp *m_pTestApp;
@@ -87,10 +88,13 @@ public:
 
 	DataBuffer m_WrappedCryptKey;
 	Secret m_CryptKey;
+	Secret m_CryptKeyCRT;
 
 	Secret m_private_exponent;
 	DataBuffer m_public_exponent;
 	DataBuffer m_modulus;
+	Secret m_prime1;
+	Secret m_prime2;
 };
 
 void TestApp::test_rsa()
@@ -118,6 +122,24 @@ void TestApp::test_rsa()
 	if (memcmp(server.m_CryptKey.get_data(), client.m_CryptKey.get_data(), server.m_CryptKey.get_size()))
 		fail();
 
+	Console::write_line("   ... Running Test (CRT)");
+
+	if (server.m_CryptKey.get_size() != client.m_CryptKeyCRT.get_size() )
+		fail();
+	if (memcmp(server.m_CryptKey.get_data(), client.m_CryptKeyCRT.get_data(), server.m_CryptKey.get_size()))
+		fail();
+
+	Secret signed_data(20);
+	client.m_Random.get_random_bytes(signed_data.get_data(), signed_data.get_size());
+	DataBuffer signature = RSA::sign(client.m_private_exponent, client.m_prime1, client.m_prime2, client.m_modulus, signed_data);
+	Secret public_exponent(client.m_public_exponent.get_size());
+	memcpy(public_exponent.get_data(), client.m_public_exponent.get_data(), public_exponent.get_size());
+	Secret verified_data = RSA::decrypt(public_exponent, client.m_modulus, signature);
+	if (verified_data.get_size() != signed_data.get_size() )
+		fail();
+	if (memcmp(verified_data.get_data(), signed_data.get_data(), signed_data.get_size()))
+		fail();
+
 }
 
 
@@ -52,6 +52,14 @@ void TestApp::test_sha1()
 	sha1.calculate();
 	test_hash(sha1, "84983E441C3BD26EBAAE4AA1F95129E5E54670F1");
 
+	// One million repetitions of "a", added in pieces that are not a multiple of the block size
+	char test_str2[1000];
+	memset(test_str2, 'a', 1000);
+	for (int cnt = 0; cnt < 1000; cnt++)
+		sha1.add(test_str2, 1000);
+	sha1.calculate();
+	test_hash(sha1, "34AA973CD4C4DAA4F61EEB2BDBAD27316534016F");
+
 	// Using wikipedia http://en.wikipedia.org/wiki/Hmac test data
 	char *test_str9a = "";
 	char *test_str9b = "";
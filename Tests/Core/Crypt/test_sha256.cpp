@@ -52,6 +52,14 @@ void TestApp::test_sha256()
 	sha256.calculate();
 	test_hash(sha256, "248D6A61D20638B8E5C026930C3E6039A33CE45964FF2167F6ECEDD419DB06C1");
 
+	// One million repetitions of "a", added in pieces that are not a multiple of the block size
+	char test_str2[1000];
+	memset(test_str2, 'a', 1000);
+	for (int cnt = 0; cnt < 1000; cnt++)
+		sha256.add(test_str2, 1000);
+	sha256.calculate();
+	test_hash(sha256, "CDC76E5C9914FB9281A1C7E284D73E67F1809A48A497200E046D39CCC7112CD0");
+
 
 	// Using wikipedia http://en.wikipedia.org/wiki/Hmac test data
 	char *test_str9a = "";
@@ -67,6 +75,61 @@ void TestApp::test_sha256()
 	sha256.add(test_str10b, strlen(test_str10b));
 	sha256.calculate();
 	test_hash(sha256, "F7BC83F430538424B13298E6AA6FB143EF4D59A14946175997479DBC2D1A3CD8");
+
+	// Hashing several messages at once must match hashing them one at a time
+	const int num_messages = 37;
+	std::vector<unsigned char> message_data(num_messages * 300);
+	for (size_t cnt = 0; cnt < message_data.size(); cnt++)
+		message_data[cnt] = (unsigned char) (cnt * 7 + (cnt >> 8));
+
+	const void *messages[num_messages];
+	int message_sizes[num_messages];
+	for (int cnt = 0; cnt < num_messages; cnt++)
+	{
+		messages[cnt] = &message_data[cnt * 300];
+		message_sizes[cnt] = (cnt * 53) % 300;
+	}
+	message_sizes[5] = 55;	// Largest size with a single padding block
+	message_sizes[6] = 56;	// Smallest size that needs two padding blocks
+	message_sizes[7] = 64;
+	message_sizes[8] = 0;
+
+	unsigned char multiple_hashes[num_messages * SHA256::hash_size];
+	SHA256::hash_multiple(num_messages, messages, message_sizes, multiple_hashes);
+
+	for (int cnt = 0; cnt < num_messages; cnt++)
+	{
+		sha256.add(messages[cnt], message_sizes[cnt]);
+		sha256.calculate();
+		unsigned char out_hash[SHA256::hash_size];
+		sha256.get_hash(out_hash);
+		if (memcmp(out_hash, multiple_hashes + cnt * SHA256::hash_size, SHA256::hash_size))
+			fail();
+	}
+
+	// The AVX2 lanes are not used by hash_multiple on CPUs with the SHA instructions, so test them directly
+	if (SHA256::is_avx2_supported())
+	{
+		Console::write_line("   Function: hash_multiple_avx2()");
+		for (int count = 0; count <= num_messages; count++)
+		{
+			memset(multiple_hashes, 0, sizeof(multiple_hashes));
+			SHA256::hash_multiple_avx2(count, messages, message_sizes, multiple_hashes);
+			for (int cnt = 0; cnt < count; cnt++)
+			{
+				sha256.add(messages[cnt], message_sizes[cnt]);
+				sha256.calculate();
+				unsigned char out_hash[SHA256::hash_size];
+				sha256.get_hash(out_hash);
+				if (memcmp(out_hash, multiple_hashes + cnt * SHA256::hash_size, SHA256::hash_size))
+					fail();
+			}
+		}
+	}
+	else
+	{
+		Console::write_line("   Function: hash_multiple_avx2() skipped, AVX2 is not available");
+	}
 }
 
 
@@ -52,6 +52,14 @@ void TestApp::test_sha512()
 	sha512.calculate();
 	test_hash(sha512, "8E959B75DAE313DA8CF4F72814FC143F8F7779C6EB9F7FA17299AEADB6889018501D289E4900F7E4331B99DEC4B5433AC7D329EEB6DD26545E96E55B874BE909");
 
+	// One million repetitions of "a", added in pieces that are not a multiple of the block size
+	char test_str2[1000];
+	memset(test_str2, 'a', 1000);
+	for (int cnt = 0; cnt < 1000; cnt++)
+		sha512.add(test_str2, 1000);
+	sha512.calculate();
+	test_hash(sha512, "E718483D0CE769644E2E42C7BC15B4638E1F98B13B2044285632A803AFA973EBDE0FF244877EA60A4CB0432CE577C31BEB009C5C2C49AA2E4EADB217AD8CC09B");
+
 
 	// Using wikipedia http://en.wikipedia.org/wiki/Hmac test data
 	char *test_str9a = "";
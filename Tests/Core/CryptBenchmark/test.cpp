@@ -0,0 +1,258 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+
+// Measures SHA-1, SHA-256 and SHA-512 hashing throughput in MB/s, both for a
+// single large buffer and for many small independent messages (the SHA-256
+// multi-buffer API), then AES throughput in MB/s for CBC encryption, CBC
+// decryption and CTR mode with each key size, then RSA private key operations (signing) per second,
+// with the plain private exponent and with the CRT form using the primes of the
+// key, and public key operations (verifying) per second, for 2048 and 4096 bit keys.
+//
+// Usage: cryptbenchmark [seconds per measurement]
+
+#include <ClanLib/core.h>
+#include <cstdlib>
+
+using namespace clan;
+
+// Runs func repeatedly for about the given time and returns the operations per second
+template<typename Func>
+double measure(double seconds, Func func)
+{
+	ubyte64 start_time = System::get_microseconds();
+	ubyte64 end_time = start_time + (ubyte64)(seconds * 1000000.0);
+	ubyte64 time;
+	int count = 0;
+	do
+	{
+		func();
+		count++;
+		time = System::get_microseconds();
+	} while (time < end_time);
+	return count * 1000000.0 / max(time - start_time, (ubyte64)1);
+}
+
+template<typename Hash>
+void run_hash(const std::string &name, double seconds, const DataBuffer &data)
+{
+	Hash hash;
+	double rate = measure(seconds, [&]()
+	{
+		hash.add(data);
+		hash.calculate();
+	});
+
+	Console::write_line("%1: %2 MB/s", name, StringHelp::float_to_text(rate * data.get_size() / (1024.0 * 1024.0), 1));
+}
+
+void run_sha256_messages(double seconds, const DataBuffer &data, int message_size)
+{
+	// Many small independent messages, like the records of a TLS connection
+	const int num_messages = 64;
+	const void *messages[num_messages];
+	int message_sizes[num_messages];
+	for (int cnt = 0; cnt < num_messages; cnt++)
+	{
+		messages[cnt] = data.get_data() + cnt * message_size;
+		message_sizes[cnt] = message_size;
+	}
+
+	unsigned char hashes[num_messages * SHA256::hash_size];
+	double single_rate = measure(seconds, [&]()
+	{
+		SHA256 sha256;
+		for (int cnt = 0; cnt < num_messages; cnt++)
+		{
+			sha256.add(messages[cnt], message_sizes[cnt]);
+			sha256.calculate();
+			sha256.get_hash(hashes + cnt * SHA256::hash_size);
+		}
+	});
+
+	unsigned char multiple_hashes[num_messages * SHA256::hash_size];
+	double multiple_rate = measure(seconds, [&]()
+	{
+		SHA256::hash_multiple(num_messages, messages, message_sizes, multiple_hashes);
+	});
+
+	if (memcmp(hashes, multiple_hashes, sizeof(hashes)))
+		throw Exception("SHA-256 hash_multiple differs from hashing each message");
+
+	double bytes = num_messages * (double) message_size / (1024.0 * 1024.0);
+	Console::write_line("SHA-256 %1 byte messages: one at a time %2 MB/s, hash_multiple %3 MB/s",
+		message_size,
+		StringHelp::float_to_text(single_rate * bytes, 1),
+		StringHelp::float_to_text(multiple_rate * bytes, 1));
+}
+
+void run_sha(double seconds)
+{
+	Random random;
+
+	DataBuffer data(1024 * 1024);
+	random.get_random_bytes((unsigned char *) data.get_data(), data.get_size());
+
+	run_hash<SHA1>("SHA-1", seconds, data);
+	run_hash<SHA256>("SHA-256", seconds, data);
+	run_hash<SHA512>("SHA-512", seconds, data);
+	run_sha256_messages(seconds, data, 64);
+	run_sha256_messages(seconds, data, 1024);
+	run_sha256_messages(seconds, data, 16384);
+}
+
+template<typename Encrypt, typename Decrypt>
+void run_aes_cbc(const std::string &name, double seconds, const DataBuffer &data, const unsigned char *key, const unsigned char *iv)
+{
+	Encrypt encrypt;
+	DataBuffer cipher;
+	double encrypt_rate = measure(seconds, [&]()
+	{
+		encrypt.set_iv(iv);
+		encrypt.set_key(key);
+		encrypt.add(data);
+		encrypt.calculate();
+		cipher = encrypt.get_data();
+	});
+
+	Decrypt decrypt;
+	double decrypt_rate = measure(seconds, [&]()
+	{
+		decrypt.set_iv(iv);
+		decrypt.set_key(key);
+		decrypt.add(cipher);
+		decrypt.calculate();
+	});
+
+	DataBuffer plain = decrypt.get_data();
+	if (plain.get_size() != data.get_size() || memcmp(plain.get_data(), data.get_data(), data.get_size()))
+		throw Exception(name + " decryption did not return the original data");
+
+	Console::write_line("%1 CBC: encrypt %2 MB/s, decrypt %3 MB/s",
+		name,
+		StringHelp::float_to_text(encrypt_rate * data.get_size() / (1024.0 * 1024.0), 1),
+		StringHelp::float_to_text(decrypt_rate * data.get_size() / (1024.0 * 1024.0), 1));
+}
+
+void run_aes_ctr(const std::string &name, double seconds, const DataBuffer &data, const unsigned char *key, int key_size, const unsigned char *iv)
+{
+	AES_CTR ctr;
+	double rate = measure(seconds, [&]()
+	{
+		ctr.set_iv(iv);
+		ctr.set_key(key, key_size);
+		ctr.add(data);
+		ctr.calculate();
+	});
+
+	Console::write_line("%1 CTR: %2 MB/s", name, StringHelp::float_to_text(rate * data.get_size() / (1024.0 * 1024.0), 1));
+}
+
+void run_aes(double seconds)
+{
+	Random random;
+
+	unsigned char key[32];
+	unsigned char iv[16];
+	random.get_random_bytes(key, sizeof(key));
+	random.get_random_bytes(iv, sizeof(iv));
+
+	DataBuffer data(1024 * 1024);
+	random.get_random_bytes((unsigned char *) data.get_data(), data.get_size());
+
+	run_aes_cbc<AES128_Encrypt, AES128_Decrypt>("AES-128", seconds, data, key, iv);
+	run_aes_ctr("AES-128", seconds, data, key, 16, iv);
+	run_aes_cbc<AES192_Encrypt, AES192_Decrypt>("AES-192", seconds, data, key, iv);
+	run_aes_ctr("AES-192", seconds, data, key, 24, iv);
+	run_aes_cbc<AES256_Encrypt, AES256_Decrypt>("AES-256", seconds, data, key, iv);
+	run_aes_ctr("AES-256", seconds, data, key, 32, iv);
+}
+
+void run_rsa(int key_size_in_bits, double seconds)
+{
+	Random random;
+
+	Secret private_exponent, prime1, prime2;
+	DataBuffer public_exponent, modulus;
+
+	ubyte64 start_time = System::get_microseconds();
+	RSA::create_keypair(random, private_exponent, public_exponent, modulus, prime1, prime2, key_size_in_bits);
+	ubyte64 keygen_time = System::get_microseconds() - start_time;
+
+	// Pretend digest to sign
+	Secret digest(32);
+	random.get_random_bytes(digest.get_data(), digest.get_size());
+
+	// Signing with block type 1 and the private exponent in place of the public one is the non-CRT path
+	DataBuffer private_exponent_buffer(private_exponent.get_data(), private_exponent.get_size());
+	Secret public_exponent_secret(public_exponent.get_size());
+	memcpy(public_exponent_secret.get_data(), public_exponent.get_data(), public_exponent.get_size());
+
+	DataBuffer signature = RSA::encrypt(1, random, private_exponent_buffer, modulus, digest);
+	DataBuffer signature_crt = RSA::sign(private_exponent, prime1, prime2, modulus, digest);
+	if (signature.get_size() != signature_crt.get_size() || memcmp(signature.get_data(), signature_crt.get_data(), signature.get_size()))
+		throw Exception("CRT signature differs from the plain signature");
+
+	Secret verified = RSA::decrypt(public_exponent_secret, modulus, signature_crt);
+	if (verified.get_size() != digest.get_size() || memcmp(verified.get_data(), digest.get_data(), digest.get_size()))
+		throw Exception("Signature did not verify");
+
+	double sign_rate = measure(seconds, [&]() { RSA::encrypt(1, random, private_exponent_buffer, modulus, digest); });
+	double sign_crt_rate = measure(seconds, [&]() { RSA::sign(private_exponent, prime1, prime2, modulus, digest); });
+	double verify_rate = measure(seconds, [&]() { RSA::decrypt(public_exponent_secret, modulus, signature_crt); });
+
+	Console::write_line("RSA %1 bit: key generation %2 ms, sign %3 ops/s, sign (CRT) %4 ops/s, verify %5 ops/s",
+		key_size_in_bits,
+		StringHelp::float_to_text(keygen_time / 1000.0, 0),
+		StringHelp::float_to_text(sign_rate, 1),
+		StringHelp::float_to_text(sign_crt_rate, 1),
+		StringHelp::float_to_text(verify_rate, 0));
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+
+	try
+	{
+		run_sha(seconds);
+		run_aes(seconds);
+		run_rsa(2048, seconds);
+		run_rsa(4096, seconds);
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,173 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+// Compares Event::wait, which hands all handles to the OS on every call, with an
+// EventWaitSet that registers them once. For each event count it measures how many
+// waits per second complete when the last event is flagged, and the latency from
+// Event::set on one thread until a waiting thread wakes up.
+//
+// Usage: eventwaitbenchmark [iterations]
+
+#include <ClanLib/core.h>
+#include <cstdlib>
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace clan;
+
+class Waiter
+{
+public:
+	Waiter(std::vector<Event> &events, bool use_wait_set)
+	: events(events), use_wait_set(use_wait_set), stop(false), wake_time(0), reply_event(false, false)
+	{
+	}
+
+	void thread_main()
+	{
+		EventWaitSet wait_set;
+		if (use_wait_set)
+		{
+			for (auto &event : events)
+				wait_set.add(event);
+		}
+
+		while (true)
+		{
+			int index = use_wait_set ? wait_set.wait() : Event::wait(events);
+			wake_time = System::get_microseconds();
+			if (stop)
+				break;
+			if (index != (int)events.size() - 1)
+				throw Exception("Waiter woke up on the wrong event");
+			events[index].reset();
+			reply_event.set();
+		}
+	}
+
+	std::vector<Event> &events;
+	bool use_wait_set;
+	volatile bool stop;
+	volatile ubyte64 wake_time;
+	Event reply_event;
+};
+
+void measure_waits(std::vector<Event> &events, bool use_wait_set, int iterations, double &out_waits_per_second)
+{
+	EventWaitSet wait_set;
+	if (use_wait_set)
+	{
+		for (auto &event : events)
+			wait_set.add(event);
+	}
+
+	events.back().set();
+	ubyte64 start_time = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		int index = use_wait_set ? wait_set.wait(0) : Event::wait(events, 0);
+		if (index != (int)events.size() - 1)
+			throw Exception("Wait returned the wrong event");
+	}
+	ubyte64 time = System::get_microseconds() - start_time;
+	events.back().reset();
+
+	out_waits_per_second = iterations * 1000000.0 / max(time, (ubyte64)1);
+}
+
+void measure_latency(std::vector<Event> &events, bool use_wait_set, int iterations, double &out_latency)
+{
+	Waiter waiter(events, use_wait_set);
+	Thread thread;
+	thread.start(&waiter, &Waiter::thread_main);
+
+	ubyte64 total_time = 0;
+	for (int i = 0; i < iterations; i++)
+	{
+		ubyte64 set_time = System::get_microseconds();
+		events.back().set();
+		waiter.reply_event.wait();
+		total_time += waiter.wake_time - set_time;
+	}
+
+	waiter.stop = true;
+	events.back().set();
+	thread.join();
+	events.back().reset();
+
+	out_latency = total_time / (double)iterations;
+}
+
+void benchmark(int num_events, int iterations)
+{
+	std::vector<Event> events;
+	for (int i = 0; i < num_events; i++)
+		events.push_back(Event());
+
+	double select_waits, set_waits, select_latency, set_latency;
+	measure_waits(events, false, iterations, select_waits);
+	measure_waits(events, true, iterations, set_waits);
+	measure_latency(events, false, iterations / 10, select_latency);
+	measure_latency(events, true, iterations / 10, set_latency);
+
+	Console::write_line("%1 events:", num_events);
+	Console::write_line("    Event::wait:  %1 waits/s, %2 us wake-up latency", StringHelp::float_to_text(select_waits, 0), StringHelp::float_to_text(select_latency, 1));
+	Console::write_line("    EventWaitSet: %1 waits/s, %2 us wake-up latency", StringHelp::float_to_text(set_waits, 0), StringHelp::float_to_text(set_latency, 1));
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int iterations = (argc > 1) ? atoi(argv[1]) : 10000;
+
+#ifndef WIN32
+	// Every event is a descriptor, so 5000 events need more than the usual default limit
+	rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+#endif
+
+	try
+	{
+		benchmark(10, iterations);
+		benchmark(5000, iterations);
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include <ClanLib/core.h>
+
+using namespace clan;
+
+void check(bool condition, const char *message)
+{
+	if (!condition)
+		throw Exception(string_format("Test failed: %1", message));
+}
+
+void test_member_references()
+{
+	JsonValue root = JsonValue::object();
+	for (int i = 0; i < 2000; i++)
+		root["k" + StringHelp::int_to_text(i)] = JsonValue::string("value " + StringHelp::int_to_text(i));
+
+	// Adding members in front of a held member must not move it
+	JsonValue &held = root["k1000"];
+	for (int i = 0; i < 2000; i++)
+		root["a" + StringHelp::int_to_text(i)] = JsonValue::number(i);
+	check(held.is_string() && held.to_string() == "value 1000", "reference held across inserts");
+
+	// Both sides stay valid whichever of them inserts a member first
+	root["b"] = JsonValue::string("b");
+	root["a"] = root["b"];
+	check(root["a"].to_string() == "b", "assignment between members");
+	root["c"] = root["c0"];
+	check(root["c"].is_null(), "assignment from new member");
+
+	// Erased members are reused without disturbing the remaining ones
+	JsonValue &k5 = root["k5"];
+	root.get_members().erase("k4");
+	root.get_members().erase("k6");
+	root["k4x"] = JsonValue::string("reused");
+	check(k5.to_string() == "value 5", "reference held across erase");
+	check(root.get_members().count("k4") == 0 && root["k4x"].to_string() == "reused", "erase and insert");
+	check(root.get_members().size() == 2000 + 2000 + 4 - 2 + 1, "member count");
+}
+
+void test_member_order()
+{
+	JsonValue root = JsonValue::from_json("{\"d\":1, \"b\":2, \"a\":3, \"c\":4, \"b\":5}");
+	std::string names;
+	for (const auto &member : root.get_members())
+		names += member.first;
+	check(names == "abcd", "members sorted by name");
+	check(root["b"].to_int() == 5, "duplicate name keeps last value");
+	check(root.to_json() == "{\"a\":3,\"b\":5,\"c\":4,\"d\":1}", "to_json");
+
+	JsonMembers::iterator it = root.get_members().end();
+	--it;
+	check(it->first == "d", "iterate backwards");
+}
+
+void test_copy()
+{
+	JsonValue root = JsonValue::from_json("{\"x\":{\"y\":[1,2,3]}, \"z\":\"text\"}");
+	JsonValue copy = root;
+	copy["x"]["y"] = JsonValue::number(7);
+	copy["w"] = JsonValue::boolean(true);
+	check(root.to_json() == "{\"x\":{\"y\":[1,2,3]},\"z\":\"text\"}", "original unchanged by copy");
+	check(copy.to_json() == "{\"w\":true,\"x\":{\"y\":7},\"z\":\"text\"}", "copy modified");
+
+	copy = root;
+	check(copy.to_json() == root.to_json(), "copy assignment");
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	try
+	{
+		test_member_references();
+		test_member_order();
+		test_copy();
+		Console::write_line("All tests passed");
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,112 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include <ClanLib/core.h>
+
+using namespace clan;
+
+// Builds a JSON document of roughly the requested size, shaped like a typical REST response
+std::string generate_json(int megabytes)
+{
+	std::string json = "{\"items\":[";
+	for (int index = 0; json.length() < (std::string::size_type)megabytes * 1024 * 1024; index++)
+	{
+		std::string id = StringHelp::int_to_text(index);
+		if (index > 0)
+			json += ",\n";
+		json +=
+			"\t{\"id\":" + id + ", \"name\":\"Item " + id + "\", \"description\":\"Item number " + id + " of the catalog, with a long description\",\n"
+			"\t \"price\":" + id + ".25, \"available\":true, \"discontinued\":false,\n"
+			"\t \"tags\":[\"red\", \"green\", \"blue\"], \"size\":{\"width\":32, \"height\":-64, \"depth\":0.5}}";
+	}
+	json += "]}\n";
+	return json;
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int megabytes = (argc > 1) ? atoi(argv[1]) : 20;
+	int iterations = (argc > 2) ? atoi(argv[2]) : 5;
+
+	try
+	{
+		std::string json = generate_json(megabytes);
+		double size = json.length() / (1024.0 * 1024.0);
+		Console::write_line("Document: %1 MB, %2 iterations", StringHelp::float_to_text(size, 1), iterations);
+
+		ubyte64 start_time = System::get_microseconds();
+		JsonValue value;
+		for (int i = 0; i < iterations; i++)
+			value = JsonValue::from_json(json);
+		double elapsed = (System::get_microseconds() - start_time) / 1000000.0;
+		Console::write_line("from_json: %1 ms, %2 MB/s", (int) (elapsed * 1000.0 / iterations), StringHelp::float_to_text(size * iterations / elapsed, 1));
+
+		// In-situ parsing modifies its input, so each iteration parses a fresh copy. The copy is not timed.
+		std::string buffer;
+		elapsed = 0.0;
+		for (int i = 0; i < iterations; i++)
+		{
+			value = JsonValue();
+			buffer = json;
+			start_time = System::get_microseconds();
+			value = JsonValue::from_json_insitu(&buffer[0], buffer.length());
+			elapsed += (System::get_microseconds() - start_time) / 1000000.0;
+		}
+		Console::write_line("from_json_insitu: %1 ms, %2 MB/s", (int) (elapsed * 1000.0 / iterations), StringHelp::float_to_text(size * iterations / elapsed, 1));
+
+		value = JsonValue::from_json(json);
+		std::string output;
+		start_time = System::get_microseconds();
+		for (int i = 0; i < iterations; i++)
+			value.to_json(output);
+		elapsed = (System::get_microseconds() - start_time) / 1000000.0;
+		double output_size = output.length() / (1024.0 * 1024.0);
+		Console::write_line("to_json: %1 ms, %2 MB/s", (int) (elapsed * 1000.0 / iterations), StringHelp::float_to_text(output_size * iterations / elapsed, 1));
+
+		start_time = System::get_microseconds();
+		for (int i = 0; i < iterations; i++)
+		{
+			IODevice_Memory device;
+			value.to_json(device);
+		}
+		elapsed = (System::get_microseconds() - start_time) / 1000000.0;
+		Console::write_line("to_json(IODevice): %1 ms, %2 MB/s", (int) (elapsed * 1000.0 / iterations), StringHelp::float_to_text(output_size * iterations / elapsed, 1));
+
+		if (JsonValue::from_json(output).to_json() != output)
+			Console::write_line("Error: output does not parse back to itself");
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+// Measures log lines per second written to a FileLogger by several threads, with
+// synchronous logging and with the asynchronous per-thread buffered pipeline, and
+// how long the logging threads themselves were busy. Then checks that size based
+// rotation keeps the files below the size limit.
+//
+// Usage: logbenchmark [number of threads] [lines per thread]
+
+#include <ClanLib/core.h>
+#include <cstdlib>
+
+using namespace clan;
+
+const std::string log_filename = "logbenchmark.log";
+
+class LogThread
+{
+public:
+	LogThread(int index, int num_lines) : index(index), num_lines(num_lines) { }
+
+	void thread_main()
+	{
+		for (int i = 0; i < num_lines; i++)
+			log_event("debug", "Thread %1 line %2 value %3 state %4", index, i, i * 0.5, "running");
+	}
+
+	int index;
+	int num_lines;
+};
+
+void delete_log_files(int max_backup_files)
+{
+	if (FileHelp::file_exists(log_filename))
+		FileHelp::delete_file(log_filename);
+	for (int i = 1; i <= max_backup_files; i++)
+	{
+		std::string backup = string_format("%1.%2", log_filename, i);
+		if (FileHelp::file_exists(backup))
+			FileHelp::delete_file(backup);
+	}
+}
+
+int count_lines(const std::string &filename)
+{
+	if (!FileHelp::file_exists(filename))
+		return 0;
+	std::string text = File::read_text(filename);
+	int lines = 0;
+	for (size_t i = 0; i < text.length(); i++)
+	{
+		if (text[i] == '\n')
+			lines++;
+	}
+	return lines;
+}
+
+void run(const std::string &name, int num_threads, int num_lines, bool async, byte64 max_file_size, int max_backup_files)
+{
+	delete_log_files(max_backup_files);
+
+	ubyte64 start_time = System::get_microseconds();
+	ubyte64 logging_time = 0;
+	{
+		FileLogger logger(log_filename);
+		logger.set_rotation(max_file_size, max_backup_files);
+		if (async)
+			Logger::enable_async();
+
+		std::vector<std::unique_ptr<LogThread> > log_threads;
+		std::vector<std::unique_ptr<Thread> > threads;
+		for (int i = 0; i < num_threads; i++)
+		{
+			log_threads.push_back(std::unique_ptr<LogThread>(new LogThread(i, num_lines)));
+			threads.push_back(std::unique_ptr<Thread>(new Thread()));
+			threads.back()->start(log_threads.back().get(), &LogThread::thread_main);
+		}
+		for (auto &thread : threads)
+			thread->join();
+		logging_time = System::get_microseconds() - start_time;
+
+		if (async)
+			Logger::disable_async();
+	}
+	ubyte64 time = System::get_microseconds() - start_time;
+
+	int total_lines = 0;
+	total_lines += count_lines(log_filename);
+	for (int i = 1; i <= max_backup_files; i++)
+		total_lines += count_lines(string_format("%1.%2", log_filename, i));
+
+	int expected_lines = num_threads * num_lines;
+	Console::write_line("%1: %2 lines/s, threads done after %3 ms, written after %4 ms",
+		name,
+		StringHelp::float_to_text(expected_lines * 1000000.0 / max(time, (ubyte64)1), 0),
+		StringHelp::float_to_text(logging_time / 1000.0, 1),
+		StringHelp::float_to_text(time / 1000.0, 1));
+
+	if (max_file_size == 0 && total_lines != expected_lines)
+		throw Exception(string_format("%1 of %2 lines were written", total_lines, expected_lines));
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int num_threads = (argc > 1) ? atoi(argv[1]) : 8;
+	int num_lines = (argc > 2) ? atoi(argv[2]) : 50000;
+
+	try
+	{
+		Console::write_line("%1 threads logging %2 lines each", num_threads, num_lines);
+		run("Synchronous", num_threads, num_lines, false, 0, 0);
+		run("Asynchronous", num_threads, num_lines, true, 0, 0);
+
+		// Older lines are dropped with the oldest file, so check the file sizes instead of the line count
+		const int max_backup_files = 4;
+		byte64 max_file_size = 1024 * 1024;
+		run("Asynchronous with 1 MB rotation", num_threads, num_lines, true, max_file_size, max_backup_files);
+
+		int kept_lines = count_lines(log_filename);
+		for (int i = 1; i <= max_backup_files; i++)
+		{
+			std::string backup = string_format("%1.%2", log_filename, i);
+			if (FileHelp::file_exists(backup) && File(backup).get_size() > max_file_size)
+				throw Exception(string_format("%1 is larger than the rotation size", backup));
+			kept_lines += count_lines(backup);
+		}
+		Console::write_line("Rotation kept the last %1 lines in %2 files", kept_lines, max_backup_files + 1);
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
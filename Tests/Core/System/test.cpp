@@ -69,6 +69,7 @@ int TestApp::main(const std::vector<std::string> &args)
 
 		test_datetime();
 		test_interlock();
+		test_work_queue();
 		
 		Console::write_line("All Tests Complete");
 		console.display_close_message();
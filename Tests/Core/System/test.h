@@ -73,6 +73,7 @@ public:
 private:
 	void test_datetime();
 	void test_interlock();
+	void test_work_queue();
 
 	std::string convert_time(DateTime &datetime);
 	void fail(void);
@@ -0,0 +1,116 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_work_queue()
+{
+	Console::write_line(" Header: work_queue.h");
+	Console::write_line("  Class: WorkQueue");
+
+	Console::write_line("   Function: void parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain_size)");
+	{
+		WorkQueue queue(false, 4);
+		std::vector<int> values(1000, 0);
+		queue.parallel_for(0, (int)values.size(), [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				values[i] = i * 2;
+		}, 7);
+
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (values[i] != (int)i * 2)
+				fail();
+		}
+	}
+
+	Console::write_line("   Function: ~WorkQueue() right after parallel_for");
+	{
+		// The queue must be safe to destroy as soon as parallel_for returns, even while the
+		// workers are still cleaning up after the last chunks
+		for (int iteration = 0; iteration < 500; iteration++)
+		{
+			InterlockedVariable sum;
+			{
+				WorkQueue queue(false, 4);
+				queue.parallel_for(0, 64, [&](int begin, int end)
+				{
+					for (int i = begin; i < end; i++)
+						sum.increment();
+				}, 1);
+			}
+			if (sum.get() != 64)
+				fail();
+		}
+	}
+
+	Console::write_line("   Function: ~WorkGroup() right after wait()");
+	{
+		for (int iteration = 0; iteration < 500; iteration++)
+		{
+			InterlockedVariable sum;
+			WorkQueue queue(false, 4);
+			{
+				WorkGroup group(queue);
+				for (int i = 0; i < 16; i++)
+					group.run([&]() { sum.increment(); });
+				group.wait();
+			}
+			if (sum.get() != 16)
+				fail();
+		}
+	}
+
+	Console::write_line("   Function: void parallel_for() from a task of a serial queue");
+	{
+		// The worker of a serial queue must run the chunks itself instead of waiting for itself
+		WorkQueue queue(true);
+		std::vector<int> values(100, 0);
+		Event done_event(true, false);
+		queue.queue([&]()
+		{
+			queue.parallel_for(0, (int)values.size(), [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+					values[i] = i * 2;
+			}, 7);
+			done_event.set();
+		});
+
+		if (!done_event.wait(10000))
+			fail();
+
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (values[i] != (int)i * 2)
+				fail();
+		}
+	}
+}
@@ -2,6 +2,8 @@
 #include <ClanLib/core.h>
 using namespace clan;
 
+bool TestXMLTokenizerStreaming();
+
 void TestXMLFile(const std::string &filename)
 {
 	try
@@ -36,5 +38,17 @@ int main(int, char**)
 	TestXMLFile("test-notepad-unicode.xml");
 	TestXMLFile("test-notepad-ansi.xml");
 
+	try
+	{
+		if (!TestXMLTokenizerStreaming())
+			return 1;
+	}
+	catch(Exception error)
+	{
+		Console::write_line("Exception caught:");
+		Console::write_line(error.message);
+		return 1;
+	}
+
 	return 0;
 }
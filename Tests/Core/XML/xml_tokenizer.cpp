@@ -0,0 +1,157 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include <ClanLib/core.h>
+using namespace clan;
+
+namespace
+{
+	const char *tokenizer_document =
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+		"<!DOCTYPE catalog SYSTEM \"catalog.dtd\">\n"
+		"<!-- A comment with <tags>, > and - inside -->\n"
+		"<catalog name=\"Tom &amp; Jerry\" filter='a &gt; b' expression=\"x > y\" quote='say \"hi\"'>\n"
+		"\t<item id=\"1\" price=\"&lt;10&gt;\">First &amp; best &quot;item&quot; &apos;here&apos;</item>\n"
+		"\t<item id=\"2\"/>\n"
+		"\t<![CDATA[Raw <data> & ]] > stays ]]]]><![CDATA[as it is]]>\n"
+		"\t<?process target data > with arrow?>\n"
+		"\t<empty></empty>\n"
+		"\t<text>Line one\n\tline two</text>\n"
+		"\t<unicode value=\"\xc3\xa6\xc3\xb8\xc3\xa5\">\xe2\x82\xac 10</unicode>\n"
+		"\t<!---->\n"
+		"</catalog>\n";
+
+	std::string describe(const XMLToken &token)
+	{
+		std::string text = string_format("%1 %2 [%3] [%4]", token.type, token.variant, token.name, token.value);
+		for (size_t i = 0; i < token.attributes.size(); i++)
+			text += string_format(" %1=[%2]", token.attributes[i].first, token.attributes[i].second);
+		return text;
+	}
+
+	std::string describe(const XMLTokenView &token)
+	{
+		std::string text = string_format("%1 %2 [%3] [%4]", token.type, token.variant, token.name.to_string(), token.value.to_string());
+		for (size_t i = 0; i < token.attributes.size(); i++)
+			text += string_format(" %1=[%2]", token.attributes[i].first.to_string(), token.attributes[i].second.to_string());
+		return text;
+	}
+
+	std::vector<std::string> tokenize(const std::string &document, bool eat_whitespace)
+	{
+		DataBuffer data(document.data(), document.length());
+		IODevice_Memory device(data);
+		XMLTokenizer tokenizer(device);
+		tokenizer.set_eat_whitespace(eat_whitespace);
+
+		std::vector<std::string> tokens;
+		XMLToken token;
+		while (true)
+		{
+			tokenizer.next(&token);
+			if (token.type == XMLToken::NULL_TOKEN)
+				break;
+			tokens.push_back(describe(token));
+		}
+		return tokens;
+	}
+
+	std::vector<std::string> tokenize_streaming(const std::string &document, bool eat_whitespace, int block_size, bool use_view)
+	{
+		DataBuffer data(document.data(), document.length());
+		IODevice_Memory device(data);
+		XMLTokenizer tokenizer(device, block_size);
+		tokenizer.set_eat_whitespace(eat_whitespace);
+
+		std::vector<std::string> tokens;
+		XMLToken token;
+		XMLTokenView view;
+		while (true)
+		{
+			if (use_view)
+			{
+				tokenizer.next(&view);
+				if (view.type == XMLToken::NULL_TOKEN)
+					break;
+				tokens.push_back(describe(view));
+			}
+			else
+			{
+				tokenizer.next(&token);
+				if (token.type == XMLToken::NULL_TOKEN)
+					break;
+				tokens.push_back(describe(token));
+			}
+		}
+		return tokens;
+	}
+}
+
+// Tokens must not depend on where the blocks read by a streaming tokenizer begin and end
+bool TestXMLTokenizerStreaming()
+{
+	Console::write_line("XMLTokenizer streaming");
+
+	std::string document = tokenizer_document;
+	for (int whitespace = 0; whitespace < 2; whitespace++)
+	{
+		bool eat_whitespace = (whitespace == 0);
+		std::vector<std::string> expected = tokenize(document, eat_whitespace);
+		if (expected.empty())
+		{
+			Console::write_line("No tokens found");
+			return false;
+		}
+
+		for (int block_size = 1; block_size <= (int)document.length() + 1; block_size++)
+		{
+			for (int view = 0; view < 2; view++)
+			{
+				std::vector<std::string> tokens = tokenize_streaming(document, eat_whitespace, block_size, view != 0);
+				if (tokens != expected)
+				{
+					Console::write_line("Token mismatch with block size %1 (eat whitespace %2, token view %3)", block_size, eat_whitespace, view != 0);
+					for (size_t i = 0; i < tokens.size() || i < expected.size(); i++)
+					{
+						if (i >= tokens.size() || i >= expected.size() || tokens[i] != expected[i])
+						{
+							Console::write_line("  expected: %1", i < expected.size() ? expected[i] : std::string("(none)"));
+							Console::write_line("  got:      %1", i < tokens.size() ? tokens[i] : std::string("(none)"));
+							break;
+						}
+					}
+					return false;
+				}
+			}
+		}
+	}
+
+	Console::write_line("%1 block sizes passed", (int)document.length() + 1);
+	Console::write_line("");
+	return true;
+}
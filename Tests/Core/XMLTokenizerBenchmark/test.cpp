@@ -0,0 +1,159 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include <ClanLib/core.h>
+#ifdef WIN32
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace clan;
+
+// Writes a resources.xml style file of roughly the requested size
+void generate_resources(const std::string &filename, int megabytes)
+{
+	File file(filename, File::create_always, File::access_write);
+	file.write_string_text("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<resources>\n");
+
+	std::string block;
+	int written = 0;
+	for (int index = 0; written < megabytes * 1024 * 1024; index++)
+	{
+		std::string id = StringHelp::int_to_text(index);
+		block =
+			"\t<sprite name=\"Sprites/sprite" + id + "\" description=\"Frame &lt;" + id + "&gt; &amp; friends\">\n"
+			"\t\t<image file=\"Images/sprite" + id + ".png\">\n"
+			"\t\t\t<grid pos=\"0,0\" size=\"32,32\" array=\"8,4\" />\n"
+			"\t\t</image>\n"
+			"\t\t<translation origin=\"center\" x=\"0\" y=\"0\" />\n"
+			"\t\t<!-- Animation settings for sprite " + id + " -->\n"
+			"\t\t<animation speed=\"100\" loop=\"yes\" pingpong=\"no\" />\n"
+			"\t\t<text>Some &quot;text&quot; for sprite " + id + "</text>\n"
+			"\t</sprite>\n";
+		file.write(block.data(), block.length());
+		written += block.length();
+	}
+
+	file.write_string_text("</resources>\n");
+}
+
+double get_peak_rss_mb()
+{
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+	return 0.0;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss / 1024.0;
+	return 0.0;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	std::string mode = (argc > 1) ? argv[1] : "stream";
+	std::string filename = (argc > 2) ? argv[2] : "resources.xml";
+	int buffer_size = (argc > 3) ? atoi(argv[3]) : 64*1024;
+
+	if (mode != "stream" && mode != "load" && mode != "dom" && mode != "resources")
+	{
+		Console::write_line("Usage: xmltokenizerbenchmark [stream|load|dom|resources] [filename] [buffer size]");
+		return 1;
+	}
+
+	try
+	{
+		if (!FileHelp::file_exists(filename))
+		{
+			Console::write_line("Generating %1", filename);
+			generate_resources(filename, 50);
+		}
+
+		// Peak RSS covers the whole process, so only one mode is measured per run
+		double start_rss = get_peak_rss_mb();
+		ubyte64 start_time = System::get_microseconds();
+
+		File file(filename);
+		double megabytes = file.get_size() / (1024.0 * 1024.0);
+		int tokens = 0;
+
+		if (mode == "stream")
+		{
+			XMLTokenizer tokenizer(file, buffer_size);
+			XMLTokenView token;
+			tokenizer.next(&token);
+			while (token.type != XMLToken::NULL_TOKEN)
+			{
+				tokens++;
+				tokenizer.next(&token);
+			}
+		}
+		else if (mode == "load")
+		{
+			XMLTokenizer tokenizer(file);
+			XMLToken token;
+			tokenizer.next(&token);
+			while (token.type != XMLToken::NULL_TOKEN)
+			{
+				tokens++;
+				tokenizer.next(&token);
+			}
+		}
+		else if (mode == "dom")
+		{
+			DomDocument document(file);
+			tokens = document.get_document_element().get_child_nodes().get_length();
+		}
+		else
+		{
+			file.close();
+			XMLResourceDocument document(filename);
+			tokens = document.get_resource_names_of_type("sprite").size();
+		}
+
+		double elapsed = (System::get_microseconds() - start_time) / 1000000.0;
+
+		Console::write_line("Mode: %1, %2 MB, %3 %4", mode, StringHelp::float_to_text(megabytes, 1), tokens, mode == "dom" ? "top level nodes" : mode == "resources" ? "resources" : "tokens");
+		Console::write_line("Time: %1 ms, %2 MB/s", (int) (elapsed * 1000.0), StringHelp::float_to_text(megabytes / elapsed, 1));
+		Console::write_line("Peak RSS: %1 MB (%2 MB at start)", StringHelp::float_to_text(get_peak_rss_mb(), 1), StringHelp::float_to_text(start_rss, 1));
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,194 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include <ClanLib/core.h>
+
+using namespace clan;
+
+// Builds a resources document with the given number of sprites
+DomDocument create_document(int num_sprites)
+{
+	DomDocument document;
+	DomElement resources = document.create_element("resources");
+	document.append_child(resources);
+	for (int index = 0; index < num_sprites; index++)
+	{
+		std::string id = StringHelp::int_to_text(index);
+
+		DomElement sprite = document.create_element("sprite");
+		sprite.set_attribute("name", "Sprites/sprite" + id);
+		resources.append_child(sprite);
+
+		DomElement image = document.create_element("image");
+		image.set_attribute("file", "Images/sprite" + id + ".png");
+		sprite.append_child(image);
+
+		DomElement grid = document.create_element("grid");
+		grid.set_attribute("pos", "0,0");
+		grid.set_attribute("size", "32,32");
+		image.append_child(grid);
+
+		DomElement animation = document.create_element("animation");
+		animation.set_attribute("speed", "100");
+		animation.set_attribute("loop", (index % 2) ? "yes" : "no");
+		sprite.append_child(animation);
+
+		DomElement text = document.create_element("text");
+		text.append_child(document.create_text_node("Sprite " + id));
+		sprite.append_child(text);
+	}
+	return document;
+}
+
+bool is_same_result(const XPathObject &a, const XPathObject &b)
+{
+	if (a.get_type() != b.get_type())
+		return false;
+
+	switch (a.get_type())
+	{
+	case XPathObject::type_node_set:
+		return a.get_node_set() == b.get_node_set();
+	case XPathObject::type_boolean:
+		return a.get_boolean() == b.get_boolean();
+	case XPathObject::type_number:
+		return a.get_number() == b.get_number();
+	case XPathObject::type_string:
+		return a.get_string() == b.get_string();
+	default:
+		return true;
+	}
+}
+
+std::string pad(std::string text, size_t width, bool left_align)
+{
+	if (text.length() < width)
+		text.insert(left_align ? text.length() : 0, width - text.length(), ' ');
+	return text;
+}
+
+std::string format_time(ubyte64 microseconds, int iterations)
+{
+	return pad(StringHelp::int_to_text((int) (microseconds / iterations)) + " us", 12, false);
+}
+
+std::string describe(const XPathObject &result)
+{
+	switch (result.get_type())
+	{
+	case XPathObject::type_node_set:
+		return string_format("%1 nodes", (int) result.get_node_set().size());
+	case XPathObject::type_boolean:
+		return result.get_boolean() ? "true" : "false";
+	case XPathObject::type_number:
+		return StringHelp::double_to_text(result.get_number());
+	case XPathObject::type_string:
+		return "'" + result.get_string() + "'";
+	default:
+		return "null";
+	}
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int num_sprites = (argc > 1) ? atoi(argv[1]) : 1000;
+	int iterations = (argc > 2) ? atoi(argv[2]) : 200;
+
+	const char *expressions[] =
+	{
+		"sprite/image/@file",
+		"/resources/sprite/animation",
+		"//grid/@size",
+		"sprite[@name='Sprites/sprite500']/image/@file",
+		"sprite[animation/@loop='yes']/text",
+		"count(sprite/image)",
+		"string(sprite[last()]/@name)",
+		0
+	};
+
+	try
+	{
+		DomDocument document = create_document(num_sprites);
+		DomElement context = document.get_document_element();
+
+		Console::write_line("%1 sprites, %2 iterations per expression", num_sprites, iterations);
+		Console::write_line("%1%2%3%4  %5", pad("Expression", 48, true), pad("Interpreted", 12, false), pad("Compiled", 12, false), pad("Memoized", 12, false), "Result");
+
+		bool failed = false;
+		for (int i = 0; expressions[i]; i++)
+		{
+			XPathEvaluator evaluator;
+			XPathExpression expression(expressions[i]);
+			XPathExpression memoized_expression(expressions[i]);
+			memoized_expression.set_memoized(true);
+
+			XPathObject interpreted_result = evaluator.evaluate(expressions[i], context);
+			XPathObject compiled_result = expression.evaluate(context);
+			XPathObject memoized_result = memoized_expression.evaluate(context);
+			if (!is_same_result(interpreted_result, compiled_result) || !is_same_result(interpreted_result, memoized_result))
+			{
+				Console::write_line("Result mismatch for %1", expressions[i]);
+				failed = true;
+			}
+
+			ubyte64 start_time = System::get_microseconds();
+			for (int j = 0; j < iterations; j++)
+				evaluator.evaluate(expressions[i], context);
+			ubyte64 interpreted_time = System::get_microseconds() - start_time;
+
+			start_time = System::get_microseconds();
+			for (int j = 0; j < iterations; j++)
+				expression.evaluate(context);
+			ubyte64 compiled_time = System::get_microseconds() - start_time;
+
+			start_time = System::get_microseconds();
+			for (int j = 0; j < iterations; j++)
+				memoized_expression.evaluate(context);
+			ubyte64 memoized_time = System::get_microseconds() - start_time;
+
+			Console::write_line("%1%2%3%4  %5",
+				pad(expressions[i], 48, true),
+				format_time(interpreted_time, iterations),
+				format_time(compiled_time, iterations),
+				format_time(memoized_time, iterations),
+				describe(compiled_result));
+		}
+
+		if (failed)
+			return 1;
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
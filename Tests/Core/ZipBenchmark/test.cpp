@@ -0,0 +1,155 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+// Measures the startup cost of a large zip archive: loading the central directory,
+// opening every file and listing every directory. The file reads are then repeated
+// on a memory mapped archive.
+//
+// Usage: zipbenchmark [number of files]
+
+#include <ClanLib/core.h>
+#include <cstdlib>
+
+using namespace clan;
+
+const int files_per_directory = 400;
+
+std::string get_archive_filename(int index)
+{
+	int directory = index / files_per_directory;
+	return string_format("Assets/Pack%1/Directory%2/asset%3.bin", directory % 8, directory, index);
+}
+
+// Writes an archive of small stored files spread over many directories
+void generate_archive(const std::string &filename, int num_files)
+{
+	File file(filename, File::create_always, File::access_write);
+	ZipWriter zip_writer(file);
+	for (int i = 0; i < num_files; i++)
+	{
+		std::string data = string_format("Contents of asset %1", i);
+		zip_writer.begin_file(get_archive_filename(i), false);
+		zip_writer.write_file_data(data.data(), data.length());
+		zip_writer.end_file();
+	}
+	zip_writer.write_toc();
+}
+
+void print_time(const std::string &name, ubyte64 start_time, int count)
+{
+	ubyte64 time = System::get_microseconds() - start_time;
+	Console::write_line("%1: %2 ms, %3 us each", name, StringHelp::float_to_text(time / 1000.0, 1), StringHelp::float_to_text(time / (double)max(count, 1), 2));
+}
+
+// Opens and reads every file in the archive, returning the number of bytes read
+int open_all_files(ZipArchive &archive, int num_files, bool upper_case)
+{
+	int total_size = 0;
+	char buffer[64];
+	for (int i = 0; i < num_files; i++)
+	{
+		std::string filename = get_archive_filename(i);
+		if (upper_case)
+			filename = StringHelp::text_to_upper(filename);
+		IODevice file = archive.open_file(filename);
+		total_size += file.read(buffer, sizeof(buffer));
+	}
+	return total_size;
+}
+
+// Fetches every file in the archive as a data buffer, returning the number of bytes
+int get_all_file_data(ZipArchive &archive, int num_files)
+{
+	int total_size = 0;
+	for (int i = 0; i < num_files; i++)
+		total_size += archive.get_file_data(get_archive_filename(i)).get_size();
+	return total_size;
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int num_files = (argc > 1) ? atoi(argv[1]) : 80000;
+	const std::string filename = "zipbenchmark.zip";
+
+	try
+	{
+		ubyte64 start_time = System::get_microseconds();
+		generate_archive(filename, num_files);
+		print_time(string_format("Writing %1 files", num_files), start_time, num_files);
+
+		start_time = System::get_microseconds();
+		ZipArchive archive(filename);
+		print_time("Loading the central directory", start_time, num_files);
+
+		start_time = System::get_microseconds();
+		int total_size = open_all_files(archive, num_files, false);
+		print_time(string_format("Opening every file (%1 bytes read)", total_size), start_time, num_files);
+
+		start_time = System::get_microseconds();
+		int num_directories = (num_files + files_per_directory - 1) / files_per_directory;
+		int num_listed = 0;
+		for (int i = 0; i < num_directories; i++)
+			num_listed += archive.get_file_list(string_format("Assets/Pack%1/Directory%2", i % 8, i)).size();
+		for (int i = 0; i < 8; i++)
+			num_listed += archive.get_file_list(string_format("Assets/Pack%1", i)).size();
+		print_time(string_format("Listing %1 directories (%2 entries)", num_directories + 8, num_listed), start_time, num_directories + 8);
+
+		start_time = System::get_microseconds();
+		archive.set_case_sensitive(false);
+		print_time("Building the case insensitive index", start_time, num_files);
+
+		start_time = System::get_microseconds();
+		total_size = open_all_files(archive, num_files, true);
+		print_time(string_format("Opening every file by its upper case name (%1 bytes read)", total_size), start_time, num_files);
+
+		start_time = System::get_microseconds();
+		total_size = get_all_file_data(archive, num_files);
+		print_time(string_format("Reading every file into a buffer (%1 bytes)", total_size), start_time, num_files);
+
+		start_time = System::get_microseconds();
+		ZipArchive mapped_archive(filename, true);
+		print_time("Loading the central directory memory mapped", start_time, num_files);
+
+		start_time = System::get_microseconds();
+		total_size = open_all_files(mapped_archive, num_files, false);
+		print_time(string_format("Opening every memory mapped file (%1 bytes read)", total_size), start_time, num_files);
+
+		start_time = System::get_microseconds();
+		total_size = get_all_file_data(mapped_archive, num_files);
+		print_time(string_format("Viewing every memory mapped file (%1 bytes)", total_size), start_time, num_files);
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+// Measures ZipArchive::save packing throughput: storing every file, deflating on a
+// single worker thread and deflating on all cores. The input mixes compressible text
+// with random data that is stored because deflating it does not make it smaller.
+//
+// Usage: zippackbenchmark [number of files] [file size in kilobytes]
+
+#include <ClanLib/core.h>
+#include <cstdlib>
+
+using namespace clan;
+
+const std::string input_directory = "zippackbenchmark_input";
+
+std::string get_input_filename(int index)
+{
+	return string_format("%1/file%2.bin", input_directory, index);
+}
+
+std::string get_archive_filename(int index)
+{
+	return string_format("Assets/file%1.bin", index);
+}
+
+// Every fourth file is random, the others are text built from a small vocabulary
+DataBuffer generate_file(int index, int size)
+{
+	static const char *words[] = { "sprite ", "texture ", "shader ", "level ", "sound ", "font ", "mesh ", "layer\n" };
+
+	DataBuffer data(size);
+	unsigned int seed = index * 7919 + 1;
+	int pos = 0;
+	while (pos < size)
+	{
+		seed = seed * 1103515245 + 12345;
+		if (index % 4 == 3)
+		{
+			data.get_data()[pos++] = (char)(seed >> 16);
+		}
+		else
+		{
+			const char *word = words[(seed >> 16) % 8];
+			for (int i = 0; word[i] && pos < size; i++)
+				data.get_data()[pos++] = word[i];
+		}
+	}
+	return data;
+}
+
+void generate_input(int num_files, int file_size)
+{
+	Directory::create(input_directory);
+	for (int i = 0; i < num_files; i++)
+	{
+		DataBuffer data = generate_file(i, file_size);
+		File file(get_input_filename(i), File::create_always, File::access_write);
+		file.write(data.get_data(), data.get_size());
+	}
+}
+
+void pack(const std::string &name, int num_files, int compression_level, WorkQueue &work_queue)
+{
+	const std::string filename = "zippackbenchmark.zip";
+
+	ubyte64 start_time = System::get_microseconds();
+
+	ZipArchive archive;
+	archive.set_compression_level(compression_level);
+	for (int i = 0; i < num_files; i++)
+		archive.add_file(get_input_filename(i), get_archive_filename(i));
+	archive.save(File(filename, File::create_always, File::access_read_write), work_queue);
+
+	ubyte64 time = System::get_microseconds() - start_time;
+
+	byte64 input_size = 0;
+	int num_stored = 0;
+	std::vector<ZipFileEntry> entries = archive.get_file_list();
+	for (auto &entry : entries)
+	{
+		input_size += entry.get_uncompressed_size();
+		if (entry.get_compressed_size() == entry.get_uncompressed_size())
+			num_stored++;
+	}
+	byte64 output_size = File(filename).get_size();
+
+	Console::write_line("%1: %2 ms, %3 MB/s, %4% of input size, %5 of %6 files stored",
+		name,
+		StringHelp::float_to_text(time / 1000.0, 1),
+		StringHelp::float_to_text(input_size / (double)max(time, (ubyte64)1), 1),
+		StringHelp::float_to_text(output_size * 100.0 / max(input_size, (byte64)1), 1),
+		num_stored,
+		num_files);
+
+	// Verify the archive against the input files
+	ZipArchive saved_archive(filename, true);
+	for (int i = 0; i < num_files; i++)
+	{
+		DataBuffer data = saved_archive.get_file_data(get_archive_filename(i));
+		File input(get_input_filename(i));
+		DataBuffer expected(input.get_size());
+		input.read(expected.get_data(), expected.get_size());
+		if (data.get_size() != expected.get_size() || memcmp(data.get_data(), expected.get_data(), data.get_size()) != 0)
+			throw Exception(string_format("%1 does not match its input file", get_archive_filename(i)));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int num_files = (argc > 1) ? atoi(argv[1]) : 256;
+	int file_size = ((argc > 2) ? atoi(argv[2]) : 1024) * 1024;
+
+	try
+	{
+		generate_input(num_files, file_size);
+
+		WorkQueue single_thread_queue(false, 1);
+		WorkQueue work_queue;
+		Console::write_line("Packing %1 files of %2 KB, %3 worker threads", num_files, file_size / 1024, work_queue.get_num_threads());
+
+		pack("Store", num_files, 0, work_queue);
+		pack("Deflate, 1 thread", num_files, 6, single_thread_queue);
+		pack(string_format("Deflate, %1 threads", work_queue.get_num_threads()), num_files, 6, work_queue);
+		pack(string_format("Deflate level 1, %1 threads", work_queue.get_num_threads()), num_files, 1, work_queue);
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
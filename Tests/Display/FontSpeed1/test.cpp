@@ -0,0 +1,229 @@
+
+#include <ClanLib/core.h>
+#include <ClanLib/application.h>
+#include <ClanLib/display.h>
+#include <ClanLib/gl.h>
+
+using namespace clan;
+// This is the Application class (That is instantiated by the Program Class)
+class App
+{
+public:
+	int start(const std::vector<std::string> &args);
+
+private:
+	void on_input_up(const InputEvent &key);
+	void on_window_close();
+	void dump_glyphs_per_second(int glyphs_drawn);
+
+	void draw_latin_text(Canvas &canvas);
+	void draw_unique_codepoints(Canvas &canvas);
+	void measure_unique_codepoints(Canvas &canvas);
+
+private:
+	bool quit;
+
+	clan::Font font;
+	std::vector<std::string> latin_lines;
+	std::vector<std::string> unique_lines;
+
+	int running_test;
+
+	static const int num_unique_codepoints = 5000;
+	static const int codepoints_per_line = 100;
+};
+
+// This is the Program class that is called by ClanApplication
+class Program
+{
+public:
+	static int main(const std::vector<std::string> &args)
+	{
+		// Initialize ClanLib base components
+		SetupCore setup_core;
+
+		// Initialize the ClanLib display component
+		SetupDisplay setup_display;
+
+		// Initilize the OpenGL drivers
+		SetupGL setup_gl;
+
+		// Start the Application
+		App app;
+		int retval = app.start(args);
+		return retval;
+	}
+};
+
+// Instantiate ClanApplication, informing it where the Program is located
+Application app(&Program::main);
+
+// The start of the Application
+int App::start(const std::vector<std::string> &args)
+{
+	quit = false;
+
+	running_test = 0;
+
+	// Create a console window for text-output if not available
+	ConsoleWindow console("Console", 80, 200);
+
+	Console::write_line("Press 1-3 for different tests!");
+
+	try
+	{
+		DisplayWindow window("ClanLib FontSpeed Test", 1000, 1000);
+
+		// Connect the Window close event
+		Slot slot_quit = window.sig_window_close().connect(this, &App::on_window_close);
+
+		// Connect a keyboard handler to on_key_up()
+		Slot slot_input_up = (window.get_ic().get_keyboard()).sig_key_up().connect(this, &App::on_input_up);
+
+		// Create the canvas
+		Canvas canvas(window);
+
+		font = clan::Font(canvas, "Sans", 12);
+
+		// 50 lines of the same latin text
+		for (int line = 0; line < num_unique_codepoints / codepoints_per_line; line++)
+			latin_lines.push_back("The quick brown fox jumps over the lazy dog. THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG! 0123456789");
+
+		// 5000 unique codepoints from the CJK Unified Ideographs block, 100 per line
+		for (int line = 0; line < num_unique_codepoints / codepoints_per_line; line++)
+		{
+			std::string text;
+			for (int cnt = 0; cnt < codepoints_per_line; cnt++)
+				text += StringHelp::unicode_to_utf8(0x4e00 + line * codepoints_per_line + cnt);
+			unique_lines.push_back(text);
+		}
+
+		// Run until someone presses escape
+		while (!quit)
+		{
+			canvas.clear(Colorf(0.0f,0.0f,0.2f));
+
+			if(running_test == 0)
+				System::sleep(100);
+			if(running_test == 1)
+				draw_latin_text(canvas);
+			if(running_test == 2)
+				draw_unique_codepoints(canvas);
+			if(running_test == 3)
+				measure_unique_codepoints(canvas);
+
+			canvas.flush();
+			// Flip the display, showing on the screen what we have drawed since last call to flip()
+			window.flip(0);
+
+			// This call processes user input and other events
+			KeepAlive::process();
+		}
+	}
+	catch(Exception& exception)
+	{
+		Console::write_line("Exception caught:");
+		Console::write_line(exception.message);
+
+		// Display the stack trace (if available)
+		std::vector<std::string> stacktrace = exception.get_stack_trace();
+		int size = stacktrace.size();
+		if (size > 0)
+		{
+			Console::write_line("Stack Trace:");
+			for (int cnt=0; cnt < size; cnt++)
+			{
+				Console::write_line(stacktrace[cnt]);
+			}
+		}
+
+		console.display_close_message();
+
+		return -1;
+	}
+	return 0;
+}
+
+// A key was pressed
+void App::on_input_up(const InputEvent &key)
+{
+	if(key.id == keycode_escape)
+		quit = true;
+
+	if(key.id ==  keycode_1 && running_test != 1)
+	{
+		running_test = 1;
+		Console::write_line("Running test 1: draw_text with 5000 latin characters (95 unique)");
+	}
+	if(key.id == keycode_2 && running_test != 2)
+	{
+		running_test = 2;
+		Console::write_line("Running test 2: draw_text with 5000 unique codepoints");
+	}
+	if(key.id ==  keycode_3 && running_test != 3)
+	{
+		running_test = 3;
+		Console::write_line("Running test 3: get_text_size with 5000 unique codepoints");
+	}
+}
+
+// The window was closed
+void App::on_window_close()
+{
+	quit = true;
+}
+
+void App::dump_glyphs_per_second(int glyphs_drawn)
+{
+	static ubyte64 start_time = System::get_microseconds();
+	static ubyte64 total_glyphs = 0;
+	static int frames = 0;
+
+	total_glyphs += glyphs_drawn;
+	frames++;
+
+	ubyte64 cur_time = System::get_microseconds();
+	if (cur_time - start_time >= 1000000)
+	{
+		double seconds = (cur_time - start_time) / 1000000.0;
+		Console::write_line(string_format("fps: %1  glyphs/sec: %2", StringHelp::float_to_text(frames / seconds, 1), StringHelp::float_to_text(total_glyphs / seconds, 0)));
+		start_time = cur_time;
+		total_glyphs = 0;
+		frames = 0;
+	}
+}
+
+void App::draw_latin_text(Canvas &canvas)
+{
+	int glyphs_drawn = 0;
+	for (size_t line = 0; line < latin_lines.size(); line++)
+	{
+		font.draw_text(canvas, 10, 20 + (int)line * 19, latin_lines[line]);
+		glyphs_drawn += latin_lines[line].length();
+	}
+	dump_glyphs_per_second(glyphs_drawn);
+}
+
+void App::draw_unique_codepoints(Canvas &canvas)
+{
+	int glyphs_drawn = 0;
+	for (size_t line = 0; line < unique_lines.size(); line++)
+	{
+		font.draw_text(canvas, 10, 20 + (int)line * 19, unique_lines[line]);
+		glyphs_drawn += codepoints_per_line;
+	}
+	dump_glyphs_per_second(glyphs_drawn);
+}
+
+void App::measure_unique_codepoints(Canvas &canvas)
+{
+	int glyphs_measured = 0;
+	int width = 0;
+	for (size_t line = 0; line < unique_lines.size(); line++)
+	{
+		width += font.get_text_size(canvas, unique_lines[line]).width;
+		glyphs_measured += codepoints_per_line;
+	}
+	font.draw_text(canvas, 10, 20, string_format("Total width: %1", width));
+	dump_glyphs_per_second(glyphs_measured);
+}
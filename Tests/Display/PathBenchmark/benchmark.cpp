@@ -0,0 +1,628 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+// Measures the CPU side of path filling.
+//
+// The shapes test rasterizes a frame of small shapes on a large canvas, comparing the full canvas
+// mask that PathFillRenderer used to build and upload for every fill with the tiled PathRasterizer.
+//
+// The glyphs test renders glyph outlines at text sizes and compares the quality and speed of the
+// 2x supersampled scanline coverage PathFillRenderer used to have with the exact area coverage of
+// PathRasterizer. Quality is measured against 16x16 supersampling.
+//
+// Usage: pathbenchmark [shapes per frame] [frames]
+
+#include "API/core.h"
+#include "API/Display/2D/path.h"
+#include "Display/2D/path_rasterizer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using namespace clan;
+
+const int canvas_width = 1920;
+const int canvas_height = 1080;
+
+class ScanlineEdge
+{
+public:
+	ScanlineEdge(float x, bool up_direction) : x(x), up_direction(up_direction) { }
+
+	float x;
+	bool up_direction;
+};
+
+typedef std::vector<ScanlineEdge> Scanline;
+
+// Calls func(x0, x1) for each span of a sorted scanline that is inside the path
+template<typename Func>
+void for_each_span(const Scanline &edges, PathFillMode mode, Func func)
+{
+	if (mode == PathFillMode::alternate)
+	{
+		for (size_t i = 0; i + 1 < edges.size(); i += 2)
+			func(edges[i].x, edges[i + 1].x);
+	}
+	else
+	{
+		int nonzero_rule = 0;
+		float x0 = 0.0f;
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			if (nonzero_rule == 0)
+				x0 = edges[i].x;
+			nonzero_rule += edges[i].up_direction ? 1 : -1;
+			if (nonzero_rule == 0)
+				func(x0, edges[i].x);
+		}
+	}
+}
+
+// Point samples the path at samples x samples positions per pixel
+class ScanlineRasterizer : public PathRenderer
+{
+public:
+	ScanlineRasterizer(int width, int height, int samples) : width(width), height(height), samples(samples), scanlines(height * samples), mask(width * height)
+	{
+	}
+
+	void clear()
+	{
+		for (size_t y = 0; y < scanlines.size(); y++)
+		{
+			if (!scanlines[y].empty())
+			{
+				memset(&mask[(y / samples) * width], 0, width);
+				scanlines[y].clear();
+			}
+		}
+	}
+
+	void line(float x1, float y1) override
+	{
+		float x0 = last_x * samples;
+		float y0 = last_y * samples;
+		last_x = x1;
+		last_y = y1;
+		x1 *= samples;
+		y1 *= samples;
+
+		bool up_direction = y1 < y0;
+		float dy = y1 - y0;
+		const float epsilon = std::numeric_limits<float>::epsilon();
+		if (dy < -epsilon || dy > epsilon)
+		{
+			int start_y = max(static_cast<int>(std::floor(min(y0, y1) + 0.5f)), 0);
+			int end_y = min(static_cast<int>(std::floor(max(y0, y1) - 0.5f)) + 1, height * samples);
+			float rcp_dy = 1.0f / dy;
+			for (int y = start_y; y < end_y; y++)
+			{
+				float x = x0 + (x1 - x0) * (y + 0.5f - y0) * rcp_dy;
+				scanlines[y].push_back(ScanlineEdge(x, up_direction));
+			}
+		}
+	}
+
+	void end(bool close) override
+	{
+		line(start_x, start_y);
+	}
+
+	// The previous PathFillRenderer algorithm: two samples per pixel vertically, adding 64 per hit
+	void fill_2x(PathFillMode mode)
+	{
+		for (size_t y = 0; y < scanlines.size(); y++)
+		{
+			auto &scanline = scanlines[y];
+			std::sort(scanline.begin(), scanline.end(), [](const ScanlineEdge &a, const ScanlineEdge &b) { return a.x < b.x; });
+
+			unsigned char *line = &mask[(y / 2) * width];
+			for_each_span(scanline, mode, [&](float span_x0, float span_x1)
+			{
+				int x0 = max(static_cast<int>(span_x0 + 0.5f), 0);
+				int x1 = min(static_cast<int>(span_x1 - 0.5f) + 1, width * 2);
+				for (int x = x0; x < x1; x++)
+					line[x / 2] = min(line[x / 2] + 64, 255);
+			});
+		}
+	}
+
+	// Reference coverage, counting samples x samples point samples per pixel
+	void fill_reference(PathFillMode mode)
+	{
+		std::vector<int> counts(width);
+		for (int pixel_y = 0; pixel_y < height; pixel_y++)
+		{
+			std::fill(counts.begin(), counts.end(), 0);
+			for (int y = pixel_y * samples; y < (pixel_y + 1) * samples; y++)
+			{
+				auto &scanline = scanlines[y];
+				std::sort(scanline.begin(), scanline.end(), [](const ScanlineEdge &a, const ScanlineEdge &b) { return a.x < b.x; });
+				for_each_span(scanline, mode, [&](float span_x0, float span_x1)
+				{
+					int x0 = max(static_cast<int>(span_x0 + 0.5f), 0);
+					int x1 = min(static_cast<int>(span_x1 - 0.5f) + 1, width * samples);
+					for (int x = x0; x < x1; x++)
+						counts[x / samples]++;
+				});
+			}
+
+			for (int x = 0; x < width; x++)
+				mask[pixel_y * width + x] = static_cast<unsigned char>(counts[x] * 255 / (samples * samples));
+		}
+	}
+
+	int width;
+	int height;
+	int samples;
+	std::vector<Scanline> scanlines;
+	std::vector<unsigned char> mask;
+};
+
+// Copies the tiles of a PathRasterizer into a canvas sized mask
+void copy_tiles(const PathRasterizer &rasterizer, std::vector<unsigned char> &mask, int width, int height)
+{
+	std::fill(mask.begin(), mask.end(), 0);
+	for (int tile_y = 0; tile_y < rasterizer.tile_rows; tile_y++)
+	{
+		for (int tile_x = 0; tile_x < rasterizer.tile_columns; tile_x++)
+		{
+			for (int y = 0; y < PathRasterizer::tile_size; y++)
+			{
+				int py = (rasterizer.tile_top + tile_y) * PathRasterizer::tile_size + y;
+				int px = (rasterizer.tile_left + tile_x) * PathRasterizer::tile_size;
+				if (py >= height)
+					break;
+				int length = min(PathRasterizer::tile_size, width - px);
+				memcpy(&mask[py * width + px], rasterizer.get_tile_line(tile_x, tile_y, y), length);
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+class Shape
+{
+public:
+	float x, y, size;
+	bool round;
+};
+
+std::vector<Shape> create_shapes(int num_shapes)
+{
+	srand(1);
+	std::vector<Shape> shapes;
+	for (int i = 0; i < num_shapes; i++)
+	{
+		Shape shape;
+		shape.x = (rand() % 18800) / 10.0f;
+		shape.y = (rand() % 10400) / 10.0f;
+		shape.size = 8.0f + (rand() % 320) / 10.0f;
+		shape.round = (i % 2) == 0;
+		shapes.push_back(shape);
+	}
+	return shapes;
+}
+
+void render_shape(PathRenderer &renderer, const Shape &shape)
+{
+	float x0 = shape.x, y0 = shape.y, x1 = shape.x + shape.size, y1 = shape.y + shape.size;
+	if (shape.round)
+	{
+		// Circle made of four cubic beziers
+		const float kappa = 0.5522848f;
+		float r = shape.size * 0.5f, k = r * kappa;
+		float cx = x0 + r, cy = y0 + r;
+		renderer.begin(cx + r, cy);
+		renderer.cubic_bezier(cx + r, cy + k, cx + k, cy + r, cx, cy + r);
+		renderer.cubic_bezier(cx - k, cy + r, cx - r, cy + k, cx - r, cy);
+		renderer.cubic_bezier(cx - r, cy - k, cx - k, cy - r, cx, cy - r);
+		renderer.cubic_bezier(cx + k, cy - r, cx + r, cy - k, cx + r, cy);
+		renderer.end(true);
+	}
+	else
+	{
+		// Star polygon, which has overlapping winding
+		renderer.begin((x0 + x1) * 0.5f, y0);
+		renderer.line(x0 + shape.size * 0.2f, y1);
+		renderer.line(x1, y0 + shape.size * 0.35f);
+		renderer.line(x0, y0 + shape.size * 0.35f);
+		renderer.line(x1 - shape.size * 0.2f, y1);
+		renderer.end(true);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Glyph outline in font units, with y pointing down and the em square being 1000 units
+class Glyph
+{
+public:
+	Glyph(const std::string &name, PathFillMode mode) : name(name), mode(mode) { }
+
+	void move_to(float x, float y) { commands.push_back(Command(command_move, x, y)); }
+	void line_to(float x, float y) { commands.push_back(Command(command_line, x, y)); }
+	void bezier_to(float cx, float cy, float x, float y) { commands.push_back(Command(command_bezier, cx, cy, x, y)); }
+
+	void polygon(const float *points, int count)
+	{
+		move_to(points[0], points[1]);
+		for (int i = 1; i < count; i++)
+			line_to(points[i * 2], points[i * 2 + 1]);
+	}
+
+	// Ellipse of eight quadratic curves, as used by TrueType outlines
+	void ellipse(float cx, float cy, float rx, float ry, bool counter)
+	{
+		const float control = 1.0f / std::cos(3.14159265f / 8.0f);
+		float sign = counter ? -1.0f : 1.0f;
+		move_to(cx + rx, cy);
+		for (int i = 1; i <= 8; i++)
+		{
+			float angle = sign * i * 3.14159265f / 4.0f;
+			float control_angle = angle - sign * 3.14159265f / 8.0f;
+			bezier_to(cx + rx * control * std::cos(control_angle), cy + ry * control * std::sin(control_angle), cx + rx * std::cos(angle), cy + ry * std::sin(angle));
+		}
+	}
+
+	void render(PathRenderer &renderer, float x, float y, float size) const
+	{
+		float scale = size / 1000.0f;
+		bool open = false;
+		for (const Command &command : commands)
+		{
+			float px = x + command.x * scale, py = y + command.y * scale;
+			if (command.type == command_move)
+			{
+				if (open)
+					renderer.end(true);
+				renderer.begin(px, py);
+				open = true;
+			}
+			else if (command.type == command_line)
+			{
+				renderer.line(px, py);
+			}
+			else
+			{
+				renderer.quadratic_bezier(px, py, x + command.x1 * scale, y + command.y1 * scale);
+			}
+		}
+		if (open)
+			renderer.end(true);
+	}
+
+	std::string name;
+	PathFillMode mode;
+
+private:
+	enum CommandType { command_move, command_line, command_bezier };
+
+	struct Command
+	{
+		Command(CommandType type, float x, float y, float x1 = 0.0f, float y1 = 0.0f) : type(type), x(x), y(y), x1(x1), y1(y1) { }
+
+		CommandType type;
+		float x, y, x1, y1;
+	};
+
+	std::vector<Command> commands;
+};
+
+std::vector<Glyph> create_glyphs()
+{
+	std::vector<Glyph> glyphs;
+
+	Glyph o("O", PathFillMode::alternate);
+	o.ellipse(380.0f, 360.0f, 320.0f, 370.0f, false);
+	o.ellipse(380.0f, 360.0f, 230.0f, 290.0f, true);
+	glyphs.push_back(o);
+
+	Glyph a("A", PathFillMode::alternate);
+	const float a_outer[] = { 320.0f, 0.0f, 420.0f, 0.0f, 740.0f, 730.0f, 640.0f, 730.0f, 550.0f, 520.0f, 190.0f, 520.0f, 100.0f, 730.0f, 0.0f, 730.0f };
+	const float a_counter[] = { 370.0f, 95.0f, 225.0f, 440.0f, 515.0f, 440.0f };
+	a.polygon(a_outer, 8);
+	a.polygon(a_counter, 3);
+	glyphs.push_back(a);
+
+	// Overlapping contours, which need the nonzero rule
+	Glyph eight("8", PathFillMode::winding);
+	eight.ellipse(320.0f, 190.0f, 230.0f, 190.0f, false);
+	eight.ellipse(320.0f, 530.0f, 270.0f, 210.0f, false);
+	eight.ellipse(320.0f, 190.0f, 140.0f, 110.0f, true);
+	eight.ellipse(320.0f, 530.0f, 175.0f, 125.0f, true);
+	glyphs.push_back(eight);
+
+	Glyph percent("%", PathFillMode::winding);
+	percent.ellipse(200.0f, 190.0f, 150.0f, 180.0f, false);
+	percent.ellipse(200.0f, 190.0f, 80.0f, 120.0f, true);
+	percent.ellipse(620.0f, 550.0f, 150.0f, 180.0f, false);
+	percent.ellipse(620.0f, 550.0f, 80.0f, 120.0f, true);
+	const float slash[] = { 640.0f, 0.0f, 720.0f, 0.0f, 180.0f, 730.0f, 100.0f, 730.0f };
+	percent.polygon(slash, 4);
+	glyphs.push_back(percent);
+
+	Glyph w("w", PathFillMode::alternate);
+	const float w_outline[] = { 0.0f, 200.0f, 90.0f, 200.0f, 210.0f, 620.0f, 340.0f, 200.0f, 440.0f, 200.0f, 570.0f, 620.0f, 690.0f, 200.0f, 780.0f, 200.0f, 620.0f, 730.0f, 520.0f, 730.0f, 390.0f, 310.0f, 260.0f, 730.0f, 160.0f, 730.0f };
+	w.polygon(w_outline, 13);
+	glyphs.push_back(w);
+
+	return glyphs;
+}
+
+class Placement
+{
+public:
+	const Glyph *glyph;
+	float x, y, size;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+template<typename Func>
+double measure(int frames, Func func)
+{
+	ubyte64 start_time = System::get_microseconds();
+	for (int frame = 0; frame < frames; frame++)
+		func();
+	return (System::get_microseconds() - start_time) / 1000000.0 / frames;
+}
+
+bool run_shapes(int num_shapes, int frames)
+{
+	std::vector<Shape> shapes = create_shapes(num_shapes);
+	ScanlineRasterizer full_canvas(canvas_width, canvas_height, 2);
+	PathRasterizer tiled;
+	tiled.set_size(canvas_width, canvas_height);
+
+	// Count the mask bytes each approach sends to the GPU, and check that both cover about the same area.
+	// The 2x scanline coverage is off by several percent for the smallest shapes.
+	double tiled_bytes = 0.0;
+	int full_tiles = 0;
+	int partial_tiles = 0;
+	std::vector<unsigned char> tiled_mask(canvas_width * canvas_height);
+	for (const Shape &shape : shapes)
+	{
+		PathFillMode mode = shape.round ? PathFillMode::alternate : PathFillMode::winding;
+
+		full_canvas.clear();
+		render_shape(full_canvas, shape);
+		full_canvas.fill_2x(mode);
+
+		tiled.clear();
+		render_shape(tiled, shape);
+		tiled.rasterize(mode);
+
+		for (int tile_y = 0; tile_y < tiled.tile_rows; tile_y++)
+		{
+			for (int tile_x = 0; tile_x < tiled.tile_columns; tile_x++)
+			{
+				PathTileCoverage coverage = tiled.get_tile_coverage(tile_x, tile_y);
+				if (coverage == PathTileCoverage::partial)
+				{
+					tiled_bytes += PathRasterizer::tile_size * PathRasterizer::tile_size;
+					partial_tiles++;
+				}
+				else if (coverage == PathTileCoverage::full)
+				{
+					full_tiles++;
+				}
+			}
+		}
+
+		copy_tiles(tiled, tiled_mask, canvas_width, canvas_height);
+		double full_canvas_area = 0.0;
+		double tiled_area = 0.0;
+		for (size_t i = 0; i < tiled_mask.size(); i++)
+		{
+			full_canvas_area += full_canvas.mask[i] / 255.0;
+			tiled_area += tiled_mask[i] / 255.0;
+		}
+		if (std::abs(full_canvas_area - tiled_area) > 1.0 + full_canvas_area * 0.1)
+		{
+			Console::write_line("Error: tiled coverage area %1 differs from the full canvas area %2", tiled_area, full_canvas_area);
+			return false;
+		}
+	}
+
+	Console::write_line("%1 shapes per frame on a %2x%3 canvas, %4 frames", num_shapes, canvas_width, canvas_height, frames);
+	Console::write_line("Tiles per frame: %1 partial, %2 full", partial_tiles, full_tiles);
+
+	double full_canvas_time = measure(frames, [&]()
+	{
+		for (const Shape &shape : shapes)
+		{
+			full_canvas.clear();
+			render_shape(full_canvas, shape);
+			full_canvas.fill_2x(shape.round ? PathFillMode::alternate : PathFillMode::winding);
+		}
+	});
+
+	double tiled_time = measure(frames, [&]()
+	{
+		for (const Shape &shape : shapes)
+		{
+			tiled.clear();
+			render_shape(tiled, shape);
+			tiled.rasterize(shape.round ? PathFillMode::alternate : PathFillMode::winding);
+		}
+	});
+
+	Console::write_line("Full canvas: %1 ms per frame, %2 us per fill, %3 MB uploaded per frame",
+		StringHelp::float_to_text(full_canvas_time * 1000.0, 2),
+		StringHelp::float_to_text(full_canvas_time * 1000000.0 / num_shapes, 2),
+		StringHelp::float_to_text(num_shapes * (double)canvas_width * canvas_height / (1024.0 * 1024.0), 2));
+	Console::write_line("Tiled: %1 ms per frame, %2 us per fill, %3 MB uploaded per frame",
+		StringHelp::float_to_text(tiled_time * 1000.0, 2),
+		StringHelp::float_to_text(tiled_time * 1000000.0 / num_shapes, 2),
+		StringHelp::float_to_text(tiled_bytes / (1024.0 * 1024.0), 2));
+	return true;
+}
+
+bool run_glyphs(int frames)
+{
+	const int width = 64;
+	const int height = 64;
+
+	std::vector<Glyph> glyphs = create_glyphs();
+	std::vector<Placement> placements;
+	srand(2);
+	for (const Glyph &glyph : glyphs)
+	{
+		for (int size = 8; size <= 48; size += 2)
+		{
+			Placement placement;
+			placement.glyph = &glyph;
+			placement.size = static_cast<float>(size);
+			placement.x = 4.0f + (rand() % 100) / 100.0f;
+			placement.y = 4.0f + (rand() % 100) / 100.0f;
+			placements.push_back(placement);
+		}
+	}
+
+	ScanlineRasterizer reference(width, height, 16);
+	ScanlineRasterizer scanline(width, height, 2);
+	PathRasterizer exact;
+	exact.set_size(width, height);
+
+	// Compare both with the reference, over the pixels the reference considers partially covered
+	std::vector<unsigned char> exact_mask(width * height);
+	double scanline_error = 0.0, exact_error = 0.0, exact_scalar_error = 0.0;
+	int scanline_max_error = 0, exact_max_error = 0;
+	int edge_pixels = 0;
+	for (const Placement &placement : placements)
+	{
+		reference.clear();
+		placement.glyph->render(reference, placement.x, placement.y, placement.size);
+		reference.fill_reference(placement.glyph->mode);
+
+		scanline.clear();
+		placement.glyph->render(scanline, placement.x, placement.y, placement.size);
+		scanline.fill_2x(placement.glyph->mode);
+
+		exact.clear();
+		placement.glyph->render(exact, placement.x, placement.y, placement.size);
+		exact.set_sse2_enabled(false);
+		exact.rasterize(placement.glyph->mode);
+		std::vector<unsigned char> scalar_mask(width * height);
+		copy_tiles(exact, scalar_mask, width, height);
+		exact.set_sse2_enabled(System::detect_cpu_extension(System::sse2));
+		exact.rasterize(placement.glyph->mode);
+		copy_tiles(exact, exact_mask, width, height);
+
+		for (int i = 0; i < width * height; i++)
+		{
+			int expected = reference.mask[i];
+			exact_scalar_error = max(exact_scalar_error, (double)std::abs(scalar_mask[i] - exact_mask[i]));
+			if (expected == 0 || expected == 255)
+			{
+				// A 16x16 sample grid is only exact on the interior and exterior
+				if (std::abs(exact_mask[i] - expected) > 128)
+				{
+					Console::write_line("Error: %1 at %2 px has coverage %3 where the reference has %4", placement.glyph->name, placement.size, (int)exact_mask[i], expected);
+					return false;
+				}
+				continue;
+			}
+
+			edge_pixels++;
+			int error = std::abs(scanline.mask[i] - expected);
+			scanline_error += error;
+			scanline_max_error = max(scanline_max_error, error);
+			error = std::abs(exact_mask[i] - expected);
+			exact_error += error;
+			exact_max_error = max(exact_max_error, error);
+		}
+	}
+
+	if (exact_scalar_error > 1.0)
+	{
+		Console::write_line("Error: SSE2 and scalar coverage differ by %1", exact_scalar_error);
+		return false;
+	}
+
+	Console::write_line("%1 glyphs from 8 to 48 px, %2 edge pixels", (int)placements.size(), edge_pixels);
+	Console::write_line("2x scanline: mean error %1, max error %2", StringHelp::float_to_text(scanline_error / edge_pixels, 2), scanline_max_error);
+	Console::write_line("Exact area: mean error %1, max error %2", StringHelp::float_to_text(exact_error / edge_pixels, 2), exact_max_error);
+
+	double scanline_time = measure(frames, [&]()
+	{
+		for (const Placement &placement : placements)
+		{
+			scanline.clear();
+			placement.glyph->render(scanline, placement.x, placement.y, placement.size);
+			scanline.fill_2x(placement.glyph->mode);
+		}
+	});
+
+	exact.set_sse2_enabled(false);
+	double scalar_time = measure(frames, [&]()
+	{
+		for (const Placement &placement : placements)
+		{
+			exact.clear();
+			placement.glyph->render(exact, placement.x, placement.y, placement.size);
+			exact.rasterize(placement.glyph->mode);
+		}
+	});
+
+	exact.set_sse2_enabled(true);
+	double sse2_time = measure(frames, [&]()
+	{
+		for (const Placement &placement : placements)
+		{
+			exact.clear();
+			placement.glyph->render(exact, placement.x, placement.y, placement.size);
+			exact.rasterize(placement.glyph->mode);
+		}
+	});
+
+	Console::write_line("2x scanline: %1 us per glyph", StringHelp::float_to_text(scanline_time * 1000000.0 / placements.size(), 2));
+	Console::write_line("Exact area: %1 us per glyph", StringHelp::float_to_text(scalar_time * 1000000.0 / placements.size(), 2));
+	if (System::detect_cpu_extension(System::sse2))
+		Console::write_line("Exact area SSE2: %1 us per glyph", StringHelp::float_to_text(sse2_time * 1000000.0 / placements.size(), 2));
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int num_shapes = (argc > 1) ? atoi(argv[1]) : 500;
+	int frames = (argc > 2) ? atoi(argv[2]) : 20;
+
+	if (!run_shapes(num_shapes, frames))
+		return 1;
+	if (!run_glyphs(frames * 10))
+		return 1;
+	return 0;
+}
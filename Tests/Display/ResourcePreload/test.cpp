@@ -0,0 +1,160 @@
+#include <ClanLib/core.h>
+#include <ClanLib/application.h>
+#include <ClanLib/display.h>
+#include <ClanLib/gl.h>
+using namespace clan;
+
+// Loads a section of large images twice: once by calling Image::resource on the render thread,
+// and once by preloading the section while frames keep rendering. Prints the worst frame time
+// and the display cache statistics of both.
+
+const int num_images = 24;
+const int image_size = 1024;
+
+class App
+{
+private:
+	bool quit;
+
+public:
+	int start(const std::vector<std::string> &args)
+	{
+		ConsoleWindow console("Console");
+
+		try
+		{
+			DisplayWindow window("Resource preload test", 1024, 768);
+
+			Canvas canvas(window);
+
+			Slot slot_quit = window.sig_window_close().connect(this, &App::on_window_close);
+
+			quit = false;
+
+			Console::write_line("Generating %1 images of %2x%2", num_images, image_size);
+			XMLResourceDocument doc = generate_resources();
+
+			Console::write_line("Loading on the render thread:");
+			run(window, canvas, doc, false);
+
+			Console::write_line("Preloading:");
+			run(window, canvas, doc, true);
+
+			console.display_close_message();
+			return 0;
+		}
+		catch(Exception error)
+		{
+			Console::write_line("Exception caught:");
+			Console::write_line(error.message);
+			console.display_close_message();
+
+			return -1;
+		}
+
+		return 0;
+	}
+
+	XMLResourceDocument generate_resources()
+	{
+		Directory::create("PreloadImages");
+
+		std::string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<resources>\n<section name=\"level\">\n";
+		for (int i = 0; i < num_images; i++)
+		{
+			std::string filename = string_format("PreloadImages/image%1.png", i);
+			PixelBuffer pixels(image_size, image_size, tf_rgba8);
+			unsigned int *data = pixels.get_data_uint32();
+			for (int y = 0; y < image_size; y++)
+				for (int x = 0; x < image_size; x++)
+					data[x + y * image_size] = ((x * (i + 1)) ^ (y * 7)) * 0x01010101 | 0xff000000;
+			PNGProvider::save(pixels, filename);
+
+			xml += string_format("<image name=\"image%1\"><image-file file=\"%2\" /></image>\n", i, filename);
+		}
+		xml += "</section>\n</resources>\n";
+
+		IODevice_Memory file;
+		file.write(xml.data(), xml.length());
+		file.seek(0);
+		return XMLResourceDocument(file, "", FileSystem("."));
+	}
+
+	void run(DisplayWindow &window, Canvas &canvas, const XMLResourceDocument &doc, bool preload)
+	{
+		ResourceManager resources = XMLResourceManager::create(doc);
+		DisplayCache &cache = DisplayCache::get(resources);
+
+		std::vector<Image> images;
+		DisplayCachePreload loading;
+		if (preload)
+			loading = cache.preload_section(canvas, "level");
+
+		ubyte64 max_frame_time = 0;
+		ubyte64 start_time = System::get_microseconds();
+		ubyte64 last_frame_time = start_time;
+
+		while (!quit && (int)images.size() < num_images)
+		{
+			if (preload)
+			{
+				cache.process_preloads();
+				if (loading.is_done())
+				{
+					for (int i = 0; i < num_images; i++)
+						images.push_back(Image::resource(canvas, string_format("image%1", i), resources));
+				}
+			}
+			else
+			{
+				// One image per frame, the way a level streams in when the player gets near
+				images.push_back(Image::resource(canvas, string_format("image%1", images.size()), resources));
+			}
+
+			canvas.clear(Colorf(0.2f, 0.2f, 0.3f));
+			float progress = preload ? loading.get_progress() : images.size() / (float)num_images;
+			canvas.fill_rect(Rectf(10.0f, 10.0f, 10.0f + 1000.0f * progress, 30.0f), Colorf::white);
+			for (size_t i = 0; i < images.size(); i++)
+				images[i].draw(canvas, Rectf(10.0f + (i % 8) * 120.0f, 50.0f + (i / 8) * 120.0f, Sizef(100.0f, 100.0f)));
+			window.flip(0);
+			KeepAlive::process();
+
+			ubyte64 now = System::get_microseconds();
+			max_frame_time = max(max_frame_time, now - last_frame_time);
+			last_frame_time = now;
+		}
+
+		DisplayCacheStatistics stats = cache.get_statistics();
+		Console::write_line("  Total time %1 ms, worst frame %2 ms", (int)((last_frame_time - start_time) / 1000), (int)(max_frame_time / 1000));
+		Console::write_line("  %1 resources loaded by get functions, worst %2 ms", stats.sync_loads, (int)(stats.max_sync_load_time / 1000));
+		Console::write_line("  %1 images decoded in %2 ms, worst %3 ms", stats.images_decoded, (int)(stats.total_decode_time / 1000), (int)(stats.max_decode_time / 1000));
+		Console::write_line("  %1 resources preloaded, %2 MB uploaded over %3 calls, worst call %4 ms", stats.resources_preloaded, (int)(stats.bytes_uploaded / (1024 * 1024)), stats.upload_calls, (int)(stats.max_upload_time / 1000));
+		if (preload)
+		{
+			std::vector<std::string> errors = loading.get_errors();
+			for (size_t i = 0; i < errors.size(); i++)
+				Console::write_line("  Error: %1", errors[i]);
+		}
+	}
+
+	void on_window_close()
+	{
+		quit = true;
+	}
+};
+
+class Program
+{
+public:
+	static int main(const std::vector<std::string> &args)
+	{
+		SetupCore setup_core;
+		SetupDisplay setup_disp;
+		SetupGL setup_gl;
+
+		App app;
+		return app.start(args);
+	}
+};
+
+Application app(&Program::main);
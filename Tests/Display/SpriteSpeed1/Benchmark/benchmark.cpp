@@ -0,0 +1,201 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+// Measures the CPU side of sprite batching: generating the triangle vertices that
+// RenderBatchTriangle uploads for every sprite. Compares a vertex at a time transform,
+// as draw_sprite used to do, with the quad writer for single and bulk submission.
+//
+// Usage: spritebatchbenchmark [sprites per frame] [frames]
+
+#include "API/core.h"
+#include "Display/2D/render_batch_quad_writer.h"
+#include <cstdlib>
+
+using namespace clan;
+
+typedef RenderBatchQuadWriter::Vertex Vertex;
+
+// RenderBatchTriangle flushes when its 1 MB vertex buffer is full
+const int max_vertices = 1024 * 1024 / sizeof(Vertex);
+
+class Scene
+{
+public:
+	Scene(int num_sprites)
+	{
+		srand(1);
+		for (int i = 0; i < num_sprites; i++)
+		{
+			float x = (float)(rand() % 1920);
+			float y = (float)(rand() % 1080);
+			float size = (float)(8 + rand() % 56);
+			dest.push_back(Rectf(x, y, x + size, y + size));
+
+			float tx = (float)((rand() % 8) * 32);
+			float ty = (float)((rand() % 8) * 32);
+			src.push_back(Rectf(tx, ty, tx + 32.0f, ty + 32.0f));
+
+			colors.push_back(Colorf(rand() % 256 / 255.0f, rand() % 256 / 255.0f, rand() % 256 / 255.0f, 1.0f));
+		}
+	}
+
+	std::vector<Rectf> dest;
+	std::vector<Rectf> src;
+	std::vector<Colorf> colors;
+};
+
+Vec4f to_position(const Mat4f &matrix, float x, float y)
+{
+	return Vec4f(
+		matrix.matrix[0*4+0]*x + matrix.matrix[1*4+0]*y + matrix.matrix[3*4+0],
+		matrix.matrix[0*4+1]*x + matrix.matrix[1*4+1]*y + matrix.matrix[3*4+1],
+		matrix.matrix[0*4+2]*x + matrix.matrix[1*4+2]*y + matrix.matrix[3*4+2],
+		matrix.matrix[0*4+3]*x + matrix.matrix[1*4+3]*y + matrix.matrix[3*4+3]);
+}
+
+void to_sprite_vertex(const Mat4f &matrix, const Pointf &texture_position, const Pointf &dest_position, Vertex &v, int texindex, const Colorf &color)
+{
+	v.position = to_position(matrix, dest_position.x, dest_position.y);
+	v.color = color;
+	v.texcoord = texture_position;
+	v.texindex = texindex;
+}
+
+// Six vertices transformed one at a time
+void draw_per_vertex(const Mat4f &matrix, const Scene &scene, const Sizef &texture_size, std::vector<Vertex> &vertices)
+{
+	int position = 0;
+	for (size_t i = 0; i < scene.dest.size(); i++)
+	{
+		if (position + 6 > max_vertices)
+			position = 0;
+
+		const Rectf &dest = scene.dest[i];
+		const Rectf &src = scene.src[i];
+		Pointf dest_position[4] = { Pointf(dest.left, dest.top), Pointf(dest.right, dest.top), Pointf(dest.left, dest.bottom), Pointf(dest.right, dest.bottom) };
+		Pointf texture_position[4] =
+		{
+			Pointf(src.left / texture_size.width, src.top / texture_size.height),
+			Pointf(src.right / texture_size.width, src.top / texture_size.height),
+			Pointf(src.left / texture_size.width, src.bottom / texture_size.height),
+			Pointf(src.right / texture_size.width, src.bottom / texture_size.height)
+		};
+
+		to_sprite_vertex(matrix, texture_position[0], dest_position[0], vertices[position++], 0, scene.colors[i]);
+		to_sprite_vertex(matrix, texture_position[1], dest_position[1], vertices[position++], 0, scene.colors[i]);
+		to_sprite_vertex(matrix, texture_position[2], dest_position[2], vertices[position++], 0, scene.colors[i]);
+		to_sprite_vertex(matrix, texture_position[1], dest_position[1], vertices[position++], 0, scene.colors[i]);
+		to_sprite_vertex(matrix, texture_position[3], dest_position[3], vertices[position++], 0, scene.colors[i]);
+		to_sprite_vertex(matrix, texture_position[2], dest_position[2], vertices[position++], 0, scene.colors[i]);
+	}
+}
+
+// One draw_image call per sprite
+void draw_per_sprite(const RenderBatchQuadWriter &writer, const Scene &scene, const Sizef &texture_size, std::vector<Vertex> &vertices)
+{
+	int position = 0;
+	for (size_t i = 0; i < scene.dest.size(); i++)
+	{
+		if (position + 6 > max_vertices)
+			position = 0;
+
+		const Rectf &src = scene.src[i];
+		Rectf texcoords(src.left / texture_size.width, src.top / texture_size.height, src.right / texture_size.width, src.bottom / texture_size.height);
+		writer.write_rect(&vertices[position], scene.dest[i], texcoords, scene.colors[i], 0);
+		position += 6;
+	}
+}
+
+// Canvas::fill_rects, filling the vertex buffer in as few calls as possible
+void draw_bulk(const RenderBatchQuadWriter &writer, const Scene &scene, const Sizef &texture_size, std::vector<Vertex> &vertices)
+{
+	int count = scene.dest.size();
+	int offset = 0;
+	while (count > 0)
+	{
+		int batch_count = min(count, max_vertices / 6);
+		writer.write_rects(&vertices[0], &scene.dest[offset], &scene.src[offset], &scene.colors[offset], scene.colors[offset], batch_count, texture_size, 0);
+		offset += batch_count;
+		count -= batch_count;
+	}
+}
+
+template<typename Func>
+void run(const std::string &name, int num_sprites, int frames, Func func)
+{
+	ubyte64 start_time = System::get_microseconds();
+	for (int frame = 0; frame < frames; frame++)
+		func();
+	double elapsed = (System::get_microseconds() - start_time) / 1000000.0;
+
+	double sprites_per_second = (double)num_sprites * frames / elapsed;
+	Console::write_line("%1: %2 ms per frame, %3 M sprites/s, %4 ns per sprite",
+		name,
+		StringHelp::float_to_text(elapsed * 1000.0 / frames, 2),
+		StringHelp::float_to_text(sprites_per_second / 1000000.0, 1),
+		StringHelp::float_to_text(1000000000.0 / sprites_per_second, 1));
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int num_sprites = (argc > 1) ? atoi(argv[1]) : 50000;
+	int frames = (argc > 2) ? atoi(argv[2]) : 200;
+
+	Scene scene(num_sprites);
+	Mat4f matrix = Mat4f::ortho_2d(0.0f, 1920.0f, 1080.0f, 0.0f, handed_left, clip_negative_positive_w) * Mat4f::identity();
+	Sizef texture_size(256.0f, 256.0f);
+	RenderBatchQuadWriter writer(matrix);
+
+	std::vector<Vertex> reference(max_vertices);
+	std::vector<Vertex> vertices(max_vertices);
+
+	Console::write_line("%1 sprites per frame, %2 frames", num_sprites, frames);
+
+	run("Per vertex", num_sprites, frames, [&]() { draw_per_vertex(matrix, scene, texture_size, reference); });
+	run("Per sprite", num_sprites, frames, [&]() { draw_per_sprite(writer, scene, texture_size, vertices); });
+	run("Bulk", num_sprites, frames, [&]() { draw_bulk(writer, scene, texture_size, vertices); });
+
+	// Compare the last vertex buffer of a frame, with texture coordinates computed the same way
+	Scene small_scene(min(num_sprites, max_vertices / 6));
+	draw_per_vertex(matrix, small_scene, texture_size, reference);
+	draw_bulk(writer, small_scene, texture_size, vertices);
+	size_t size = small_scene.dest.size() * 6;
+	for (size_t i = 0; i < size; i++)
+	{
+		if (reference[i].position != vertices[i].position || reference[i].color != vertices[i].color || reference[i].texindex != vertices[i].texindex ||
+			std::abs(reference[i].texcoord.x - vertices[i].texcoord.x) > 1.0e-6f || std::abs(reference[i].texcoord.y - vertices[i].texcoord.y) > 1.0e-6f)
+		{
+			Console::write_line("Error: vertex %1 differs from the per vertex result", (int)i);
+			return 1;
+		}
+	}
+
+	return 0;
+}
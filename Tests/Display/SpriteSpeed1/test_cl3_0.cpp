@@ -22,6 +22,7 @@ private:
 
 	void draw_diff_tex_diff_sprites(Canvas &canvas, int sprite_count, int time_elapsed);
 	void draw_diff_tex_diff_sprites_batch(Canvas &canvas, int sprite_count, int time_elapsed);
+	void draw_equal_tex_rects_bulk(Canvas &canvas, int sprite_count, int time_elapsed);
 
 private:
 	bool quit;
@@ -31,6 +32,10 @@ private:
 	std::vector<Sprite> explosions_same_tex;
 	std::vector<Sprite> explosions_diff_tex;
 
+	Texture2D explosion_texture;
+	std::vector<Rectf> bulk_dest_rects;
+	std::vector<Rectf> bulk_texture_rects;
+
 	int running_test;
 };
 
@@ -69,7 +74,7 @@ int App::start(const std::vector<std::string> &args)
 	// Create a console window for text-output if not available
 	ConsoleWindow console("Console", 80, 200);
 	
-	Console::write_line("Press 1-5 for different tests! (Test 3 and 5 not applicable for ClanLib 0.8)");			
+	Console::write_line("Press 1-6 for different tests! (Test 3, 5 and 6 not applicable for ClanLib 0.8)");			
 
 	try
 	{
@@ -94,6 +99,10 @@ int App::start(const std::vector<std::string> &args)
 		explosion1 = Sprite(canvas, "Explosion1", &resources);
 		explosion2 = Sprite(canvas, "Explosion2", &resources);
 
+		explosion_texture = Texture2D(canvas, "Gfx/explosion_01.png");
+		bulk_dest_rects.resize(10000);
+		bulk_texture_rects.resize(10000, Rectf(explosion_texture.get_size()));
+
 		explosions_same_tex.reserve(10000);
 		for(int i=0; i<10000; i++)
 		{
@@ -124,6 +133,8 @@ int App::start(const std::vector<std::string> &args)
 				draw_diff_tex_diff_sprites(canvas, 10000, delta_time);
 			if(running_test == 5)
 				draw_diff_tex_diff_sprites_batch(canvas, 10000, delta_time);
+			if(running_test == 6)
+				draw_equal_tex_rects_bulk(canvas, 10000, delta_time);
 
 			canvas.flush();
 			// Flip the display, showing on the screen what we have drawed since last call to flip()
@@ -137,6 +148,7 @@ int App::start(const std::vector<std::string> &args)
 		explosions_diff_tex.clear();
 		explosion1 = Sprite();
 		explosion2 = Sprite();
+		explosion_texture = Texture2D();
 	}
 	catch(Exception& exception)
 	{
@@ -193,6 +205,11 @@ void App::on_input_up(const InputEvent &key)
 		running_test = 5;
 		Console::write_line("Running test 5: draw_diff_tex_diff_sprites_batch");
 	}
+	if(key.id ==  keycode_6 && running_test != 6)
+	{
+		running_test = 6;
+		Console::write_line("Running test 6: draw_equal_tex_rects_bulk");
+	}
 }
 
 // The window was closed
@@ -301,4 +318,20 @@ void App::draw_diff_tex_diff_sprites_batch(Canvas &canvas, int sprite_count, int
 {
 	// Batching is builtin in 2.0..
 	draw_diff_tex_diff_sprites(canvas, sprite_count, time_elapsed);
+}
+
+void App::draw_equal_tex_rects_bulk(Canvas &canvas, int sprite_count, int time_elapsed)
+{
+	// Same layout as test 1, submitted with a single Canvas::fill_rects call
+	Sizef size = explosion_texture.get_size();
+	int count = 0;
+	for(int x=0; x<100 && count < sprite_count; ++x)
+	{
+		for(int y=0; y<100 && count < sprite_count; ++y)
+		{
+			bulk_dest_rects[count] = Rectf(Pointf(x * 10.0f, y * 10.0f), size);
+			count++;
+		}
+	}
+	canvas.fill_rects(&bulk_dest_rects[0], &bulk_texture_rects[0], count, explosion_texture);
 }
\ No newline at end of file
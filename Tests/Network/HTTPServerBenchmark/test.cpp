@@ -0,0 +1,282 @@
+// HTTPServer benchmark
+//
+// Runs a HTTPServer and hammers it with keep-alive, pipelined GET requests from
+// raw socket clients, in the style of wrk. Reports requests per second.
+//
+// Usage: httpserverbenchmark [io threads] [connections] [pipeline depth] [seconds] [url]
+//
+// With 0 I/O threads the server runs a thread per connection and closes the connection
+// after every response, so the clients reconnect for each request.
+// The url /hello returns a small text response and /file a 64 KB file sent with sendfile().
+
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstdlib>
+
+using namespace clan;
+
+const int server_port = 4558;
+const char *static_filename = "httpserverbenchmark.tmp";
+
+class BenchmarkHandler : public HTTPRequestHandlerProvider
+{
+public:
+	bool is_handling_request(const std::string &type, const std::string &url, const std::string &headers)
+	{
+		return url == "/hello" || url == "/file";
+	}
+
+	void handle_request(HTTPServerConnection &connection)
+	{
+		if (connection.get_request_url() == "/file")
+		{
+			connection.write_response_status(200, "OK");
+			connection.write_response_headers("Content-Type: application/octet-stream");
+			connection.write_response_file(static_filename);
+		}
+		else
+		{
+			static std::string hello("Hello World\r\n");
+			connection.write_response_status(200, "OK");
+			connection.write_response_headers("Content-Type: text/plain");
+			connection.write_response_data(DataBuffer(hello.data(), hello.length()));
+		}
+	}
+};
+
+class BenchmarkClient
+{
+public:
+	BenchmarkClient(int num_connections, int pipeline_depth, bool reconnect, const std::string &url)
+	: num_connections(num_connections), pipeline_depth(pipeline_depth), reconnect(reconnect), url(url),
+	  stop_flag(false), requests_completed(0), bytes_received(0), failed(false)
+	{
+	}
+
+	~BenchmarkClient()
+	{
+		for (size_t i = 0; i < handles.size(); i++)
+			close(handles[i]);
+	}
+
+	void start()
+	{
+		thread.start(this, &BenchmarkClient::thread_main);
+	}
+
+	void stop()
+	{
+		stop_flag = true;
+		thread.join();
+	}
+
+	int num_connections;
+	int pipeline_depth;
+	bool reconnect;
+	std::string url;
+	volatile bool stop_flag;
+
+	int requests_completed;
+	byte64 bytes_received;
+	bool failed;
+	std::string error;
+
+private:
+	void thread_main()
+	{
+		try
+		{
+			std::string request = "GET " + url + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+			std::string pipeline;
+			for (int i = 0; i < pipeline_depth; i++)
+				pipeline += request;
+
+			handles.resize(num_connections, -1);
+			buffers.resize(num_connections);
+			if (!reconnect)
+			{
+				for (int i = 0; i < num_connections; i++)
+					handles[i] = connect_client();
+			}
+
+			while (!stop_flag)
+			{
+				for (int i = 0; i < num_connections; i++)
+				{
+					if (reconnect)
+						handles[i] = connect_client();
+					send_all(handles[i], pipeline);
+				}
+
+				for (int i = 0; i < num_connections; i++)
+				{
+					for (int j = 0; j < pipeline_depth; j++)
+						read_response(handles[i], buffers[i]);
+					requests_completed += pipeline_depth;
+
+					if (reconnect)
+					{
+						close(handles[i]);
+						handles[i] = -1;
+						buffers[i].clear();
+					}
+				}
+			}
+		}
+		catch (const Exception &e)
+		{
+			failed = true;
+			error = e.message;
+		}
+	}
+
+	int connect_client()
+	{
+		sockaddr_in address;
+		memset(&address, 0, sizeof(sockaddr_in));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(server_port);
+		address.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+		int handle = socket(AF_INET, SOCK_STREAM, 0);
+		if (handle == -1)
+			throw Exception("Unable to create socket");
+
+		int value = 1;
+		setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(int));
+
+		if (connect(handle, (sockaddr *) &address, sizeof(sockaddr_in)) == -1)
+		{
+			close(handle);
+			throw Exception("Unable to connect");
+		}
+		return handle;
+	}
+
+	void send_all(int handle, const std::string &data)
+	{
+		size_t pos = 0;
+		while (pos < data.length())
+		{
+			ssize_t sent = send(handle, data.data() + pos, data.length() - pos, MSG_NOSIGNAL);
+			if (sent <= 0)
+				throw Exception("Unable to send request");
+			pos += sent;
+		}
+	}
+
+	void read_response(int handle, std::string &buffer)
+	{
+		std::string::size_type header_end;
+		while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos)
+			receive_more(handle, buffer);
+
+		if (buffer.compare(0, 12, "HTTP/1.1 200") != 0)
+			throw Exception("Unexpected response: " + buffer.substr(0, buffer.find("\r\n")));
+
+		std::string::size_type length_pos = buffer.find("Content-Length: ");
+		if (length_pos == std::string::npos || length_pos > header_end)
+			throw Exception("Response has no Content-Length");
+		size_t content_length = StringHelp::text_to_int(buffer.substr(length_pos + 16, buffer.find("\r\n", length_pos) - length_pos - 16));
+
+		size_t response_length = header_end + 4 + content_length;
+		while (buffer.length() < response_length)
+			receive_more(handle, buffer);
+
+		bytes_received += response_length;
+		buffer.erase(0, response_length);
+	}
+
+	void receive_more(int handle, std::string &buffer)
+	{
+		char data[16*1024];
+		ssize_t received = recv(handle, data, 16*1024, 0);
+		if (received <= 0)
+			throw Exception("Connection closed while waiting for response");
+		buffer.append(data, received);
+	}
+
+	Thread thread;
+	std::vector<int> handles;
+	std::vector<std::string> buffers;
+};
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+	SetupNetwork setup_network;
+
+	int num_io_threads = (argc > 1) ? atoi(argv[1]) : 2;
+	int num_connections = (argc > 2) ? atoi(argv[2]) : 64;
+	int pipeline_depth = (argc > 3) ? atoi(argv[3]) : 16;
+	int seconds = (argc > 4) ? atoi(argv[4]) : 5;
+	std::string url = (argc > 5) ? argv[5] : "/hello";
+
+	bool reconnect = (num_io_threads == 0);
+	if (reconnect)
+		pipeline_depth = 1;
+
+	int num_client_threads = clamp(System::get_num_cores(), 1, num_connections);
+
+	rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t) (num_connections * 2 + 64))
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+
+	try
+	{
+		File::write_bytes(static_filename, DataBuffer(64*1024));
+
+		HTTPServer server;
+		server.set_io_thread_count(num_io_threads);
+		server.bind(SocketName("127.0.0.1", StringHelp::int_to_text(server_port)));
+		server.add_handler(HTTPRequestHandler(new BenchmarkHandler()));
+
+		Console::write_line("I/O threads: %1, connections: %2, pipeline depth: %3, url: %4", num_io_threads, num_connections, pipeline_depth, url);
+
+		std::vector<std::unique_ptr<BenchmarkClient> > clients;
+		for (int i = 0; i < num_client_threads; i++)
+		{
+			int connections = num_connections / num_client_threads + (i < num_connections % num_client_threads ? 1 : 0);
+			clients.push_back(std::unique_ptr<BenchmarkClient>(new BenchmarkClient(connections, pipeline_depth, reconnect, url)));
+		}
+
+		ubyte64 start_time = System::get_microseconds();
+		for (size_t i = 0; i < clients.size(); i++)
+			clients[i]->start();
+		System::sleep(seconds * 1000);
+		for (size_t i = 0; i < clients.size(); i++)
+			clients[i]->stop();
+		double elapsed = (System::get_microseconds() - start_time) / 1000000.0;
+
+		int requests = 0;
+		byte64 bytes = 0;
+		for (size_t i = 0; i < clients.size(); i++)
+		{
+			if (clients[i]->failed)
+				Console::write_line("Client failed: %1", clients[i]->error);
+			requests += clients[i]->requests_completed;
+			bytes += clients[i]->bytes_received;
+		}
+
+		Console::write_line("%1 requests in %2 ms", requests, (int) (elapsed * 1000.0));
+		Console::write_line("Requests/sec: %1", (int) (requests / elapsed));
+		Console::write_line("Transfer/sec: %1 KB", (int) (bytes / elapsed / 1024.0));
+	}
+	catch (const Exception &e)
+	{
+		Console::write_line("Exception: %1", e.message);
+	}
+
+	unlink(static_filename);
+	return 0;
+}
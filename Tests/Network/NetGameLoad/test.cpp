@@ -0,0 +1,254 @@
+// NetGameServer load test
+//
+// Connects thousands of clients to a NetGameServer running with epoll I/O threads and
+// measures connect time and ping/pong round trips per second.
+//
+// Usage: netgameload [clients] [io threads] [rounds]
+//
+// The clients use plain blocking BSD sockets since Event::wait cannot handle more than
+// FD_SETSIZE handles. Make sure the file descriptor limit is high enough (ulimit -n).
+
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstdlib>
+
+using namespace clan;
+
+const int server_port = 4557;
+
+class LoadServer
+{
+public:
+	LoadServer(int io_threads) : connected_count(0), peak_connected_count(0), ping_count(0)
+	{
+		slots.connect(server.sig_client_connected(), this, &LoadServer::on_client_connected);
+		slots.connect(server.sig_client_disconnected(), this, &LoadServer::on_client_disconnected);
+		slots.connect(server.sig_event_received(), this, &LoadServer::on_event_received);
+
+		server.set_io_thread_count(io_threads);
+		server.start("127.0.0.1", StringHelp::int_to_text(server_port));
+	}
+
+	int connected_count;
+	int peak_connected_count;
+	int ping_count;
+
+private:
+	void on_client_connected(NetGameConnection *connection)
+	{
+		connected_count++;
+		peak_connected_count = max(peak_connected_count, connected_count);
+	}
+
+	void on_client_disconnected(NetGameConnection *connection, const std::string &reason)
+	{
+		connected_count--;
+		if (!reason.empty())
+			Console::write_line("Client disconnected: %1", reason);
+	}
+
+	void on_event_received(NetGameConnection *connection, const NetGameEvent &e)
+	{
+		if (e.get_name() == "ping")
+		{
+			ping_count++;
+			connection->send_event(NetGameEvent("pong", { e.get_argument(0) }));
+		}
+	}
+
+	NetGameServer server;
+	SlotContainer slots;
+};
+
+class LoadClients
+{
+public:
+	LoadClients(int num_clients, int num_rounds)
+	: num_clients(num_clients), num_rounds(num_rounds), connect_time(0), round_trip_time(0), failed(false)
+	{
+	}
+
+	~LoadClients()
+	{
+		for (size_t i = 0; i < handles.size(); i++)
+			close(handles[i]);
+	}
+
+	void start()
+	{
+		thread.start(this, &LoadClients::thread_main);
+	}
+
+	void join()
+	{
+		thread.join();
+	}
+
+	Event done_event;
+	int num_clients;
+	int num_rounds;
+	ubyte64 connect_time;
+	ubyte64 round_trip_time;
+	bool failed;
+	std::string error;
+
+private:
+	void thread_main()
+	{
+		try
+		{
+			ubyte64 start_time = System::get_microseconds();
+			connect_clients();
+			connect_time = System::get_microseconds() - start_time;
+
+			start_time = System::get_microseconds();
+			for (int round = 0; round < num_rounds; round++)
+			{
+				for (int i = 0; i < num_clients; i++)
+					send_ping(handles[i], round);
+				for (int i = 0; i < num_clients; i++)
+					receive_pong(handles[i], round);
+			}
+			round_trip_time = System::get_microseconds() - start_time;
+
+			for (size_t i = 0; i < handles.size(); i++)
+				close(handles[i]);
+			handles.clear();
+		}
+		catch (const Exception &e)
+		{
+			failed = true;
+			error = e.message;
+		}
+		done_event.set();
+	}
+
+	void connect_clients()
+	{
+		sockaddr_in address;
+		memset(&address, 0, sizeof(sockaddr_in));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(server_port);
+		address.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+		for (int i = 0; i < num_clients; i++)
+		{
+			int handle = socket(AF_INET, SOCK_STREAM, 0);
+			if (handle == -1)
+				throw Exception(string_format("Unable to create socket %1", i));
+			handles.push_back(handle);
+
+			int value = 1;
+			setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(int));
+
+			if (connect(handle, (sockaddr *) &address, sizeof(sockaddr_in)) == -1)
+				throw Exception(string_format("Unable to connect client %1", i));
+		}
+	}
+
+	// Hand encoded NetGameEvent("ping", round)
+	void send_ping(int handle, int round)
+	{
+		unsigned char packet[14];
+		encode_packet(packet, "ping", round);
+		if (send(handle, packet, 14, MSG_NOSIGNAL) != 14)
+			throw Exception("Unable to send ping");
+	}
+
+	void receive_pong(int handle, int round)
+	{
+		unsigned char packet[14];
+		int pos = 0;
+		while (pos < 14)
+		{
+			int received = recv(handle, packet + pos, 14 - pos, 0);
+			if (received <= 0)
+				throw Exception("Connection closed while waiting for pong");
+			pos += received;
+		}
+
+		unsigned char expected[14];
+		encode_packet(expected, "pong", round);
+		if (memcmp(packet, expected, 14) != 0)
+			throw Exception("Unexpected pong packet");
+	}
+
+	void encode_packet(unsigned char *packet, const char *name, int value)
+	{
+		unsigned short payload_size = 12;
+		unsigned short name_length = 4;
+		memcpy(packet, &payload_size, 2);
+		memcpy(packet + 2, &name_length, 2);
+		memcpy(packet + 4, name, 4);
+		packet[8] = 3; // int
+		memcpy(packet + 9, &value, 4);
+		packet[13] = 0;
+	}
+
+	Thread thread;
+	std::vector<int> handles;
+};
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+	SetupNetwork setup_network;
+
+	int num_clients = (argc > 1) ? atoi(argv[1]) : 2000;
+	int num_io_threads = (argc > 2) ? atoi(argv[2]) : 4;
+	int num_rounds = (argc > 3) ? atoi(argv[3]) : 20;
+
+	// Client and server side both need a handle per connection
+	rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t) (num_clients * 2 + 64))
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+
+	try
+	{
+		Console::write_line("Clients: %1, I/O threads: %2, rounds: %3", num_clients, num_io_threads, num_rounds);
+
+		LoadServer server(num_io_threads);
+		LoadClients clients(num_clients, num_rounds);
+		clients.start();
+
+		while (!clients.done_event.wait(0))
+			KeepAlive::process(1);
+		clients.join();
+
+		if (clients.failed)
+		{
+			Console::write_line("Failed: %1", clients.error);
+			return 1;
+		}
+
+		double connect_seconds = clients.connect_time / 1000000.0;
+		double round_trip_seconds = clients.round_trip_time / 1000000.0;
+		int round_trips = num_clients * num_rounds;
+
+		Console::write_line("Connected %1 clients in %2 ms", num_clients, (int) (connect_seconds * 1000.0));
+		Console::write_line("%1 round trips in %2 ms, %3 round trips/sec", round_trips, (int) (round_trip_seconds * 1000.0), (int) (round_trips / round_trip_seconds));
+		Console::write_line("Server saw %1 connections and %2 pings", server.peak_connected_count, server.ping_count);
+
+		ubyte64 disconnect_start_time = System::get_time();
+		while (server.connected_count > 0 && System::get_time() - disconnect_start_time < 10000)
+			KeepAlive::process(10);
+		Console::write_line("%1 clients still connected after disconnect", server.connected_count);
+	}
+	catch (const Exception &e)
+	{
+		Console::write_line("Exception: %1", e.message);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+// Plays many pitched sessions on a null sound output and measures how fast they are mixed,
+// and how long the application thread spends changing session settings while they play.
+//
+// Usage: mixerbenchmark [voices] [seconds]
+
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <atomic>
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+
+using namespace clan;
+
+const int mixing_frequency = 44100;
+const double pi = 3.14159265358979323846;
+
+/// \brief Counts the samples passing through the output
+class CountingFilterProvider : public SoundFilterProvider
+{
+public:
+	CountingFilterProvider() : samples(0) { }
+
+	void filter(float **sample_data, int num_samples, int channels)
+	{
+		samples += num_samples;
+	}
+
+	std::atomic<long long> samples;
+};
+
+void run(int num_voices, int seconds, int mixing_threads, SoundResampleQuality quality, const std::vector<short> &sound_data)
+{
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(mixing_frequency);
+	desc.set_device(sound_output_device_null);
+	desc.set_mixing_threads(mixing_threads);
+	SoundOutput output(desc);
+
+	CountingFilterProvider *counter = new CountingFilterProvider();
+	SoundFilter counter_filter(counter);
+	output.add_filter(counter_filter);
+
+	SoundBuffer buffer(new SoundProvider_Raw((void *)sound_data.data(), sound_data.size(), 2, false, 22050));
+
+	srand(1);
+	std::vector<SoundBuffer_Session> sessions;
+	for (int i = 0; i < num_voices; i++)
+	{
+		SoundBuffer_Session session = buffer.prepare(true, &output);
+		session.set_frequency(11025 + rand() % 33075);
+		session.set_resample_quality(quality);
+		session.set_volume(1.0f / num_voices);
+		session.set_pan((rand() % 200) / 100.0f - 1.0f);
+		sessions.push_back(session);
+	}
+
+	std::clock_t start_cpu = std::clock();
+	ubyte64 start_time = System::get_microseconds();
+	long long start_samples = counter->samples;
+
+	for (auto &session : sessions)
+		session.play();
+
+	// Update the settings of every session like a game would every frame
+	int updates = 0;
+	ubyte64 update_time = 0, max_update_time = 0;
+	while (System::get_microseconds() - start_time < (ubyte64)seconds * 1000000)
+	{
+		ubyte64 update_start = System::get_microseconds();
+		float t = (update_start - start_time) / 1000000.0f;
+		for (size_t i = 0; i < sessions.size(); i++)
+		{
+			sessions[i].set_volume((0.75f + 0.25f * std::sin(t + i)) / num_voices);
+			sessions[i].set_pan(std::sin(t * 0.5f + i));
+		}
+		ubyte64 elapsed = System::get_microseconds() - update_start;
+		update_time += elapsed;
+		max_update_time = max(max_update_time, elapsed);
+		updates++;
+
+		System::sleep(16);
+	}
+
+	double elapsed = (System::get_microseconds() - start_time) / 1000000.0;
+	double cpu = (std::clock() - start_cpu) / double(CLOCKS_PER_SEC);
+	double mixed_seconds = (counter->samples - start_samples) / double(mixing_frequency);
+
+	Console::write_line("%1 threads, %2: %3x real time, %4 ms CPU per mixed second, settings update %5 us average, %6 us max",
+		mixing_threads == 0 ? std::string("auto") : StringHelp::int_to_text(mixing_threads),
+		quality == resample_sinc ? "sinc" : "linear",
+		StringHelp::float_to_text(mixed_seconds / elapsed, 1),
+		StringHelp::float_to_text(cpu * 1000.0 / mixed_seconds, 1),
+		(int)(update_time / max(updates, 1)),
+		(int)max_update_time);
+
+	for (auto &session : sessions)
+		session.stop();
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+	SetupSound setup_sound;
+
+	int num_voices = (argc > 1) ? atoi(argv[1]) : 256;
+	int seconds = (argc > 2) ? atoi(argv[2]) : 5;
+
+	try
+	{
+		// Ten seconds of a 22050 Hz chord shared by all sessions
+		std::vector<short> sound_data(22050 * 10);
+		for (size_t i = 0; i < sound_data.size(); i++)
+		{
+			double t = i / 22050.0;
+			sound_data[i] = (short)(8000.0 * std::sin(2.0 * pi * 440.0 * t) + 4000.0 * std::sin(2.0 * pi * 1320.0 * t));
+		}
+
+		Console::write_line("%1 voices, %2 cores", num_voices, System::get_num_cores());
+		run(num_voices, seconds, 1, resample_linear, sound_data);
+		run(num_voices, seconds, 0, resample_linear, sound_data);
+		run(num_voices, seconds, 1, resample_sinc, sound_data);
+		run(num_voices, seconds, 0, resample_sinc, sound_data);
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
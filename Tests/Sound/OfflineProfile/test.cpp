@@ -0,0 +1,216 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+// Profiles Vorbis streaming, output filters and AudioWorld on the null sound output,
+// and captures a mix to a wave file, so the mixer can be measured without a sound card.
+//
+// Usage: offlineprofile [ogg file] [seconds]
+
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <cmath>
+#include <cstdlib>
+
+using namespace clan;
+
+const int mixing_frequency = 44100;
+
+void print_statistics(const std::string &name, const SoundOutputStatistics &statistics)
+{
+	double fragment_time = statistics.fragment_size * 1000.0 / mixing_frequency;
+	double mixed_seconds = statistics.fragments_mixed * (double)statistics.fragment_size / mixing_frequency;
+	double mix_seconds = statistics.total_mix_time / 1000000.0;
+
+	Console::write_line("%1: %2 fragments of %3 ms, %4 ms average, %5 ms max, %6 late, %7x real time",
+		name,
+		statistics.fragments_mixed,
+		StringHelp::float_to_text(fragment_time, 1),
+		StringHelp::float_to_text(statistics.total_mix_time / 1000.0 / max(statistics.fragments_mixed, 1), 3),
+		StringHelp::float_to_text(statistics.max_mix_time / 1000.0, 3),
+		statistics.late_fragments,
+		StringHelp::float_to_text(mix_seconds > 0.0 ? mixed_seconds / mix_seconds : 0.0, 1));
+
+	if (statistics.decode_chunks > 0 || statistics.decode_underruns > 0)
+	{
+		Console::write_line("  decoded ahead: %1 chunks, %2 ms average, %3 ms max, %4 underruns, %5 ms minimum headroom",
+			statistics.decode_chunks,
+			StringHelp::float_to_text(statistics.total_decode_time / 1000.0 / max(statistics.decode_chunks, 1), 3),
+			StringHelp::float_to_text(statistics.max_decode_time / 1000.0, 3),
+			statistics.decode_underruns,
+			StringHelp::float_to_text(statistics.min_decode_headroom / 1000.0, 1));
+	}
+}
+
+SoundOutput create_null_output(bool real_time)
+{
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(mixing_frequency);
+	desc.set_device(sound_output_device_null);
+	desc.set_real_time(real_time);
+	return SoundOutput(desc);
+}
+
+// Streamed Vorbis sessions decode on the mixer thread, or ahead of it on the decode thread.
+// Decoding ahead can only keep up with a mixer running at play speed.
+void profile_vorbis(const std::string &filename, int num_sessions, int seconds, int decode_ahead, bool real_time, bool echo)
+{
+	SoundOutput output = create_null_output(real_time);
+	EchoFilter echo_filter;
+	if (echo)
+		output.add_filter(echo_filter);
+
+	std::vector<SoundBuffer> buffers;
+	std::vector<SoundBuffer_Session> sessions;
+	for (int i = 0; i < num_sessions; i++)
+	{
+		SoundProvider_Vorbis *provider = new SoundProvider_Vorbis(filename, true);
+		provider->set_decode_ahead(decode_ahead);
+		buffers.push_back(SoundBuffer(provider));
+		SoundBuffer_Session session = buffers.back().prepare(true, &output);
+		session.set_volume(1.0f / num_sessions);
+		session.play();
+		sessions.push_back(session);
+	}
+
+	output.reset_statistics();
+	System::sleep(seconds * 1000);
+	std::string name = StringHelp::int_to_text(num_sessions) + " streamed Vorbis sessions";
+	if (decode_ahead > 0)
+		name += " decoding " + StringHelp::int_to_text(decode_ahead) + " samples ahead";
+	if (real_time)
+		name += " at play speed";
+	if (echo)
+		name += " with echo";
+	print_statistics(name, output.get_statistics());
+
+	for (auto &session : sessions)
+		session.stop();
+}
+
+// AudioWorld updating the volume and pan of moving objects at 60 Hz, mixed at play speed
+void profile_audio_world(const std::string &filename, int num_objects, int seconds)
+{
+	SoundOutput output = create_null_output(true);
+	SoundBuffer buffer(filename);
+
+	ResourceManager resources;
+	AudioWorld world(resources);
+	world.set_listener(Vec3f(0.0f, 0.0f, 0.0f), Quaternionf());
+
+	std::vector<AudioObject> objects;
+	for (int i = 0; i < num_objects; i++)
+	{
+		AudioObject object(world);
+		object.set_sound(buffer);
+		object.set_looping(true);
+		object.set_attenuation_begin(1.0f);
+		object.set_attenuation_end(50.0f);
+		object.set_volume(1.0f / num_objects);
+		object.play();
+		objects.push_back(object);
+	}
+
+	output.reset_statistics();
+	ubyte64 start_time = System::get_microseconds();
+	ubyte64 update_time = 0;
+	int updates = 0;
+	while (System::get_microseconds() - start_time < (ubyte64)seconds * 1000000)
+	{
+		float t = (System::get_microseconds() - start_time) / 1000000.0f;
+		for (size_t i = 0; i < objects.size(); i++)
+			objects[i].set_position(Vec3f(std::cos(t + i) * (5.0f + i), 0.0f, std::sin(t + i) * (5.0f + i)));
+
+		ubyte64 update_start = System::get_microseconds();
+		world.update();
+		update_time += System::get_microseconds() - update_start;
+		updates++;
+
+		System::sleep(16);
+	}
+
+	print_statistics(StringHelp::int_to_text(num_objects) + " AudioWorld objects", output.get_statistics());
+	Console::write_line("AudioWorld::update: %1 us average", (int)(update_time / max(updates, 1)));
+
+	for (auto &object : objects)
+		object.stop();
+}
+
+// Mixes a sound once into a wave file and loads the file back
+void capture_wave(const std::string &filename)
+{
+	const std::string capture_filename = "capture.wav";
+	double mixed_seconds = 0.0;
+	{
+		SoundOutput_Description desc;
+		desc.set_mixing_frequency(mixing_frequency);
+		desc.set_device(sound_output_device_wave_file);
+		desc.set_filename(capture_filename);
+		SoundOutput output(desc);
+
+		SoundBuffer buffer(filename);
+		SoundBuffer_Session session = buffer.prepare(false, &output);
+		session.play();
+		while (session.is_playing())
+			System::sleep(1);
+
+		SoundOutputStatistics statistics = output.get_statistics();
+		mixed_seconds = statistics.fragments_mixed * (double)statistics.fragment_size / mixing_frequency;
+		print_statistics("Wave capture", statistics);
+	}
+
+	SoundBuffer capture(capture_filename);
+	SoundBuffer_Session session = capture.prepare();
+	double captured_seconds = session.get_length() / (double)session.get_frequency();
+	Console::write_line("Sound ended after %1 s of mixing, %2 s captured to %3", StringHelp::float_to_text(mixed_seconds, 2), StringHelp::float_to_text(captured_seconds, 2), capture_filename);
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+	SetupSound setup_sound;
+
+	std::string filename = (argc > 1) ? argv[1] : "../../../Examples/Sound/Sound/Resources/cheer1.ogg";
+	int seconds = (argc > 2) ? atoi(argv[2]) : 3;
+
+	try
+	{
+		profile_vorbis(filename, 16, seconds, 0, false, false);
+		profile_vorbis(filename, 16, seconds, 0, false, true);
+		profile_vorbis(filename, 16, seconds, 0, true, false);
+		profile_vorbis(filename, 16, seconds, 32768, true, false);
+		profile_audio_world(filename, 64, seconds);
+		capture_wave(filename);
+	}
+	catch (Exception &exception)
+	{
+		Console::write_line("Exception caught: %1", exception.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
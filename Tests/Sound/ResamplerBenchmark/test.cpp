@@ -0,0 +1,222 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2013 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+// Mixes many pitched voices the way SoundBuffer_Session does, comparing the nearest sample
+// resampling SoundBuffer_Session used to do with the linear and windowed sinc SoundResampler.
+//
+// Usage: resamplerbenchmark [voices] [seconds]
+
+#include "API/core.h"
+#include "API/sound.h"
+#include "Sound/Mixer/sound_resampler.h"
+#include <cmath>
+#include <cstdlib>
+
+using namespace clan;
+
+const int mixing_frequency = 44100;
+const int fragment_size = 1024;
+const double pi = 3.14159265358979323846;
+
+class Source
+{
+public:
+	Source(int frequency, int seconds) : frequency(frequency), samples(SoundResampler::history + frequency * seconds + SoundResampler::lookahead)
+	{
+		// A chord with some noise, which has content up to the Nyquist frequency
+		for (int i = SoundResampler::history; i < (int)samples.size() - SoundResampler::lookahead; i++)
+		{
+			double t = i / double(frequency);
+			samples[i] = (float)(0.3 * std::sin(2.0 * pi * 440.0 * t) + 0.2 * std::sin(2.0 * pi * 3520.0 * t) + 0.1 * (rand() / double(RAND_MAX) - 0.5));
+		}
+	}
+
+	int frequency;
+	std::vector<float> samples;
+};
+
+class Voice
+{
+public:
+	const Source *source;
+	double speed;
+	float volume[2];
+
+	SoundResampler resampler;
+	ubyte64 position;
+	double nearest_position;
+};
+
+// The resampling SoundBuffer_Session used to do, one sample at a time
+int resample_nearest(const Source &source, double &position, double speed, float *output, int count)
+{
+	int length = source.samples.size() - SoundResampler::lookahead;
+	int sample_count;
+	for (sample_count = 0; sample_count < count; sample_count++)
+	{
+		if (position < length)
+			output[sample_count] = source.samples[int(position)];
+		else
+			break;
+		position += speed;
+	}
+	return sample_count;
+}
+
+void mix_nearest(std::vector<Voice> &voices, float **mix_buffers, float *temp_buffer)
+{
+	for (auto &voice : voices)
+	{
+		int count = 0;
+		while (count < fragment_size)
+		{
+			count += resample_nearest(*voice.source, voice.nearest_position, voice.speed, temp_buffer + count, fragment_size - count);
+			if (count < fragment_size)
+				voice.nearest_position = SoundResampler::history;
+		}
+		SoundSSE::mix_one_to_many(temp_buffer, fragment_size, mix_buffers, voice.volume, 2);
+	}
+}
+
+void mix_resampler(std::vector<Voice> &voices, float **mix_buffers, float *temp_buffer)
+{
+	for (auto &voice : voices)
+	{
+		float *input = const_cast<float *>(voice.source->samples.data());
+		int input_length = voice.source->samples.size();
+		int count = 0;
+		while (count < fragment_size)
+		{
+			count += voice.resampler.process(&input, 1, input_length, voice.position, &temp_buffer, count, fragment_size - count);
+			if (count < fragment_size)
+				voice.position = ((ubyte64)SoundResampler::history) << 32;
+		}
+		SoundSSE::mix_one_to_many(temp_buffer, fragment_size, mix_buffers, voice.volume, 2);
+	}
+}
+
+// Signal to noise ratio of an 8 kHz sine resampled from 48 kHz to the mixing frequency
+double measure_snr(SoundResampleQuality quality, bool nearest)
+{
+	const int input_frequency = 48000;
+	const double tone = 8000.0;
+	std::vector<float> samples(SoundResampler::history + input_frequency + SoundResampler::lookahead);
+	for (size_t i = 0; i < samples.size(); i++)
+		samples[i] = (float)std::sin(2.0 * pi * tone * (double(i) - SoundResampler::history) / input_frequency);
+
+	double speed = input_frequency / double(mixing_frequency);
+	std::vector<float> output(mixing_frequency / 2);
+	float *output_ptr = output.data();
+	if (nearest)
+	{
+		double position = SoundResampler::history;
+		for (size_t i = 0; i < output.size(); i++)
+		{
+			output[i] = samples[int(position)];
+			position += speed;
+		}
+	}
+	else
+	{
+		SoundResampler resampler;
+		resampler.set_quality(quality);
+		resampler.set_speed(speed);
+		ubyte64 position = ((ubyte64)SoundResampler::history) << 32;
+		float *input = samples.data();
+		resampler.process(&input, 1, samples.size(), position, &output_ptr, 0, output.size());
+	}
+
+	double signal = 0.0, noise = 0.0;
+	for (size_t i = 0; i < output.size(); i++)
+	{
+		double expected = std::sin(2.0 * pi * tone * (i * speed) / input_frequency);
+		signal += expected * expected;
+		noise += (output[i] - expected) * (output[i] - expected);
+	}
+	return 10.0 * std::log10(signal / noise);
+}
+
+template<typename Func>
+void run(const std::string &name, int seconds, double snr, Func func)
+{
+	int fragments = seconds * mixing_frequency / fragment_size;
+	ubyte64 start_time = System::get_microseconds();
+	for (int fragment = 0; fragment < fragments; fragment++)
+		func();
+	double elapsed = (System::get_microseconds() - start_time) / 1000000.0;
+	double mixed_seconds = fragments * fragment_size / double(mixing_frequency);
+
+	Console::write_line("%1: %2 ms CPU per mixed second, %3 dB SNR",
+		name,
+		StringHelp::float_to_text(elapsed * 1000.0 / mixed_seconds, 1),
+		StringHelp::float_to_text(snr, 1));
+}
+
+int main(int argc, char **argv)
+{
+	SetupCore setup_core;
+
+	int num_voices = (argc > 1) ? atoi(argv[1]) : 256;
+	int seconds = (argc > 2) ? atoi(argv[2]) : 10;
+
+	srand(1);
+	std::vector<Source> sources;
+	sources.push_back(Source(22050, 2));
+	sources.push_back(Source(44100, 2));
+	sources.push_back(Source(48000, 2));
+
+	std::vector<Voice> voices(num_voices);
+	for (auto &voice : voices)
+	{
+		voice.source = &sources[rand() % sources.size()];
+		double pitch = 0.5 + (rand() % 1500) / 1000.0;
+		voice.speed = voice.source->frequency * pitch / mixing_frequency;
+		voice.volume[0] = voice.volume[1] = 1.0f / num_voices;
+		voice.resampler.set_speed(voice.speed);
+		voice.position = ((ubyte64)SoundResampler::history) << 32;
+		voice.nearest_position = SoundResampler::history;
+	}
+
+	std::vector<float> mix_data[2] = { std::vector<float>(fragment_size), std::vector<float>(fragment_size) };
+	float *mix_buffers[2] = { mix_data[0].data(), mix_data[1].data() };
+	std::vector<float> temp_buffer(fragment_size);
+
+	Console::write_line("%1 voices at pitches from 0.5 to 2.0, %2 seconds at %3 Hz", num_voices, seconds, mixing_frequency);
+
+	run("Nearest (previous)", seconds, measure_snr(resample_linear, true), [&]() { mix_nearest(voices, mix_buffers, temp_buffer.data()); });
+
+	for (auto &voice : voices)
+		voice.resampler.set_quality(resample_linear);
+	run("Linear", seconds, measure_snr(resample_linear, false), [&]() { mix_resampler(voices, mix_buffers, temp_buffer.data()); });
+
+	for (auto &voice : voices)
+		voice.resampler.set_quality(resample_sinc);
+	run("Windowed sinc", seconds, measure_snr(resample_sinc, false), [&]() { mix_resampler(voices, mix_buffers, temp_buffer.data()); });
+
+	return 0;
+}